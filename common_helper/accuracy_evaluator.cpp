@@ -0,0 +1,645 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+/* for My modules */
+#include "common_helper.h"
+#include "json_reader.h"
+#include "hungarian_algorithm.h"
+#include "accuracy_evaluator.h"
+
+/*** Macro ***/
+#define TAG "AccuracyEvaluator"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static constexpr int32_t kNumIouThreshold = 10;     /* 0.50, 0.55, ..., 0.95 */
+static constexpr int32_t kNumRecallPoint = 101;
+static constexpr int32_t kMaxDetectionBbox = 100;
+static constexpr int32_t kMaxDetectionPose = 20;
+static constexpr std::array<float, KeypointEvaluator::kNumKeypoint> kKeypointSigmaList = { {
+    0.26f, 0.25f, 0.25f, 0.35f, 0.35f, 0.79f, 0.79f, 0.72f, 0.72f, 0.62f, 0.62f, 1.07f, 1.07f, 0.87f, 0.87f, 0.89f, 0.89f
+} };   /* x 1/10 */
+
+/*** Function ***/
+/* COCO style greedy matching for one image. det is sorted by score, gt is sorted as not-ignored first */
+/* det_state: 1 = TP, 0 = FP, -1 = ignored (matched to ignored gt) */
+static void MatchGreedy(const std::vector<std::vector<float>>& similarity, const std::vector<bool>& gt_ignore, const std::vector<bool>& gt_crowd, float threshold, std::vector<int32_t>& det_state)
+{
+    const size_t num_gt = gt_ignore.size();
+    std::vector<bool> gt_matched(num_gt, false);
+    det_state.assign(similarity.size(), 0);
+    for (size_t i_det = 0; i_det < similarity.size(); i_det++) {
+        float best = (std::min)(threshold, 1.0f - 1e-10f);
+        int32_t m = -1;
+        for (size_t i_gt = 0; i_gt < num_gt; i_gt++) {
+            if (gt_matched[i_gt] && !gt_crowd[i_gt]) continue;
+            if (m >= 0 && !gt_ignore[m] && gt_ignore[i_gt]) break;
+            if (similarity[i_det][i_gt] < best) continue;
+            best = similarity[i_det][i_gt];
+            m = static_cast<int32_t>(i_gt);
+        }
+        if (m < 0) continue;
+        gt_matched[m] = true;
+        det_state[i_det] = gt_ignore[m] ? -1 : 1;
+    }
+}
+
+/* 101 point interpolated AP. returns -1 if there is no gt */
+static double CalculateAp(std::vector<std::pair<float, int32_t>>& score_state_list, int32_t num_gt)
+{
+    if (num_gt <= 0) return -1;
+    std::stable_sort(score_state_list.begin(), score_state_list.end(), [](const std::pair<float, int32_t>& a, const std::pair<float, int32_t>& b) { return a.first > b.first; });
+    std::vector<double> precision_list;
+    std::vector<double> recall_list;
+    int32_t tp = 0;
+    int32_t fp = 0;
+    for (const auto& score_state : score_state_list) {
+        if (score_state.second < 0) continue;
+        if (score_state.second > 0) {
+            tp++;
+        } else {
+            fp++;
+        }
+        precision_list.push_back(static_cast<double>(tp) / (tp + fp));
+        recall_list.push_back(static_cast<double>(tp) / num_gt);
+    }
+    for (int32_t i = static_cast<int32_t>(precision_list.size()) - 2; i >= 0; i--) {
+        precision_list[i] = (std::max)(precision_list[i], precision_list[i + 1]);
+    }
+    double sum = 0;
+    for (int32_t i = 0; i < kNumRecallPoint; i++) {
+        const double recall = static_cast<double>(i) / (kNumRecallPoint - 1);
+        const auto it = std::lower_bound(recall_list.begin(), recall_list.end(), recall - 1e-12);
+        if (it != recall_list.end()) sum += precision_list[it - recall_list.begin()];
+    }
+    return sum / kNumRecallPoint;
+}
+
+static float CalculateIoU(float x0, float y0, float w0, float h0, float x1, float y1, float w1, float h1, bool is_crowd = false)
+{
+    const float iw = (std::min)(x0 + w0, x1 + w1) - (std::max)(x0, x1);
+    const float ih = (std::min)(y0 + h0, y1 + h1) - (std::max)(y0, y1);
+    if (iw <= 0 || ih <= 0) return 0;
+    const float inter = iw * ih;
+    /* for crowd gt, the denominator is the detection area (a detection inside the crowd region is ignored) */
+    const float uni = is_crowd ? w0 * h0 : w0 * h0 + w1 * h1 - inter;
+    return (uni > 0) ? inter / uni : 0;
+}
+
+static int32_t LoadCocoImageList(const JsonValue& root, std::vector<DetectionEvaluator::Image>& image_list)
+{
+    image_list.clear();
+    const JsonValue& images = root["images"];
+    for (size_t i = 0; i < images.GetSize(); i++) {
+        DetectionEvaluator::Image image;
+        image.id = static_cast<int32_t>(images[i]["id"].GetNumber());
+        image.file_name = images[i]["file_name"].GetString();
+        image.width = static_cast<int32_t>(images[i]["width"].GetNumber());
+        image.height = static_cast<int32_t>(images[i]["height"].GetNumber());
+        image_list.push_back(image);
+    }
+    if (image_list.empty()) {
+        PRINT_E("No image in annotation\n");
+        return -1;
+    }
+    return 0;
+}
+
+/*** DetectionEvaluator ***/
+int32_t DetectionEvaluator::LoadCocoAnnotation(const std::string& filename)
+{
+    JsonValue root;
+    if (JsonValue::ParseFile(filename, root) != 0) return -1;
+    if (LoadCocoImageList(root, image_list_) != 0) return -1;
+
+    category_name2id_.clear();
+    const JsonValue& categories = root["categories"];
+    for (size_t i = 0; i < categories.GetSize(); i++) {
+        category_name2id_[categories[i]["name"].GetString()] = static_cast<int32_t>(categories[i]["id"].GetNumber());
+    }
+
+    gt_list_.clear();
+    const JsonValue& annotations = root["annotations"];
+    for (size_t i = 0; i < annotations.GetSize(); i++) {
+        const JsonValue& annotation = annotations[i];
+        const JsonValue& bbox = annotation["bbox"];
+        Object object;
+        object.image_id = static_cast<int32_t>(annotation["image_id"].GetNumber());
+        object.category_id = static_cast<int32_t>(annotation["category_id"].GetNumber());
+        object.x = static_cast<float>(bbox[0].GetNumber());
+        object.y = static_cast<float>(bbox[1].GetNumber());
+        object.w = static_cast<float>(bbox[2].GetNumber());
+        object.h = static_cast<float>(bbox[3].GetNumber());
+        object.score = 1.0f;
+        object.is_crowd = annotation["iscrowd"].GetNumber() != 0;
+        gt_list_.push_back(object);
+    }
+    PRINT("%s: %zu images, %zu categories, %zu objects\n", filename.c_str(), image_list_.size(), category_name2id_.size(), gt_list_.size());
+    return 0;
+}
+
+void DetectionEvaluator::ClearResult()
+{
+    det_list_.clear();
+}
+
+void DetectionEvaluator::AddResult(int32_t image_id, const std::vector<BoundingBox>& bbox_list)
+{
+    for (const auto& bbox : bbox_list) {
+        const auto& it = category_name2id_.find(bbox.label);
+        if (it == category_name2id_.end()) continue;
+        Object object;
+        object.image_id = image_id;
+        object.category_id = it->second;
+        object.x = static_cast<float>(bbox.x);
+        object.y = static_cast<float>(bbox.y);
+        object.w = static_cast<float>(bbox.w);
+        object.h = static_cast<float>(bbox.h);
+        object.score = bbox.score;
+        object.is_crowd = false;
+        det_list_.push_back(object);
+    }
+}
+
+DetectionEvaluator::Summary DetectionEvaluator::Evaluate() const
+{
+    /* Group by (category, image) */
+    std::map<std::pair<int32_t, int32_t>, std::vector<const Object*>> gt_group;
+    std::map<std::pair<int32_t, int32_t>, std::vector<const Object*>> det_group;
+    for (const auto& object : gt_list_) gt_group[std::make_pair(object.category_id, object.image_id)].push_back(&object);
+    for (const auto& object : det_list_) det_group[std::make_pair(object.category_id, object.image_id)].push_back(&object);
+    std::set<std::pair<int32_t, int32_t>> key_list;
+    for (const auto& it : gt_group) key_list.insert(it.first);
+    for (const auto& it : det_group) key_list.insert(it.first);
+
+    std::map<int32_t, std::array<std::vector<std::pair<float, int32_t>>, kNumIouThreshold>> score_state_list;   /* key = category */
+    std::map<int32_t, int32_t> num_gt_list;
+    std::vector<int32_t> det_state;
+    for (const auto& key : key_list) {
+        std::vector<const Object*> gt = gt_group[key];
+        std::vector<const Object*> det = det_group[key];
+        std::stable_sort(gt.begin(), gt.end(), [](const Object* a, const Object* b) { return !a->is_crowd && b->is_crowd; });
+        std::stable_sort(det.begin(), det.end(), [](const Object* a, const Object* b) { return a->score > b->score; });
+        if (det.size() > static_cast<size_t>(kMaxDetectionBbox)) det.resize(kMaxDetectionBbox);
+
+        std::vector<bool> gt_crowd;
+        for (const auto& g : gt) gt_crowd.push_back(g->is_crowd);
+        num_gt_list[key.first] += static_cast<int32_t>(std::count(gt_crowd.begin(), gt_crowd.end(), false));
+
+        std::vector<std::vector<float>> similarity(det.size(), std::vector<float>(gt.size()));
+        for (size_t i_det = 0; i_det < det.size(); i_det++) {
+            for (size_t i_gt = 0; i_gt < gt.size(); i_gt++) {
+                similarity[i_det][i_gt] = CalculateIoU(det[i_det]->x, det[i_det]->y, det[i_det]->w, det[i_det]->h, gt[i_gt]->x, gt[i_gt]->y, gt[i_gt]->w, gt[i_gt]->h, gt[i_gt]->is_crowd);
+            }
+        }
+        for (int32_t i_th = 0; i_th < kNumIouThreshold; i_th++) {
+            MatchGreedy(similarity, gt_crowd, gt_crowd, 0.5f + 0.05f * i_th, det_state);
+            for (size_t i_det = 0; i_det < det.size(); i_det++) {
+                score_state_list[key.first][i_th].push_back(std::make_pair(det[i_det]->score, det_state[i_det]));
+            }
+        }
+    }
+
+    Summary summary = { 0, 0, 0, 0 };
+    for (const auto& it : num_gt_list) {
+        /* a category which has GT but no detection counts as AP = 0 */
+        const int32_t num_gt = it.second;
+        if (num_gt <= 0) continue;
+        auto& score_state = score_state_list[it.first];
+        double ap_sum = 0;
+        for (int32_t i_th = 0; i_th < kNumIouThreshold; i_th++) {
+            const double ap = CalculateAp(score_state[i_th], num_gt);
+            ap_sum += ap;
+            if (i_th == 0) summary.ap50 += ap;
+            if (i_th == 5) summary.ap75 += ap;
+        }
+        summary.ap += ap_sum / kNumIouThreshold;
+        summary.num_category++;
+    }
+    if (summary.num_category > 0) {
+        summary.ap /= summary.num_category;
+        summary.ap50 /= summary.num_category;
+        summary.ap75 /= summary.num_category;
+    }
+    return summary;
+}
+
+
+/*** KeypointEvaluator ***/
+int32_t KeypointEvaluator::LoadCocoAnnotation(const std::string& filename)
+{
+    JsonValue root;
+    if (JsonValue::ParseFile(filename, root) != 0) return -1;
+    if (LoadCocoImageList(root, image_list_) != 0) return -1;
+
+    gt_list_.clear();
+    const JsonValue& annotations = root["annotations"];
+    for (size_t i = 0; i < annotations.GetSize(); i++) {
+        const JsonValue& annotation = annotations[i];
+        if (annotation["category_id"].GetNumber(1) != 1) continue;  /* person only */
+        const JsonValue& keypoints = annotation["keypoints"];
+        const JsonValue& bbox = annotation["bbox"];
+        Pose pose;
+        pose.image_id = static_cast<int32_t>(annotation["image_id"].GetNumber());
+        for (int32_t i_kp = 0; i_kp < kNumKeypoint; i_kp++) {
+            for (int32_t i_val = 0; i_val < 3; i_val++) {
+                pose.keypoint_list[i_kp][i_val] = static_cast<float>(keypoints[i_kp * 3 + i_val].GetNumber());
+            }
+        }
+        pose.x = static_cast<float>(bbox[0].GetNumber());
+        pose.y = static_cast<float>(bbox[1].GetNumber());
+        pose.w = static_cast<float>(bbox[2].GetNumber());
+        pose.h = static_cast<float>(bbox[3].GetNumber());
+        pose.area = static_cast<float>(annotation["area"].GetNumber());
+        pose.score = 1.0f;
+        pose.is_ignore = annotation["iscrowd"].GetNumber() != 0 || annotation["num_keypoints"].GetNumber() == 0;
+        gt_list_.push_back(pose);
+    }
+    PRINT("%s: %zu images, %zu persons\n", filename.c_str(), image_list_.size(), gt_list_.size());
+    return 0;
+}
+
+void KeypointEvaluator::ClearResult()
+{
+    det_list_.clear();
+}
+
+void KeypointEvaluator::AddResult(int32_t image_id, const std::vector<KeypointList>& pose_list, const std::vector<float>& score_list)
+{
+    for (size_t i = 0; i < pose_list.size(); i++) {
+        Pose pose;
+        pose.image_id = image_id;
+        pose.keypoint_list = pose_list[i];
+        pose.x = pose.y = pose.w = pose.h = pose.area = 0;
+        pose.score = (i < score_list.size()) ? score_list[i] : 1.0f;
+        pose.is_ignore = false;
+        det_list_.push_back(pose);
+    }
+}
+
+static float CalculateOks(const KeypointEvaluator::KeypointList& det, const KeypointEvaluator::KeypointList& gt, float x, float y, float w, float h, float area)
+{
+    int32_t num_visible = 0;
+    for (const auto& kp : gt) num_visible += (kp[2] > 0) ? 1 : 0;
+    double sum = 0;
+    for (int32_t i = 0; i < KeypointEvaluator::kNumKeypoint; i++) {
+        double dx, dy;
+        if (num_visible > 0) {
+            if (gt[i][2] <= 0) continue;
+            dx = det[i][0] - gt[i][0];
+            dy = det[i][1] - gt[i][1];
+        } else {
+            /* no labeled keypoint: measure the distance from the bbox doubled in size */
+            dx = (std::max)(0.0f, (x - w) - det[i][0]) + (std::max)(0.0f, det[i][0] - (x + w * 2));
+            dy = (std::max)(0.0f, (y - h) - det[i][1]) + (std::max)(0.0f, det[i][1] - (y + h * 2));
+        }
+        const double k = 2.0 * kKeypointSigmaList[i] / 10.0;
+        const double e = (dx * dx + dy * dy) / (k * k) / (area + std::numeric_limits<float>::epsilon()) / 2;
+        sum += std::exp(-e);
+    }
+    const int32_t num_keypoint = (num_visible > 0) ? num_visible : static_cast<int32_t>(KeypointEvaluator::kNumKeypoint);
+    return static_cast<float>(sum / num_keypoint);
+}
+
+KeypointEvaluator::Summary KeypointEvaluator::Evaluate() const
+{
+    std::map<int32_t, std::vector<const Pose*>> gt_group;
+    std::map<int32_t, std::vector<const Pose*>> det_group;
+    for (const auto& pose : gt_list_) gt_group[pose.image_id].push_back(&pose);
+    for (const auto& pose : det_list_) det_group[pose.image_id].push_back(&pose);
+    std::set<int32_t> key_list;
+    for (const auto& it : gt_group) key_list.insert(it.first);
+    for (const auto& it : det_group) key_list.insert(it.first);
+
+    std::array<std::vector<std::pair<float, int32_t>>, kNumIouThreshold> score_state_list;
+    int32_t num_gt = 0;
+    std::vector<int32_t> det_state;
+    for (int32_t key : key_list) {
+        std::vector<const Pose*> gt = gt_group[key];
+        std::vector<const Pose*> det = det_group[key];
+        std::stable_sort(gt.begin(), gt.end(), [](const Pose* a, const Pose* b) { return !a->is_ignore && b->is_ignore; });
+        std::stable_sort(det.begin(), det.end(), [](const Pose* a, const Pose* b) { return a->score > b->score; });
+        if (det.size() > static_cast<size_t>(kMaxDetectionPose)) det.resize(kMaxDetectionPose);
+
+        std::vector<bool> gt_ignore;
+        std::vector<bool> gt_crowd(gt.size(), false);
+        for (const auto& g : gt) gt_ignore.push_back(g->is_ignore);
+        num_gt += static_cast<int32_t>(std::count(gt_ignore.begin(), gt_ignore.end(), false));
+
+        std::vector<std::vector<float>> similarity(det.size(), std::vector<float>(gt.size()));
+        for (size_t i_det = 0; i_det < det.size(); i_det++) {
+            for (size_t i_gt = 0; i_gt < gt.size(); i_gt++) {
+                similarity[i_det][i_gt] = CalculateOks(det[i_det]->keypoint_list, gt[i_gt]->keypoint_list, gt[i_gt]->x, gt[i_gt]->y, gt[i_gt]->w, gt[i_gt]->h, gt[i_gt]->area);
+            }
+        }
+        for (int32_t i_th = 0; i_th < kNumIouThreshold; i_th++) {
+            MatchGreedy(similarity, gt_ignore, gt_crowd, 0.5f + 0.05f * i_th, det_state);
+            for (size_t i_det = 0; i_det < det.size(); i_det++) {
+                score_state_list[i_th].push_back(std::make_pair(det[i_det]->score, det_state[i_det]));
+            }
+        }
+    }
+
+    Summary summary = { 0, 0, 0 };
+    if (num_gt <= 0) return summary;
+    for (int32_t i_th = 0; i_th < kNumIouThreshold; i_th++) {
+        const double ap = CalculateAp(score_state_list[i_th], num_gt);
+        summary.ap += ap / kNumIouThreshold;
+        if (i_th == 0) summary.ap50 = ap;
+        if (i_th == 5) summary.ap75 = ap;
+    }
+    return summary;
+}
+
+
+/*** TrackingEvaluator ***/
+TrackingEvaluator::TrackingEvaluator(float threshold_iou)
+{
+    threshold_iou_ = threshold_iou;
+    frame_num_ = 0;
+}
+
+int32_t TrackingEvaluator::LoadMotGroundTruth(const std::string& filename)
+{
+    std::ifstream ifs(filename);
+    if (ifs.fail()) {
+        PRINT_E("Failed to read %s\n", filename.c_str());
+        return -1;
+    }
+    gt_list_.clear();
+    ignore_list_.clear();
+    frame_num_ = 0;
+    int32_t num_gt = 0;
+    std::string line;
+    while (std::getline(ifs, line)) {
+        std::vector<double> value_list;
+        std::stringstream ss(line);
+        std::string value;
+        while (std::getline(ss, value, ',')) value_list.push_back(std::atof(value.c_str()));
+        if (value_list.size() < 6) continue;
+        const int32_t frame = static_cast<int32_t>(value_list[0]);
+        Object object;
+        object.id = static_cast<int32_t>(value_list[1]);
+        object.x = static_cast<float>(value_list[2]);
+        object.y = static_cast<float>(value_list[3]);
+        object.w = static_cast<float>(value_list[4]);
+        object.h = static_cast<float>(value_list[5]);
+        /* conf = 0 and non-pedestrian classes (distractors etc.) are not evaluated */
+        const bool is_ignore = (value_list.size() > 6 && value_list[6] == 0) || (value_list.size() > 7 && value_list[7] != 1);
+        if (is_ignore) {
+            ignore_list_[frame].push_back(object);
+        } else {
+            gt_list_[frame].push_back(object);
+            num_gt++;
+        }
+        frame_num_ = (std::max)(frame_num_, frame);
+    }
+    PRINT("%s: %d frames, %d objects\n", filename.c_str(), frame_num_, num_gt);
+    return 0;
+}
+
+void TrackingEvaluator::ClearResult()
+{
+    det_list_.clear();
+}
+
+void TrackingEvaluator::AddResult(int32_t frame, const std::vector<Object>& object_list)
+{
+    auto& det = det_list_[frame];
+    det.insert(det.end(), object_list.begin(), object_list.end());
+}
+
+static float CalculateIoU(const TrackingEvaluator::Object& a, const TrackingEvaluator::Object& b)
+{
+    return CalculateIoU(a.x, a.y, a.w, a.h, b.x, b.y, b.w, b.h);
+}
+
+TrackingEvaluator::Summary TrackingEvaluator::Evaluate() const
+{
+    static const std::vector<Object> kEmpty;
+    static constexpr float kCostInvalid = 2.0f;
+    Summary summary = { 0, 0, 0, 0, 0, 0 };
+    int32_t num_det_total = 0;
+    std::map<int32_t, int32_t> last_match;                      /* gt id -> det id (CLEAR MOT) */
+    std::map<std::pair<int32_t, int32_t>, int32_t> pair_count;  /* (gt id, det id) -> frames overlapped (IDF1) */
+    std::map<int32_t, int32_t> gt_count;                        /* gt id -> frames */
+    std::map<int32_t, int32_t> det_count;                       /* det id -> frames */
+
+    int32_t frame_last = frame_num_;
+    if (!det_list_.empty()) frame_last = (std::max)(frame_last, det_list_.rbegin()->first);
+    for (int32_t frame = 1; frame <= frame_last; frame++) {
+        const auto& it_gt = gt_list_.find(frame);
+        const auto& it_ignore = ignore_list_.find(frame);
+        const auto& it_det = det_list_.find(frame);
+        const std::vector<Object>& gt = (it_gt != gt_list_.end()) ? it_gt->second : kEmpty;
+        const std::vector<Object>& ignore = (it_ignore != ignore_list_.end()) ? it_ignore->second : kEmpty;
+
+        /* Remove detections on ignored objects unless they also cover a valid gt */
+        std::vector<Object> det;
+        if (it_det != det_list_.end()) {
+            for (const auto& d : it_det->second) {
+                bool is_on_ignore = false;
+                for (const auto& g : ignore) is_on_ignore |= CalculateIoU(d, g) >= threshold_iou_;
+                for (const auto& g : gt) is_on_ignore &= CalculateIoU(d, g) < threshold_iou_;
+                if (!is_on_ignore) det.push_back(d);
+            }
+        }
+        summary.num_gt += static_cast<int32_t>(gt.size());
+        num_det_total += static_cast<int32_t>(det.size());
+
+        std::vector<std::vector<float>> iou_matrix(gt.size(), std::vector<float>(det.size()));
+        for (size_t i_gt = 0; i_gt < gt.size(); i_gt++) {
+            gt_count[gt[i_gt].id]++;
+            for (size_t i_det = 0; i_det < det.size(); i_det++) {
+                iou_matrix[i_gt][i_det] = CalculateIoU(gt[i_gt], det[i_det]);
+                if (iou_matrix[i_gt][i_det] >= threshold_iou_) pair_count[std::make_pair(gt[i_gt].id, det[i_det].id)]++;
+            }
+        }
+        for (const auto& d : det) det_count[d.id]++;
+
+        /* Keep the correspondence of the previous frame if it's still valid */
+        std::vector<int32_t> assign_for_gt(gt.size(), -1);
+        std::vector<bool> det_assigned(det.size(), false);
+        for (size_t i_gt = 0; i_gt < gt.size(); i_gt++) {
+            const auto& it = last_match.find(gt[i_gt].id);
+            if (it == last_match.end()) continue;
+            for (size_t i_det = 0; i_det < det.size(); i_det++) {
+                if (!det_assigned[i_det] && det[i_det].id == it->second && iou_matrix[i_gt][i_det] >= threshold_iou_) {
+                    assign_for_gt[i_gt] = static_cast<int32_t>(i_det);
+                    det_assigned[i_det] = true;
+                    break;
+                }
+            }
+        }
+
+        /* Assign the others by IoU */
+        std::vector<int32_t> row_list, col_list;
+        for (size_t i_gt = 0; i_gt < gt.size(); i_gt++) if (assign_for_gt[i_gt] < 0) row_list.push_back(static_cast<int32_t>(i_gt));
+        for (size_t i_det = 0; i_det < det.size(); i_det++) if (!det_assigned[i_det]) col_list.push_back(static_cast<int32_t>(i_det));
+        if (!row_list.empty() && !col_list.empty()) {
+            /* HungarianAlgorithm requires square matrix */
+            const size_t size_cost_matrix = (std::max)(row_list.size(), col_list.size());
+            std::vector<std::vector<float>> cost_matrix(size_cost_matrix, std::vector<float>(size_cost_matrix, kCostInvalid));
+            for (size_t r = 0; r < row_list.size(); r++) {
+                for (size_t c = 0; c < col_list.size(); c++) {
+                    const float iou = iou_matrix[row_list[r]][col_list[c]];
+                    if (iou >= threshold_iou_) cost_matrix[r][c] = 1.0f - iou;
+                }
+            }
+            std::vector<int32_t> assign_for_row(size_cost_matrix, -1);
+            std::vector<int32_t> assign_for_col(size_cost_matrix, -1);
+            HungarianAlgorithm<float> solver(cost_matrix);
+            solver.Solve(assign_for_row, assign_for_col);
+            for (size_t r = 0; r < row_list.size(); r++) {
+                const int32_t c = assign_for_row[r];
+                if (c < 0 || c >= static_cast<int32_t>(col_list.size())) continue;
+                if (cost_matrix[r][c] >= kCostInvalid) continue;
+                const int32_t i_gt = row_list[r];
+                const int32_t i_det = col_list[c];
+                const auto& it = last_match.find(gt[i_gt].id);
+                if (it != last_match.end() && it->second != det[i_det].id) summary.num_switch++;
+                assign_for_gt[i_gt] = i_det;
+                det_assigned[i_det] = true;
+            }
+        }
+
+        int32_t num_match = 0;
+        for (size_t i_gt = 0; i_gt < gt.size(); i_gt++) {
+            if (assign_for_gt[i_gt] < 0) continue;
+            last_match[gt[i_gt].id] = det[assign_for_gt[i_gt]].id;
+            num_match++;
+        }
+        summary.num_fn += static_cast<int32_t>(gt.size()) - num_match;
+        summary.num_fp += static_cast<int32_t>(det.size()) - num_match;
+    }
+
+    if (summary.num_gt > 0) {
+        summary.mota = 1.0 - static_cast<double>(summary.num_fn + summary.num_fp + summary.num_switch) / summary.num_gt;
+    }
+
+    /* IDF1: one-to-one id mapping over the whole sequence which maximizes the number of matched frames */
+    std::map<int32_t, int32_t> gt_index;
+    std::map<int32_t, int32_t> det_index;
+    int32_t count_max = 0;
+    for (const auto& it : pair_count) {
+        if (gt_index.count(it.first.first) == 0) gt_index[it.first.first] = static_cast<int32_t>(gt_index.size());
+        if (det_index.count(it.first.second) == 0) det_index[it.first.second] = static_cast<int32_t>(det_index.size());
+        count_max = (std::max)(count_max, it.second);
+    }
+    int32_t idtp = 0;
+    if (!pair_count.empty()) {
+        const size_t size_cost_matrix = (std::max)(gt_index.size(), det_index.size());
+        std::vector<std::vector<float>> cost_matrix(size_cost_matrix, std::vector<float>(size_cost_matrix, static_cast<float>(count_max)));
+        for (const auto& it : pair_count) {
+            cost_matrix[gt_index[it.first.first]][det_index[it.first.second]] = static_cast<float>(count_max - it.second);
+        }
+        std::vector<int32_t> assign_for_row(size_cost_matrix, -1);
+        std::vector<int32_t> assign_for_col(size_cost_matrix, -1);
+        HungarianAlgorithm<float> solver(cost_matrix);
+        solver.Solve(assign_for_row, assign_for_col);
+        for (size_t r = 0; r < size_cost_matrix; r++) {
+            if (assign_for_row[r] >= 0) idtp += count_max - static_cast<int32_t>(cost_matrix[r][assign_for_row[r]]);
+        }
+    }
+    if (summary.num_gt + num_det_total > 0) {
+        summary.idf1 = 2.0 * idtp / (summary.num_gt + num_det_total);
+    }
+    return summary;
+}
+
+
+/*** EvaluationReport ***/
+void EvaluationReport::Add(const std::string& config, double accuracy, const std::vector<double>& latency_list)
+{
+    Row row;
+    row.config = config;
+    row.accuracy = accuracy;
+    row.latency_mean = row.latency_p50 = row.latency_p90 = row.fps = 0;
+    row.is_pareto = false;
+    if (!latency_list.empty()) {
+        std::vector<double> sorted_list = latency_list;
+        std::sort(sorted_list.begin(), sorted_list.end());
+        double sum = 0;
+        for (double latency : sorted_list) sum += latency;
+        row.latency_mean = sum / sorted_list.size();
+        row.latency_p50 = sorted_list[(sorted_list.size() - 1) * 50 / 100];
+        row.latency_p90 = sorted_list[(sorted_list.size() - 1) * 90 / 100];
+        row.fps = (row.latency_mean > 0) ? 1000.0 / row.latency_mean : 0;
+    }
+    row_list_.push_back(row);
+}
+
+void EvaluationReport::UpdatePareto()
+{
+    /* A configuration is on the frontier if no other one is both faster (or equal) and more (or equally) accurate */
+    for (auto& row : row_list_) {
+        row.is_pareto = true;
+        for (const auto& other : row_list_) {
+            if (&other == &row) continue;
+            if (other.accuracy >= row.accuracy && other.latency_mean <= row.latency_mean
+                && (other.accuracy > row.accuracy || other.latency_mean < row.latency_mean)) {
+                row.is_pareto = false;
+                break;
+            }
+        }
+    }
+    std::stable_sort(row_list_.begin(), row_list_.end(), [](const Row& a, const Row& b) { return a.latency_mean < b.latency_mean; });
+}
+
+const std::vector<EvaluationReport::Row>& EvaluationReport::GetRowList()
+{
+    UpdatePareto();
+    return row_list_;
+}
+
+void EvaluationReport::Print(const std::string& accuracy_name)
+{
+    UpdatePareto();
+    printf("%-24s %10s %10s %10s %10s %8s %s\n", "config", accuracy_name.c_str(), "mean[ms]", "p50[ms]", "p90[ms]", "fps", "pareto");
+    for (const auto& row : row_list_) {
+        printf("%-24s %10.4f %10.2f %10.2f %10.2f %8.2f %s\n", row.config.c_str(), row.accuracy, row.latency_mean, row.latency_p50, row.latency_p90, row.fps, row.is_pareto ? "*" : "");
+    }
+}
+
+int32_t EvaluationReport::WriteCsv(const std::string& filename, const std::string& accuracy_name)
+{
+    UpdatePareto();
+    FILE* fp = fopen(filename.c_str(), "w");
+    if (fp == nullptr) {
+        PRINT_E("Failed to open %s\n", filename.c_str());
+        return -1;
+    }
+    fprintf(fp, "config,%s,latency_mean,latency_p50,latency_p90,fps,pareto\n", accuracy_name.c_str());
+    for (const auto& row : row_list_) {
+        fprintf(fp, "%s,%f,%f,%f,%f,%f,%d\n", row.config.c_str(), row.accuracy, row.latency_mean, row.latency_p50, row.latency_p90, row.fps, row.is_pareto ? 1 : 0);
+    }
+    fclose(fp);
+    return 0;
+}
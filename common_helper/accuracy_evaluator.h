@@ -0,0 +1,168 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef ACCURACY_EVALUATOR_
+#define ACCURACY_EVALUATOR_
+
+/* for general */
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+
+/* for My modules */
+#include "bounding_box.h"
+
+/* Offline accuracy metrics for speed/accuracy trade-off evaluation */
+/*   - DetectionEvaluator: COCO bbox AP (AP@[.5:.95], AP50, AP75. area range = all, maxDets = 100) */
+/*   - KeypointEvaluator: COCO keypoint AP using OKS (person, 17 keypoints) */
+/*   - TrackingEvaluator: MOTA and IDF1 with MOT Challenge format ground truth */
+/*   - EvaluationReport: accuracy and latency of each configuration, and the Pareto frontier */
+/* The numbers are close to pycocotools / py-motmetrics, but not guaranteed to be identical */
+
+class DetectionEvaluator {
+public:
+    typedef struct Image_ {
+        int32_t     id;
+        std::string file_name;
+        int32_t     width;
+        int32_t     height;
+    } Image;
+
+    typedef struct Summary_ {
+        double  ap;         /* AP@[.5:.95] */
+        double  ap50;
+        double  ap75;
+        int32_t num_category;
+    } Summary;
+
+public:
+    int32_t LoadCocoAnnotation(const std::string& filename);    /* instances_xxx.json */
+    const std::vector<Image>& GetImageList() const { return image_list_; }
+    void ClearResult();
+    void AddResult(int32_t image_id, const std::vector<BoundingBox>& bbox_list);   /* bbox.label is matched to the category name */
+    Summary Evaluate() const;
+
+private:
+    typedef struct Object_ {
+        int32_t image_id;
+        int32_t category_id;
+        float   x, y, w, h;
+        float   score;
+        bool    is_crowd;
+    } Object;
+
+private:
+    std::vector<Image> image_list_;
+    std::map<std::string, int32_t> category_name2id_;
+    std::vector<Object> gt_list_;
+    std::vector<Object> det_list_;
+};
+
+
+class KeypointEvaluator {
+public:
+    static constexpr int32_t kNumKeypoint = 17;
+    typedef std::array<std::array<float, 3>, kNumKeypoint> KeypointList;    /* (x, y, score or visibility) */
+
+    typedef struct Summary_ {
+        double  ap;         /* OKS AP@[.5:.95] */
+        double  ap50;
+        double  ap75;
+    } Summary;
+
+public:
+    int32_t LoadCocoAnnotation(const std::string& filename);    /* person_keypoints_xxx.json */
+    const std::vector<DetectionEvaluator::Image>& GetImageList() const { return image_list_; }
+    void ClearResult();
+    void AddResult(int32_t image_id, const std::vector<KeypointList>& pose_list, const std::vector<float>& score_list);
+    Summary Evaluate() const;
+
+private:
+    typedef struct Pose_ {
+        int32_t      image_id;
+        KeypointList keypoint_list;
+        float        x, y, w, h;     /* bbox of gt is used to ignore detections when gt has no keypoints */
+        float        area;
+        float        score;
+        bool         is_ignore;
+    } Pose;
+
+private:
+    std::vector<DetectionEvaluator::Image> image_list_;
+    std::vector<Pose> gt_list_;
+    std::vector<Pose> det_list_;
+};
+
+
+class TrackingEvaluator {
+public:
+    typedef struct Object_ {
+        int32_t id;
+        float   x, y, w, h;
+    } Object;
+
+    typedef struct Summary_ {
+        double  mota;
+        double  idf1;
+        int32_t num_gt;
+        int32_t num_fp;
+        int32_t num_fn;
+        int32_t num_switch;
+    } Summary;
+
+public:
+    TrackingEvaluator(float threshold_iou = 0.5f);
+    int32_t LoadMotGroundTruth(const std::string& filename);   /* gt/gt.txt: frame,id,x,y,w,h,conf,class,visibility */
+    int32_t GetFrameNum() const { return frame_num_; }
+    void ClearResult();
+    void AddResult(int32_t frame, const std::vector<Object>& object_list);    /* frame starts from 1 */
+    Summary Evaluate() const;
+
+private:
+    float threshold_iou_;
+    int32_t frame_num_;
+    std::map<int32_t, std::vector<Object>> gt_list_;        /* key = frame */
+    std::map<int32_t, std::vector<Object>> ignore_list_;    /* distractors and conf = 0 */
+    std::map<int32_t, std::vector<Object>> det_list_;
+};
+
+
+class EvaluationReport {
+public:
+    typedef struct Row_ {
+        std::string config;
+        double      accuracy;
+        double      latency_mean;   /* [msec] */
+        double      latency_p50;
+        double      latency_p90;
+        double      fps;
+        bool        is_pareto;
+    } Row;
+
+public:
+    void Add(const std::string& config, double accuracy, const std::vector<double>& latency_list);
+    const std::vector<Row>& GetRowList();
+    void Print(const std::string& accuracy_name);
+    int32_t WriteCsv(const std::string& filename, const std::string& accuracy_name);
+
+private:
+    void UpdatePareto();
+
+private:
+    std::vector<Row> row_list_;
+};
+
+#endif
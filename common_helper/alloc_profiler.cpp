@@ -0,0 +1,277 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+
+/* for My modules */
+#include "common_helper.h"
+#include "alloc_profiler.h"
+
+/*** Macro ***/
+#define TAG "AllocProfiler"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+#if defined(ALLOC_PROFILER_ENABLED) && defined(__GLIBC__) && !defined(__ANDROID__)
+#define ALLOC_PROFILER_HOOK_MALLOC
+#endif
+
+static constexpr int32_t kMaxThread = 64;          /* threads beyond this share the last slot */
+static constexpr int32_t kMaxStageName = 32;
+
+/*** Global variable ***/
+/* Nothing here may allocate, because it's used inside the hooks. Static storage is zero initialized before any allocation */
+typedef struct CounterAtomic_ {
+    std::atomic<uint64_t> num_alloc;
+    std::atomic<uint64_t> size_alloc;
+    std::atomic<uint64_t> num_free;
+} CounterAtomic;
+
+static CounterAtomic s_counter_list[kMaxThread][AllocProfiler::kMaxStage];
+static std::atomic<int32_t> s_thread_num;
+static thread_local int32_t t_thread_index = -1;
+static thread_local int32_t t_stage_id = 0;
+
+static char s_stage_name_list[AllocProfiler::kMaxStage][kMaxStageName] = { "other" };
+static std::atomic<int32_t> s_stage_num(1);
+static std::mutex s_mutex_stage;
+
+/*** Function ***/
+static inline CounterAtomic& GetCounter()
+{
+    if (t_thread_index < 0) {
+        t_thread_index = (std::min)(s_thread_num.fetch_add(1, std::memory_order_relaxed), kMaxThread - 1);
+    }
+    return s_counter_list[t_thread_index][t_stage_id];
+}
+
+static inline void CountAlloc(size_t size)
+{
+    CounterAtomic& counter = GetCounter();
+    counter.num_alloc.fetch_add(1, std::memory_order_relaxed);
+    counter.size_alloc.fetch_add(size, std::memory_order_relaxed);
+}
+
+static inline void CountFree()
+{
+    GetCounter().num_free.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool AllocProfiler::IsEnabled()
+{
+#ifdef ALLOC_PROFILER_ENABLED
+    return true;
+#else
+    return false;
+#endif
+}
+
+int32_t AllocProfiler::RegisterStage(const char* name)
+{
+    std::lock_guard<std::mutex> lock(s_mutex_stage);
+    const int32_t stage_num = s_stage_num.load();
+    for (int32_t i = 0; i < stage_num; i++) {
+        if (strncmp(s_stage_name_list[i], name, kMaxStageName - 1) == 0) return i;
+    }
+    if (stage_num >= kMaxStage) {
+        PRINT_E("Too many stages. %s is counted as other\n", name);
+        return 0;
+    }
+    strncpy(s_stage_name_list[stage_num], name, kMaxStageName - 1);
+    s_stage_num.store(stage_num + 1);
+    return stage_num;
+}
+
+int32_t AllocProfiler::SetStage(int32_t stage_id)
+{
+    const int32_t stage_id_previous = t_stage_id;
+    t_stage_id = (stage_id >= 0 && stage_id < kMaxStage) ? stage_id : 0;
+    return stage_id_previous;
+}
+
+int32_t AllocProfiler::GetStageNum()
+{
+    return s_stage_num.load();
+}
+
+const char* AllocProfiler::GetStageName(int32_t stage_id)
+{
+    return (stage_id >= 0 && stage_id < GetStageNum()) ? s_stage_name_list[stage_id] : "";
+}
+
+void AllocProfiler::GetSnapshot(Snapshot& snapshot)
+{
+    const int32_t thread_num = (std::min)(s_thread_num.load(), kMaxThread);
+    for (int32_t stage_id = 0; stage_id < kMaxStage; stage_id++) {
+        Counter& counter = snapshot[stage_id];
+        counter.num_alloc = counter.size_alloc = counter.num_free = 0;
+        for (int32_t i = 0; i < thread_num; i++) {
+            counter.num_alloc += s_counter_list[i][stage_id].num_alloc.load(std::memory_order_relaxed);
+            counter.size_alloc += s_counter_list[i][stage_id].size_alloc.load(std::memory_order_relaxed);
+            counter.num_free += s_counter_list[i][stage_id].num_free.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void AllocProfiler::PrintPerFrame(const Snapshot& snapshot_start, const Snapshot& snapshot_end, int32_t num_frame)
+{
+    if (!IsEnabled()) {
+        printf("Allocation profiler is disabled (build with COMMON_HELPER_WITH_ALLOC_PROFILER=on)\n");
+        return;
+    }
+    if (num_frame <= 0) return;
+    printf("=== Heap allocation per frame ===\n");
+    printf("  %-16s %12s %14s %12s\n", "stage", "alloc", "bytes", "free");
+    for (int32_t stage_id = 0; stage_id < GetStageNum(); stage_id++) {
+        const Counter& start = snapshot_start[stage_id];
+        const Counter& end = snapshot_end[stage_id];
+        printf("  %-16s %12.1f %14.1f %12.1f\n", GetStageName(stage_id),
+            static_cast<double>(end.num_alloc - start.num_alloc) / num_frame,
+            static_cast<double>(end.size_alloc - start.size_alloc) / num_frame,
+            static_cast<double>(end.num_free - start.num_free) / num_frame);
+    }
+}
+
+
+/*** Hooks ***/
+#ifdef ALLOC_PROFILER_ENABLED
+#ifdef ALLOC_PROFILER_HOOK_MALLOC
+/* Replace malloc family in the executable (also catches allocations in shared libraries such as OpenCV) */
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size)
+{
+    CountAlloc(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size)
+{
+    CountAlloc(num * size);
+    return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    if (ptr) CountFree();
+    if (size > 0 || !ptr) CountAlloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    if (ptr) CountFree();
+    __libc_free(ptr);
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size)
+{
+    CountAlloc(size);
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) return ENOMEM;
+    *memptr = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    CountAlloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    CountAlloc(size);
+    return __libc_memalign(alignment, size);
+}
+}
+#define RAW_MALLOC(size) __libc_malloc(size)
+#define RAW_FREE(ptr)    __libc_free(ptr)
+#else
+#define RAW_MALLOC(size) std::malloc(size)
+#define RAW_FREE(ptr)    std::free(ptr)
+#endif
+
+/* operator new / delete don't go through the malloc hooks above, so that each allocation is counted once */
+void* operator new(std::size_t size)
+{
+    CountAlloc(size);
+    void* ptr = RAW_MALLOC(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    CountAlloc(size);
+    return RAW_MALLOC(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (!ptr) return;
+    CountFree();
+    RAW_FREE(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr);
+}
+#endif
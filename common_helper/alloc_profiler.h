@@ -0,0 +1,58 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef ALLOC_PROFILER_
+#define ALLOC_PROFILER_
+
+/* for general */
+#include <cstdint>
+#include <array>
+
+/* Heap allocation counter attributed to the current stage of each thread */
+/*   - the hooks (operator new / delete, and malloc family on glibc) are compiled only with COMMON_HELPER_WITH_ALLOC_PROFILER=on */
+/*   - without it, the API still works but all counters stay 0 (IsEnabled() == false) */
+/*   - counters are per thread and lock-free. GetSnapshot sums them over all threads */
+/*   - stage 0 is "other" (allocations outside of any stage) */
+class AllocProfiler {
+public:
+    static constexpr int32_t kMaxStage = 32;
+
+    typedef struct Counter_ {
+        uint64_t num_alloc;
+        uint64_t size_alloc;    /* [byte] requested size */
+        uint64_t num_free;
+    } Counter;
+    typedef std::array<Counter, kMaxStage> Snapshot;    /* cumulative from the start of the process */
+
+    /* Set the stage of the current thread while alive (nestable) */
+    class Scope {
+    public:
+        Scope(int32_t stage_id) : stage_id_previous_(SetStage(stage_id)) {}
+        ~Scope() { SetStage(stage_id_previous_); }
+    private:
+        int32_t stage_id_previous_;
+    };
+
+public:
+    static bool IsEnabled();
+    static int32_t RegisterStage(const char* name);     /* returns the same id for the same name. call once and cache it */
+    static int32_t SetStage(int32_t stage_id);          /* returns the previous stage */
+    static int32_t GetStageNum();
+    static const char* GetStageName(int32_t stage_id);
+
+    static void GetSnapshot(Snapshot& snapshot);
+    static void PrintPerFrame(const Snapshot& snapshot_start, const Snapshot& snapshot_end, int32_t num_frame);
+};
+
+#endif
@@ -0,0 +1,146 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef BATCH_SCHEDULER_
+#define BATCH_SCHEDULER_
+
+/* for general */
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+/* Collect requests from multiple streams (threads) and process them as one batch */
+/*   - Process blocks the caller until the batch including the request is processed */
+/*   - a batch is started when max_batch_size requests are collected, or the oldest request waits for max_wait_msec */
+/*   - batch_func receives inputs of up to max_batch_size requests and fills the same number of outputs */
+template <typename INPUT, typename OUTPUT>
+class BatchScheduler {
+public:
+    typedef std::function<int32_t(const std::vector<const INPUT*>& input_list, std::vector<OUTPUT*>& output_list)> BatchFunc;
+
+    typedef struct Stat_ {
+        double  time_wait;      /* [msec] from Process call to start of the batch */
+        int32_t batch_size;
+        Stat_() : time_wait(0), batch_size(0) {}
+    } Stat;
+
+public:
+    BatchScheduler(BatchFunc batch_func, int32_t max_batch_size = 4, double max_wait_msec = 5.0)
+    {
+        batch_func_ = batch_func;
+        max_batch_size_ = (std::max)(1, max_batch_size);
+        max_wait_msec_ = max_wait_msec;
+        is_thread_exit_ = false;
+        thread_ = std::thread(&BatchScheduler::ThreadMain, this);
+    }
+
+    ~BatchScheduler()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_thread_exit_ = true;
+        }
+        cv_request_.notify_all();
+        thread_.join();
+    }
+
+    int32_t Process(const INPUT& input, OUTPUT& output, Stat* stat = nullptr)
+    {
+        Request request;
+        request.input = &input;
+        request.output = &output;
+        request.time_request = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        request_queue_.push_back(&request);
+        cv_request_.notify_all();
+        cv_done_.wait(lock, [&request] { return request.is_done; });
+        if (stat) *stat = request.stat;
+        return request.ret;
+    }
+
+private:
+    typedef struct Request_ {
+        const INPUT* input;
+        OUTPUT*      output;
+        std::chrono::steady_clock::time_point time_request;
+        Stat         stat;
+        int32_t      ret;
+        bool         is_done;
+        Request_() : input(nullptr), output(nullptr), ret(0), is_done(false) {}
+    } Request;
+
+    void ThreadMain()
+    {
+        std::vector<Request*> batch;
+        std::vector<const INPUT*> input_list;
+        std::vector<OUTPUT*> output_list;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_request_.wait(lock, [this] { return !request_queue_.empty() || is_thread_exit_; });
+                if (is_thread_exit_ && request_queue_.empty()) break;
+
+                /* Wait for other streams until the batch is full or the oldest request expires */
+                const auto deadline = request_queue_.front()->time_request + std::chrono::microseconds(static_cast<int64_t>(max_wait_msec_ * 1000));
+                cv_request_.wait_until(lock, deadline, [this] { return static_cast<int32_t>(request_queue_.size()) >= max_batch_size_ || is_thread_exit_; });
+
+                batch.clear();
+                while (!request_queue_.empty() && static_cast<int32_t>(batch.size()) < max_batch_size_) {
+                    batch.push_back(request_queue_.front());
+                    request_queue_.pop_front();
+                }
+            }
+
+            const auto& time_start = std::chrono::steady_clock::now();
+            input_list.clear();
+            output_list.clear();
+            for (auto request : batch) {
+                input_list.push_back(request->input);
+                output_list.push_back(request->output);
+            }
+            int32_t ret = batch_func_(input_list, output_list);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (auto request : batch) {
+                    request->stat.time_wait = static_cast<std::chrono::duration<double>>(time_start - request->time_request).count() * 1000.0;
+                    request->stat.batch_size = static_cast<int32_t>(batch.size());
+                    request->ret = ret;
+                    request->is_done = true;
+                }
+            }
+            cv_done_.notify_all();
+        }
+    }
+
+private:
+    BatchFunc batch_func_;
+    int32_t max_batch_size_;
+    double max_wait_msec_;
+
+    std::deque<Request*> request_queue_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_request_;
+    std::condition_variable cv_done_;
+    bool is_thread_exit_;
+};
+
+#endif
@@ -0,0 +1,94 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef BUFFER_RING_
+#define BUFFER_RING_
+
+/* for general */
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+/* Fixed number of buffer sets (e.g. output tensors) rotated between invocations */
+/*   - Acquire returns a reference to a buffer which nobody refers to. The buffer is not reused while the reference (or its copy) is alive */
+/*   - buffers are visited in round robin, so the latest results stay valid as long as possible */
+/*   - returns nullptr when all buffers are referred to. Release old results, or create the ring with more buffers */
+/*   - the ring must outlive all references */
+template <typename T>
+class BufferRing {
+public:
+    typedef std::shared_ptr<T> Reference;
+
+public:
+    BufferRing() : index_next_(0) {}
+    ~BufferRing() {}
+
+    void Reset(int32_t num)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer_list_.clear();
+        for (int32_t i = 0; i < num; i++) {
+            buffer_list_.push_back(std::make_shared<T>());
+        }
+        index_next_ = 0;
+    }
+
+    int32_t GetNum() const
+    {
+        return static_cast<int32_t>(buffer_list_.size());
+    }
+
+    /* Access regardless of the reference count (e.g. for initialization) */
+    T& Get(int32_t index)
+    {
+        return *buffer_list_[index];
+    }
+
+    const T& Get(int32_t index) const
+    {
+        return *buffer_list_[index];
+    }
+
+    Reference Acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const int32_t num = GetNum();
+        for (int32_t i = 0; i < num; i++) {
+            const int32_t index = (index_next_ + i) % num;
+            if (buffer_list_[index].use_count() == 1) {
+                index_next_ = (index + 1) % num;
+                return buffer_list_[index];
+            }
+        }
+        return Reference();
+    }
+
+    int32_t GetNumInUse() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int32_t num_in_use = 0;
+        for (const auto& buffer : buffer_list_) {
+            if (buffer.use_count() > 1) num_in_use++;
+        }
+        return num_in_use;
+    }
+
+private:
+    std::vector<std::shared_ptr<T>> buffer_list_;   /* use_count() - 1 = number of references */
+    int32_t index_next_;
+    mutable std::mutex mutex_;
+};
+
+#endif
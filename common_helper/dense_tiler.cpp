@@ -0,0 +1,242 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "common_helper.h"
+#include "dense_tiler.h"
+
+/*** Macro ***/
+#define TAG "DenseTiler"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static constexpr double kScaleStep = 0.9;     /* working resolution is reduced by this until the number of tiles fits */
+
+
+/*** Function ***/
+DenseTiler::DenseTiler(int32_t tile_width, int32_t tile_height, int32_t overlap, int32_t max_tile_num, int32_t normalize_type)
+{
+    tile_width_ = tile_width;
+    tile_height_ = tile_height;
+    overlap_ = (std::max)(0, overlap);
+    max_tile_num_ = (std::max)(1, max_tile_num);
+    normalize_type_ = normalize_type;
+}
+
+DenseTiler::~DenseTiler()
+{
+}
+
+void DenseTiler::SetTileSize(int32_t tile_width, int32_t tile_height)
+{
+    tile_width_ = tile_width;
+    tile_height_ = tile_height;
+}
+
+static int32_t CountTile(int32_t length, int32_t tile, int32_t step)
+{
+    if (length <= tile) return 1;
+    return 1 + (length - tile + step - 1) / step;
+}
+
+static int32_t GetTilePosition(int32_t index, int32_t num, int32_t length, int32_t tile)
+{
+    /* spread tiles evenly. the first one starts at 0 and the last one ends at the edge */
+    if (num <= 1) return 0;
+    return static_cast<int32_t>(std::round(static_cast<double>(index) * (length - tile) / (num - 1)));
+}
+
+void DenseTiler::Plan(const cv::Size& original_size)
+{
+    const int32_t step_x = (std::max)(1, tile_width_ - overlap_);
+    const int32_t step_y = (std::max)(1, tile_height_ - overlap_);
+
+    /* the working image must be at least as large as a tile */
+    const double scale_min = (std::max)(static_cast<double>(tile_width_) / original_size.width, static_cast<double>(tile_height_) / original_size.height);
+    double scale = (std::max)(1.0, scale_min);
+    cv::Size size;
+    int32_t num_x = 1;
+    int32_t num_y = 1;
+    while (true) {
+        size.width = (std::max)(tile_width_, static_cast<int32_t>(std::round(original_size.width * scale)));
+        size.height = (std::max)(tile_height_, static_cast<int32_t>(std::round(original_size.height * scale)));
+        num_x = CountTile(size.width, tile_width_, step_x);
+        num_y = CountTile(size.height, tile_height_, step_y);
+        if (num_x * num_y <= max_tile_num_ || scale <= scale_min) break;
+        scale = (std::max)(scale_min, scale * kScaleStep);
+    }
+
+    working_size_ = size;
+    tile_list_.clear();
+    for (int32_t y = 0; y < num_y; y++) {
+        for (int32_t x = 0; x < num_x; x++) {
+            tile_list_.push_back(cv::Rect(GetTilePosition(x, num_x, size.width, tile_width_), GetTilePosition(y, num_y, size.height, tile_height_), tile_width_, tile_height_));
+        }
+    }
+}
+
+int32_t DenseTiler::RunTiles(const std::vector<TileFunc>& func_list)
+{
+    const int32_t tile_num = static_cast<int32_t>(tile_list_.size());
+    out_list_.resize(tile_num);
+    if (func_list.size() == 1) {
+        for (int32_t i = 0; i < tile_num; i++) {
+            if (func_list[0](working_mat_(tile_list_[i]), out_list_[i]) != 0) return kRetErr;
+        }
+        return kRetOk;
+    }
+
+    /* Each function (interpreter) takes the next tile */
+    std::atomic<int32_t> index_next(0);
+    std::atomic<bool> is_error(false);
+    std::vector<std::thread> thread_list;
+    for (const auto& func : func_list) {
+        thread_list.push_back(std::thread([&, func] {
+            for (int32_t i = index_next++; i < tile_num && !is_error; i = index_next++) {
+                if (func(working_mat_(tile_list_[i]), out_list_[i]) != 0) is_error = true;
+            }
+        }));
+    }
+    for (auto& thread : thread_list) thread.join();
+    return is_error ? kRetErr : kRetOk;
+}
+
+void DenseTiler::CreateWeight(const cv::Size& size)
+{
+    if (weight_.size() == size) return;
+    /* 1.0 in the center, linear ramp to the border in the overlap */
+    std::vector<float> weight_x(size.width), weight_y(size.height);
+    const float ramp = static_cast<float>(overlap_ + 1);
+    for (int32_t x = 0; x < size.width; x++) weight_x[x] = (std::min)(1.0f, ((std::min)(x, size.width - 1 - x) + 1) / ramp);
+    for (int32_t y = 0; y < size.height; y++) weight_y[y] = (std::min)(1.0f, ((std::min)(y, size.height - 1 - y) + 1) / ramp);
+    weight_.create(size, CV_32FC1);
+    for (int32_t y = 0; y < size.height; y++) {
+        float* p = weight_.ptr<float>(y);
+        for (int32_t x = 0; x < size.width; x++) p[x] = weight_x[x] * weight_y[y];
+    }
+}
+
+void DenseTiler::FitAffine(cv::Mat& out, const cv::Mat& reference) const
+{
+    /* reference = a * out + b for each channel (least squares) */
+    const int32_t channel = out.channels();
+    for (int32_t c = 0; c < channel; c++) {
+        double sum_o = 0, sum_r = 0, sum_oo = 0, sum_or = 0;
+        for (int32_t y = 0; y < out.rows; y++) {
+            const float* p_o = out.ptr<float>(y);
+            const float* p_r = reference.ptr<float>(y);
+            for (int32_t x = 0; x < out.cols; x++) {
+                const double o = p_o[x * channel + c];
+                const double r = p_r[x * channel + c];
+                sum_o += o;
+                sum_r += r;
+                sum_oo += o * o;
+                sum_or += o * r;
+            }
+        }
+        const double n = static_cast<double>(out.rows) * out.cols;
+        const double denominator = n * sum_oo - sum_o * sum_o;
+        const double a = (std::abs(denominator) > 1e-12) ? (n * sum_or - sum_o * sum_r) / denominator : 1.0;
+        const double b = (sum_r - a * sum_o) / n;
+        for (int32_t y = 0; y < out.rows; y++) {
+            float* p_o = out.ptr<float>(y);
+            for (int32_t x = 0; x < out.cols; x++) {
+                p_o[x * channel + c] = static_cast<float>(a * p_o[x * channel + c] + b);
+            }
+        }
+    }
+}
+
+int32_t DenseTiler::Process(const cv::Mat& original_mat, cv::Mat& dst, const std::vector<TileFunc>& func_list)
+{
+    if (original_mat.empty() || tile_width_ <= 0 || tile_height_ <= 0 || func_list.empty()) {
+        PRINT_E("Invalid parameter\n");
+        return kRetErr;
+    }
+
+    /*** Working image and tiles ***/
+    Plan(original_mat.size());
+    if (working_size_ == original_mat.size()) {
+        working_mat_ = original_mat;
+    } else {
+        const int32_t interpolation = (working_size_.width < original_mat.cols) ? cv::INTER_AREA : cv::INTER_LINEAR;
+        cv::resize(original_mat, working_mat_, working_size_, 0, 0, interpolation);
+    }
+
+    /*** Reference for normalization (the whole image in one tile) ***/
+    if (normalize_type_ == kNormalizeAffine) {
+        cv::Mat tile_whole;
+        cv::resize(original_mat, tile_whole, cv::Size(tile_width_, tile_height_), 0, 0, cv::INTER_AREA);
+        cv::Mat out_whole;
+        if (func_list[0](tile_whole, out_whole) != 0) return kRetErr;
+        out_whole.convertTo(out_whole, CV_32F);
+        cv::resize(out_whole, reference_, working_size_, 0, 0, cv::INTER_LINEAR);
+    }
+
+    /*** Inference for each tile ***/
+    if (RunTiles(func_list) != kRetOk) return kRetErr;
+
+    /*** Blend ***/
+    const int32_t channel = out_list_[0].channels();
+    const cv::Size tile_size(tile_width_, tile_height_);
+    CreateWeight(tile_size);
+    dst = cv::Mat::zeros(working_size_, CV_32FC(channel));
+    weight_sum_ = cv::Mat::zeros(working_size_, CV_32FC1);
+    for (size_t i = 0; i < tile_list_.size(); i++) {
+        cv::Mat& out = out_list_[i];
+        if (out.channels() != channel) {
+            PRINT_E("Output channel is different between tiles\n");
+            return kRetErr;
+        }
+        out.convertTo(out, CV_32F);
+        if (out.size() != tile_size) cv::resize(out, out, tile_size, 0, 0, cv::INTER_LINEAR);
+        const cv::Rect& rect = tile_list_[i];
+        if (normalize_type_ == kNormalizeAffine) FitAffine(out, reference_(rect));
+
+        for (int32_t y = 0; y < rect.height; y++) {
+            const float* p_out = out.ptr<float>(y);
+            const float* p_weight = weight_.ptr<float>(y);
+            float* p_dst = dst.ptr<float>(rect.y + y) + rect.x * channel;
+            float* p_weight_sum = weight_sum_.ptr<float>(rect.y + y) + rect.x;
+            for (int32_t x = 0; x < rect.width; x++) {
+                const float weight = p_weight[x];
+                for (int32_t c = 0; c < channel; c++) {
+                    p_dst[x * channel + c] += p_out[x * channel + c] * weight;
+                }
+                p_weight_sum[x] += weight;
+            }
+        }
+    }
+    for (int32_t y = 0; y < dst.rows; y++) {
+        float* p_dst = dst.ptr<float>(y);
+        const float* p_weight_sum = weight_sum_.ptr<float>(y);
+        for (int32_t x = 0; x < dst.cols; x++) {
+            const float weight_inv = 1.0f / p_weight_sum[x];    /* always > 0 because all pixels are covered */
+            for (int32_t c = 0; c < channel; c++) p_dst[x * channel + c] *= weight_inv;
+        }
+    }
+    return kRetOk;
+}
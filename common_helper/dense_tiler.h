@@ -0,0 +1,81 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef DENSE_TILER_
+#define DENSE_TILER_
+
+/* for general */
+#include <cstdint>
+#include <vector>
+#include <functional>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* Dense prediction (edge, depth, segmentation) in high resolution with overlapping model-sized tiles */
+/*   - the image is covered with tiles of the model input size. The working resolution is the original one, */
+/*     but it's reduced so that the number of tiles doesn't exceed max_tile_num (work is linear in the number of tiles) */
+/*   - outputs of tiles are blended with feathered weights (linear ramp in the overlap) */
+/*   - kNormalizeAffine: for outputs which have unknown scale and shift for each inference (e.g. relative depth). */
+/*     the whole image is inferred once as reference, and each tile is fitted to it by least squares before blending */
+class DenseTiler {
+public:
+    enum {
+        kRetOk = 0,
+        kRetErr = -1,
+    };
+
+    enum {
+        kNormalizeNone = 0,
+        kNormalizeAffine,
+    };
+
+    /* Run the model for one tile. tile: CV_8UC3 in the model input size (the same color order as the original image) */
+    /* out: CV_32FC(n) in any size (resized to the tile). Must not refer to the tensor memory */
+    typedef std::function<int32_t(const cv::Mat& tile, cv::Mat& out)> TileFunc;
+
+public:
+    DenseTiler(int32_t tile_width = 0, int32_t tile_height = 0, int32_t overlap = 32, int32_t max_tile_num = 16, int32_t normalize_type = kNormalizeNone);
+    ~DenseTiler();
+    void SetTileSize(int32_t tile_width, int32_t tile_height);
+
+    /* dst: CV_32FC(n) in the working resolution (the same aspect ratio as original_mat) */
+    /* func_list: one function for each interpreter. Tiles are processed in parallel when more than one is given */
+    int32_t Process(const cv::Mat& original_mat, cv::Mat& dst, const std::vector<TileFunc>& func_list);
+    int32_t GetTileNum() const { return static_cast<int32_t>(tile_list_.size()); }     /* of the last Process */
+
+private:
+    void Plan(const cv::Size& original_size);
+    int32_t RunTiles(const std::vector<TileFunc>& func_list);
+    void CreateWeight(const cv::Size& size);
+    void FitAffine(cv::Mat& out, const cv::Mat& reference) const;
+
+private:
+    int32_t tile_width_;
+    int32_t tile_height_;
+    int32_t overlap_;
+    int32_t max_tile_num_;
+    int32_t normalize_type_;
+
+    /* work buffers (reused across frames) */
+    cv::Size working_size_;
+    std::vector<cv::Rect> tile_list_;
+    cv::Mat working_mat_;
+    std::vector<cv::Mat> out_list_;
+    cv::Mat weight_;            /* CV_32FC1, tile size */
+    cv::Mat weight_sum_;        /* CV_32FC1, working size */
+    cv::Mat reference_;         /* CV_32FC(n), working size */
+};
+
+#endif
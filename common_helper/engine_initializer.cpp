@@ -0,0 +1,53 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <future>
+
+/* for My modules */
+#include "common_helper.h"
+#include "engine_initializer.h"
+
+/*** Macro ***/
+#define TAG "EngineInitializer"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+
+/*** Function ***/
+std::future<bool> CommonHelper::InitializeEngineAsync(const std::string& name, bool is_warm_up, std::function<int32_t()> initialize, std::function<int32_t()> warm_up)
+{
+    return std::async(std::launch::async, [name, is_warm_up, initialize, warm_up]() {
+        const auto& t0 = std::chrono::steady_clock::now();
+        if (initialize() != 0) {
+            PRINT_E("%s: failed to initialize\n", name.c_str());
+            return false;
+        }
+        const auto& t1 = std::chrono::steady_clock::now();
+        if (is_warm_up && warm_up() != 0) {
+            PRINT_E("%s: failed to warm up\n", name.c_str());
+            return false;
+        }
+        const auto& t2 = std::chrono::steady_clock::now();
+        PRINT("%s: initialize = %.3lf [msec], warm up = %.3lf [msec]\n", name.c_str(),
+            static_cast<std::chrono::duration<double>>(t1 - t0).count() * 1000.0, static_cast<std::chrono::duration<double>>(t2 - t1).count() * 1000.0);
+        return true;
+    });
+}
@@ -0,0 +1,33 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef ENGINE_INITIALIZER_
+#define ENGINE_INITIALIZER_
+
+/* for general */
+#include <cstdint>
+#include <string>
+#include <functional>
+#include <future>
+
+namespace CommonHelper
+{
+/* Initialize an engine in another thread so that engines are initialized concurrently */
+/*   - initialize and warm_up return 0 on success (kRetOk of engines). The future returns false when either fails */
+/*   - warm_up runs inference once so that the first frame costs the same as others (only when is_warm_up is true) */
+/*   - times of both are printed with name */
+std::future<bool> InitializeEngineAsync(const std::string& name, bool is_warm_up, std::function<int32_t()> initialize, std::function<int32_t()> warm_up);
+}
+
+#endif
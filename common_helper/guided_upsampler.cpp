@@ -0,0 +1,121 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "guided_upsampler.h"
+
+/*** Macro ***/
+static constexpr int32_t kMaxChannel = 4;
+
+
+GuidedUpsampler::GuidedUpsampler(int32_t radius, float eps)
+{
+    radius_ = radius;
+    eps_ = eps;
+}
+
+GuidedUpsampler::~GuidedUpsampler()
+{
+}
+
+void GuidedUpsampler::Process(const cv::Mat& guide, const cv::Mat& src, cv::Mat& dst)
+{
+    const int32_t channel = src.channels();
+    if (guide.empty() || src.empty() || channel > kMaxChannel) {
+        dst = cv::Mat();
+        return;
+    }
+
+    /* Guide in full resolution and low resolution ([0, 1]) */
+    if (guide.channels() == 3) {
+#ifdef CV_COLOR_IS_RGB
+        cv::cvtColor(guide, guide_gray_, cv::COLOR_RGB2GRAY);
+#else
+        cv::cvtColor(guide, guide_gray_, cv::COLOR_BGR2GRAY);
+#endif
+    } else {
+        guide_gray_ = guide;
+    }
+    cv::resize(guide_gray_, guide_low_, src.size(), 0, 0, cv::INTER_AREA);
+    guide_low_.convertTo(guide_low_, CV_32FC1, 1.0 / 255);
+    src.convertTo(src_low_, CV_32FC(channel), 1.0 / 255);
+
+    /* Coefficients in low resolution: a = cov(I, p) / (var(I) + eps), b = mean(p) - a * mean(I) */
+    const cv::Size ksize(radius_ * 2 + 1, radius_ * 2 + 1);
+    cv::Mat mean_i, mean_ii;
+    cv::boxFilter(guide_low_, mean_i, CV_32F, ksize);
+    cv::boxFilter(guide_low_.mul(guide_low_), mean_ii, CV_32F, ksize);
+    std::vector<cv::Mat> guide_list(channel, guide_low_);
+    cv::Mat guide_low_multi;
+    cv::merge(guide_list, guide_low_multi);
+    cv::Mat mean_p, mean_ip;
+    cv::boxFilter(src_low_, mean_p, CV_32F, ksize);
+    cv::boxFilter(guide_low_multi.mul(src_low_), mean_ip, CV_32F, ksize);
+
+    coef_a_.create(src.size(), CV_32FC(channel));
+    coef_b_.create(src.size(), CV_32FC(channel));
+    for (int32_t y = 0; y < src.rows; y++) {
+        const float* p_mean_i = mean_i.ptr<float>(y);
+        const float* p_mean_ii = mean_ii.ptr<float>(y);
+        const float* p_mean_p = mean_p.ptr<float>(y);
+        const float* p_mean_ip = mean_ip.ptr<float>(y);
+        float* p_a = coef_a_.ptr<float>(y);
+        float* p_b = coef_b_.ptr<float>(y);
+        for (int32_t x = 0; x < src.cols; x++) {
+            const float var_i = p_mean_ii[x] - p_mean_i[x] * p_mean_i[x];
+            for (int32_t c = 0; c < channel; c++) {
+                const int32_t index = x * channel + c;
+                const float cov_ip = p_mean_ip[index] - p_mean_i[x] * p_mean_p[index];
+                p_a[index] = cov_ip / (var_i + eps_);
+                p_b[index] = p_mean_p[index] - p_a[index] * p_mean_i[x];
+            }
+        }
+    }
+    cv::boxFilter(coef_a_, coef_a_, CV_32F, ksize);
+    cv::boxFilter(coef_b_, coef_b_, CV_32F, ksize);
+
+    /* Upsample only the coefficients, then q = a * I + b in full resolution */
+    cv::resize(coef_a_, coef_a_up_, guide.size(), 0, 0, cv::INTER_LINEAR);
+    cv::resize(coef_b_, coef_b_up_, guide.size(), 0, 0, cv::INTER_LINEAR);
+    dst.create(guide.size(), CV_8UC(channel));
+    const cv::Mat& guide_gray = guide_gray_;
+    const cv::Mat& coef_a_up = coef_a_up_;
+    const cv::Mat& coef_b_up = coef_b_up_;
+    const int32_t width = guide.cols;
+    cv::parallel_for_(cv::Range(0, guide.rows), [&](const cv::Range& range) {
+        for (int32_t y = range.start; y < range.end; y++) {
+            const uint8_t* p_i = guide_gray.ptr<uint8_t>(y);
+            const float* p_a = coef_a_up.ptr<float>(y);
+            const float* p_b = coef_b_up.ptr<float>(y);
+            uint8_t* p_dst = dst.ptr<uint8_t>(y);
+            for (int32_t x = 0; x < width; x++) {
+                const float i = p_i[x];
+                for (int32_t c = 0; c < channel; c++) {
+                    const int32_t index = x * channel + c;
+                    const float q = p_a[index] * i + p_b[index] * 255.0f;
+                    p_dst[index] = static_cast<uint8_t>((std::min)(255.0f, (std::max)(0.0f, q + 0.5f)));
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,50 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef GUIDED_UPSAMPLER_
+#define GUIDED_UPSAMPLER_
+
+/* for general */
+#include <cstdint>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* Edge-aware upsampling of a low resolution result using the full resolution image as guide (Fast Guided Filter) */
+/*   - the linear coefficients (q = a * I + b) are computed in the low resolution, and only they are upsampled */
+/*   - the guide is the gray scale of the full resolution image. each channel of src has its own coefficients */
+/*   - the last step (a * I + b in full resolution) is done in one pass with multiple threads */
+class GuidedUpsampler {
+public:
+    GuidedUpsampler(int32_t radius = 4, float eps = 1e-3f);   /* radius is in the low resolution */
+    ~GuidedUpsampler();
+
+    /* guide: CV_8UC3 (BGR) or CV_8UC1 in full resolution. src: CV_8UC3 or CV_8UC1 in low resolution. dst: the same size as guide and the same type as src */
+    void Process(const cv::Mat& guide, const cv::Mat& src, cv::Mat& dst);
+
+private:
+    int32_t radius_;
+    float eps_;
+
+    /* work buffers (reused across frames) */
+    cv::Mat guide_gray_;
+    cv::Mat guide_low_;
+    cv::Mat src_low_;
+    cv::Mat coef_a_;
+    cv::Mat coef_b_;
+    cv::Mat coef_a_up_;
+    cv::Mat coef_b_up_;
+};
+
+#endif
@@ -0,0 +1,135 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "common_helper.h"
+#include "head_pose_estimator.h"
+
+/*** Macro ***/
+#define TAG "HeadPoseEstimator"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static constexpr float kRadToDeg = static_cast<float>(180.0 / CV_PI);
+
+
+/*** Function ***/
+HeadPoseEstimator::HeadPoseEstimator(int32_t keypoint_type, float fov)
+{
+    keypoint_type_ = keypoint_type;
+    fov_ = fov;
+
+    /* Canonical face [mm]. x = right (in the image), y = down, z = backward (away from the camera) */
+    if (keypoint_type_ == kKeypointFaceMesh) {
+        /* ref: https://learnopencv.com/head-pose-estimation-using-opencv-and-dlib/ (scaled to mm) */
+        keypoint_index_list_ = { 1, 152, 33, 263, 61, 291 };
+        model_point_list_ = {
+            cv::Point3f(  0.0f,   0.0f, -14.0f),    /* nose tip */
+            cv::Point3f(  0.0f,  66.0f,  -1.0f),    /* chin */
+            cv::Point3f(-45.0f, -34.0f,  13.0f),    /* right eye outer corner */
+            cv::Point3f( 45.0f, -34.0f,  13.0f),    /* left eye outer corner */
+            cv::Point3f(-30.0f,  30.0f,  11.0f),    /* mouth right corner */
+            cv::Point3f( 30.0f,  30.0f,  11.0f),    /* mouth left corner */
+        };
+    } else {
+        keypoint_index_list_ = { 0, 1, 2, 3, 4, 5 };
+        model_point_list_ = {
+            cv::Point3f(-32.0f,   0.0f,   0.0f),    /* right eye */
+            cv::Point3f( 32.0f,   0.0f,   0.0f),    /* left eye */
+            cv::Point3f(  0.0f,  35.0f, -30.0f),    /* nose tip */
+            cv::Point3f(  0.0f,  70.0f, -15.0f),    /* mouth center */
+            cv::Point3f(-75.0f,  20.0f,  80.0f),    /* right ear tragion */
+            cv::Point3f( 75.0f,  20.0f,  80.0f),    /* left ear tragion */
+        };
+    }
+    dist_coeffs_ = cv::Mat::zeros(4, 1, CV_64FC1);
+}
+
+HeadPoseEstimator::~HeadPoseEstimator()
+{
+}
+
+void HeadPoseEstimator::UpdateCameraMatrix(const cv::Size& image_size)
+{
+    if (image_size == image_size_ && !camera_matrix_.empty()) return;
+    image_size_ = image_size;
+    const double fov = fov_ * CV_PI / 180.0;
+    const double fx = (image_size.width / 2) / std::tan(fov / 2);
+    const double fy = (image_size.height / 2) / std::tan(fov / 2);
+    camera_matrix_ = (cv::Mat_<double>(3, 3) << fx, 0, image_size.width / 2, 0, fy, image_size.height / 2, 0, 0, 1);
+}
+
+int32_t HeadPoseEstimator::Estimate(const cv::Size& image_size, const std::vector<cv::Point2f>& keypoint_list, Result& result)
+{
+    image_point_list_.clear();
+    for (const auto& index : keypoint_index_list_) {
+        if (index >= static_cast<int32_t>(keypoint_list.size())) {
+            PRINT_E("Invalid number of keypoints (%d)\n", static_cast<int32_t>(keypoint_list.size()));
+            return kRetErr;
+        }
+        image_point_list_.push_back(keypoint_list[index]);
+    }
+    UpdateCameraMatrix(image_size);
+
+    cv::Mat rvec, tvec;
+    if (!cv::solvePnP(model_point_list_, image_point_list_, camera_matrix_, dist_coeffs_, rvec, tvec, false, cv::SOLVEPNP_ITERATIVE)) {
+        return kRetErr;
+    }
+    if (tvec.at<double>(2) <= 0) {
+        return kRetErr;     /* behind the camera */
+    }
+
+    /* Fitting error normalized by the face size so that the threshold doesn't depend on the distance */
+    std::vector<cv::Point2f> projected_point_list;
+    cv::projectPoints(model_point_list_, rvec, tvec, camera_matrix_, dist_coeffs_, projected_point_list);
+    double error2 = 0;
+    for (size_t i = 0; i < image_point_list_.size(); i++) {
+        const cv::Point2f d = projected_point_list[i] - image_point_list_[i];
+        error2 += d.dot(d);
+    }
+    const cv::Rect face_rect = cv::boundingRect(image_point_list_);
+    const float face_size = static_cast<float>((std::max)(1, (std::max)(face_rect.width, face_rect.height)));
+    result.error = static_cast<float>(std::sqrt(error2 / image_point_list_.size())) / face_size;
+
+    cv::Mat rotation;
+    cv::Rodrigues(rvec, rotation);
+    rotation.convertTo(rotation, CV_32F);
+    result.rotation = cv::Matx33f(rotation.ptr<float>());
+    result.translation = cv::Vec3f(static_cast<float>(tvec.at<double>(0)), static_cast<float>(tvec.at<double>(1)), static_cast<float>(tvec.at<double>(2)));
+
+    /* rotation = Rz(roll) * Ry(-yaw) * Rx(pitch) */
+    const cv::Matx33f& r = result.rotation;
+    result.yaw = std::asin((std::max)(-1.0f, (std::min)(1.0f, r(2, 0)))) * kRadToDeg;
+    result.pitch = std::atan2(r(2, 1), r(2, 2)) * kRadToDeg;
+    result.roll = std::atan2(r(1, 0), r(0, 0)) * kRadToDeg;
+    return kRetOk;
+}
+
+void HeadPoseEstimator::GetEulerXyz(const cv::Matx33f& rotation, float& yaw, float& pitch, float& roll)
+{
+    /* rotation = Rx(-pitch) * Ry(yaw) * Rz(roll) */
+    yaw = std::asin((std::max)(-1.0f, (std::min)(1.0f, rotation(0, 2)))) * kRadToDeg;
+    pitch = -std::atan2(-rotation(1, 2), rotation(2, 2)) * kRadToDeg;
+    roll = std::atan2(-rotation(0, 1), rotation(0, 0)) * kRadToDeg;
+}
@@ -0,0 +1,75 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef HEAD_POSE_ESTIMATOR_
+#define HEAD_POSE_ESTIMATOR_
+
+/* for general */
+#include <cstdint>
+#include <vector>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* Geometric head pose from face keypoints (no inference) */
+/*   - keypoints are fitted to a canonical 3D face model with solvePnP. It takes microseconds per face */
+/*   - the camera matrix is created from the image size and the field of view, and cached until the size changes */
+/*   - error (reprojection error / face size) tells how much the keypoints agree with the model. */
+/*     it gets large for profile faces (occluded keypoints), where a head pose network should refine the result */
+class HeadPoseEstimator {
+public:
+    enum {
+        kRetOk = 0,
+        kRetErr = -1,
+    };
+
+    enum {
+        kKeypointBlazeFace = 0,     /* 6 points: right eye, left eye, nose tip, mouth center, right ear tragion, left ear tragion */
+        kKeypointFaceMesh,          /* 468 points of MediaPipe FaceMesh */
+    };
+
+    typedef struct Result_ {
+        cv::Matx33f rotation;       /* face to camera. face: x = right (in the image), y = down, z = backward. identity for a frontal face */
+        cv::Vec3f   translation;    /* in the unit of the model (about mm) */
+        float       yaw;            /* [deg] rotation = Rz(roll) * Ry(-yaw) * Rx(pitch). the same as head-pose-estimation-adas-0001 */
+        float       pitch;          /* [deg] */
+        float       roll;           /* [deg] */
+        float       error;          /* RMS reprojection error / face size */
+        Result_() : rotation(cv::Matx33f::eye()), yaw(0), pitch(0), roll(0), error(0)
+        {}
+    } Result;
+
+public:
+    HeadPoseEstimator(int32_t keypoint_type = kKeypointBlazeFace, float fov = 80.0f);
+    ~HeadPoseEstimator();
+    int32_t Estimate(const cv::Size& image_size, const std::vector<cv::Point2f>& keypoint_list, Result& result);
+
+    /* angles for rotation = Rx(-pitch) * Ry(yaw) * Rz(roll) (e.g. WHENet, HopeNet) */
+    static void GetEulerXyz(const cv::Matx33f& rotation, float& yaw, float& pitch, float& roll);
+
+private:
+    void UpdateCameraMatrix(const cv::Size& image_size);
+
+private:
+    int32_t keypoint_type_;
+    float fov_;
+    std::vector<cv::Point3f> model_point_list_;
+    std::vector<int32_t> keypoint_index_list_;      /* index in the keypoint list for each model point */
+    cv::Size image_size_;
+    cv::Mat camera_matrix_;
+    cv::Mat dist_coeffs_;
+    std::vector<cv::Point2f> image_point_list_;     /* work buffer */
+};
+
+#endif
@@ -0,0 +1,301 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+
+/* for Tensorflow Lite */
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+
+/* for My modules */
+#include "common_helper.h"
+#include "inference_helper_tensorflow_lite_xnnpack_cache.h"
+
+/*** Macro ***/
+#define TAG "InferenceHelperTensorflowLiteXnnpackCache"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+/* TfLiteXNNPackDelegateOptions::weight_cache_file_path is available from TensorFlow Lite 2.17 */
+#if (TF_MAJOR_VERSION < 2) || (TF_MAJOR_VERSION == 2 && TF_MINOR_VERSION < 17)
+#error "XNNPACK weight cache needs TensorFlow Lite 2.17 or later. Update InferenceHelper or set COMMON_HELPER_WITH_XNNPACK_WEIGHT_CACHE=off"
+#endif
+
+#ifndef XNNPACK_WEIGHT_CACHE_LIBRARY_VERSION
+#define XNNPACK_WEIGHT_CACHE_LIBRARY_VERSION "unknown"
+#endif
+static const std::string kLibraryVersion = std::string(TF_VERSION_STRING) + "-" + XNNPACK_WEIGHT_CACHE_LIBRARY_VERSION;
+
+
+/*** Function ***/
+static int32_t ConvertTensorType(TfLiteType type)
+{
+    switch (type) {
+    case kTfLiteFloat32: return TensorInfo::kTensorTypeFp32;
+    case kTfLiteUInt8:   return TensorInfo::kTensorTypeUint8;
+    case kTfLiteInt8:    return TensorInfo::kTensorTypeInt8;
+    case kTfLiteInt32:   return TensorInfo::kTensorTypeInt32;
+    case kTfLiteInt64:   return TensorInfo::kTensorTypeInt64;
+    default:             return TensorInfo::kTensorTypeNone;
+    }
+}
+
+static std::vector<int32_t> GetTensorDims(const TfLiteTensor* tensor)
+{
+    return std::vector<int32_t>(tensor->dims->data, tensor->dims->data + tensor->dims->size);
+}
+
+
+InferenceHelperTensorflowLiteXnnpackCache::InferenceHelperTensorflowLiteXnnpackCache()
+{
+    num_threads_ = 1;
+    delegate_ = nullptr;
+}
+
+InferenceHelperTensorflowLiteXnnpackCache::~InferenceHelperTensorflowLiteXnnpackCache()
+{
+    Finalize();
+}
+
+int32_t InferenceHelperTensorflowLiteXnnpackCache::SetNumThreads(const int32_t num_threads)
+{
+    num_threads_ = num_threads;
+    return kRetOk;
+}
+
+int32_t InferenceHelperTensorflowLiteXnnpackCache::SetCustomOps(const std::vector<std::pair<const char*, const void*>>& custom_ops)
+{
+    custom_ops_ = custom_ops;
+    return kRetOk;
+}
+
+int32_t InferenceHelperTensorflowLiteXnnpackCache::Initialize(const std::string& model_filename, std::vector<InputTensorInfo>& input_tensor_info_list, std::vector<OutputTensorInfo>& output_tensor_info_list)
+{
+    /*** Create interpreter ***/
+    if (!model_file_.Open(model_filename)) {
+        PRINT_E("Failed to open model (%s)\n", model_filename.c_str());
+        return kRetErr;
+    }
+    model_ = tflite::FlatBufferModel::BuildFromBuffer(reinterpret_cast<const char*>(model_file_.GetData()), model_file_.GetSize());
+    if (!model_) {
+        PRINT_E("Failed to build model (%s)\n", model_filename.c_str());
+        Finalize();
+        return kRetErr;
+    }
+    resolver_.reset(new tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates());
+    for (const auto& custom_op : custom_ops_) {
+        resolver_->AddCustom(custom_op.first, static_cast<const TfLiteRegistration*>(custom_op.second));
+    }
+    tflite::InterpreterBuilder builder(*model_, *resolver_);
+    builder(&interpreter_);
+    if (!interpreter_) {
+        PRINT_E("Failed to build interpreter (%s)\n", model_filename.c_str());
+        Finalize();
+        return kRetErr;
+    }
+    interpreter_->SetNumThreads(num_threads_);
+
+    for (auto& input_tensor_info : input_tensor_info_list) {
+        if (SetInputTensorInfo(input_tensor_info) != kRetOk) {
+            Finalize();
+            return kRetErr;
+        }
+    }
+
+    /*** Create XNNPACK delegate with the weight cache ***/
+    TfLiteXNNPackDelegateOptions options = TfLiteXNNPackDelegateOptionsDefault();
+    options.num_threads = num_threads_;
+    if (weight_cache_.Prepare(model_file_, kLibraryVersion)) {
+        options.weight_cache_file_path = weight_cache_.GetFilename().c_str();
+    }
+    delegate_ = TfLiteXNNPackDelegateCreate(&options);
+    if (!delegate_ || interpreter_->ModifyGraphWithDelegate(delegate_) != kTfLiteOk) {
+        PRINT_E("Failed to apply XNNPACK delegate\n");
+        Finalize();
+        return kRetErr;
+    }
+    if (interpreter_->AllocateTensors() != kTfLiteOk) {
+        PRINT_E("Failed to allocate tensors\n");
+        Finalize();
+        return kRetErr;
+    }
+
+    /*** Update tensor info ***/
+    for (auto& input_tensor_info : input_tensor_info_list) {
+        input_tensor_info.tensor_dims = GetTensorDims(interpreter_->tensor(input_tensor_info.id));
+    }
+    for (auto& output_tensor_info : output_tensor_info_list) {
+        if (SetOutputTensorInfo(output_tensor_info) != kRetOk) {
+            Finalize();
+            return kRetErr;
+        }
+    }
+
+    /* XNNPACK packs the weights and finalizes the cache file while the delegate is applied */
+    /* Commit here so that another interpreter of the same model (e.g. RVM output buffers) reuses it */
+    weight_cache_.Commit();
+
+    return kRetOk;
+}
+
+int32_t InferenceHelperTensorflowLiteXnnpackCache::Finalize(void)
+{
+    /* the interpreter must be deleted before the delegate */
+    interpreter_.reset();
+    if (delegate_) {
+        TfLiteXNNPackDelegateDelete(delegate_);
+        delegate_ = nullptr;
+    }
+    resolver_.reset();
+    model_.reset();
+    model_file_.Close();
+    return kRetOk;
+}
+
+int32_t InferenceHelperTensorflowLiteXnnpackCache::PreProcess(const std::vector<InputTensorInfo>& input_tensor_info_list)
+{
+    if (!interpreter_) {
+        PRINT_E("Interpreter is not created\n");
+        return kRetErr;
+    }
+    for (const auto& input_tensor_info : input_tensor_info_list) {
+        const TfLiteTensor* tensor = interpreter_->tensor(input_tensor_info.id);
+        if (input_tensor_info.data_type == InputTensorInfo::kDataTypeImage) {
+            const auto& image_info = input_tensor_info.image_info;
+            if ((image_info.crop_x != 0) || (image_info.crop_y != 0) || (image_info.crop_width != image_info.width) || (image_info.crop_height != image_info.height)) {
+                PRINT_E("Crop is not supported\n");
+                return kRetErr;
+            }
+            if ((image_info.width != input_tensor_info.GetWidth()) || (image_info.height != input_tensor_info.GetHeight())) {
+                PRINT_E("Resize is not supported\n");
+                return kRetErr;
+            }
+            if ((image_info.channel != input_tensor_info.GetChannel()) || (image_info.channel > 3) || input_tensor_info.is_nchw) {
+                PRINT_E("Image format is not supported\n");
+                return kRetErr;
+            }
+            const uint8_t* src = static_cast<const uint8_t*>(input_tensor_info.data);
+            const int32_t channel = image_info.channel;
+            const int32_t element_num = image_info.width * image_info.height * channel;
+            if (input_tensor_info.tensor_type == TensorInfo::kTensorTypeFp32) {
+                /* dst = (src / 255 - mean) / norm */
+                float mean[3];
+                float scale[3];
+                int32_t src_offset[3];
+                for (int32_t c = 0; c < channel; c++) {
+                    mean[c] = input_tensor_info.normalize.mean[c] * 255.0f;
+                    scale[c] = 1.0f / (input_tensor_info.normalize.norm[c] * 255.0f);
+                    src_offset[c] = (image_info.swap_color && channel == 3) ? 2 - c : c;
+                }
+                float* dst = interpreter_->typed_tensor<float>(input_tensor_info.id);
+                for (int32_t i = 0; i < element_num; i += channel) {
+                    for (int32_t c = 0; c < channel; c++) {
+                        dst[i + c] = (src[i + src_offset[c]] - mean[c]) * scale[c];
+                    }
+                }
+            } else if (input_tensor_info.tensor_type == TensorInfo::kTensorTypeUint8) {
+                memcpy(interpreter_->typed_tensor<uint8_t>(input_tensor_info.id), src, element_num);
+            } else if (input_tensor_info.tensor_type == TensorInfo::kTensorTypeInt8) {
+                int8_t* dst = interpreter_->typed_tensor<int8_t>(input_tensor_info.id);
+                for (int32_t i = 0; i < element_num; i++) {
+                    dst[i] = static_cast<int8_t>(src[i] - 128);
+                }
+            } else {
+                PRINT_E("Unsupported tensor type (%d)\n", input_tensor_info.tensor_type);
+                return kRetErr;
+            }
+        } else if ((input_tensor_info.data_type == InputTensorInfo::kDataTypeBlobNhwc) || (input_tensor_info.data_type == InputTensorInfo::kDataTypeBlobNchw)) {
+            memcpy(tensor->data.raw, input_tensor_info.data, tensor->bytes);
+        } else {
+            PRINT_E("Unsupported data type (%d)\n", input_tensor_info.data_type);
+            return kRetErr;
+        }
+    }
+    return kRetOk;
+}
+
+int32_t InferenceHelperTensorflowLiteXnnpackCache::Process(std::vector<OutputTensorInfo>& output_tensor_info_list)
+{
+    if (!interpreter_) {
+        PRINT_E("Interpreter is not created\n");
+        return kRetErr;
+    }
+    if (interpreter_->Invoke() != kTfLiteOk) {
+        PRINT_E("Failed to invoke\n");
+        return kRetErr;
+    }
+    for (auto& output_tensor_info : output_tensor_info_list) {
+        output_tensor_info.data = interpreter_->tensor(output_tensor_info.id)->data.raw;
+    }
+    return kRetOk;
+}
+
+int32_t InferenceHelperTensorflowLiteXnnpackCache::GetTensorId(const std::string& name)
+{
+    for (int32_t id = 0; id < static_cast<int32_t>(interpreter_->tensors_size()); id++) {
+        const char* tensor_name = interpreter_->tensor(id)->name;
+        if (tensor_name && name == tensor_name) return id;
+    }
+    PRINT_E("Invalid tensor name (%s)\n", name.c_str());
+    return -1;
+}
+
+int32_t InferenceHelperTensorflowLiteXnnpackCache::SetInputTensorInfo(InputTensorInfo& input_tensor_info)
+{
+    const int32_t id = GetTensorId(input_tensor_info.name);
+    if (id < 0) return kRetErr;
+    input_tensor_info.id = id;
+
+    const TfLiteTensor* tensor = interpreter_->tensor(id);
+    if (ConvertTensorType(tensor->type) != input_tensor_info.tensor_type) {
+        PRINT_E("Tensor type mismatch (%s)\n", input_tensor_info.name.c_str());
+        return kRetErr;
+    }
+    if (input_tensor_info.tensor_dims.empty()) {
+        input_tensor_info.tensor_dims = GetTensorDims(tensor);
+    } else if (input_tensor_info.tensor_dims != GetTensorDims(tensor)) {
+        if (interpreter_->ResizeInputTensor(id, input_tensor_info.tensor_dims) != kTfLiteOk) {
+            PRINT_E("Failed to resize input tensor (%s)\n", input_tensor_info.name.c_str());
+            return kRetErr;
+        }
+    }
+    return kRetOk;
+}
+
+int32_t InferenceHelperTensorflowLiteXnnpackCache::SetOutputTensorInfo(OutputTensorInfo& output_tensor_info)
+{
+    const int32_t id = GetTensorId(output_tensor_info.name);
+    if (id < 0) return kRetErr;
+    output_tensor_info.id = id;
+
+    const TfLiteTensor* tensor = interpreter_->tensor(id);
+    output_tensor_info.tensor_type = ConvertTensorType(tensor->type);
+    output_tensor_info.tensor_dims = GetTensorDims(tensor);
+    output_tensor_info.data = tensor->data.raw;
+    if (tensor->quantization.type == kTfLiteAffineQuantization) {
+        output_tensor_info.quant.scale = tensor->params.scale;
+        output_tensor_info.quant.zero_point = tensor->params.zero_point;
+    }
+    return kRetOk;
+}
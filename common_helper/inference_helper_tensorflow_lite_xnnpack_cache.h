@@ -0,0 +1,67 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef INFERENCE_HELPER_TENSORFLOW_LITE_XNNPACK_CACHE_
+#define INFERENCE_HELPER_TENSORFLOW_LITE_XNNPACK_CACHE_
+
+/* for general */
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+/* for Tensorflow Lite */
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+
+/* for My modules */
+#include "inference_helper.h"
+#include "mapped_file.h"
+#include "weight_cache.h"
+
+/* TensorFlow Lite + XNNPACK delegate which keeps the packed weights in a file next to the model (see XnnpackWeightCache) */
+/* InferenceHelper creates the XNNPACK delegate by itself and cannot pass weight_cache_file_path, so the delegate is created here */
+/* Supported input: image already resized to the tensor size (no crop, no resize) or blob. Fp32 / Uint8 / Int8 tensors */
+class InferenceHelperTensorflowLiteXnnpackCache : public InferenceHelper {
+public:
+    InferenceHelperTensorflowLiteXnnpackCache();
+    ~InferenceHelperTensorflowLiteXnnpackCache() override;
+    int32_t SetNumThreads(const int32_t num_threads) override;
+    int32_t SetCustomOps(const std::vector<std::pair<const char*, const void*>>& custom_ops) override;
+    int32_t Initialize(const std::string& model_filename, std::vector<InputTensorInfo>& input_tensor_info_list, std::vector<OutputTensorInfo>& output_tensor_info_list) override;
+    int32_t Finalize(void) override;
+    int32_t PreProcess(const std::vector<InputTensorInfo>& input_tensor_info_list) override;
+    int32_t Process(std::vector<OutputTensorInfo>& output_tensor_info_list) override;
+
+    bool IsWeightCacheWarm() const { return weight_cache_.IsWarm(); }
+
+private:
+    int32_t GetTensorId(const std::string& name);
+    int32_t SetInputTensorInfo(InputTensorInfo& input_tensor_info);
+    int32_t SetOutputTensorInfo(OutputTensorInfo& output_tensor_info);
+
+private:
+    int32_t num_threads_;
+    std::vector<std::pair<const char*, const void*>> custom_ops_;
+    MappedFile model_file_;         /* the model is read from this mapping (FlatBufferModel doesn't copy it) */
+    XnnpackWeightCache weight_cache_;
+    std::unique_ptr<tflite::FlatBufferModel> model_;
+    std::unique_ptr<tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates> resolver_;    /* the delegate is applied by this class only */
+    std::unique_ptr<tflite::Interpreter> interpreter_;
+    TfLiteDelegate* delegate_;
+};
+
+#endif
@@ -0,0 +1,185 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+
+#include "common_helper.h"
+#include "json_reader.h"
+
+/*** Macro ***/
+#define TAG "JsonReader"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+    static const JsonValue kNull;
+    return (index < array_.size()) ? array_[index] : kNull;
+}
+
+const JsonValue& JsonValue::operator[](const std::string& key) const
+{
+    static const JsonValue kNull;
+    const auto& it = object_.find(key);
+    return (it != object_.end()) ? it->second : kNull;
+}
+
+int32_t JsonValue::Parse(const std::string& text, JsonValue& value)
+{
+    const char* p = text.data();
+    const char* end = p + text.size();
+    value = JsonValue();
+    if (!ParseValue(p, end, value)) {
+        PRINT_E("Parse error at %d\n", static_cast<int32_t>(p - text.data()));
+        return -1;
+    }
+    return 0;
+}
+
+int32_t JsonValue::ParseFile(const std::string& filename, JsonValue& value)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    if (ifs.fail()) {
+        PRINT_E("Failed to read %s\n", filename.c_str());
+        return -1;
+    }
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    return Parse(ss.str(), value);
+}
+
+void JsonValue::SkipSpace(const char*& p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+}
+
+bool JsonValue::ParseString(const char*& p, const char* end, std::string& str)
+{
+    if (p >= end || *p != '"') return false;
+    p++;
+    str.clear();
+    while (p < end && *p != '"') {
+        if (*p == '\\' && p + 1 < end) {
+            p++;
+            switch (*p) {
+            case 'n': str += '\n'; break;
+            case 't': str += '\t'; break;
+            case 'r': str += '\r'; break;
+            case 'b': str += '\b'; break;
+            case 'f': str += '\f'; break;
+            case 'u': str += "\\u"; break;
+            default:  str += *p; break;
+            }
+        } else {
+            str += *p;
+        }
+        p++;
+    }
+    if (p >= end) return false;
+    p++;
+    return true;
+}
+
+bool JsonValue::ParseValue(const char*& p, const char* end, JsonValue& value)
+{
+    SkipSpace(p, end);
+    if (p >= end) return false;
+
+    if (*p == '{') {
+        value.type_ = kTypeObject;
+        p++;
+        SkipSpace(p, end);
+        if (p < end && *p == '}') {
+            p++;
+            return true;
+        }
+        while (p < end) {
+            std::string key;
+            SkipSpace(p, end);
+            if (!ParseString(p, end, key)) return false;
+            SkipSpace(p, end);
+            if (p >= end || *p != ':') return false;
+            p++;
+            if (!ParseValue(p, end, value.object_[key])) return false;
+            SkipSpace(p, end);
+            if (p < end && *p == ',') {
+                p++;
+            } else if (p < end && *p == '}') {
+                p++;
+                return true;
+            } else {
+                return false;
+            }
+        }
+        return false;
+    } else if (*p == '[') {
+        value.type_ = kTypeArray;
+        p++;
+        SkipSpace(p, end);
+        if (p < end && *p == ']') {
+            p++;
+            return true;
+        }
+        while (p < end) {
+            value.array_.push_back(JsonValue());
+            if (!ParseValue(p, end, value.array_.back())) return false;
+            SkipSpace(p, end);
+            if (p < end && *p == ',') {
+                p++;
+            } else if (p < end && *p == ']') {
+                p++;
+                return true;
+            } else {
+                return false;
+            }
+        }
+        return false;
+    } else if (*p == '"') {
+        value.type_ = kTypeString;
+        return ParseString(p, end, value.string_);
+    } else if (end - p >= 4 && strncmp(p, "true", 4) == 0) {
+        value.type_ = kTypeBool;
+        value.number_ = 1;
+        p += 4;
+        return true;
+    } else if (end - p >= 5 && strncmp(p, "false", 5) == 0) {
+        value.type_ = kTypeBool;
+        value.number_ = 0;
+        p += 5;
+        return true;
+    } else if (end - p >= 4 && strncmp(p, "null", 4) == 0) {
+        value.type_ = kTypeNull;
+        p += 4;
+        return true;
+    } else {
+        /* the text is not null terminated necessarily. copy the number part */
+        const char* start = p;
+        while (p < end && ((*p != '\0' && strchr("+-.eE", *p)) || (*p >= '0' && *p <= '9'))) p++;
+        if (p == start) return false;
+        value.type_ = kTypeNumber;
+        value.number_ = strtod(std::string(start, p).c_str(), nullptr);
+        return true;
+    }
+}
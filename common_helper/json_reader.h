@@ -0,0 +1,67 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef JSON_READER_
+#define JSON_READER_
+
+/* for general */
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+
+/* Minimal JSON reader (enough for annotation files such as COCO) */
+/*   - no escape except \" \\ \/ \n \t \r \b \f (\uXXXX is kept as is) */
+/*   - accessing a missing member or a wrong type returns an empty (null) value instead of failing */
+class JsonValue {
+public:
+    enum {
+        kTypeNull = 0,
+        kTypeBool,
+        kTypeNumber,
+        kTypeString,
+        kTypeArray,
+        kTypeObject,
+    };
+
+public:
+    JsonValue() : type_(kTypeNull), number_(0) {}
+
+    int32_t GetType() const { return type_; }
+    bool IsNull() const { return type_ == kTypeNull; }
+    double GetNumber(double default_value = 0) const { return (type_ == kTypeNumber || type_ == kTypeBool) ? number_ : default_value; }
+    const std::string& GetString() const { return string_; }
+
+    size_t GetSize() const { return array_.size(); }
+    const JsonValue& operator[](size_t index) const;
+    const JsonValue& operator[](const std::string& key) const;
+    bool HasMember(const std::string& key) const { return object_.count(key) > 0; }
+
+    static int32_t Parse(const std::string& text, JsonValue& value);           /* 0 = OK */
+    static int32_t ParseFile(const std::string& filename, JsonValue& value);
+
+private:
+    static bool ParseValue(const char*& p, const char* end, JsonValue& value);
+    static bool ParseString(const char*& p, const char* end, std::string& str);
+    static void SkipSpace(const char*& p, const char* end);
+
+private:
+    int32_t type_;
+    double number_;
+    std::string string_;
+    std::vector<JsonValue> array_;
+    std::map<std::string, JsonValue> object_;
+};
+
+#endif
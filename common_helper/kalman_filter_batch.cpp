@@ -0,0 +1,237 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/* for general */
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <array>
+#include <algorithm>
+
+/* for My modules */
+#include "bounding_box.h"
+#include "kalman_filter_batch.h"
+
+/* the same model as the previous KalmanFilter in Track */
+static constexpr double kQ[KalmanFilterBatch::kNumStatus] = { 1, 1, 1, 1, 0.01, 0.01, 0.001 };    /* system noise (diagonal) */
+static constexpr double kR[KalmanFilterBatch::kNumObserve] = { 1, 1, 10, 10 };                   /* observation noise (diagonal) */
+static constexpr double kP0 = 10;   /* Set big noise at first to make K=1 and trust observed value rather than estimated value */
+static constexpr int32_t kNumVelocity = 3;  /* (cx, cy, area) have velocity at index + 4 */
+
+#define P(row, col) P_[(row) * kNumStatus + (col)]
+#define L(row, col) L_[(row) * kNumObserve + (col)]
+
+constexpr int32_t KalmanFilterBatch::kNumObserve;   // for link error in Android Studio (clang)
+constexpr int32_t KalmanFilterBatch::kNumStatus;
+
+KalmanFilterBatch::KalmanFilterBatch()
+{
+    Clear();
+}
+
+KalmanFilterBatch::~KalmanFilterBatch()
+{
+}
+
+void KalmanFilterBatch::Clear()
+{
+    capacity_ = 0;
+    free_index_list_.clear();
+    for (auto& v : X_) v.clear();
+    for (auto& v : P_) v.clear();
+    for (auto& v : L_) v.clear();
+}
+
+int32_t KalmanFilterBatch::Add(const BoundingBox& bbox_start)
+{
+    int32_t index;
+    if (!free_index_list_.empty()) {
+        index = free_index_list_.back();
+        free_index_list_.pop_back();
+    } else {
+        index = capacity_++;
+        for (auto& v : X_) v.push_back(0);
+        for (auto& v : P_) v.push_back(0);
+        for (auto& v : L_) v.push_back(0);
+    }
+
+    std::array<double, kNumObserve> z;
+    Observe(bbox_start, z);
+    for (int32_t i = 0; i < kNumStatus; i++) {
+        X_[i][index] = (i < kNumObserve) ? z[i] : 0;
+        for (int32_t j = 0; j < kNumStatus; j++) {
+            P(i, j)[index] = (i == j) ? kP0 : 0;
+        }
+    }
+    UpdateInnovationCovariance(index);
+    return index;
+}
+
+void KalmanFilterBatch::Remove(int32_t index)
+{
+    /* data is kept (still valid values) so that Predict can process all slots without branch */
+    free_index_list_.push_back(index);
+}
+
+void KalmanFilterBatch::Predict()
+{
+    const int32_t n = capacity_;
+
+    /*** X = F * X ***/
+    for (int32_t i = 0; i < kNumVelocity; i++) {
+        double* x = X_[i].data();
+        const double* v = X_[i + 4].data();
+        for (int32_t k = 0; k < n; k++) x[k] += v[k];
+    }
+
+    /*** P = F * P * F^T + Q ***/
+    /* F = I + E (E moves velocity to position), so F*P*F^T = P + E*P + P*E^T + E*P*E^T */
+    /* Blocks are processed in this order so that every element is read before it is modified */
+    for (int32_t i = 0; i < kNumVelocity; i++) {
+        for (int32_t j = 0; j < kNumVelocity; j++) {
+            double* p = P(i, j).data();
+            const double* p_vj = P(i + 4, j).data();
+            const double* p_iv = P(i, j + 4).data();
+            const double* p_vv = P(i + 4, j + 4).data();
+            for (int32_t k = 0; k < n; k++) p[k] += p_vj[k] + p_iv[k] + p_vv[k];
+        }
+    }
+    for (int32_t i = 0; i < kNumVelocity; i++) {
+        for (int32_t j = kNumVelocity; j < kNumStatus; j++) {
+            double* p = P(i, j).data();
+            const double* p_vj = P(i + 4, j).data();
+            for (int32_t k = 0; k < n; k++) p[k] += p_vj[k];
+        }
+    }
+    for (int32_t i = kNumVelocity; i < kNumStatus; i++) {
+        for (int32_t j = 0; j < kNumVelocity; j++) {
+            double* p = P(i, j).data();
+            const double* p_iv = P(i, j + 4).data();
+            for (int32_t k = 0; k < n; k++) p[k] += p_iv[k];
+        }
+    }
+    for (int32_t i = 0; i < kNumStatus; i++) {
+        double* p = P(i, i).data();
+        for (int32_t k = 0; k < n; k++) p[k] += kQ[i];
+    }
+
+    /*** Cholesky decomposition of S = H * P * H^T + R (= P[0:4][0:4] + R) for gating ***/
+    for (int32_t i = 0; i < kNumObserve; i++) {
+        for (int32_t j = 0; j <= i; j++) {
+            double* l = L(i, j).data();
+            const double* p = P(i, j).data();
+            const double r = (i == j) ? kR[i] : 0;
+            for (int32_t k = 0; k < n; k++) {
+                double sum = p[k] + r;
+                for (int32_t m = 0; m < j; m++) sum -= L(i, m)[k] * L(j, m)[k];
+                l[k] = (i == j) ? std::sqrt((std::max)(sum, 1e-12)) : sum / L(j, j)[k];
+            }
+        }
+    }
+}
+
+void KalmanFilterBatch::Update(int32_t index, const BoundingBox& bbox_det)
+{
+    /* H = [I 0], so H * P = P[0:4][:] and P * H^T = P[:][0:4] */
+    /* L is already calculated by Add or Predict */
+    std::array<double, kNumObserve> z;
+    Observe(bbox_det, z);
+
+    /* e = Z - H * X */
+    std::array<double, kNumObserve> e;
+    for (int32_t i = 0; i < kNumObserve; i++) e[i] = z[i] - X_[i][index];
+
+    /* K = P * H^T * S^-1  (solve S * K^T = H * P using L) */
+    std::array<std::array<double, kNumObserve>, kNumStatus> K;
+    for (int32_t r = 0; r < kNumStatus; r++) {
+        std::array<double, kNumObserve> y;
+        for (int32_t i = 0; i < kNumObserve; i++) {
+            double sum = P(r, i)[index];
+            for (int32_t m = 0; m < i; m++) sum -= L(i, m)[index] * y[m];
+            y[i] = sum / L(i, i)[index];
+        }
+        for (int32_t i = kNumObserve - 1; i >= 0; i--) {
+            double sum = y[i];
+            for (int32_t m = i + 1; m < kNumObserve; m++) sum -= L(m, i)[index] * K[r][m];
+            K[r][i] = sum / L(i, i)[index];
+        }
+    }
+
+    /* X = X + K * e */
+    for (int32_t r = 0; r < kNumStatus; r++) {
+        double sum = 0;
+        for (int32_t i = 0; i < kNumObserve; i++) sum += K[r][i] * e[i];
+        X_[r][index] += sum;
+    }
+
+    /* P = (I - K * H) * P = P - K * P[0:4][:] */
+    std::array<double, kNumObserve * kNumStatus> HP;
+    for (int32_t i = 0; i < kNumObserve; i++) {
+        for (int32_t c = 0; c < kNumStatus; c++) HP[i * kNumStatus + c] = P(i, c)[index];
+    }
+    for (int32_t r = 0; r < kNumStatus; r++) {
+        for (int32_t c = 0; c < kNumStatus; c++) {
+            double sum = 0;
+            for (int32_t i = 0; i < kNumObserve; i++) sum += K[r][i] * HP[i * kNumStatus + c];
+            P(r, c)[index] -= sum;
+        }
+    }
+    UpdateInnovationCovariance(index);
+}
+
+BoundingBox KalmanFilterBatch::GetBoundingBox(int32_t index) const
+{
+    BoundingBox bbox;
+    bbox.w = static_cast<int32_t>(std::sqrt(X_[2][index] * X_[3][index]));
+    bbox.h = static_cast<int32_t>(X_[2][index] / bbox.w);
+    bbox.x = static_cast<int32_t>(X_[0][index] - bbox.w / 2);
+    bbox.y = static_cast<int32_t>(X_[1][index] - bbox.h / 2);
+    return bbox;
+}
+
+double KalmanFilterBatch::GetMahalanobisDistance(int32_t index, const BoundingBox& bbox_det) const
+{
+    /* d^2 = e^T * S^-1 * e = |L^-1 * e|^2 */
+    std::array<double, kNumObserve> z;
+    Observe(bbox_det, z);
+    double distance = 0;
+    std::array<double, kNumObserve> y;
+    for (int32_t i = 0; i < kNumObserve; i++) {
+        double sum = z[i] - X_[i][index];
+        for (int32_t m = 0; m < i; m++) sum -= L(i, m)[index] * y[m];
+        y[i] = sum / L(i, i)[index];
+        distance += y[i] * y[i];
+    }
+    return distance;
+}
+
+void KalmanFilterBatch::Observe(const BoundingBox& bbox, std::array<double, kNumObserve>& z) const
+{
+    z[0] = static_cast<double>(bbox.x + bbox.w / 2);
+    z[1] = static_cast<double>(bbox.y + bbox.h / 2);
+    z[2] = static_cast<double>(bbox.w * bbox.h);
+    z[3] = static_cast<double>(bbox.w) / bbox.h;
+}
+
+void KalmanFilterBatch::UpdateInnovationCovariance(int32_t index)
+{
+    /* The same calculation as Predict for one object */
+    for (int32_t i = 0; i < kNumObserve; i++) {
+        for (int32_t j = 0; j <= i; j++) {
+            double sum = P(i, j)[index] + ((i == j) ? kR[i] : 0);
+            for (int32_t m = 0; m < j; m++) sum -= L(i, m)[index] * L(j, m)[index];
+            L(i, j)[index] = (i == j) ? std::sqrt((std::max)(sum, 1e-12)) : sum / L(j, j)[index];
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef KALMAN_FILTER_BATCH_
+#define KALMAN_FILTER_BATCH_
+
+/* for general */
+#include <cstdint>
+#include <vector>
+#include <array>
+
+/* for My modules */
+#include "bounding_box.h"
+
+/* Kalman filters of all tracked objects with uniform linear motion model */
+/*   - status X = (cx, cy, area, aspect, vx, vy, v_area), observed Z = (cx, cy, area, aspect) */
+/*   - all filters share the same F, Q, H and R, so each element of X and P is stored as an array over objects (SoA), */
+/*     and Predict processes all objects at once with the structure of F (X += velocity) instead of general matrix products */
+/*   - index returned by Add is kept until Remove is called, and is reused after that */
+class KalmanFilterBatch {
+public:
+    static constexpr int32_t kNumObserve = 4;
+    static constexpr int32_t kNumStatus = 7;
+
+public:
+    KalmanFilterBatch();
+    ~KalmanFilterBatch();
+
+    void Clear();
+    int32_t Add(const BoundingBox& bbox_start);
+    void Remove(int32_t index);
+
+    void Predict();
+    void Update(int32_t index, const BoundingBox& bbox_det);
+
+    BoundingBox GetBoundingBox(int32_t index) const;
+    double GetMahalanobisDistance(int32_t index, const BoundingBox& bbox_det) const;   /* squared distance in observation space. updated by Predict */
+
+private:
+    void Observe(const BoundingBox& bbox, std::array<double, kNumObserve>& z) const;
+    void UpdateInnovationCovariance(int32_t index);
+
+private:
+    int32_t capacity_;
+    std::vector<int32_t> free_index_list_;
+    std::vector<double> X_[kNumStatus];                 /* X_[i][object] */
+    std::vector<double> P_[kNumStatus * kNumStatus];    /* P_[row * kNumStatus + col][object] */
+    std::vector<double> L_[kNumObserve * kNumObserve];  /* lower triangle of cholesky decomposition of S = H * P * H^T + R */
+};
+
+#endif
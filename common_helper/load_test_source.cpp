@@ -0,0 +1,429 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "common_helper.h"
+#include "load_test_source.h"
+
+/*** Macro ***/
+#define TAG "LoadTestSource"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static const std::string kSyntheticSourceName = "synthetic";
+static const std::string kReplaySourcePrefix = "replay:";
+
+
+/*** Function ***/
+static std::map<std::string, std::string> ParseOption(const std::string& option)
+{
+    /* key0=value0&key1=value1 */
+    std::map<std::string, std::string> option_map;
+    size_t pos = 0;
+    while (pos < option.size()) {
+        size_t pos_end = option.find('&', pos);
+        if (pos_end == std::string::npos) pos_end = option.size();
+        const std::string item = option.substr(pos, pos_end - pos);
+        const size_t pos_equal = item.find('=');
+        if (pos_equal != std::string::npos) {
+            option_map[item.substr(0, pos_equal)] = item.substr(pos_equal + 1);
+        } else if (!item.empty()) {
+            option_map[item] = "1";
+        }
+        pos = pos_end + 1;
+    }
+    return option_map;
+}
+
+static double GetOption(const std::map<std::string, std::string>& option_map, const std::string& key, double default_value)
+{
+    auto it = option_map.find(key);
+    if (it == option_map.end()) return default_value;
+    return std::atof(it->second.c_str());
+}
+
+static void SplitInputName(const std::string& input_name, std::string& name, std::string& option)
+{
+    const size_t pos = input_name.find('?');
+    name = input_name.substr(0, pos);
+    option = (pos == std::string::npos) ? "" : input_name.substr(pos + 1);
+}
+
+
+/*** LoadTestCapture ***/
+LoadTestCapture::LoadTestCapture()
+{
+    is_opened_ = false;
+    speed_ = 1.0;
+    drop_ratio_ = 0.0;
+    frame_max_ = 0;
+    frame_index_ = 0;
+    frame_num_ = 0;
+    drop_num_ = 0;
+    frame_time_start_ = -1;
+}
+
+LoadTestCapture::~LoadTestCapture()
+{
+}
+
+bool LoadTestCapture::Configure(const std::string& option, int32_t copy_index)
+{
+    const auto option_map = ParseOption(option);
+    speed_ = (std::max)(0.0, GetOption(option_map, "speed", 1.0));
+    drop_ratio_ = GetOption(option_map, "drop", 0.0);
+    if (drop_ratio_ < 0 || drop_ratio_ >= 1.0) {
+        PRINT_E("drop must be in [0, 1): %f\n", drop_ratio_);    /* drop=1 never delivers a frame */
+        return false;
+    }
+    frame_max_ = static_cast<int32_t>(GetOption(option_map, "frames", 0));
+    random_engine_.seed(static_cast<uint32_t>(GetOption(option_map, "seed", 0)) + copy_index);
+    frame_index_ = 0;
+    frame_num_ = 0;
+    drop_num_ = 0;
+    ResetPacing();
+    return true;
+}
+
+void LoadTestCapture::ResetPacing()
+{
+    frame_time_start_ = -1;     /* the next frame becomes the origin */
+}
+
+bool LoadTestCapture::isOpened() const
+{
+    return is_opened_;
+}
+
+void LoadTestCapture::release()
+{
+    is_opened_ = false;
+}
+
+bool LoadTestCapture::read(cv::OutputArray image)
+{
+    if (!is_opened_ || (frame_max_ > 0 && frame_num_ >= frame_max_)) {
+        release();
+        image.release();
+        return false;
+    }
+
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    const double frame_interval = 1.0 / GetFps();
+    while (true) {
+        double frame_time = 0;
+        if (!Grab(frame_index_, frame_time)) {
+            release();
+            image.release();
+            return false;
+        }
+        frame_index_++;
+
+        bool is_drop = (drop_ratio_ > 0) && (distribution(random_engine_) < drop_ratio_);
+        if (speed_ > 0) {
+            const auto& time_now = std::chrono::steady_clock::now();
+            if (frame_time_start_ < 0) {
+                time_start_ = time_now;
+                frame_time_start_ = frame_time;
+            }
+            const double time_target = (frame_time - frame_time_start_) / speed_;     /* [sec] from the start */
+            const double time_elapsed = static_cast<std::chrono::duration<double>>(time_now - time_start_).count();
+            if (time_elapsed > time_target + frame_interval / speed_) {
+                is_drop = true;     /* the next frame is already due */
+            } else if (!is_drop && time_target > time_elapsed) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(time_target - time_elapsed));
+            }
+        }
+        if (!is_drop) break;
+        drop_num_++;
+    }
+
+    cv::Mat mat;
+    if (!Retrieve(mat)) {
+        release();
+        image.release();
+        return false;
+    }
+    image.assign(mat);
+    frame_num_++;
+    return true;
+}
+
+double LoadTestCapture::get(int prop_id) const
+{
+    switch (prop_id) {
+    case cv::CAP_PROP_POS_FRAMES:
+        return static_cast<double>(frame_index_);
+    case cv::CAP_PROP_FPS:
+        return GetFps();
+    case cv::CAP_PROP_FRAME_WIDTH:
+        return GetSize().width;
+    case cv::CAP_PROP_FRAME_HEIGHT:
+        return GetSize().height;
+    case cv::CAP_PROP_FRAME_COUNT:
+        return frame_max_;
+    default:
+        return 0;
+    }
+}
+
+bool LoadTestCapture::set(int prop_id, double value)
+{
+    if (prop_id == cv::CAP_PROP_POS_FRAMES) {
+        frame_index_ = (std::max)(static_cast<int64_t>(0), static_cast<int64_t>(value));
+        Seek(frame_index_);
+        ResetPacing();
+        return true;
+    }
+    return false;
+}
+
+
+/*** SyntheticCapture ***/
+/* Boxes move at constant velocities and bounce at the edges. Positions are a function of time, so dropped frames are not rendered */
+class SyntheticCapture : public LoadTestCapture {
+public:
+    SyntheticCapture() : width_(640), height_(480), fps_(30.0), frame_time_(0) {}
+    bool Open(const std::string& option, int32_t copy_index);
+
+protected:
+    virtual double GetFps() const override { return fps_; }
+    virtual cv::Size GetSize() const override { return cv::Size(width_, height_); }
+    virtual bool Grab(int64_t frame_index, double& frame_time) override;
+    virtual bool Retrieve(cv::Mat& image) override;
+    virtual void Seek(int64_t frame_index) override {}
+
+private:
+    typedef struct Object_ {
+        cv::Point2f position;   /* top left at time 0 */
+        cv::Point2f velocity;   /* [px/sec] */
+        cv::Size    size;
+        cv::Scalar  color;
+    } Object;
+
+private:
+    int32_t width_;
+    int32_t height_;
+    double fps_;
+    double frame_time_;         /* of the grabbed frame */
+    std::vector<Object> object_list_;
+    cv::Mat background_;
+};
+
+static float Reflect(float position, float range)
+{
+    /* position moving in [0, range] with reflection at both ends */
+    if (range <= 0) return 0;
+    float p = std::fmod(position, 2 * range);
+    if (p < 0) p += 2 * range;
+    return (p > range) ? 2 * range - p : p;
+}
+
+bool SyntheticCapture::Open(const std::string& option, int32_t copy_index)
+{
+    if (!Configure(option, copy_index)) return false;
+    const auto option_map = ParseOption(option);
+    width_ = (std::max)(16, static_cast<int32_t>(GetOption(option_map, "width", 640)));
+    height_ = (std::max)(16, static_cast<int32_t>(GetOption(option_map, "height", 480)));
+    fps_ = GetOption(option_map, "fps", 30.0);
+    if (fps_ <= 0) fps_ = 30.0;
+    const int32_t object_num = (std::max)(0, static_cast<int32_t>(GetOption(option_map, "objects", 10)));
+
+    /* Background with texture (gradient and grid) */
+    background_ = cv::Mat(height_, width_, CV_8UC3);
+    for (int32_t y = 0; y < height_; y++) {
+        uint8_t* p = background_.ptr<uint8_t>(y);
+        for (int32_t x = 0; x < width_; x++) {
+            p[x * 3 + 0] = static_cast<uint8_t>(64 + 96 * x / width_);
+            p[x * 3 + 1] = static_cast<uint8_t>(64 + 96 * y / height_);
+            p[x * 3 + 2] = 96;
+        }
+    }
+    for (int32_t x = 0; x < width_; x += 64) cv::line(background_, cv::Point(x, 0), cv::Point(x, height_ - 1), cv::Scalar(48, 48, 48), 1);
+    for (int32_t y = 0; y < height_; y += 64) cv::line(background_, cv::Point(0, y), cv::Point(width_ - 1, y), cv::Scalar(48, 48, 48), 1);
+
+    /* Objects (different for each copy) */
+    const int32_t size_min = (std::max)(4, (std::min)(width_, height_) / 20);
+    const int32_t size_max = (std::max)(size_min + 1, (std::min)(width_, height_) / 6);
+    std::uniform_int_distribution<int32_t> distribution_size(size_min, size_max);
+    std::uniform_real_distribution<float> distribution_speed(0.05f * width_, 0.3f * width_);
+    std::uniform_real_distribution<float> distribution_angle(0.0f, static_cast<float>(2 * CV_PI));
+    std::uniform_real_distribution<float> distribution_position(0.0f, 1.0f);
+    std::uniform_int_distribution<int32_t> distribution_color(0, 255);
+    object_list_.clear();
+    for (int32_t i = 0; i < object_num; i++) {
+        Object object;
+        object.size = cv::Size(distribution_size(random_engine_), distribution_size(random_engine_));
+        object.position = cv::Point2f(distribution_position(random_engine_) * (width_ - object.size.width), distribution_position(random_engine_) * (height_ - object.size.height));
+        const float speed = distribution_speed(random_engine_);
+        const float angle = distribution_angle(random_engine_);
+        object.velocity = cv::Point2f(speed * std::cos(angle), speed * std::sin(angle));
+        object.color = cv::Scalar(distribution_color(random_engine_), distribution_color(random_engine_), distribution_color(random_engine_));
+        object_list_.push_back(object);
+    }
+
+    is_opened_ = true;
+    PRINT("Synthetic source %d: %dx%d, %.1f fps, %d objects\n", copy_index, width_, height_, fps_, object_num);
+    return true;
+}
+
+bool SyntheticCapture::Grab(int64_t frame_index, double& frame_time)
+{
+    frame_time = frame_index / fps_;
+    frame_time_ = frame_time;
+    return true;
+}
+
+bool SyntheticCapture::Retrieve(cv::Mat& image)
+{
+    image = background_.clone();
+    ground_truth_list_.clear();
+    const float t = static_cast<float>(frame_time_);
+    for (size_t i = 0; i < object_list_.size(); i++) {
+        const Object& object = object_list_[i];
+        const int32_t x = static_cast<int32_t>(Reflect(object.position.x + object.velocity.x * t, static_cast<float>(width_ - object.size.width)));
+        const int32_t y = static_cast<int32_t>(Reflect(object.position.y + object.velocity.y * t, static_cast<float>(height_ - object.size.height)));
+        const cv::Rect rect(x, y, object.size.width, object.size.height);
+        cv::rectangle(image, rect, object.color, -1);
+        cv::rectangle(image, rect, cv::Scalar(0, 0, 0), 2);
+        ground_truth_list_.push_back(BoundingBox(static_cast<int32_t>(i), "object", 1.0f, rect.x, rect.y, rect.width, rect.height));  /* class_id = object id */
+    }
+    return true;
+}
+
+
+/*** ReplayCapture ***/
+/* Frames are shown at their timestamps in the file (CAP_PROP_POS_MSEC) */
+class ReplayCapture : public LoadTestCapture {
+public:
+    ReplayCapture() : is_loop_(false), time_offset_(0), frame_time_last_(0) {}
+    bool Open(const std::string& filename, const std::string& option, int32_t copy_index, int32_t copy_num);
+
+protected:
+    virtual double GetFps() const override;
+    virtual cv::Size GetSize() const override;
+    virtual bool Grab(int64_t frame_index, double& frame_time) override;
+    virtual bool Retrieve(cv::Mat& image) override;
+    virtual void Seek(int64_t frame_index) override;
+
+private:
+    cv::VideoCapture capture_;
+    bool is_loop_;
+    double time_offset_;        /* [sec] added after looping so that time keeps increasing */
+    double frame_time_last_;
+};
+
+bool ReplayCapture::Open(const std::string& filename, const std::string& option, int32_t copy_index, int32_t copy_num)
+{
+    if (!Configure(option, copy_index)) return false;
+    const auto option_map = ParseOption(option);
+    is_loop_ = GetOption(option_map, "loop", 0) != 0;
+    if (!capture_.open(filename) || !capture_.isOpened()) {
+        PRINT_E("Invalid input source: %s\n", filename.c_str());
+        return false;
+    }
+
+    /* Copies start at different positions so that they don't show the same frame */
+    const double frame_count = capture_.get(cv::CAP_PROP_FRAME_COUNT);
+    if (copy_num > 1 && frame_count > 0) {
+        capture_.set(cv::CAP_PROP_POS_FRAMES, std::floor(frame_count * copy_index / copy_num));
+    }
+
+    is_opened_ = true;
+    PRINT("Replay source %d: %s, %.1f fps, x%.1f speed%s\n", copy_index, filename.c_str(), GetFps(), speed_, is_loop_ ? ", loop" : "");
+    return true;
+}
+
+double ReplayCapture::GetFps() const
+{
+    const double fps = capture_.get(cv::CAP_PROP_FPS);
+    return (fps > 0) ? fps : 30.0;
+}
+
+cv::Size ReplayCapture::GetSize() const
+{
+    return cv::Size(static_cast<int32_t>(capture_.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int32_t>(capture_.get(cv::CAP_PROP_FRAME_HEIGHT)));
+}
+
+bool ReplayCapture::Grab(int64_t frame_index, double& frame_time)
+{
+    if (!capture_.grab()) {
+        if (!is_loop_) return false;
+        capture_.set(cv::CAP_PROP_POS_FRAMES, 0);
+        time_offset_ = frame_time_last_ + 1.0 / GetFps();
+        if (!capture_.grab()) return false;
+    }
+    frame_time = time_offset_ + capture_.get(cv::CAP_PROP_POS_MSEC) / 1000.0;
+    frame_time_last_ = frame_time;
+    return true;
+}
+
+bool ReplayCapture::Retrieve(cv::Mat& image)
+{
+    return capture_.retrieve(image);
+}
+
+void ReplayCapture::Seek(int64_t frame_index)
+{
+    capture_.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(frame_index));
+}
+
+
+/*** CommonHelper ***/
+bool CommonHelper::IsLoadTestSource(const std::string& input_name)
+{
+    std::string name, option;
+    SplitInputName(input_name, name, option);
+    return name == kSyntheticSourceName || name.compare(0, kReplaySourcePrefix.size(), kReplaySourcePrefix) == 0;
+}
+
+std::vector<std::unique_ptr<cv::VideoCapture>> CommonHelper::CreateLoadTestSource(const std::string& input_name)
+{
+    std::vector<std::unique_ptr<cv::VideoCapture>> source_list;
+    std::string name, option;
+    SplitInputName(input_name, name, option);
+    const int32_t copy_num = (std::max)(1, static_cast<int32_t>(GetOption(ParseOption(option), "copies", 1)));
+    for (int32_t i = 0; i < copy_num; i++) {
+        if (name == kSyntheticSourceName) {
+            std::unique_ptr<SyntheticCapture> source(new SyntheticCapture());
+            if (!source->Open(option, i)) return std::vector<std::unique_ptr<cv::VideoCapture>>();
+            source_list.push_back(std::move(source));
+        } else if (name.compare(0, kReplaySourcePrefix.size(), kReplaySourcePrefix) == 0) {
+            std::unique_ptr<ReplayCapture> source(new ReplayCapture());
+            if (!source->Open(name.substr(kReplaySourcePrefix.size()), option, i, copy_num)) return std::vector<std::unique_ptr<cv::VideoCapture>>();
+            source_list.push_back(std::move(source));
+        } else {
+            PRINT_E("Invalid input source: %s\n", input_name.c_str());
+            return std::vector<std::unique_ptr<cv::VideoCapture>>();
+        }
+    }
+    return source_list;
+}
@@ -0,0 +1,85 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef LOAD_TEST_SOURCE_
+#define LOAD_TEST_SOURCE_
+
+/* for general */
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "bounding_box.h"
+
+/* Input sources for load testing without cameras. They are used as cv::VideoCapture (read, isOpened, get, set, release) */
+/*   - "synthetic?width=1280&height=720&fps=30&objects=100" : generated video with moving boxes. ground truth is available */
+/*   - "replay:<video file>?speed=2&loop=1"                  : recorded video at its original timestamps (x speed) */
+/*   - common options: speed   : multiple of real time. 0 = as fast as possible (no pacing)                            */
+/*                     drop    : probability to drop a frame (simulated transmission loss). 0 <= drop < 1              */
+/*                     copies  : number of independent sources (emulate many cameras). each copy has another phase   */
+/*                     frames  : stop after this number of frames. 0 = endless (synthetic) or until the end (replay) */
+/*                     seed    : random seed for objects and drops (+ copy index)                                  */
+/*   - like a live camera, frames which are late (the consumer is slower than real time) are dropped, not queued */
+class LoadTestCapture : public cv::VideoCapture {
+public:
+    LoadTestCapture();
+    virtual ~LoadTestCapture();
+
+    virtual bool isOpened() const override;
+    virtual void release() override;
+    virtual bool read(cv::OutputArray image) override;
+    virtual double get(int prop_id) const override;
+    virtual bool set(int prop_id, double value) override;
+
+    int32_t GetFrameNum() const { return frame_num_; }      /* frames returned */
+    int32_t GetDropNum() const { return drop_num_; }        /* frames dropped (late or simulated loss) */
+    const std::vector<BoundingBox>& GetGroundTruth() const { return ground_truth_list_; }     /* of the last frame. empty for replay */
+
+protected:
+    bool Configure(const std::string& option, int32_t copy_index);
+    void ResetPacing();
+    virtual double GetFps() const = 0;
+    virtual cv::Size GetSize() const = 0;
+    virtual bool Grab(int64_t frame_index, double& frame_time) = 0;    /* frame_time: [sec] in the source. false at the end */
+    virtual bool Retrieve(cv::Mat& image) = 0;                          /* only for frames which are not dropped */
+    virtual void Seek(int64_t frame_index) = 0;
+
+protected:
+    bool is_opened_;
+    double speed_;
+    double drop_ratio_;
+    int32_t frame_max_;
+    int64_t frame_index_;       /* next frame */
+    int32_t frame_num_;
+    int32_t drop_num_;
+    std::chrono::steady_clock::time_point time_start_;
+    double frame_time_start_;
+    std::mt19937 random_engine_;
+    std::vector<BoundingBox> ground_truth_list_;
+};
+
+namespace CommonHelper
+{
+bool IsLoadTestSource(const std::string& input_name);
+std::vector<std::unique_ptr<cv::VideoCapture>> CreateLoadTestSource(const std::string& input_name);    /* returns "copies" sources. empty on error */
+}
+
+#endif
@@ -0,0 +1,149 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* for My modules */
+#include "common_helper.h"
+#include "mapped_file.h"
+
+/*** Macro ***/
+#define TAG "MappedFile"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static uint64_t CalculateHash(const uint8_t* data, size_t size)
+{
+    /* FNV-1a (64bit) */
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+MappedFile::MappedFile()
+{
+    data_ = nullptr;
+    size_ = 0;
+    hash_ = 0;
+    is_hash_ready_ = false;
+#ifdef _WIN32
+    handle_file_ = INVALID_HANDLE_VALUE;
+    handle_mapping_ = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& filename)
+{
+    Close();
+#ifdef _WIN32
+    handle_file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle_file_ == INVALID_HANDLE_VALUE) {
+        PRINT_E("Failed to open %s\n", filename.c_str());
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(handle_file_, &file_size) || file_size.QuadPart == 0) {
+        PRINT_E("Invalid file size: %s\n", filename.c_str());
+        Close();
+        return false;
+    }
+    handle_mapping_ = CreateFileMappingA(handle_file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (handle_mapping_ == nullptr) {
+        PRINT_E("Failed to map %s\n", filename.c_str());
+        Close();
+        return false;
+    }
+    void* data = MapViewOfFile(handle_mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        PRINT_E("Failed to map %s\n", filename.c_str());
+        Close();
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(data);
+    size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        PRINT_E("Failed to open %s\n", filename.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        PRINT_E("Invalid file size: %s\n", filename.c_str());
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);     /* the mapping is still valid after close */
+    if (data == MAP_FAILED) {
+        PRINT_E("Failed to map %s\n", filename.c_str());
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(data);
+    size_ = static_cast<size_t>(st.st_size);
+#endif
+    filename_ = filename;
+    return true;
+}
+
+uint64_t MappedFile::GetHash() const
+{
+    std::lock_guard<std::mutex> lock(mutex_hash_);
+    if (!is_hash_ready_) {
+        hash_ = CalculateHash(data_, size_);
+        is_hash_ready_ = true;
+    }
+    return hash_;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+    if (handle_mapping_) CloseHandle(handle_mapping_);
+    if (handle_file_ != INVALID_HANDLE_VALUE) CloseHandle(handle_file_);
+    handle_mapping_ = nullptr;
+    handle_file_ = INVALID_HANDLE_VALUE;
+#else
+    if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    hash_ = 0;
+    is_hash_ready_ = false;
+    filename_.clear();
+}
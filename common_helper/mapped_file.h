@@ -0,0 +1,53 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef MAPPED_FILE_
+#define MAPPED_FILE_
+
+/* for general */
+#include <cstdint>
+#include <string>
+#include <mutex>
+
+/* Read-only memory mapped file */
+/*   - pages are backed by the page cache, so they are shared among processes using the same file */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    const std::string& GetFilename() const { return filename_; }
+    const uint8_t* GetData() const { return data_; }
+    size_t GetSize() const { return size_; }
+    uint64_t GetHash() const;   /* calculated at the first call (reads the whole file) */
+
+private:
+    std::string filename_;
+    const uint8_t* data_;
+    size_t size_;
+    mutable uint64_t hash_;
+    mutable bool is_hash_ready_;
+    mutable std::mutex mutex_hash_;
+#ifdef _WIN32
+    void* handle_file_;
+    void* handle_mapping_;
+#endif
+};
+
+#endif
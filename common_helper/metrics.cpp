@@ -0,0 +1,454 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define METRICS_WITH_HTTP
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#endif
+
+#include "common_helper.h"
+#include "metrics.h"
+
+/*** Macro ***/
+#define TAG "Metrics"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+#ifdef METRICS_WITH_HTTP
+static constexpr int32_t kClientTimeoutMsec = 1000;     /* a client which doesn't send or receive doesn't block the endpoint */
+#ifdef MSG_NOSIGNAL
+static constexpr int32_t kSendFlag = MSG_NOSIGNAL;      /* a client which closes early must not kill the process with SIGPIPE */
+#else
+static constexpr int32_t kSendFlag = 0;                 /* SO_NOSIGPIPE is set instead (macOS) */
+#endif
+#endif
+
+
+/*** Histogram ***/
+const std::array<double, Metrics::Histogram::kBucketNum - 1> Metrics::Histogram::kBucketBound = { 0.5, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+
+Metrics::Histogram::Histogram() : count_(0), sum_usec_(0)
+{
+    for (auto& bucket : bucket_) bucket.store(0);
+}
+
+void Metrics::Histogram::Observe(double value)
+{
+    int32_t index = 0;
+    while (index < kBucketNum - 1 && value > kBucketBound[index]) index++;
+    bucket_[index].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_usec_.fetch_add(static_cast<uint64_t>((std::max)(0.0, value) * 1000.0), std::memory_order_relaxed);
+}
+
+uint64_t Metrics::Histogram::GetCount() const
+{
+    return count_.load(std::memory_order_relaxed);
+}
+
+double Metrics::Histogram::GetSum() const
+{
+    return sum_usec_.load(std::memory_order_relaxed) / 1000.0;
+}
+
+uint64_t Metrics::Histogram::GetBucket(int32_t index) const
+{
+    return bucket_[index].load(std::memory_order_relaxed);
+}
+
+double Metrics::Histogram::GetPercentile(double q) const
+{
+    const uint64_t count = GetCount();
+    if (count == 0) return 0;
+    const double target = q * count;
+    uint64_t cumulative = 0;
+    for (int32_t i = 0; i < kBucketNum - 1; i++) {
+        cumulative += GetBucket(i);
+        if (cumulative >= target) return kBucketBound[i];
+    }
+    return kBucketBound[kBucketNum - 2];    /* +Inf. report the largest finite bound */
+}
+
+
+/*** Registry ***/
+std::mutex& Metrics::GetMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<Metrics::Key, std::unique_ptr<Metrics::Counter>>& Metrics::GetCounterMap()
+{
+    static std::map<Key, std::unique_ptr<Counter>> counter_map;
+    return counter_map;
+}
+
+std::map<Metrics::Key, std::unique_ptr<Metrics::Gauge>>& Metrics::GetGaugeMap()
+{
+    static std::map<Key, std::unique_ptr<Gauge>> gauge_map;
+    return gauge_map;
+}
+
+std::map<Metrics::Key, std::unique_ptr<Metrics::Histogram>>& Metrics::GetHistogramMap()
+{
+    static std::map<Key, std::unique_ptr<Histogram>> histogram_map;
+    return histogram_map;
+}
+
+std::map<std::string, std::string>& Metrics::GetHelpMap()
+{
+    static std::map<std::string, std::string> help_map;
+    return help_map;
+}
+
+Metrics::Counter& Metrics::GetCounter(const std::string& name, const std::string& label_key, const std::string& label_value, const std::string& help)
+{
+    std::lock_guard<std::mutex> lock(GetMutex());
+    if (!help.empty()) GetHelpMap()[name] = help;
+    auto& item = GetCounterMap()[{ name, label_key, label_value }];
+    if (!item) item.reset(new Counter());
+    return *item;
+}
+
+Metrics::Gauge& Metrics::GetGauge(const std::string& name, const std::string& label_key, const std::string& label_value, const std::string& help)
+{
+    std::lock_guard<std::mutex> lock(GetMutex());
+    if (!help.empty()) GetHelpMap()[name] = help;
+    auto& item = GetGaugeMap()[{ name, label_key, label_value }];
+    if (!item) item.reset(new Gauge());
+    return *item;
+}
+
+Metrics::Histogram& Metrics::GetHistogram(const std::string& name, const std::string& label_key, const std::string& label_value, const std::string& help)
+{
+    std::lock_guard<std::mutex> lock(GetMutex());
+    if (!help.empty()) GetHelpMap()[name] = help;
+    auto& item = GetHistogramMap()[{ name, label_key, label_value }];
+    if (!item) item.reset(new Histogram());
+    return *item;
+}
+
+void Metrics::UpdateProcessMetrics()
+{
+    static Gauge& rss = GetGauge("process_resident_memory_bytes", "", "", "Resident memory size");
+#if defined(__linux__)
+    /* /proc/self/statm: size resident shared ... [page] */
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (fp) {
+        unsigned long size = 0, resident = 0;
+        if (fscanf(fp, "%lu %lu", &size, &resident) == 2) {
+            rss.Set(static_cast<double>(resident) * sysconf(_SC_PAGESIZE));
+        }
+        fclose(fp);
+    }
+#else
+    (void)rss;
+#endif
+}
+
+
+/*** Format ***/
+static std::string FormatLabel(const std::string& label_key, const std::string& label_value, bool is_json, const std::string& extra = "")
+{
+    std::string label;
+    if (!label_key.empty()) {
+        label = is_json ? (label_key + "=" + label_value) : (label_key + "=\"" + label_value + "\"");
+    }
+    if (!extra.empty()) {
+        label += (label.empty() ? "" : ",") + extra;
+    }
+    return label.empty() ? "" : "{" + label + "}";
+}
+
+static std::string FormatNumber(double value)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.6g", value);
+    return buffer;
+}
+
+std::string Metrics::CreatePrometheusText()
+{
+    std::lock_guard<std::mutex> lock(GetMutex());
+    std::string text;
+    std::string name_previous;
+    auto add_header = [&](const std::string& name, const char* type) {
+        if (name == name_previous) return;
+        name_previous = name;
+        const auto& it = GetHelpMap().find(name);
+        if (it != GetHelpMap().end()) text += "# HELP " + name + " " + it->second + "\n";
+        text += "# TYPE " + name + " " + type + "\n";
+    };
+
+    for (const auto& it : GetCounterMap()) {
+        add_header(it.first.name, "counter");
+        text += it.first.name + FormatLabel(it.first.label_key, it.first.label_value, false) + " " + std::to_string(it.second->Get()) + "\n";
+    }
+    for (const auto& it : GetGaugeMap()) {
+        add_header(it.first.name, "gauge");
+        text += it.first.name + FormatLabel(it.first.label_key, it.first.label_value, false) + " " + FormatNumber(it.second->Get()) + "\n";
+    }
+    for (const auto& it : GetHistogramMap()) {
+        add_header(it.first.name, "histogram");
+        const Histogram& histogram = *it.second;
+        uint64_t cumulative = 0;
+        for (int32_t i = 0; i < Histogram::kBucketNum; i++) {
+            cumulative += histogram.GetBucket(i);
+            const std::string le = (i < Histogram::kBucketNum - 1) ? FormatNumber(Histogram::kBucketBound[i]) : "+Inf";
+            text += it.first.name + "_bucket" + FormatLabel(it.first.label_key, it.first.label_value, false, "le=\"" + le + "\"") + " " + std::to_string(cumulative) + "\n";
+        }
+        text += it.first.name + "_sum" + FormatLabel(it.first.label_key, it.first.label_value, false) + " " + FormatNumber(histogram.GetSum()) + "\n";
+        text += it.first.name + "_count" + FormatLabel(it.first.label_key, it.first.label_value, false) + " " + std::to_string(histogram.GetCount()) + "\n";
+    }
+    return text;
+}
+
+std::string Metrics::CreateJson()
+{
+    std::lock_guard<std::mutex> lock(GetMutex());
+    const auto& now = std::chrono::system_clock::now().time_since_epoch();
+    std::string json = "{\"timestamp_ms\":" + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+
+    json += ",\"counter\":{";
+    for (const auto& it : GetCounterMap()) {
+        if (json.back() != '{') json += ",";
+        json += "\"" + it.first.name + FormatLabel(it.first.label_key, it.first.label_value, true) + "\":" + std::to_string(it.second->Get());
+    }
+    json += "},\"gauge\":{";
+    for (const auto& it : GetGaugeMap()) {
+        if (json.back() != '{') json += ",";
+        json += "\"" + it.first.name + FormatLabel(it.first.label_key, it.first.label_value, true) + "\":" + FormatNumber(it.second->Get());
+    }
+    json += "},\"histogram\":{";
+    for (const auto& it : GetHistogramMap()) {
+        if (json.back() != '{') json += ",";
+        const Histogram& histogram = *it.second;
+        const uint64_t count = histogram.GetCount();
+        json += "\"" + it.first.name + FormatLabel(it.first.label_key, it.first.label_value, true) + "\":{"
+            + "\"count\":" + std::to_string(count)
+            + ",\"mean\":" + FormatNumber(count > 0 ? histogram.GetSum() / count : 0)
+            + ",\"p50\":" + FormatNumber(histogram.GetPercentile(0.5))
+            + ",\"p90\":" + FormatNumber(histogram.GetPercentile(0.9))
+            + ",\"p99\":" + FormatNumber(histogram.GetPercentile(0.99)) + "}";
+    }
+    json += "}}";
+    return json;
+}
+
+
+/*** Sink ***/
+MetricsSinkPrometheusFile::MetricsSinkPrometheusFile(const std::string& filename)
+{
+    filename_ = filename;
+}
+
+void MetricsSinkPrometheusFile::Write()
+{
+    /* write to a temporary file and rename, so that readers never see a partial file */
+    const std::string text = Metrics::CreatePrometheusText();
+    const std::string filename_tmp = filename_ + ".tmp";
+    FILE* fp = fopen(filename_tmp.c_str(), "w");
+    if (!fp) {
+        PRINT_E("Failed to open %s\n", filename_tmp.c_str());
+        return;
+    }
+    fwrite(text.data(), 1, text.size(), fp);
+    fclose(fp);
+#ifdef _WIN32
+    std::remove(filename_.c_str());
+#endif
+    std::rename(filename_tmp.c_str(), filename_.c_str());
+}
+
+MetricsSinkJsonLines::MetricsSinkJsonLines(const std::string& filename)
+{
+    fp_ = filename.empty() ? stdout : fopen(filename.c_str(), "a");
+    if (!fp_) {
+        PRINT_E("Failed to open %s\n", filename.c_str());
+    }
+}
+
+MetricsSinkJsonLines::~MetricsSinkJsonLines()
+{
+    if (fp_ && fp_ != stdout) fclose(fp_);
+}
+
+void MetricsSinkJsonLines::Write()
+{
+    if (!fp_) return;
+    const std::string json = Metrics::CreateJson();
+    fprintf(fp_, "%s\n", json.c_str());
+    fflush(fp_);
+}
+
+MetricsSinkHttp::MetricsSinkHttp(int32_t port, const std::string& address)
+{
+    socket_ = -1;
+    is_thread_exit_ = false;
+#ifdef METRICS_WITH_HTTP
+    socket_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (socket_ < 0) {
+        PRINT_E("Failed to create socket\n");
+        return;
+    }
+    int32_t option = 1;
+    setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, address.c_str(), &addr.sin_addr);
+    if (bind(socket_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || listen(socket_, 4) != 0) {
+        PRINT_E("Failed to listen %s:%d\n", address.c_str(), port);
+        close(socket_);
+        socket_ = -1;
+        return;
+    }
+    thread_ = std::thread(&MetricsSinkHttp::ThreadMain, this);
+#else
+    PRINT_E("HTTP endpoint is not supported on this platform (port %d, %s)\n", port, address.c_str());
+#endif
+}
+
+MetricsSinkHttp::~MetricsSinkHttp()
+{
+    is_thread_exit_ = true;
+    if (thread_.joinable()) thread_.join();
+#ifdef METRICS_WITH_HTTP
+    if (socket_ >= 0) close(socket_);
+#endif
+}
+
+bool MetricsSinkHttp::IsOpened() const
+{
+    return socket_ >= 0;
+}
+
+void MetricsSinkHttp::ThreadMain()
+{
+#ifdef METRICS_WITH_HTTP
+    while (!is_thread_exit_) {
+        /* wake up periodically to check the exit flag */
+        struct pollfd pfd = { socket_, POLLIN, 0 };
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        int32_t client = accept(socket_, nullptr, nullptr);
+        if (client < 0) continue;
+        struct timeval timeout;
+        timeout.tv_sec = kClientTimeoutMsec / 1000;
+        timeout.tv_usec = (kClientTimeoutMsec % 1000) * 1000;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+        int32_t option = 1;
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &option, sizeof(option));
+#endif
+
+        /* the request is not parsed. any path returns metrics */
+        char request[1024];
+        (void)recv(client, request, sizeof(request), 0);
+        const std::string body = Metrics::CreatePrometheusText();
+        const std::string header = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+        const std::string response = header + body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t ret = send(client, response.data() + sent, response.size() - sent, kSendFlag);
+            if (ret <= 0) break;
+            sent += static_cast<size_t>(ret);
+        }
+        close(client);
+    }
+#endif
+}
+
+
+/*** Exporter ***/
+MetricsExporter::MetricsExporter()
+{
+    interval_msec_ = 1000;
+    is_thread_exit_ = false;
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    Stop();
+}
+
+void MetricsExporter::AddSink(std::unique_ptr<MetricsSink> sink)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_list_.push_back(std::move(sink));
+}
+
+void MetricsExporter::Start(int32_t interval_msec)
+{
+    Stop();
+    interval_msec_ = interval_msec;
+    is_thread_exit_ = false;
+    thread_ = std::thread(&MetricsExporter::ThreadMain, this);
+}
+
+void MetricsExporter::Stop()
+{
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_thread_exit_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+}
+
+void MetricsExporter::Flush()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Metrics::UpdateProcessMetrics();
+    for (auto& sink : sink_list_) {
+        sink->Write();
+    }
+}
+
+void MetricsExporter::ThreadMain()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!is_thread_exit_) {
+        cv_.wait_for(lock, std::chrono::milliseconds(interval_msec_), [this] { return is_thread_exit_; });
+        if (is_thread_exit_) break;
+        lock.unlock();
+        Flush();
+        lock.lock();
+    }
+}
@@ -0,0 +1,164 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef METRICS_
+#define METRICS_
+
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/* Runtime metrics (counters, gauges and latency histograms) */
+/*   - Get* looks up the registry with a lock. cache the returned reference (e.g. static local) and use it for each frame */
+/*   - Add / Set / Observe are lock-free (atomic only), so they can stay enabled in production */
+/*   - one optional label is supported (e.g. latency_msec{stage="inference"}) */
+class Metrics {
+public:
+    class Counter {
+    public:
+        Counter() : value_(0) {}
+        void Add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+        uint64_t Get() const { return value_.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<uint64_t> value_;
+    };
+
+    class Gauge {
+    public:
+        Gauge() : value_(0) {}
+        void Set(double value) { value_.store(value, std::memory_order_relaxed); }
+        double Get() const { return value_.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<double> value_;
+    };
+
+    class Histogram {
+    public:
+        static constexpr int32_t kBucketNum = 12;   /* the last bucket is +Inf */
+        static const std::array<double, kBucketNum - 1> kBucketBound;   /* [msec] */
+    public:
+        Histogram();
+        void Observe(double value);     /* [msec] */
+        uint64_t GetCount() const;
+        double GetSum() const;
+        uint64_t GetBucket(int32_t index) const;     /* not cumulative */
+        double GetPercentile(double q) const;       /* estimated by the upper bound of the bucket */
+    private:
+        std::array<std::atomic<uint64_t>, kBucketNum> bucket_;
+        std::atomic<uint64_t> count_;
+        std::atomic<uint64_t> sum_usec_;
+    };
+
+public:
+    static Counter& GetCounter(const std::string& name, const std::string& label_key = "", const std::string& label_value = "", const std::string& help = "");
+    static Gauge& GetGauge(const std::string& name, const std::string& label_key = "", const std::string& label_value = "", const std::string& help = "");
+    static Histogram& GetHistogram(const std::string& name, const std::string& label_key = "", const std::string& label_value = "", const std::string& help = "");
+
+    static void UpdateProcessMetrics();     /* process_resident_memory_bytes */
+    static std::string CreatePrometheusText();
+    static std::string CreateJson();        /* one line */
+
+private:
+    typedef struct Key_ {
+        std::string name;
+        std::string label_key;
+        std::string label_value;
+        bool operator<(const struct Key_& other) const {
+            if (name != other.name) return name < other.name;
+            if (label_key != other.label_key) return label_key < other.label_key;
+            return label_value < other.label_value;
+        }
+    } Key;
+
+    static std::mutex& GetMutex();
+    static std::map<Key, std::unique_ptr<Counter>>& GetCounterMap();
+    static std::map<Key, std::unique_ptr<Gauge>>& GetGaugeMap();
+    static std::map<Key, std::unique_ptr<Histogram>>& GetHistogramMap();
+    static std::map<std::string, std::string>& GetHelpMap();
+};
+
+
+/* Destination of metrics. Write is called periodically from the exporter thread */
+class MetricsSink {
+public:
+    virtual ~MetricsSink() {}
+    virtual void Write() = 0;
+};
+
+/* Prometheus text format file (e.g. for textfile collector of node_exporter). replaced atomically */
+class MetricsSinkPrometheusFile : public MetricsSink {
+public:
+    MetricsSinkPrometheusFile(const std::string& filename);
+    void Write() override;
+private:
+    std::string filename_;
+};
+
+/* One JSON object per line (appended). empty filename = stdout */
+class MetricsSinkJsonLines : public MetricsSink {
+public:
+    MetricsSinkJsonLines(const std::string& filename = "");
+    ~MetricsSinkJsonLines();
+    void Write() override;
+private:
+    FILE* fp_;
+};
+
+/* Local HTTP endpoint (Prometheus text format for any path). Linux / macOS only */
+class MetricsSinkHttp : public MetricsSink {
+public:
+    MetricsSinkHttp(int32_t port, const std::string& address = "127.0.0.1");
+    ~MetricsSinkHttp();
+    bool IsOpened() const;
+    void Write() override {}    /* response is created for each request */
+private:
+    void ThreadMain();
+private:
+    int32_t socket_;
+    std::atomic<bool> is_thread_exit_;
+    std::thread thread_;
+};
+
+/* Call sinks periodically on a worker thread */
+class MetricsExporter {
+public:
+    MetricsExporter();
+    ~MetricsExporter();
+    void AddSink(std::unique_ptr<MetricsSink> sink);
+    void Start(int32_t interval_msec = 1000);
+    void Stop();
+    void Flush();       /* write to all sinks now */
+
+private:
+    void ThreadMain();
+
+private:
+    std::vector<std::unique_ptr<MetricsSink>> sink_list_;
+    int32_t interval_msec_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool is_thread_exit_;
+};
+
+#endif
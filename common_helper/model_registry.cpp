@@ -0,0 +1,71 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <map>
+#include <mutex>
+
+#include "common_helper.h"
+#include "mapped_file.h"
+#include "model_registry.h"
+
+/*** Macro ***/
+#define TAG "ModelRegistry"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+
+std::mutex ModelRegistry::mutex_;
+std::map<std::string, std::string> ModelRegistry::resolved_filename_map_;
+std::multimap<size_t, std::string> ModelRegistry::filename_by_size_;
+
+std::string ModelRegistry::Resolve(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    /* Already resolved */
+    auto it = resolved_filename_map_.find(filename);
+    if (it != resolved_filename_map_.end()) return it->second;
+
+    MappedFile file_new;
+    if (!file_new.Open(filename)) {
+        return "";
+    }
+
+    /* Already registered with another path (e.g. copied model file). Only models with the same size are read and compared */
+    auto range = filename_by_size_.equal_range(file_new.GetSize());
+    for (auto it_size = range.first; it_size != range.second; ++it_size) {
+        MappedFile file;
+        if (file.Open(it_size->second) && file.GetSize() == file_new.GetSize() && std::memcmp(file.GetData(), file_new.GetData(), file.GetSize()) == 0) {
+            PRINT("%s is the same as %s\n", filename.c_str(), it_size->second.c_str());
+            resolved_filename_map_[filename] = it_size->second;
+            return it_size->second;
+        }
+    }
+
+    resolved_filename_map_[filename] = filename;
+    filename_by_size_.insert(std::make_pair(file_new.GetSize(), filename));
+    return filename;
+}
+
+int32_t ModelRegistry::GetModelNum()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int32_t>(filename_by_size_.size());
+}
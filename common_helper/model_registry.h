@@ -0,0 +1,40 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef MODEL_REGISTRY_
+#define MODEL_REGISTRY_
+
+/* for general */
+#include <cstdint>
+#include <string>
+#include <map>
+#include <mutex>
+
+/* Process-wide registry of model paths */
+/*   - Resolve returns the path registered first for a model with the same content (e.g. a copied model file), */
+/*     so that engines read identical models from one file and share its page cache */
+/*   - contents are compared only when another model has the same size, so a new model is not read at Resolve */
+/*   - only paths are kept. InferenceHelper (TensorFlow Lite) maps the model file by itself */
+class ModelRegistry {
+public:
+    static std::string Resolve(const std::string& filename);    /* empty when the file cannot be opened */
+    static int32_t GetModelNum();                               /* models with different contents */
+
+private:
+    static std::mutex mutex_;
+    static std::map<std::string, std::string> resolved_filename_map_;   /* key = requested path */
+    static std::multimap<size_t, std::string> filename_by_size_;        /* resolved paths */
+};
+
+#endif
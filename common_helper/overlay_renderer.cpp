@@ -0,0 +1,269 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+#include "common_helper.h"
+#include "overlay_renderer.h"
+
+/*** Macro ***/
+#define TAG "OverlayRenderer"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static inline std::pair<std::array<double, 4>, int32_t> CreateKey(const cv::Scalar& color, int32_t thickness)
+{
+    return std::make_pair(std::array<double, 4>{ color[0], color[1], color[2], color[3] }, thickness);
+}
+
+
+OverlayRenderer::OverlayRenderer(int32_t max_glyph_cache_num)
+{
+    mode_ = kModeDisplay;
+    max_glyph_cache_num_ = max_glyph_cache_num;
+    is_thread_exit_ = false;
+    is_job_requested_ = false;
+}
+
+OverlayRenderer::~OverlayRenderer()
+{
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            is_thread_exit_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+}
+
+void OverlayRenderer::SetMode(int32_t mode)
+{
+    Wait();
+    mode_ = mode;
+    if (mode_ == kModeNone) {
+        draw_list_.Clear();
+    }
+}
+
+int32_t OverlayRenderer::GetMode() const
+{
+    return mode_;
+}
+
+bool OverlayRenderer::IsEnabled() const
+{
+    return mode_ != kModeNone;
+}
+
+void OverlayRenderer::Clear()
+{
+    draw_list_.Clear();
+}
+
+void OverlayRenderer::AddRect(const cv::Rect& rect, const cv::Scalar& color, int32_t thickness)
+{
+    if (!IsEnabled()) return;
+    /* the same points as cv::rectangle(mat, rect, ...) */
+    std::vector<cv::Point> point_list = {
+        cv::Point(rect.x, rect.y),
+        cv::Point(rect.x + rect.width - 1, rect.y),
+        cv::Point(rect.x + rect.width - 1, rect.y + rect.height - 1),
+        cv::Point(rect.x, rect.y + rect.height - 1),
+    };
+    if (thickness < 0) {
+        draw_list_.polygon_filled_list[CreateKey(color, thickness)].push_back(point_list);
+    } else {
+        draw_list_.polyline_closed_list[CreateKey(color, thickness)].push_back(point_list);
+    }
+}
+
+void OverlayRenderer::AddLine(const cv::Point& p0, const cv::Point& p1, const cv::Scalar& color, int32_t thickness)
+{
+    if (!IsEnabled()) return;
+    draw_list_.polyline_open_list[CreateKey(color, thickness)].push_back({ p0, p1 });
+}
+
+void OverlayRenderer::AddPolyline(const std::vector<cv::Point>& point_list, const cv::Scalar& color, int32_t thickness, bool is_closed)
+{
+    if (!IsEnabled() || point_list.size() < 2) return;
+    if (is_closed) {
+        draw_list_.polyline_closed_list[CreateKey(color, thickness)].push_back(point_list);
+    } else {
+        draw_list_.polyline_open_list[CreateKey(color, thickness)].push_back(point_list);
+    }
+}
+
+void OverlayRenderer::AddCircle(const cv::Point& center, int32_t radius, const cv::Scalar& color, int32_t thickness)
+{
+    if (!IsEnabled()) return;
+    draw_list_.circle_list.push_back({ center, radius, color, thickness });
+}
+
+void OverlayRenderer::AddText(const std::string& text, const cv::Point& pos, double font_scale, int32_t thickness, const cv::Scalar& color_front, const cv::Scalar& color_back, bool is_text_on_rect, bool use_cache)
+{
+    if (!IsEnabled()) return;
+    draw_list_.text_list.push_back({ text, pos, font_scale, thickness, color_front, color_back, is_text_on_rect, use_cache });
+}
+
+void OverlayRenderer::Render(cv::Mat& mat)
+{
+    Wait();
+    if (!IsEnabled()) return;
+    RenderDrawList(draw_list_, mat);
+    draw_list_.Clear();
+}
+
+void OverlayRenderer::RenderAsync(cv::Mat& mat)
+{
+    Wait();
+    if (!IsEnabled()) return;
+
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&OverlayRenderer::ThreadMain, this);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(draw_list_job_, draw_list_);
+        mat_job_ = mat;     /* shallow copy. the caller must not release mat until Wait */
+        is_job_requested_ = true;
+    }
+    draw_list_.Clear();
+    cv_.notify_all();
+}
+
+void OverlayRenderer::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !is_job_requested_; });
+}
+
+void OverlayRenderer::ThreadMain()
+{
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return is_job_requested_ || is_thread_exit_; });
+        if (is_thread_exit_) break;
+        lock.unlock();
+
+        RenderDrawList(draw_list_job_, mat_job_);
+
+        lock.lock();
+        draw_list_job_.Clear();
+        mat_job_ = cv::Mat();
+        is_job_requested_ = false;
+        lock.unlock();
+        cv_.notify_all();
+    }
+}
+
+void OverlayRenderer::RenderDrawList(const DrawList& draw_list, cv::Mat& mat)
+{
+    /* Draw all lines with the same color and thickness at once */
+    for (const auto& it : draw_list.polygon_filled_list) {
+        const auto& color = it.first.first;
+        cv::fillPoly(mat, it.second, cv::Scalar(color[0], color[1], color[2], color[3]));
+    }
+    for (const auto& it : draw_list.polyline_closed_list) {
+        const auto& color = it.first.first;
+        cv::polylines(mat, it.second, true, cv::Scalar(color[0], color[1], color[2], color[3]), it.first.second);
+    }
+    for (const auto& it : draw_list.polyline_open_list) {
+        const auto& color = it.first.first;
+        cv::polylines(mat, it.second, false, cv::Scalar(color[0], color[1], color[2], color[3]), it.first.second);
+    }
+    for (const auto& circle : draw_list.circle_list) {
+        cv::circle(mat, circle.center, circle.radius, circle.color, circle.thickness);
+    }
+
+    /* Text is drawn at last to be on the top */
+    for (const auto& text : draw_list.text_list) {
+        if (text.use_cache) {
+            BlitGlyph(GetGlyph(text), text.pos, mat);
+        } else {
+            Glyph glyph;
+            CreateGlyph(text, glyph);
+            BlitGlyph(glyph, text.pos, mat);
+        }
+    }
+}
+
+const OverlayRenderer::Glyph& OverlayRenderer::GetGlyph(const Text& text)
+{
+    char key[128];
+    snprintf(key, sizeof(key), "%.3f,%d,%d,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f:", text.font_scale, text.thickness, text.is_text_on_rect,
+        text.color_front[0], text.color_front[1], text.color_front[2], text.color_back[0], text.color_back[1], text.color_back[2]);
+    const std::string key_str = key + text.text;
+
+    auto it = glyph_cache_.find(key_str);
+    if (it != glyph_cache_.end()) {
+        return it->second;
+    }
+
+    if (static_cast<int32_t>(glyph_cache_.size()) >= max_glyph_cache_num_) {
+        glyph_cache_.clear();
+    }
+    Glyph& glyph = glyph_cache_[key_str];
+    CreateGlyph(text, glyph);
+    return glyph;
+}
+
+void OverlayRenderer::CreateGlyph(const Text& text, Glyph& glyph)
+{
+    /* The same drawing as CommonHelper::DrawText, but onto a small canvas with mask */
+    int32_t baseline = 0;
+    cv::Size text_size = cv::getTextSize(text.text, cv::FONT_HERSHEY_SIMPLEX, text.font_scale, text.thickness, &baseline);
+    baseline += text.thickness;
+    const int32_t margin = text.is_text_on_rect ? 0 : text.thickness * 2;
+    const int32_t width = text_size.width + margin * 2 + 1;
+    const int32_t height = text_size.height + baseline + margin * 2 + 1;
+    glyph.image = cv::Mat::zeros(height, width, CV_8UC3);
+    glyph.mask = cv::Mat::zeros(height, width, CV_8UC1);
+    glyph.offset = cv::Point(-margin, -margin);
+
+    cv::Point pos(margin, margin + text_size.height);
+    if (text.is_text_on_rect) {
+        cv::rectangle(glyph.image, pos + cv::Point(0, baseline), pos + cv::Point(text_size.width, -text_size.height), text.color_back, -1);
+        cv::rectangle(glyph.mask, pos + cv::Point(0, baseline), pos + cv::Point(text_size.width, -text_size.height), cv::Scalar(255), -1);
+        cv::putText(glyph.image, text.text, pos, cv::FONT_HERSHEY_SIMPLEX, text.font_scale, text.color_front, text.thickness);
+    } else {
+        cv::putText(glyph.image, text.text, pos, cv::FONT_HERSHEY_SIMPLEX, text.font_scale, text.color_back, text.thickness * 3);
+        cv::putText(glyph.mask, text.text, pos, cv::FONT_HERSHEY_SIMPLEX, text.font_scale, cv::Scalar(255), text.thickness * 3);
+        cv::putText(glyph.image, text.text, pos, cv::FONT_HERSHEY_SIMPLEX, text.font_scale, text.color_front, text.thickness);
+    }
+}
+
+void OverlayRenderer::BlitGlyph(const Glyph& glyph, const cv::Point& pos, cv::Mat& mat)
+{
+    cv::Rect rect_dst(pos + glyph.offset, glyph.image.size());
+    cv::Rect rect_clipped = rect_dst & cv::Rect(0, 0, mat.cols, mat.rows);
+    if (rect_clipped.area() <= 0) return;
+    cv::Rect rect_src(rect_clipped.tl() - rect_dst.tl(), rect_clipped.size());
+    if (mat.type() == glyph.image.type()) {
+        glyph.image(rect_src).copyTo(mat(rect_clipped), glyph.mask(rect_src));
+    }
+}
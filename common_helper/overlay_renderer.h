@@ -0,0 +1,128 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef OVERLAY_RENDERER_
+#define OVERLAY_RENDERER_
+
+/* for general */
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* Collect drawing primitives during processing, and draw them onto a frame later (only when drawing is needed) */
+/*   - lines and rectangles with the same color and thickness are drawn by one cv::polylines call */
+/*   - text labels are rasterised once and cached as bitmaps */
+/*   - Render can run on the worker thread (RenderAsync + Wait) */
+class OverlayRenderer {
+public:
+    enum {
+        kModeNone = 0,      /* do nothing (primitives are not even stored) */
+        kModeDisplay,
+        kModeRecord,
+    };
+
+public:
+    OverlayRenderer(int32_t max_glyph_cache_num = 512);
+    ~OverlayRenderer();
+
+    void SetMode(int32_t mode);
+    int32_t GetMode() const;
+    bool IsEnabled() const;
+
+    void Clear();
+    void AddRect(const cv::Rect& rect, const cv::Scalar& color, int32_t thickness = 1);
+    void AddLine(const cv::Point& p0, const cv::Point& p1, const cv::Scalar& color, int32_t thickness = 1);
+    void AddPolyline(const std::vector<cv::Point>& point_list, const cv::Scalar& color, int32_t thickness = 1, bool is_closed = false);
+    void AddCircle(const cv::Point& center, int32_t radius, const cv::Scalar& color, int32_t thickness = 1);
+    void AddText(const std::string& text, const cv::Point& pos, double font_scale, int32_t thickness, const cv::Scalar& color_front, const cv::Scalar& color_back, bool is_text_on_rect = true, bool use_cache = true);
+
+    void Render(cv::Mat& mat);
+    void RenderAsync(cv::Mat& mat);
+    void Wait();
+
+private:
+    typedef struct Text_ {
+        std::string text;
+        cv::Point   pos;
+        double      font_scale;
+        int32_t     thickness;
+        cv::Scalar  color_front;
+        cv::Scalar  color_back;
+        bool        is_text_on_rect;
+        bool        use_cache;
+    } Text;
+
+    typedef struct Circle_ {
+        cv::Point   center;
+        int32_t     radius;
+        cv::Scalar  color;
+        int32_t     thickness;
+    } Circle;
+
+    typedef struct Glyph_ {
+        cv::Mat     image;
+        cv::Mat     mask;
+        cv::Point   offset;     /* top-left position from the text position */
+    } Glyph;
+
+    typedef struct DrawList_ {
+        /* key = (color, thickness) */
+        std::map<std::pair<std::array<double, 4>, int32_t>, std::vector<std::vector<cv::Point>>> polyline_open_list;
+        std::map<std::pair<std::array<double, 4>, int32_t>, std::vector<std::vector<cv::Point>>> polyline_closed_list;
+        std::map<std::pair<std::array<double, 4>, int32_t>, std::vector<std::vector<cv::Point>>> polygon_filled_list;
+        std::vector<Circle> circle_list;
+        std::vector<Text>   text_list;
+        void Clear() {
+            polyline_open_list.clear();
+            polyline_closed_list.clear();
+            polygon_filled_list.clear();
+            circle_list.clear();
+            text_list.clear();
+        }
+    } DrawList;
+
+private:
+    void RenderDrawList(const DrawList& draw_list, cv::Mat& mat);
+    const Glyph& GetGlyph(const Text& text);
+    void CreateGlyph(const Text& text, Glyph& glyph);
+    void BlitGlyph(const Glyph& glyph, const cv::Point& pos, cv::Mat& mat);
+    void ThreadMain();
+
+private:
+    int32_t mode_;
+    DrawList draw_list_;
+
+    int32_t max_glyph_cache_num_;
+    std::unordered_map<std::string, Glyph> glyph_cache_;
+
+    /* for worker thread */
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool is_thread_exit_;
+    bool is_job_requested_;
+    DrawList draw_list_job_;
+    cv::Mat mat_job_;
+};
+
+#endif
@@ -0,0 +1,247 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <chrono>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+/* for My modules */
+#include "common_helper.h"
+#include "metrics.h"
+#include "perf_counter.h"
+
+/*** Macro ***/
+#define TAG "PerfCounter"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static const char* kEventNameList[PerfCounter::kEventNum] = { "cycles", "instructions", "l1d_miss", "llc_miss", "branch_miss", "context_switch" };
+
+/*** Global variable ***/
+typedef struct Stage_ {
+    std::string name;
+    uint64_t    num_call;
+    PerfCounter::Value value_sum;
+    std::array<bool, PerfCounter::kEventNum> is_available;
+    Metrics::Histogram* metrics_latency;
+    std::array<Metrics::Counter*, PerfCounter::kEventNum> metrics_counter;
+} Stage;
+
+static std::mutex s_mutex;
+
+/*** Function ***/
+/* Stages can be registered from static initializers of other modules. So create the list at the first use */
+static std::vector<std::unique_ptr<Stage>>& GetStageList()
+{
+    static std::vector<std::unique_ptr<Stage>> s_stage_list;
+    return s_stage_list;
+}
+
+#ifdef __linux__
+/* Counters of the calling thread and its child threads */
+class ThreadCounter {
+public:
+    ThreadCounter()
+    {
+        for (int32_t event = 0; event < PerfCounter::kEventNum; event++) {
+            fd_list_[event] = Open(event);
+        }
+    }
+
+    ~ThreadCounter()
+    {
+        for (int32_t fd : fd_list_) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    bool IsAvailable(int32_t event) const
+    {
+        return fd_list_[event] >= 0;
+    }
+
+    void Read(PerfCounter::Value& value) const
+    {
+        for (int32_t event = 0; event < PerfCounter::kEventNum; event++) {
+            value[event] = 0;
+            if (fd_list_[event] < 0) continue;
+            uint64_t data[3] = { 0 };   /* value, time enabled, time running */
+            if (read(fd_list_[event], data, sizeof(data)) != sizeof(data)) continue;
+            /* scale when the counter was multiplexed with others */
+            value[event] = (data[2] > 0 && data[2] < data[1]) ? static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]) : data[0];
+        }
+    }
+
+private:
+    static int32_t Open(int32_t event)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;   /* worker threads (e.g. XNNPACK threadpool) do most of the work of inference */
+        switch (event) {
+        case PerfCounter::kEventCycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PerfCounter::kEventInstructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PerfCounter::kEventL1dMiss:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PerfCounter::kEventLlcMiss:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PerfCounter::kEventBranchMiss:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case PerfCounter::kEventContextSwitch:
+        default:
+            attr.type = PERF_TYPE_SOFTWARE;
+            attr.config = PERF_COUNT_SW_CONTEXT_SWITCHES;
+            break;
+        }
+        /* Count kernel too if allowed. otherwise user space only (perf_event_paranoid >= 2) */
+        for (int32_t exclude_kernel = 0; exclude_kernel <= 1; exclude_kernel++) {
+            attr.exclude_kernel = exclude_kernel;
+            int32_t fd = static_cast<int32_t>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+            if (fd >= 0) return fd;
+        }
+        return -1;
+    }
+
+private:
+    std::array<int32_t, PerfCounter::kEventNum> fd_list_;
+};
+#else
+class ThreadCounter {
+public:
+    bool IsAvailable(int32_t event) const { return false; }
+    void Read(PerfCounter::Value& value) const { value.fill(0); }
+};
+#endif
+
+static ThreadCounter& GetThreadCounter()
+{
+    static thread_local ThreadCounter s_thread_counter;
+    return s_thread_counter;
+}
+
+void PerfCounter::Initialize()
+{
+    (void)GetThreadCounter();
+}
+
+int32_t PerfCounter::RegisterStage(const char* name)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto& stage_list = GetStageList();
+    for (size_t i = 0; i < stage_list.size(); i++) {
+        if (stage_list[i]->name == name) return static_cast<int32_t>(i);
+    }
+    std::unique_ptr<Stage> stage(new Stage());
+    stage->name = name;
+    stage->num_call = 0;
+    stage->value_sum.fill(0);
+    stage->is_available.fill(false);
+    stage->metrics_latency = &Metrics::GetHistogram("perf_stage_latency_msec", "stage", name, "Processing time of each stage measured with performance counters");
+    for (int32_t event = 0; event < kEventNum; event++) {
+        stage->metrics_counter[event] = &Metrics::GetCounter(std::string("perf_") + kEventNameList[event] + "_total", "stage", name);
+    }
+    stage_list.push_back(std::move(stage));
+    return static_cast<int32_t>(stage_list.size()) - 1;
+}
+
+bool PerfCounter::IsAvailable(int32_t event)
+{
+    return (event >= 0 && event < kEventNum) ? GetThreadCounter().IsAvailable(event) : false;
+}
+
+PerfCounter::Scope::Scope(int32_t stage_id)
+{
+    stage_id_ = stage_id;
+    GetThreadCounter().Read(value_start_);
+    time_start_ = std::chrono::steady_clock::now();
+}
+
+PerfCounter::Scope::~Scope()
+{
+    const auto& time_end = std::chrono::steady_clock::now();
+    Value value_end;
+    const ThreadCounter& thread_counter = GetThreadCounter();
+    thread_counter.Read(value_end);
+    const double time = static_cast<std::chrono::duration<double>>(time_end - time_start_).count() * 1000.0;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto& stage_list = GetStageList();
+    if (stage_id_ < 0 || stage_id_ >= static_cast<int32_t>(stage_list.size())) return;
+    Stage& stage = *stage_list[stage_id_];
+    stage.num_call++;
+    stage.metrics_latency->Observe(time);
+    for (int32_t event = 0; event < kEventNum; event++) {
+        if (!thread_counter.IsAvailable(event)) continue;
+        const uint64_t delta = (value_end[event] > value_start_[event]) ? value_end[event] - value_start_[event] : 0;
+        stage.value_sum[event] += delta;
+        stage.is_available[event] = true;
+        stage.metrics_counter[event]->Add(delta);
+    }
+}
+
+void PerfCounter::Print()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    printf("=== Performance counters per stage (including threads created after the counters were opened) ===\n");
+    printf("  %-16s %8s %9s %9s %9s %6s %9s %9s %9s %8s\n", "stage", "calls", "mean[ms]", "p50<[ms]", "p90<[ms]", "IPC", "L1D MPKI", "LLC MPKI", "BR MPKI", "CS/call");
+    for (const auto& stage : GetStageList()) {
+        if (stage->num_call == 0) continue;
+        const auto& histogram = *stage->metrics_latency;
+        const double instructions = static_cast<double>(stage->value_sum[kEventInstructions]);
+        const bool has_instructions = stage->is_available[kEventInstructions] && instructions > 0;
+        char ipc[16] = "n/a";
+        char l1d_mpki[16] = "n/a";
+        char llc_mpki[16] = "n/a";
+        char branch_mpki[16] = "n/a";
+        char context_switch[16] = "n/a";
+        if (has_instructions && stage->is_available[kEventCycles] && stage->value_sum[kEventCycles] > 0) snprintf(ipc, sizeof(ipc), "%.2f", instructions / stage->value_sum[kEventCycles]);
+        if (has_instructions && stage->is_available[kEventL1dMiss]) snprintf(l1d_mpki, sizeof(l1d_mpki), "%.2f", stage->value_sum[kEventL1dMiss] * 1000.0 / instructions);
+        if (has_instructions && stage->is_available[kEventLlcMiss]) snprintf(llc_mpki, sizeof(llc_mpki), "%.2f", stage->value_sum[kEventLlcMiss] * 1000.0 / instructions);
+        if (has_instructions && stage->is_available[kEventBranchMiss]) snprintf(branch_mpki, sizeof(branch_mpki), "%.2f", stage->value_sum[kEventBranchMiss] * 1000.0 / instructions);
+        if (stage->is_available[kEventContextSwitch]) snprintf(context_switch, sizeof(context_switch), "%.2f", static_cast<double>(stage->value_sum[kEventContextSwitch]) / stage->num_call);
+        printf("  %-16s %8llu %9.3f %9.3f %9.3f %6s %9s %9s %9s %8s\n", stage->name.c_str(), static_cast<unsigned long long>(stage->num_call),
+            histogram.GetSum() / histogram.GetCount(), histogram.GetPercentile(0.5), histogram.GetPercentile(0.9),
+            ipc, l1d_mpki, llc_mpki, branch_mpki, context_switch);
+    }
+    printf("  (p50< / p90< : upper bound of the histogram bucket)\n");
+}
@@ -0,0 +1,59 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef PERF_COUNTER_
+#define PERF_COUNTER_
+
+/* for general */
+#include <cstdint>
+#include <array>
+#include <chrono>
+
+/* Hardware performance counters for each stage (Linux perf_event_open) */
+/*   - counters are opened for each thread at Initialize or the first Scope. They count the thread and threads created by it after that */
+/*     (e.g. XNNPACK / OpenMP workers), so call Initialize before creating engines. Other threads running during a stage are counted too */
+/*   - when perf_event_open is not permitted (container, perf_event_paranoid, not Linux), the event is shown as n/a and only time is measured */
+/*   - each stage is also exported to Metrics: perf_stage_latency_msec{stage} and perf_<event>_total{stage} */
+class PerfCounter {
+public:
+    enum {
+        kEventCycles = 0,
+        kEventInstructions,
+        kEventL1dMiss,
+        kEventLlcMiss,
+        kEventBranchMiss,
+        kEventContextSwitch,
+        kEventNum,
+    };
+    typedef std::array<uint64_t, kEventNum> Value;
+
+    /* Measure the stage while alive */
+    class Scope {
+    public:
+        Scope(int32_t stage_id);
+        ~Scope();
+    private:
+        int32_t stage_id_;
+        Value value_start_;
+        std::chrono::steady_clock::time_point time_start_;
+    };
+
+public:
+    static void Initialize();                           /* open counters of the calling thread */
+    static int32_t RegisterStage(const char* name);     /* returns the same id for the same name. call once and cache it */
+    static bool IsAvailable(int32_t event);             /* on the calling thread */
+    static void Print();
+};
+
+#endif
@@ -0,0 +1,161 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <algorithm>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "segmentation_map.h"
+#include "person_roi_tracker.h"
+
+/*** Macro ***/
+static constexpr float kMinRoiRatio = 0.25f;        /* the crop is not smaller than 1/4 of the image (too much zoom doesn't help) */
+static constexpr float kMarginTruncated = 0.5f;     /* extra margin to the side where the person touches the crop border */
+
+
+PersonRoiTracker::PersonRoiTracker(float margin_ratio, float smooth_ratio, float min_area_ratio)
+{
+    margin_ratio_ = margin_ratio;
+    smooth_ratio_ = smooth_ratio;
+    min_area_ratio_ = min_area_ratio;
+    aspect_ratio_ = 0;
+    Reset();
+}
+
+PersonRoiTracker::~PersonRoiTracker()
+{
+}
+
+void PersonRoiTracker::SetAspectRatio(float aspect_ratio)
+{
+    aspect_ratio_ = aspect_ratio;
+}
+
+void PersonRoiTracker::Reset()
+{
+    is_tracking_ = false;
+    roi_ = cv::Rect2f();
+}
+
+bool PersonRoiTracker::IsTracking() const
+{
+    return is_tracking_;
+}
+
+cv::Rect PersonRoiTracker::GetRoi(const cv::Size& image_size) const
+{
+    const cv::Rect image_rect(0, 0, image_size.width, image_size.height);
+    if (!is_tracking_) return image_rect;
+    cv::Rect roi(cvRound(roi_.x), cvRound(roi_.y), cvRound(roi_.width), cvRound(roi_.height));
+    roi &= image_rect;
+    return (roi.area() > 0) ? roi : image_rect;
+}
+
+void PersonRoiTracker::UpdateByMask(const SegmentationMap& mask, double threshold, const cv::Size& image_size)
+{
+    if (mask.IsEmpty()) {
+        Reset();
+        return;
+    }
+    const cv::Mat& map = mask.GetMap();
+    const cv::Rect& crop = mask.GetCrop();
+    const cv::Mat binary = map > threshold;
+    const int32_t num_pixel = cv::countNonZero(binary);
+    const float scale_x = static_cast<float>(crop.width) / map.cols;
+    const float scale_y = static_cast<float>(crop.height) / map.rows;
+    if (num_pixel * scale_x * scale_y < min_area_ratio_ * image_size.area()) {
+        /* lost. go back to full frame to find the person again */
+        Reset();
+        return;
+    }
+
+    /* Person area in the image */
+    const cv::Rect bbox_map = cv::boundingRect(binary);
+    cv::Rect2f target(crop.x + bbox_map.x * scale_x, crop.y + bbox_map.y * scale_y, bbox_map.width * scale_x, bbox_map.height * scale_y);
+
+    /* The person may be cut by the crop. extend to that side unless it's the image border */
+    const float extra_x = target.width * kMarginTruncated;
+    const float extra_y = target.height * kMarginTruncated;
+    if (bbox_map.x == 0 && crop.x > 0) {
+        target.x -= extra_x;
+        target.width += extra_x;
+    }
+    if (bbox_map.x + bbox_map.width == map.cols && crop.x + crop.width < image_size.width) {
+        target.width += extra_x;
+    }
+    if (bbox_map.y == 0 && crop.y > 0) {
+        target.y -= extra_y;
+        target.height += extra_y;
+    }
+    if (bbox_map.y + bbox_map.height == map.rows && crop.y + crop.height < image_size.height) {
+        target.height += extra_y;
+    }
+
+    UpdateTarget(target, image_size);
+}
+
+void PersonRoiTracker::UpdateByBox(const cv::Rect& box, const cv::Size& image_size)
+{
+    if (box.area() <= 0 || box.area() < min_area_ratio_ * image_size.area()) {
+        Reset();
+        return;
+    }
+    UpdateTarget(cv::Rect2f(static_cast<float>(box.x), static_cast<float>(box.y), static_cast<float>(box.width), static_cast<float>(box.height)), image_size);
+}
+
+void PersonRoiTracker::UpdateTarget(cv::Rect2f target, const cv::Size& image_size)
+{
+    /* Add margin */
+    target.x -= target.width * margin_ratio_;
+    target.y -= target.height * margin_ratio_;
+    target.width *= 1.0f + margin_ratio_ * 2;
+    target.height *= 1.0f + margin_ratio_ * 2;
+
+    /* Match the aspect ratio of the model input (expand only), and keep the minimum size */
+    const float aspect_ratio = (aspect_ratio_ > 0) ? aspect_ratio_ : static_cast<float>(image_size.width) / image_size.height;
+    float width = (std::max)(target.width, target.height * aspect_ratio);
+    float height = width / aspect_ratio;
+    const float height_min = (std::min)(image_size.height * kMinRoiRatio, image_size.width * kMinRoiRatio / aspect_ratio);
+    if (height < height_min) {
+        height = height_min;
+        width = height * aspect_ratio;
+    }
+    cv::Point2f center(target.x + target.width / 2, target.y + target.height / 2);
+
+    /* Stabilize: grow immediately, shrink and move slowly, but always contain the target */
+    if (is_tracking_) {
+        const cv::Point2f center_previous(roi_.x + roi_.width / 2, roi_.y + roi_.height / 2);
+        if (width < roi_.width) width = roi_.width + (width - roi_.width) * smooth_ratio_;
+        if (height < roi_.height) height = roi_.height + (height - roi_.height) * smooth_ratio_;
+        cv::Point2f center_smoothed = center_previous + (center - center_previous) * smooth_ratio_;
+        center_smoothed.x = (std::max)(center_smoothed.x, target.x + target.width - width / 2);
+        center_smoothed.x = (std::min)(center_smoothed.x, target.x + width / 2);
+        center_smoothed.y = (std::max)(center_smoothed.y, target.y + target.height - height / 2);
+        center_smoothed.y = (std::min)(center_smoothed.y, target.y + height / 2);
+        center = center_smoothed;
+    }
+
+    /* Keep inside the image (the engine pads if the aspect ratio doesn't match after clipping) */
+    width = (std::min)(width, static_cast<float>(image_size.width));
+    height = (std::min)(height, static_cast<float>(image_size.height));
+    float x = (std::max)(0.0f, (std::min)(center.x - width / 2, image_size.width - width));
+    float y = (std::max)(0.0f, (std::min)(center.y - height / 2, image_size.height - height));
+    roi_ = cv::Rect2f(x, y, width, height);
+    is_tracking_ = true;
+}
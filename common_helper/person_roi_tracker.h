@@ -0,0 +1,60 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef PERSON_ROI_TRACKER_
+#define PERSON_ROI_TRACKER_
+
+/* for general */
+#include <cstdint>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "segmentation_map.h"
+
+/* Decide the crop area for the next frame of person segmentation / matting */
+/*   - the crop follows the person area of the previous mask (or a detector box) with margin */
+/*   - the crop has the aspect ratio of the model input, and is kept inside the image as much as possible */
+/*   - it grows immediately and shrinks / moves slowly to avoid jitter */
+/*   - it falls back to the full frame when the person is lost */
+class PersonRoiTracker {
+public:
+    PersonRoiTracker(float margin_ratio = 0.2f, float smooth_ratio = 0.3f, float min_area_ratio = 0.005f);
+    ~PersonRoiTracker();
+
+    void SetAspectRatio(float aspect_ratio);    /* width / height of the model input. 0 = same as image */
+    void Reset();
+
+    bool IsTracking() const;
+    cv::Rect GetRoi(const cv::Size& image_size) const;     /* full frame when not tracking */
+
+    /* pixels whose value > threshold are regarded as person */
+    void UpdateByMask(const SegmentationMap& mask, double threshold, const cv::Size& image_size);
+    void UpdateByBox(const cv::Rect& box, const cv::Size& image_size);
+
+private:
+    void UpdateTarget(cv::Rect2f target, const cv::Size& image_size);
+
+private:
+    float margin_ratio_;
+    float smooth_ratio_;
+    float min_area_ratio_;
+    float aspect_ratio_;
+
+    bool is_tracking_;
+    cv::Rect2f roi_;
+};
+
+#endif
@@ -0,0 +1,104 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/* for general */
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+/* for My modules */
+#include "qos_controller.h"
+
+static constexpr double kHeadroomToGoUp = 0.7;      /* go up only when the estimated time < deadline * 0.7 */
+static constexpr int32_t kIntervalToGoUp = 30;      /* [frame] */
+static constexpr int32_t kIntervalToGoDown = 5;     /* [frame]. wait until the effect of the previous change appears in EWMA */
+
+
+QosController::QosController(int32_t level_num, double deadline, double ewma_alpha)
+{
+    level_num_ = (std::max)(1, level_num);
+    deadline_ = deadline;
+    ewma_alpha_ = ewma_alpha;
+    Reset();
+}
+
+QosController::~QosController()
+{
+}
+
+void QosController::Reset()
+{
+    level_ = 0;
+    cnt_frame_since_change_ = 0;
+    stage_time_ewma_list_.clear();
+}
+
+void QosController::SetDeadline(double deadline)
+{
+    deadline_ = deadline;
+    if (deadline_ <= 0) level_ = 0;
+}
+
+void QosController::Feedback(int32_t stage, double time)
+{
+    if (stage < 0) return;
+    if (stage >= static_cast<int32_t>(stage_time_ewma_list_.size())) {
+        stage_time_ewma_list_.resize(stage + 1, -1);
+    }
+    double& ewma = stage_time_ewma_list_[stage];
+    ewma = (ewma < 0) ? time : (1.0 - ewma_alpha_) * ewma + ewma_alpha_ * time;
+}
+
+int32_t QosController::Update()
+{
+    if (deadline_ <= 0) return level_;
+
+    cnt_frame_since_change_++;
+    double time_estimated = GetEstimatedTime();
+    if (time_estimated > deadline_) {
+        if (level_ < level_num_ - 1 && cnt_frame_since_change_ >= kIntervalToGoDown) {
+            level_++;
+            cnt_frame_since_change_ = 0;
+        }
+    } else if (time_estimated < deadline_ * kHeadroomToGoUp) {
+        if (level_ > 0 && cnt_frame_since_change_ >= kIntervalToGoUp) {
+            level_--;
+            cnt_frame_since_change_ = 0;
+        }
+    } else {
+        /* keep the current level, and restart counting for recovery */
+        cnt_frame_since_change_ = (std::min)(cnt_frame_since_change_, kIntervalToGoDown);
+    }
+    return level_;
+}
+
+int32_t QosController::GetLevel() const
+{
+    return level_;
+}
+
+double QosController::GetEstimatedTime() const
+{
+    double time = 0;
+    for (double ewma : stage_time_ewma_list_) {
+        if (ewma > 0) time += ewma;
+    }
+    return time;
+}
+
+double QosController::GetStageTime(int32_t stage) const
+{
+    if (stage < 0 || stage >= static_cast<int32_t>(stage_time_ewma_list_.size())) return 0;
+    return (std::max)(0.0, stage_time_ewma_list_[stage]);
+}
@@ -0,0 +1,50 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef QOS_CONTROLLER_
+#define QOS_CONTROLLER_
+
+/* for general */
+#include <cstdint>
+#include <vector>
+
+/* Decide degradation level of a pipeline from processing time of each stage and frame deadline */
+/*   - level 0 = full processing. Larger level = more work is dropped (what to drop is decided by the user) */
+/*   - goes down one level when the estimated frame time exceeds the deadline, */
+/*     and goes up one level when there is enough headroom for a while */
+class QosController {
+public:
+    QosController(int32_t level_num, double deadline = 0, double ewma_alpha = 0.2);
+    ~QosController();
+
+    void Reset();
+    void SetDeadline(double deadline);
+    void Feedback(int32_t stage, double time);
+    int32_t Update();
+
+    int32_t GetLevel() const;
+    double GetEstimatedTime() const;
+    double GetStageTime(int32_t stage) const;
+
+private:
+    int32_t level_num_;
+    int32_t level_;
+    int32_t cnt_frame_since_change_;
+
+    double deadline_;   /* [msec]. 0 = QoS off (always level 0) */
+    double ewma_alpha_;
+    std::vector<double> stage_time_ewma_list_;  /* [msec] */
+};
+
+#endif
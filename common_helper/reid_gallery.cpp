@@ -0,0 +1,370 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/* for general */
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+/* for My modules */
+#include "common_helper.h"
+#include "reid_gallery.h"
+
+/*** Macro ***/
+#define TAG "ReidGallery"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static constexpr float kMomentum = 0.9f;        /* weight of the stored feature when merging a new feature */
+static constexpr int32_t kMinNumPerList = 4;    /* start using index when the gallery has (num_list * kMinNumPerList) entries */
+static constexpr int32_t kNumIterationTrain = 5;
+static constexpr uint32_t kFileMagic = 0x47444952;  /* "RIDG" */
+static constexpr uint32_t kFileVersion = 1;
+
+
+ReidGallery::ReidGallery(int32_t dim, int32_t capacity, int32_t num_list, int32_t num_probe)
+{
+    dim_ = dim;
+    capacity_ = capacity;
+    num_list_ = num_list;
+    num_probe_ = (std::min)(num_probe, num_list);
+    Reset();
+}
+
+ReidGallery::~ReidGallery()
+{
+}
+
+void ReidGallery::Reset()
+{
+    feature_store_.assign(static_cast<size_t>(capacity_) * dim_, 0.0f);
+    entry_list_.assign(capacity_, Entry());
+    id_to_slot_.clear();
+    free_slot_list_.clear();
+    for (int32_t slot = capacity_ - 1; slot >= 0; slot--) {
+        free_slot_list_.push_back(slot);
+    }
+    centroid_list_.clear();
+    inverted_list_.clear();
+    size_at_train_ = 0;
+    num_insert_since_train_ = 0;
+}
+
+void ReidGallery::Normalize(std::vector<float>& feature)
+{
+    float norm = 0;
+    for (const auto& val : feature) norm += val * val;
+    if (norm == 0) return;
+    norm = 1.0f / std::sqrt(norm);
+    for (auto& val : feature) val *= norm;
+}
+
+float ReidGallery::Dot(const float* feature0, const float* feature1, int32_t dim)
+{
+    float dot = 0;
+    for (int32_t i = 0; i < dim; i++) {
+        dot += feature0[i] * feature1[i];
+    }
+    return dot;
+}
+
+void ReidGallery::Update(int32_t id, const std::vector<float>& feature, int32_t frame)
+{
+    if (static_cast<int32_t>(feature.size()) != dim_) return;
+
+    std::vector<float> feature_norm = feature;
+    Normalize(feature_norm);
+
+    int32_t slot = -1;
+    const auto& it = id_to_slot_.find(id);
+    if (it != id_to_slot_.end()) {
+        /* Merge into the stored feature (moving average) */
+        slot = it->second;
+        float* stored = &feature_store_[static_cast<size_t>(slot) * dim_];
+        float norm = 0;
+        for (int32_t i = 0; i < dim_; i++) {
+            stored[i] = kMomentum * stored[i] + (1.0f - kMomentum) * feature_norm[i];
+            norm += stored[i] * stored[i];
+        }
+        if (norm > 0) {
+            norm = 1.0f / std::sqrt(norm);
+            for (int32_t i = 0; i < dim_; i++) stored[i] *= norm;
+        }
+        RemoveFromList(slot);
+        entry_list_[slot].count++;
+    } else {
+        slot = AllocateSlot();
+        std::copy(feature_norm.begin(), feature_norm.end(), feature_store_.begin() + static_cast<size_t>(slot) * dim_);
+        entry_list_[slot].id = id;
+        entry_list_[slot].count = 1;
+        id_to_slot_[id] = slot;
+        num_insert_since_train_++;
+    }
+    entry_list_[slot].last_seen = frame;
+    entry_list_[slot].is_active = true;
+    AddToList(slot);
+
+    /* (Re)build index when the gallery has doubled or its entries have been replaced as many times as it had at the last training */
+    /* (a full gallery doesn't grow, but eviction replaces its population and the centroids go stale) */
+    if (size_at_train_ == 0 ? GetSize() >= num_list_ * kMinNumPerList : num_insert_since_train_ >= size_at_train_) {
+        TrainIndex();
+    }
+}
+
+void ReidGallery::SetActive(int32_t id, bool is_active)
+{
+    const auto& it = id_to_slot_.find(id);
+    if (it != id_to_slot_.end()) {
+        entry_list_[it->second].is_active = is_active;
+    }
+}
+
+bool ReidGallery::Search(const std::vector<float>& feature, int32_t& id, float& similarity, bool exclude_active)
+{
+    id = -1;
+    similarity = -1.0f;
+    if (static_cast<int32_t>(feature.size()) != dim_ || GetSize() == 0) return false;
+
+    std::vector<float> feature_norm = feature;
+    Normalize(feature_norm);
+
+    int32_t best_slot = -1;
+    auto check_slot = [&](int32_t slot) {
+        const Entry& entry = entry_list_[slot];
+        if (entry.id < 0 || (exclude_active && entry.is_active)) return;
+        float val = Dot(feature_norm.data(), &feature_store_[static_cast<size_t>(slot) * dim_], dim_);
+        if (val > similarity) {
+            similarity = val;
+            best_slot = slot;
+        }
+    };
+
+    if (size_at_train_ == 0) {
+        /* Index is not built yet. The gallery is small enough to check all */
+        for (int32_t slot = 0; slot < capacity_; slot++) check_slot(slot);
+    } else {
+        /* Check the lists of the nearest num_probe centroids only */
+        std::vector<std::pair<float, int32_t>> score_list(num_list_);
+        for (int32_t i = 0; i < num_list_; i++) {
+            score_list[i] = std::make_pair(Dot(feature_norm.data(), &centroid_list_[static_cast<size_t>(i) * dim_], dim_), i);
+        }
+        std::partial_sort(score_list.begin(), score_list.begin() + num_probe_, score_list.end(),
+            [](const std::pair<float, int32_t>& lhs, const std::pair<float, int32_t>& rhs) { return lhs.first > rhs.first; });
+        for (int32_t i = 0; i < num_probe_; i++) {
+            for (const auto& slot : inverted_list_[score_list[i].second]) check_slot(slot);
+        }
+    }
+
+    if (best_slot < 0) return false;
+    id = entry_list_[best_slot].id;
+    return true;
+}
+
+int32_t ReidGallery::Save(const std::string& filename) const
+{
+    std::ofstream ofs(filename, std::ios::binary);
+    if (ofs.fail()) {
+        PRINT_E("Failed to open %s\n", filename.c_str());
+        return kRetErr;
+    }
+    uint32_t header[4] = { kFileMagic, kFileVersion, static_cast<uint32_t>(dim_), static_cast<uint32_t>(GetSize()) };
+    ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (int32_t slot = 0; slot < capacity_; slot++) {
+        const Entry& entry = entry_list_[slot];
+        if (entry.id < 0) continue;
+        int32_t info[3] = { entry.id, entry.last_seen, entry.count };
+        ofs.write(reinterpret_cast<const char*>(info), sizeof(info));
+        ofs.write(reinterpret_cast<const char*>(&feature_store_[static_cast<size_t>(slot) * dim_]), sizeof(float) * dim_);
+    }
+    return ofs.good() ? kRetOk : kRetErr;
+}
+
+int32_t ReidGallery::Load(const std::string& filename)
+{
+    std::ifstream ifs(filename, std::ios::binary);
+    if (ifs.fail()) {
+        PRINT_E("Failed to open %s\n", filename.c_str());
+        return kRetErr;
+    }
+    uint32_t header[4] = { 0 };
+    ifs.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!ifs.good() || header[0] != kFileMagic || header[1] != kFileVersion || header[2] != static_cast<uint32_t>(dim_)) {
+        PRINT_E("Invalid gallery file: %s\n", filename.c_str());
+        return kRetErr;
+    }
+
+    Reset();
+    int32_t num = (std::min)(static_cast<int32_t>(header[3]), capacity_);
+    for (int32_t i = 0; i < num; i++) {
+        int32_t info[3] = { 0 };
+        ifs.read(reinterpret_cast<char*>(info), sizeof(info));
+        if (id_to_slot_.count(info[0]) > 0) {
+            /* Duplicate id. Keep the first one so that every slot can be looked up by id */
+            ifs.seekg(sizeof(float) * dim_, std::ios::cur);
+            if (!ifs.good()) {
+                PRINT_E("Broken gallery file: %s\n", filename.c_str());
+                Reset();
+                return kRetErr;
+            }
+            continue;
+        }
+        int32_t slot = AllocateSlot();
+        ifs.read(reinterpret_cast<char*>(&feature_store_[static_cast<size_t>(slot) * dim_]), sizeof(float) * dim_);
+        if (!ifs.good()) {
+            PRINT_E("Broken gallery file: %s\n", filename.c_str());
+            Reset();
+            return kRetErr;
+        }
+        entry_list_[slot].id = info[0];
+        entry_list_[slot].last_seen = info[1];
+        entry_list_[slot].count = info[2];
+        entry_list_[slot].is_active = false;
+        id_to_slot_[info[0]] = slot;
+    }
+
+    /* Frame numbers restart at 0 in this run. Rebase loaded ones to negative values so that they are evicted before new objects */
+    int32_t last_seen_max = 0;
+    for (const auto& it : id_to_slot_) last_seen_max = (std::max)(last_seen_max, entry_list_[it.second].last_seen);
+    for (const auto& it : id_to_slot_) entry_list_[it.second].last_seen -= last_seen_max + 1;
+
+    if (GetSize() >= num_list_ * kMinNumPerList) {
+        TrainIndex();
+    }
+    return kRetOk;
+}
+
+int32_t ReidGallery::GetSize() const
+{
+    return static_cast<int32_t>(id_to_slot_.size());
+}
+
+int32_t ReidGallery::GetMaxId() const
+{
+    int32_t max_id = -1;
+    for (const auto& it : id_to_slot_) max_id = (std::max)(max_id, it.first);
+    return max_id;
+}
+
+int32_t ReidGallery::AllocateSlot()
+{
+    if (!free_slot_list_.empty()) {
+        int32_t slot = free_slot_list_.back();
+        free_slot_list_.pop_back();
+        return slot;
+    }
+
+    /* Gallery is full. Evict the oldest lost object (or the oldest object if all objects are active) */
+    int32_t slot_evict = -1;
+    for (int32_t slot = 0; slot < capacity_; slot++) {
+        const Entry& entry = entry_list_[slot];
+        if (slot_evict < 0) {
+            slot_evict = slot;
+            continue;
+        }
+        const Entry& entry_evict = entry_list_[slot_evict];
+        if (entry_evict.is_active && !entry.is_active) {
+            slot_evict = slot;
+        } else if (entry_evict.is_active == entry.is_active && entry.last_seen < entry_evict.last_seen) {
+            slot_evict = slot;
+        }
+    }
+    RemoveFromList(slot_evict);
+    id_to_slot_.erase(entry_list_[slot_evict].id);
+    entry_list_[slot_evict] = Entry();
+    return slot_evict;
+}
+
+void ReidGallery::AddToList(int32_t slot)
+{
+    if (size_at_train_ == 0) return;
+    int32_t list_index = FindNearestList(&feature_store_[static_cast<size_t>(slot) * dim_]);
+    inverted_list_[list_index].push_back(slot);
+    entry_list_[slot].list_index = list_index;
+}
+
+void ReidGallery::RemoveFromList(int32_t slot)
+{
+    int32_t list_index = entry_list_[slot].list_index;
+    if (list_index < 0) return;
+    auto& list = inverted_list_[list_index];
+    auto it = std::find(list.begin(), list.end(), slot);
+    if (it != list.end()) {
+        *it = list.back();
+        list.pop_back();
+    }
+    entry_list_[slot].list_index = -1;
+}
+
+int32_t ReidGallery::FindNearestList(const float* feature) const
+{
+    int32_t list_index = 0;
+    float score_max = -std::numeric_limits<float>::max();
+    for (int32_t i = 0; i < num_list_; i++) {
+        float score = Dot(feature, &centroid_list_[static_cast<size_t>(i) * dim_], dim_);
+        if (score > score_max) {
+            score_max = score;
+            list_index = i;
+        }
+    }
+    return list_index;
+}
+
+void ReidGallery::TrainIndex()
+{
+    std::vector<int32_t> slot_list;
+    for (const auto& it : id_to_slot_) slot_list.push_back(it.second);
+    if (static_cast<int32_t>(slot_list.size()) < num_list_) return;
+    std::sort(slot_list.begin(), slot_list.end());
+
+    /* Spherical k-means. Initial centroids are picked evenly from the stored features */
+    centroid_list_.assign(static_cast<size_t>(num_list_) * dim_, 0.0f);
+    for (int32_t i = 0; i < num_list_; i++) {
+        int32_t slot = slot_list[i * slot_list.size() / num_list_];
+        std::copy(feature_store_.begin() + static_cast<size_t>(slot) * dim_, feature_store_.begin() + static_cast<size_t>(slot + 1) * dim_, centroid_list_.begin() + static_cast<size_t>(i) * dim_);
+    }
+
+    std::vector<float> sum_list(centroid_list_.size());
+    std::vector<int32_t> num_member_list(num_list_);
+    for (int32_t iteration = 0; iteration < kNumIterationTrain; iteration++) {
+        std::fill(sum_list.begin(), sum_list.end(), 0.0f);
+        std::fill(num_member_list.begin(), num_member_list.end(), 0);
+        for (const auto& slot : slot_list) {
+            const float* feature = &feature_store_[static_cast<size_t>(slot) * dim_];
+            int32_t list_index = FindNearestList(feature);
+            float* sum = &sum_list[static_cast<size_t>(list_index) * dim_];
+            for (int32_t i = 0; i < dim_; i++) sum[i] += feature[i];
+            num_member_list[list_index]++;
+        }
+        for (int32_t list_index = 0; list_index < num_list_; list_index++) {
+            if (num_member_list[list_index] == 0) continue;  /* keep the previous centroid */
+            std::vector<float> centroid(sum_list.begin() + static_cast<size_t>(list_index) * dim_, sum_list.begin() + static_cast<size_t>(list_index + 1) * dim_);
+            Normalize(centroid);
+            std::copy(centroid.begin(), centroid.end(), centroid_list_.begin() + static_cast<size_t>(list_index) * dim_);
+        }
+    }
+
+    /* Rebuild inverted lists */
+    inverted_list_.assign(num_list_, std::vector<int32_t>());
+    size_at_train_ = static_cast<int32_t>(slot_list.size());
+    num_insert_since_train_ = 0;
+    for (const auto& slot : slot_list) {
+        entry_list_[slot].list_index = -1;
+        AddToList(slot);
+    }
+}
@@ -0,0 +1,86 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef REID_GALLERY_
+#define REID_GALLERY_
+
+/* for general */
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/* Gallery of re-identification features (embeddings) of active and recently lost objects */
+/* All features are L2-normalised, so cosine similarity = dot product */
+/* Features are stored in one contiguous buffer, and IVF-flat index is used to search (only num_probe lists out of num_list are scanned) */
+class ReidGallery {
+public:
+    enum {
+        kRetOk = 0,
+        kRetErr = -1,
+    };
+
+    typedef struct Entry_ {
+        int32_t id;             /* -1 = free slot */
+        int32_t last_seen;      /* frame number (negative for entries loaded from file) */
+        int32_t count;          /* the number of features merged into this entry */
+        int32_t list_index;     /* index of inverted list (-1 = not indexed yet) */
+        bool    is_active;      /* true = the object is in tracker now */
+        Entry_() : id(-1), last_seen(0), count(0), list_index(-1), is_active(false)
+        {}
+    } Entry;
+
+public:
+    ReidGallery(int32_t dim = 512, int32_t capacity = 2000, int32_t num_list = 32, int32_t num_probe = 4);
+    ~ReidGallery();
+    void Reset();
+
+    void Update(int32_t id, const std::vector<float>& feature, int32_t frame);
+    void SetActive(int32_t id, bool is_active);
+    bool Search(const std::vector<float>& feature, int32_t& id, float& similarity, bool exclude_active = true);
+
+    int32_t Save(const std::string& filename) const;
+    int32_t Load(const std::string& filename);
+
+    int32_t GetSize() const;
+    int32_t GetMaxId() const;
+
+    static void Normalize(std::vector<float>& feature);
+    static float Dot(const float* feature0, const float* feature1, int32_t dim);
+
+private:
+    int32_t AllocateSlot();
+    void AddToList(int32_t slot);
+    void RemoveFromList(int32_t slot);
+    int32_t FindNearestList(const float* feature) const;
+    void TrainIndex();
+
+private:
+    int32_t dim_;
+    int32_t capacity_;
+    int32_t num_list_;
+    int32_t num_probe_;
+
+    std::vector<float> feature_store_;      /* capacity x dim */
+    std::vector<Entry> entry_list_;         /* capacity */
+    std::unordered_map<int32_t, int32_t> id_to_slot_;
+    std::vector<int32_t> free_slot_list_;
+
+    std::vector<float> centroid_list_;      /* num_list x dim */
+    std::vector<std::vector<int32_t>> inverted_list_;   /* slots for each centroid */
+    int32_t size_at_train_;                 /* 0 = not trained yet (brute force search) */
+    int32_t num_insert_since_train_;        /* new entries (including ones which replaced evicted entries) since the last training */
+};
+
+#endif
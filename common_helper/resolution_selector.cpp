@@ -0,0 +1,117 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/* for general */
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+/* for My modules */
+#include "resolution_selector.h"
+
+static constexpr double kHeadroomToGoUp = 0.8;      /* go up only when the estimated time of the higher level < budget * 0.8 */
+static constexpr int32_t kIntervalToGoUp = 10;      /* [frame] */
+
+
+ResolutionSelector::ResolutionSelector(double latency_budget, int32_t min_object_size, double ewma_alpha)
+{
+    current_level_ = 0;
+    cnt_frame_since_change_ = 0;
+    latency_budget_ = latency_budget;
+    min_object_size_ = min_object_size;
+    ewma_alpha_ = ewma_alpha;
+}
+
+ResolutionSelector::~ResolutionSelector()
+{
+}
+
+void ResolutionSelector::AddLevel(int32_t width, int32_t height, double time_initial)
+{
+    /* levels must be added from the highest resolution */
+    level_list_.push_back({ width, height, time_initial });
+}
+
+int32_t ResolutionSelector::Select(int32_t image_width, int32_t image_height, int32_t min_object_size_in_image)
+{
+    const int32_t level_num = GetLevelNum();
+    if (level_num <= 1 || latency_budget_ <= 0) return 0;
+
+    /* The highest resolution which fits in the budget */
+    int32_t level_budget = level_num - 1;
+    for (int32_t level = 0; level < level_num; level++) {
+        if (level_list_[level].time_ewma <= latency_budget_) {
+            level_budget = level;
+            break;
+        }
+    }
+
+    /* The lowest resolution where the smallest object is still large enough */
+    int32_t level_object = 0;
+    if (min_object_size_in_image > 0 && image_width > 0 && image_height > 0) {
+        for (int32_t level = level_num - 1; level >= 0; level--) {
+            float scale = (std::min)(static_cast<float>(level_list_[level].width) / image_width, static_cast<float>(level_list_[level].height) / image_height);
+            if (min_object_size_in_image * scale >= min_object_size_) {
+                level_object = level;
+                break;
+            }
+        }
+    }
+
+    int32_t level_target = (std::max)(level_budget, level_object);
+    cnt_frame_since_change_++;
+    if (level_target > current_level_) {
+        /* Degrade immediately (overloaded or objects are big enough) */
+        current_level_ = level_target;
+        cnt_frame_since_change_ = 0;
+    } else if (level_target < current_level_ && cnt_frame_since_change_ >= kIntervalToGoUp) {
+        /* Recover one step at a time, and only when there is enough headroom */
+        int32_t level_up = current_level_ - 1;
+        if (level_list_[level_up].time_ewma <= latency_budget_ * kHeadroomToGoUp) {
+            current_level_ = level_up;
+            cnt_frame_since_change_ = 0;
+        }
+    }
+    return current_level_;
+}
+
+void ResolutionSelector::Feedback(int32_t level, double time)
+{
+    if (level < 0 || level >= GetLevelNum()) return;
+    Level& lv = level_list_[level];
+    const double time_previous = lv.time_ewma;
+    lv.time_ewma = (1.0 - ewma_alpha_) * lv.time_ewma + ewma_alpha_ * time;
+
+    /* Other levels are not measured now. Scale them by the same ratio so that a transient spike doesn't stay in them */
+    if (time_previous <= 0) return;
+    const double ratio = lv.time_ewma / time_previous;
+    for (int32_t i = 0; i < GetLevelNum(); i++) {
+        if (i != level) level_list_[i].time_ewma *= ratio;
+    }
+}
+
+void ResolutionSelector::SetLatencyBudget(double latency_budget)
+{
+    latency_budget_ = latency_budget;
+}
+
+int32_t ResolutionSelector::GetLevelNum() const
+{
+    return static_cast<int32_t>(level_list_.size());
+}
+
+const ResolutionSelector::Level& ResolutionSelector::GetLevel(int32_t level) const
+{
+    return level_list_[level];
+}
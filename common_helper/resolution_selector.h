@@ -0,0 +1,56 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef RESOLUTION_SELECTOR_
+#define RESOLUTION_SELECTOR_
+
+/* for general */
+#include <cstdint>
+#include <vector>
+
+/* Select input resolution (level) for each frame from latency budget and object size */
+/*   - level 0 is the highest resolution. Larger index = lower resolution */
+/*   - goes down immediately when overloaded, and goes up step by step when there is headroom */
+/*   - only the selected level is measured. The others follow the change ratio of the measured one */
+class ResolutionSelector {
+public:
+    typedef struct Level_ {
+        int32_t width;
+        int32_t height;
+        double  time_ewma;  /* [msec] */
+    } Level;
+
+public:
+    ResolutionSelector(double latency_budget = 0, int32_t min_object_size = 24, double ewma_alpha = 0.2);
+    ~ResolutionSelector();
+
+    void AddLevel(int32_t width, int32_t height, double time_initial);
+    int32_t Select(int32_t image_width, int32_t image_height, int32_t min_object_size_in_image);
+    void Feedback(int32_t level, double time);
+
+    void SetLatencyBudget(double latency_budget);
+    int32_t GetLevelNum() const;
+    const Level& GetLevel(int32_t level) const;
+
+private:
+    std::vector<Level> level_list_;
+    int32_t current_level_;
+    int32_t cnt_frame_since_change_;
+
+    double latency_budget_;     /* [msec]. 0 = adaptive mode off (always level 0) */
+    int32_t min_object_size_;   /* [px] in model input */
+    double ewma_alpha_;
+};
+
+#endif
@@ -0,0 +1,203 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+
+/* for My modules */
+#include "common_helper.h"
+#include "result_store.h"
+
+/*** Macro ***/
+#define TAG "ResultStore"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static constexpr char kMagic[4] = { 'R', 'S', 'T', 'R' };
+static constexpr uint32_t kVersion = 1;
+static constexpr size_t kAlignment = 8;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+} FileHeader;
+
+typedef struct {
+    int64_t frame_index;
+    uint32_t size;
+    uint32_t checksum;      /* lower 32 bits of the payload hash */
+} RecordHeader;
+
+/*** Function ***/
+static size_t Align(size_t size)
+{
+    return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+constexpr uint64_t ResultStore::kHashInit;
+
+ResultStore::ResultStore()
+{
+    size_valid_ = 0;
+    fp_ = nullptr;
+}
+
+ResultStore::~ResultStore()
+{
+    Close();
+}
+
+uint64_t ResultStore::CalculateHash(const void* data, size_t size, uint64_t hash)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t ResultStore::CalculateHash(const std::string& str, uint64_t hash)
+{
+    return CalculateHash(str.data(), str.size(), hash);
+}
+
+bool ResultStore::Load(uint64_t key)
+{
+    /* returns true when the existing records can be used */
+    if (!std::ifstream(filename_).good()) return false;     /* the first run */
+    if (!mapped_file_.Open(filename_)) return false;
+    const uint8_t* data = mapped_file_.GetData();
+    const size_t size = mapped_file_.GetSize();
+
+    FileHeader file_header;
+    if (size < sizeof(file_header)) return false;
+    std::memcpy(&file_header, data, sizeof(file_header));
+    if (std::memcmp(file_header.magic, kMagic, sizeof(kMagic)) != 0 || file_header.version != kVersion) {
+        PRINT_E("Invalid file: %s\n", filename_.c_str());
+        return false;
+    }
+    if (file_header.key != key) {
+        PRINT("Configuration is changed. Stored results are discarded: %s\n", filename_.c_str());
+        return false;
+    }
+
+    size_t offset = sizeof(file_header);
+    while (offset + sizeof(RecordHeader) <= size) {
+        RecordHeader record_header;
+        std::memcpy(&record_header, data + offset, sizeof(record_header));
+        const size_t offset_next = offset + sizeof(record_header) + Align(record_header.size);
+        if (offset_next > size || offset_next <= offset) break;
+        if (static_cast<uint32_t>(CalculateHash(data + offset + sizeof(record_header), record_header.size)) != record_header.checksum) break;
+        record_map_[record_header.frame_index] = offset;
+        offset = offset_next;
+    }
+    size_valid_ = offset;
+    if (size_valid_ < size) PRINT("Broken record at the end is ignored (%zu bytes)\n", size - size_valid_);
+    return true;
+}
+
+int32_t ResultStore::Open(const std::string& filename, uint64_t key)
+{
+    Close();
+    filename_ = filename;
+    if (Load(key)) {
+        fp_ = std::fopen(filename_.c_str(), "r+b");
+        if (fp_ && std::fseek(fp_, static_cast<long>(size_valid_), SEEK_SET) != 0) {
+            std::fclose(fp_);
+            fp_ = nullptr;
+        }
+        if (!fp_) {
+            PRINT_E("Failed to open %s\n", filename_.c_str());
+            Close();
+            return kRetErr;
+        }
+        PRINT("%d frames are stored: %s\n", GetStoredNum(), filename_.c_str());
+        return kRetOk;
+    }
+
+    /* Start a new file */
+    Close();
+    filename_ = filename;
+    fp_ = std::fopen(filename_.c_str(), "wb");
+    if (!fp_) {
+        PRINT_E("Failed to create %s\n", filename_.c_str());
+        return kRetErr;
+    }
+    FileHeader file_header;
+    std::memcpy(file_header.magic, kMagic, sizeof(kMagic));
+    file_header.version = kVersion;
+    file_header.key = key;
+    if (std::fwrite(&file_header, sizeof(file_header), 1, fp_) != 1 || std::fflush(fp_) != 0) {
+        PRINT_E("Failed to write %s\n", filename_.c_str());
+        Close();
+        return kRetErr;
+    }
+    size_valid_ = sizeof(file_header);
+    return kRetOk;
+}
+
+void ResultStore::Close()
+{
+    if (fp_) std::fclose(fp_);
+    fp_ = nullptr;
+    mapped_file_.Close();
+    record_map_.clear();
+    size_valid_ = 0;
+}
+
+bool ResultStore::Find(int64_t frame_index, const uint8_t*& data, uint32_t& size) const
+{
+    auto it = record_map_.find(frame_index);
+    if (it == record_map_.end()) return false;
+    RecordHeader record_header;
+    std::memcpy(&record_header, mapped_file_.GetData() + it->second, sizeof(record_header));
+    data = mapped_file_.GetData() + it->second + sizeof(record_header);
+    size = record_header.size;
+    return true;
+}
+
+int32_t ResultStore::Append(int64_t frame_index, const void* data, uint32_t size)
+{
+    if (!fp_) return kRetErr;
+    RecordHeader record_header;
+    record_header.frame_index = frame_index;
+    record_header.size = size;
+    record_header.checksum = static_cast<uint32_t>(CalculateHash(data, size));
+    static const uint8_t kPadding[kAlignment] = { 0 };
+    const size_t size_padding = Align(size) - size;
+    if (std::fwrite(&record_header, sizeof(record_header), 1, fp_) != 1
+        || (size > 0 && std::fwrite(data, size, 1, fp_) != 1)
+        || (size_padding > 0 && std::fwrite(kPadding, size_padding, 1, fp_) != 1)
+        || std::fflush(fp_) != 0) {
+        PRINT_E("Failed to write %s\n", filename_.c_str());
+        return kRetErr;
+    }
+    size_valid_ += sizeof(record_header) + Align(size);
+    return kRetOk;
+}
+
+int64_t ResultStore::GetResumeIndex() const
+{
+    int64_t frame_index = 0;
+    while (record_map_.count(frame_index) > 0) frame_index++;
+    return frame_index;
+}
@@ -0,0 +1,72 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef RESULT_STORE_
+#define RESULT_STORE_
+
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+/* for My modules */
+#include "mapped_file.h"
+
+/* Append-only file of per-frame results for resumable offline processing */
+/*   - header (magic, version, key) followed by records (frame index, size, checksum, payload). The payload is 8-byte aligned */
+/*   - key: hash of the configuration which produced the results (e.g. models and thresholds). The file is discarded when it changes */
+/*   - the existing file is memory mapped at Open. Find returns a pointer into the mapping (valid until Close) */
+/*   - a record is flushed at each Append (checkpoint). A broken record at the end (crash) is ignored and overwritten */
+/*   - when the same frame is appended again, the last one is used at the next Open */
+class ResultStore {
+public:
+    enum {
+        kRetOk = 0,
+        kRetErr = -1,
+    };
+
+    static constexpr uint64_t kHashInit = 14695981039346656037ULL;
+
+public:
+    ResultStore();
+    ~ResultStore();
+    ResultStore(const ResultStore&) = delete;
+    ResultStore& operator=(const ResultStore&) = delete;
+
+    int32_t Open(const std::string& filename, uint64_t key);
+    void Close();
+    bool IsOpened() const { return fp_ != nullptr; }
+
+    bool Find(int64_t frame_index, const uint8_t*& data, uint32_t& size) const;    /* only records which existed at Open */
+    int32_t Append(int64_t frame_index, const void* data, uint32_t size);
+    int32_t GetStoredNum() const { return static_cast<int32_t>(record_map_.size()); }
+    int64_t GetResumeIndex() const;     /* the first frame which is not stored */
+
+    /* FNV-1a (64bit). Pass the previous hash to combine values */
+    static uint64_t CalculateHash(const void* data, size_t size, uint64_t hash = kHashInit);
+    static uint64_t CalculateHash(const std::string& str, uint64_t hash = kHashInit);
+
+private:
+    bool Load(uint64_t key);
+
+private:
+    std::string filename_;
+    MappedFile mapped_file_;
+    std::unordered_map<int64_t, size_t> record_map_;    /* frame index -> offset of the record header */
+    size_t size_valid_;         /* the end of the last complete record */
+    FILE* fp_;
+};
+
+#endif
@@ -0,0 +1,283 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/* for general */
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "segmentation_map.h"
+
+/*** Fused kernel ***/
+/* Output pixel -> source pixel in the map is precomputed for each column and row, then */
+/* each output pixel is sampled, colorized and blended in the same loop (no intermediate image) */
+static constexpr int32_t kWeightBits = 8;
+static constexpr int32_t kWeightOne = 1 << kWeightBits;
+
+typedef struct SampleTable_ {
+    std::vector<int32_t> index0;
+    std::vector<int32_t> index1;
+    std::vector<int32_t> weight;    /* weight for index1. [0, kWeightOne] */
+} SampleTable;
+
+static void CreateSampleTable(int32_t dst_start, int32_t dst_num, int32_t crop_start, int32_t crop_size, int32_t src_size, bool is_linear, SampleTable& table)
+{
+    table.index0.resize(dst_num);
+    table.index1.resize(dst_num);
+    table.weight.resize(dst_num);
+    const double scale = static_cast<double>(src_size) / crop_size;
+    for (int32_t i = 0; i < dst_num; i++) {
+        const int32_t pos = dst_start + i - crop_start;     /* position in the crop */
+        int32_t index = 0;
+        int32_t weight = 0;
+        if (is_linear) {
+            /* the same sampling position as cv::resize */
+            const double src = (pos + 0.5) * scale - 0.5;
+            index = static_cast<int32_t>(std::floor(src));
+            weight = static_cast<int32_t>((src - index) * kWeightOne + 0.5);
+            if (index < 0) {
+                index = 0;
+                weight = 0;
+            }
+        } else {
+            index = static_cast<int32_t>(std::floor(pos * scale));
+        }
+        if (index >= src_size - 1) {
+            index = src_size - 1;
+            weight = 0;
+        }
+        table.index0[i] = index;
+        table.index1[i] = (std::min)(index + 1, src_size - 1);
+        table.weight[i] = weight;
+    }
+}
+
+/* FETCH(src_y, src_x, int32_t bgra[4]), WRITE(uint8_t* dst_bgr, const int32_t bgra[4]) */
+template <bool IS_LINEAR, typename FETCH, typename WRITE>
+static void RunFusedKernel(cv::Mat& mat_roi, const SampleTable& table_x, const SampleTable& table_y, FETCH fetch, WRITE write)
+{
+#pragma omp parallel for
+    for (int32_t y = 0; y < mat_roi.rows; y++) {
+        uint8_t* dst = mat_roi.ptr<uint8_t>(y);
+        const int32_t sy0 = table_y.index0[y];
+        const int32_t sy1 = table_y.index1[y];
+        const int32_t wy = table_y.weight[y];
+        for (int32_t x = 0; x < mat_roi.cols; x++) {
+            int32_t color[4];
+            if (IS_LINEAR) {
+                int32_t c00[4], c01[4], c10[4], c11[4];
+                const int32_t sx0 = table_x.index0[x];
+                const int32_t sx1 = table_x.index1[x];
+                const int32_t wx = table_x.weight[x];
+                fetch(sy0, sx0, c00);
+                fetch(sy0, sx1, c01);
+                fetch(sy1, sx0, c10);
+                fetch(sy1, sx1, c11);
+                for (int32_t k = 0; k < 4; k++) {
+                    const int32_t top = c00[k] * (kWeightOne - wx) + c01[k] * wx;
+                    const int32_t bottom = c10[k] * (kWeightOne - wx) + c11[k] * wx;
+                    color[k] = (top * (kWeightOne - wy) + bottom * wy + (1 << (kWeightBits * 2 - 1))) >> (kWeightBits * 2);
+                }
+            } else {
+                fetch(sy0, table_x.index0[x], color);
+            }
+            write(dst + x * 3, color);
+        }
+    }
+}
+
+template <typename FETCH, typename WRITE>
+static void RunFusedKernel(cv::Mat& mat, const cv::Rect& roi, const cv::Rect& crop, const cv::Size& map_size, int32_t interpolation, FETCH fetch, WRITE write)
+{
+    const bool is_linear = (interpolation != cv::INTER_NEAREST);
+    SampleTable table_x, table_y;
+    CreateSampleTable(roi.x, roi.width, crop.x, crop.width, map_size.width, is_linear, table_x);
+    CreateSampleTable(roi.y, roi.height, crop.y, crop.height, map_size.height, is_linear, table_y);
+    cv::Mat mat_roi = mat(roi);
+    if (is_linear) {
+        RunFusedKernel<true>(mat_roi, table_x, table_y, fetch, write);
+    } else {
+        RunFusedKernel<false>(mat_roi, table_x, table_y, fetch, write);
+    }
+}
+
+static inline void WriteAdd(uint8_t* dst, const int32_t* color)
+{
+    dst[0] = static_cast<uint8_t>((std::min)(255, dst[0] + color[0]));
+    dst[1] = static_cast<uint8_t>((std::min)(255, dst[1] + color[1]));
+    dst[2] = static_cast<uint8_t>((std::min)(255, dst[2] + color[2]));
+}
+
+static inline void WriteBlend(uint8_t* dst, const int32_t* color)
+{
+    const int32_t alpha = color[3];
+    dst[0] = static_cast<uint8_t>((dst[0] * (255 - alpha) + color[0] * alpha + 127) / 255);
+    dst[1] = static_cast<uint8_t>((dst[1] * (255 - alpha) + color[1] * alpha + 127) / 255);
+    dst[2] = static_cast<uint8_t>((dst[2] * (255 - alpha) + color[2] * alpha + 127) / 255);
+}
+
+
+SegmentationMap::SegmentationMap()
+{
+}
+
+SegmentationMap::SegmentationMap(const cv::Mat& map, const cv::Rect& crop)
+{
+    Set(map, crop);
+}
+
+SegmentationMap::~SegmentationMap()
+{
+}
+
+void SegmentationMap::Set(const cv::Mat& map, const cv::Rect& crop)
+{
+    map_ = map;
+    crop_ = crop;
+}
+
+bool SegmentationMap::IsEmpty() const
+{
+    return map_.empty() || crop_.width <= 0 || crop_.height <= 0;
+}
+
+const cv::Mat& SegmentationMap::GetMap() const
+{
+    return map_;
+}
+
+const cv::Rect& SegmentationMap::GetCrop() const
+{
+    return crop_;
+}
+
+cv::Rect SegmentationMap::GetRoi(const cv::Size& image_size) const
+{
+    return crop_ & cv::Rect(0, 0, image_size.width, image_size.height);
+}
+
+bool SegmentationMap::ConvertToMap(const cv::Point& point_in_image, cv::Point& point_in_map) const
+{
+    if (IsEmpty() || !crop_.contains(point_in_image)) return false;
+    point_in_map.x = (std::min)(map_.cols - 1, (point_in_image.x - crop_.x) * map_.cols / crop_.width);
+    point_in_map.y = (std::min)(map_.rows - 1, (point_in_image.y - crop_.y) * map_.rows / crop_.height);
+    return true;
+}
+
+void SegmentationMap::MaterializeRoi(const cv::Size& image_size, cv::Mat& dst, int32_t interpolation) const
+{
+    const cv::Rect roi = GetRoi(image_size);
+    if (IsEmpty() || roi.area() <= 0) {
+        dst = cv::Mat();
+        return;
+    }
+    if (roi == crop_) {
+        cv::resize(map_, dst, roi.size(), 0, 0, interpolation);
+    } else {
+        /* The crop exceeds the image. Create only the visible part instead of the whole crop */
+        /* (the same sampling position as cv::resize: src = (dst + 0.5) / scale - 0.5) */
+        const double scale_x = static_cast<double>(crop_.width) / map_.cols;
+        const double scale_y = static_cast<double>(crop_.height) / map_.rows;
+        cv::Mat affine = (cv::Mat_<double>(2, 3) <<
+            scale_x, 0, 0.5 * scale_x - 0.5 + crop_.x - roi.x,
+            0, scale_y, 0.5 * scale_y - 0.5 + crop_.y - roi.y);
+        cv::warpAffine(map_, dst, affine, roi.size(), interpolation, cv::BORDER_REPLICATE);
+    }
+}
+
+void SegmentationMap::Materialize(const cv::Size& image_size, cv::Mat& dst, int32_t interpolation) const
+{
+    dst = cv::Mat::zeros(image_size, map_.type());
+    const cv::Rect roi = GetRoi(image_size);
+    if (IsEmpty() || roi.area() <= 0) return;
+    cv::Mat target = dst(roi);
+    MaterializeRoi(image_size, target, interpolation);
+}
+
+void SegmentationMap::AddTo(cv::Mat& mat, int32_t interpolation) const
+{
+    const cv::Rect roi = GetRoi(mat.size());
+    if (IsEmpty() || roi.area() <= 0) return;
+    if (map_.type() == CV_8UC3 && mat.type() == CV_8UC3) {
+        const cv::Mat& map = map_;
+        RunFusedKernel(mat, roi, crop_, map_.size(), interpolation,
+            [&map](int32_t y, int32_t x, int32_t* color) {
+                const uint8_t* src = map.ptr<uint8_t>(y) + x * 3;
+                color[0] = src[0];
+                color[1] = src[1];
+                color[2] = src[2];
+                color[3] = 255;
+            }, WriteAdd);
+    } else {
+        cv::Mat mat_roi = mat(roi);
+        cv::Mat resized;
+        MaterializeRoi(mat.size(), resized, interpolation);
+        cv::add(mat_roi, resized, mat_roi);
+    }
+}
+
+void SegmentationMap::BlendTo(cv::Mat& mat, double alpha, int32_t interpolation) const
+{
+    const cv::Rect roi = GetRoi(mat.size());
+    if (IsEmpty() || roi.area() <= 0) return;
+    if (map_.type() == CV_8UC3 && mat.type() == CV_8UC3) {
+        const cv::Mat& map = map_;
+        const int32_t alpha_int = cv::saturate_cast<uint8_t>(alpha * 255);
+        RunFusedKernel(mat, roi, crop_, map_.size(), interpolation,
+            [&map, alpha_int](int32_t y, int32_t x, int32_t* color) {
+                const uint8_t* src = map.ptr<uint8_t>(y) + x * 3;
+                color[0] = src[0];
+                color[1] = src[1];
+                color[2] = src[2];
+                color[3] = alpha_int;
+            }, WriteBlend);
+    } else {
+        cv::Mat mat_roi = mat(roi);
+        cv::Mat resized;
+        MaterializeRoi(mat.size(), resized, interpolation);
+        cv::addWeighted(mat_roi, 1.0 - alpha, resized, alpha, 0, mat_roi);
+    }
+}
+
+void SegmentationMap::OverlayTo(cv::Mat& mat, const cv::Mat& palette, int32_t interpolation) const
+{
+    const cv::Rect roi = GetRoi(mat.size());
+    if (IsEmpty() || roi.area() <= 0) return;
+    if (map_.type() != CV_8UC1 || mat.type() != CV_8UC3 || palette.type() != CV_8UC4 || palette.total() != 256) return;
+    const cv::Mat& map = map_;
+    const cv::Vec4b* palette_data = palette.ptr<cv::Vec4b>();
+    RunFusedKernel(mat, roi, crop_, map_.size(), interpolation,
+        [&map, palette_data](int32_t y, int32_t x, int32_t* color) {
+            const cv::Vec4b& entry = palette_data[map.ptr<uint8_t>(y)[x]];
+            color[0] = entry[0];
+            color[1] = entry[1];
+            color[2] = entry[2];
+            color[3] = entry[3];
+        }, WriteBlend);
+}
+
+cv::Mat SegmentationMap::CreatePalette(const std::vector<cv::Scalar>& color_list, int32_t alpha)
+{
+    cv::Mat palette = cv::Mat::zeros(1, 256, CV_8UC4);
+    for (int32_t i = 0; i < (std::min)(256, static_cast<int32_t>(color_list.size())); i++) {
+        const cv::Scalar& color = color_list[i];
+        palette.at<cv::Vec4b>(i) = cv::Vec4b(cv::saturate_cast<uint8_t>(color[0]), cv::saturate_cast<uint8_t>(color[1]), cv::saturate_cast<uint8_t>(color[2]), cv::saturate_cast<uint8_t>(alpha));
+    }
+    return palette;
+}
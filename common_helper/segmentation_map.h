@@ -0,0 +1,57 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef SEGMENTATION_MAP_
+#define SEGMENTATION_MAP_
+
+/* for general */
+#include <cstdint>
+#include <vector>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* Segmentation result in model resolution, with the transform to the original image */
+/*   - crop is the area in the original image which the map corresponds to (stretched). it may exceed the image (kCropTypeExpand) */
+/*   - nothing is created in the original image resolution until Materialize / AddTo / BlendTo is called */
+/*   - only the area of the crop in the image is touched. the rest of the frame is not allocated nor processed */
+/*   - AddTo / BlendTo / OverlayTo run in one pass over the output pixels (upscale, palette lookup and blend at once) */
+class SegmentationMap {
+public:
+    SegmentationMap();
+    SegmentationMap(const cv::Mat& map, const cv::Rect& crop);
+    ~SegmentationMap();
+
+    void Set(const cv::Mat& map, const cv::Rect& crop);     /* map is not copied */
+    bool IsEmpty() const;
+    const cv::Mat& GetMap() const;
+    const cv::Rect& GetCrop() const;
+    cv::Rect GetRoi(const cv::Size& image_size) const;      /* crop clipped by the image */
+    bool ConvertToMap(const cv::Point& point_in_image, cv::Point& point_in_map) const;
+
+    void MaterializeRoi(const cv::Size& image_size, cv::Mat& dst, int32_t interpolation = cv::INTER_LINEAR) const;    /* dst size = GetRoi */
+    void Materialize(const cv::Size& image_size, cv::Mat& dst, int32_t interpolation = cv::INTER_LINEAR) const;       /* dst size = image size. 0 outside of the crop */
+    void AddTo(cv::Mat& mat, int32_t interpolation = cv::INTER_LINEAR) const;                     /* mat(roi) += map */
+    void BlendTo(cv::Mat& mat, double alpha, int32_t interpolation = cv::INTER_LINEAR) const;     /* mat(roi) = mat(roi) * (1 - alpha) + map * alpha */
+    void OverlayTo(cv::Mat& mat, const cv::Mat& palette, int32_t interpolation = cv::INTER_NEAREST) const;   /* map is CV_8UC1 index. mat(roi) = mat(roi) * (1 - a) + palette[map].bgr * a */
+
+    /* palette = 1 x 256 CV_8UC4 (b, g, r, alpha). unused entries are transparent */
+    static cv::Mat CreatePalette(const std::vector<cv::Scalar>& color_list, int32_t alpha = 255);
+
+private:
+    cv::Mat map_;
+    cv::Rect crop_;
+};
+
+#endif
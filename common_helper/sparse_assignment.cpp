@@ -0,0 +1,104 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/* for general */
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+/* for My modules */
+#include "sparse_assignment.h"
+#include "hungarian_algorithm.h"
+
+static int32_t FindRoot(std::vector<int32_t>& parent, int32_t i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void SparseAssignment::Solve(int32_t row_num, int32_t col_num, const std::vector<Edge>& edge_list, float cost_invalid,
+    std::vector<int32_t>& assign_for_row, std::vector<int32_t>& assign_for_col)
+{
+    assign_for_row.assign(row_num, -1);
+    assign_for_col.assign(col_num, -1);
+    if (edge_list.empty()) return;
+
+    /*** Group rows and cols connected by valid pairs (node = row index, or row_num + col index) ***/
+    std::vector<int32_t> parent(row_num + col_num);
+    for (int32_t i = 0; i < static_cast<int32_t>(parent.size()); i++) parent[i] = i;
+    for (const auto& edge : edge_list) {
+        int32_t root_row = FindRoot(parent, edge.row);
+        int32_t root_col = FindRoot(parent, row_num + edge.col);
+        if (root_row != root_col) parent[root_col] = root_row;
+    }
+
+    std::vector<std::vector<int32_t>> edge_index_list_group(row_num + col_num);
+    for (int32_t i = 0; i < static_cast<int32_t>(edge_list.size()); i++) {
+        edge_index_list_group[FindRoot(parent, edge_list[i].row)].push_back(i);
+    }
+
+    /*** Solve each group ***/
+    std::vector<int32_t> local_index(row_num + col_num, -1);
+    std::vector<int32_t> row_list;
+    std::vector<int32_t> col_list;
+    for (const auto& edge_index_list : edge_index_list_group) {
+        if (edge_index_list.empty()) continue;
+        if (edge_index_list.size() == 1) {
+            /* only one pair. no need to solve */
+            const auto& edge = edge_list[edge_index_list[0]];
+            assign_for_row[edge.row] = edge.col;
+            assign_for_col[edge.col] = edge.row;
+            continue;
+        }
+
+        row_list.clear();
+        col_list.clear();
+        for (int32_t i : edge_index_list) {
+            const auto& edge = edge_list[i];
+            if (local_index[edge.row] < 0) {
+                local_index[edge.row] = static_cast<int32_t>(row_list.size());
+                row_list.push_back(edge.row);
+            }
+            if (local_index[row_num + edge.col] < 0) {
+                local_index[row_num + edge.col] = static_cast<int32_t>(col_list.size());
+                col_list.push_back(edge.col);
+            }
+        }
+
+        /* HungarianAlgorithm requires square matrix */
+        size_t size_cost_matrix = (std::max)(row_list.size(), col_list.size());
+        std::vector<std::vector<float>> cost_matrix(size_cost_matrix, std::vector<float>(size_cost_matrix, cost_invalid));
+        for (int32_t i : edge_index_list) {
+            const auto& edge = edge_list[i];
+            cost_matrix[local_index[edge.row]][local_index[row_num + edge.col]] = edge.cost;
+        }
+        std::vector<int32_t> local_assign_for_row(size_cost_matrix, -1);
+        std::vector<int32_t> local_assign_for_col(size_cost_matrix, -1);
+        HungarianAlgorithm<float> solver(cost_matrix);
+        solver.Solve(local_assign_for_row, local_assign_for_col);
+
+        for (size_t i_row = 0; i_row < row_list.size(); i_row++) {
+            int32_t i_col = local_assign_for_row[i_row];
+            if (i_col < 0 || i_col >= static_cast<int32_t>(col_list.size())) continue;
+            if (cost_matrix[i_row][i_col] >= cost_invalid) continue;
+            assign_for_row[row_list[i_row]] = col_list[i_col];
+            assign_for_col[col_list[i_col]] = row_list[i_row];
+        }
+        for (int32_t row : row_list) local_index[row] = -1;
+        for (int32_t col : col_list) local_index[row_num + col] = -1;
+    }
+}
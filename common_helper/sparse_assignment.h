@@ -0,0 +1,39 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef SPARSE_ASSIGNMENT_
+#define SPARSE_ASSIGNMENT_
+
+/* for general */
+#include <cstdint>
+#include <vector>
+
+/* Solve assignment problem given only valid (row, col, cost) pairs */
+/*   - rows and cols are split into independent groups connected by valid pairs */
+/*   - HungarianAlgorithm is applied to each group, so the cost is small when objects are scattered */
+/*   - rows / cols without a valid pair are left unassigned (-1) */
+class SparseAssignment {
+public:
+    typedef struct Edge_ {
+        int32_t row;
+        int32_t col;
+        float   cost;
+    } Edge;
+
+public:
+    static void Solve(int32_t row_num, int32_t col_num, const std::vector<Edge>& edge_list, float cost_invalid,
+        std::vector<int32_t>& assign_for_row, std::vector<int32_t>& assign_for_col);
+};
+
+#endif
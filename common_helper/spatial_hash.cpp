@@ -0,0 +1,79 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/* for general */
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+/* for My modules */
+#include "spatial_hash.h"
+
+
+SpatialHash::SpatialHash(int32_t cell_size)
+{
+    SetCellSize(cell_size);
+}
+
+SpatialHash::~SpatialHash()
+{
+}
+
+void SpatialHash::Clear()
+{
+    /* keep buckets to avoid allocation in the next frame */
+    for (auto& it : cell_map_) {
+        it.second.clear();
+    }
+}
+
+void SpatialHash::SetCellSize(int32_t cell_size)
+{
+    cell_size_ = (std::max)(1, cell_size);
+    cell_map_.clear();
+}
+
+void SpatialHash::Insert(int32_t index, int32_t x, int32_t y)
+{
+    cell_map_[CreateKey(ToCell(x), ToCell(y))].push_back(index);
+}
+
+void SpatialHash::Query(int32_t x0, int32_t y0, int32_t x1, int32_t y1, std::vector<int32_t>& index_list) const
+{
+    index_list.clear();
+    const int32_t cell_x0 = ToCell(x0);
+    const int32_t cell_y0 = ToCell(y0);
+    const int32_t cell_x1 = ToCell(x1);
+    const int32_t cell_y1 = ToCell(y1);
+    for (int32_t cell_y = cell_y0; cell_y <= cell_y1; cell_y++) {
+        for (int32_t cell_x = cell_x0; cell_x <= cell_x1; cell_x++) {
+            auto it = cell_map_.find(CreateKey(cell_x, cell_y));
+            if (it != cell_map_.end()) {
+                index_list.insert(index_list.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+}
+
+int64_t SpatialHash::CreateKey(int32_t cell_x, int32_t cell_y) const
+{
+    return (static_cast<int64_t>(cell_y) << 32) | static_cast<uint32_t>(cell_x);
+}
+
+int32_t SpatialHash::ToCell(int32_t v) const
+{
+    /* floor division (coordinates can be negative) */
+    return (v >= 0) ? (v / cell_size_) : -((-v + cell_size_ - 1) / cell_size_);
+}
@@ -0,0 +1,44 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef SPATIAL_HASH_
+#define SPATIAL_HASH_
+
+/* for general */
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+/* Uniform grid to find points in a rectangle without checking all points */
+/*   - Query returns candidates in the cells overlapping the rectangle (may include points slightly outside) */
+class SpatialHash {
+public:
+    SpatialHash(int32_t cell_size = 64);
+    ~SpatialHash();
+
+    void Clear();
+    void SetCellSize(int32_t cell_size);
+    void Insert(int32_t index, int32_t x, int32_t y);
+    void Query(int32_t x0, int32_t y0, int32_t x1, int32_t y1, std::vector<int32_t>& index_list) const;
+
+private:
+    int64_t CreateKey(int32_t cell_x, int32_t cell_y) const;
+    int32_t ToCell(int32_t v) const;
+
+private:
+    int32_t cell_size_;
+    std::unordered_map<int64_t, std::vector<int32_t>> cell_map_;
+};
+
+#endif
@@ -0,0 +1,85 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fstream>
+
+/* for My modules */
+#include "bounding_box.h"
+#include "accuracy_evaluator.h"
+
+/*** Macro ***/
+#define CHECK(x) do { if (!(x)) { printf("[FAIL] %s:%d: %s\n", __FILE__, __LINE__, #x); return -1; } } while (0)
+
+static constexpr char kAnnotationFilename[] = "accuracy_evaluator_test.json";
+
+/*** Function ***/
+/* one image with a person and a car */
+static int32_t WriteAnnotation(const std::string& filename)
+{
+    std::ofstream ofs(filename);
+    if (!ofs) return -1;
+    ofs << R"({
+        "images": [ { "id": 1, "file_name": "000001.jpg", "width": 640, "height": 480 } ],
+        "categories": [ { "id": 1, "name": "person" }, { "id": 3, "name": "car" } ],
+        "annotations": [
+            { "image_id": 1, "category_id": 1, "bbox": [ 10, 20, 100, 200 ], "iscrowd": 0 },
+            { "image_id": 1, "category_id": 3, "bbox": [ 300, 200, 150, 100 ], "iscrowd": 0 }
+        ]
+    })";
+    return 0;
+}
+
+static int32_t TestAllDetected(DetectionEvaluator& evaluator)
+{
+    evaluator.ClearResult();
+    evaluator.AddResult(1, { BoundingBox(0, "person", 0.9f, 10, 20, 100, 200), BoundingBox(2, "car", 0.8f, 300, 200, 150, 100) });
+    const DetectionEvaluator::Summary summary = evaluator.Evaluate();
+    CHECK(summary.num_category == 2);
+    CHECK(std::abs(summary.ap - 1.0) < 1e-6);
+    return 0;
+}
+
+/* a category which has GT but no detection counts as AP = 0 */
+static int32_t TestCategoryWithoutDetection(DetectionEvaluator& evaluator)
+{
+    evaluator.ClearResult();
+    evaluator.AddResult(1, { BoundingBox(0, "person", 0.9f, 10, 20, 100, 200) });
+    const DetectionEvaluator::Summary summary = evaluator.Evaluate();
+    CHECK(summary.num_category == 2);
+    CHECK(std::abs(summary.ap - 0.5) < 1e-6);
+    CHECK(std::abs(summary.ap50 - 0.5) < 1e-6);
+    CHECK(std::abs(summary.ap75 - 0.5) < 1e-6);
+    return 0;
+}
+
+int main()
+{
+    CHECK(WriteAnnotation(kAnnotationFilename) == 0);
+    DetectionEvaluator evaluator;
+    CHECK(evaluator.LoadCocoAnnotation(kAnnotationFilename) == 0);
+    std::remove(kAnnotationFilename);
+
+    int32_t ret = 0;
+    ret |= TestAllDetected(evaluator);
+    ret |= TestCategoryWithoutDetection(evaluator);
+    printf("%s\n", ret == 0 ? "[PASS]" : "[FAIL]");
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <sstream>
+
+#if defined(__linux__) && (defined(__aarch64__) || defined(__arm__))
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+/* for My modules */
+#include "common_helper.h"
+#include "weight_cache.h"
+
+/*** Macro ***/
+#define TAG "XnnpackWeightCache"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static constexpr char kCacheExtension[] = ".xnnpack_cache";
+static constexpr char kMetaExtension[] = ".meta";
+
+
+/*** Function ***/
+static bool IsFileExist(const std::string& filename)
+{
+    std::ifstream ifs(filename, std::ios::binary | std::ios::ate);
+    return ifs && ifs.tellg() > 0;
+}
+
+static std::string ReadText(const std::string& filename)
+{
+    std::ifstream ifs(filename);
+    if (!ifs) return "";
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    return ss.str();
+}
+
+static bool IsDirectoryWritable(const std::string& filename)
+{
+    /* XNNPACK fails to create the delegate when it cannot create the cache file */
+    const std::string filename_probe = filename + ".probe";
+    bool ret = static_cast<bool>(std::ofstream(filename_probe));
+    std::remove(filename_probe.c_str());
+    return ret;
+}
+
+static bool WriteText(const std::string& filename, const std::string& text)
+{
+    /* write to a temporary file and rename so that another process never reads a partial file */
+    const std::string filename_tmp = filename + ".tmp";
+    {
+        std::ofstream ofs(filename_tmp, std::ios::trunc);
+        if (!ofs) return false;
+        ofs << text;
+        if (!ofs.flush()) return false;
+    }
+#ifdef _WIN32
+    std::remove(filename.c_str());      /* rename doesn't overwrite on Windows */
+#endif
+    if (std::rename(filename_tmp.c_str(), filename.c_str()) != 0) {
+        std::remove(filename_tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+XnnpackWeightCache::XnnpackWeightCache()
+{
+    is_warm_ = false;
+}
+
+XnnpackWeightCache::~XnnpackWeightCache()
+{
+}
+
+std::string XnnpackWeightCache::GetCpuFeatureTag()
+{
+    /* packed layout depends on the micro kernels XNNPACK selects for the CPU */
+    std::string tag;
+#if defined(__x86_64__) || defined(_M_X64)
+    tag = "x86_64";
+#if defined(__GNUC__)
+    if (__builtin_cpu_supports("avx512f")) tag += "-avx512f";
+    if (__builtin_cpu_supports("avx2")) tag += "-avx2";
+    if (__builtin_cpu_supports("fma")) tag += "-fma";
+    if (__builtin_cpu_supports("avx")) tag += "-avx";
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    tag = "aarch64";
+#if defined(__linux__)
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+#ifdef HWCAP_ASIMDDP
+    if (hwcap & HWCAP_ASIMDDP) tag += "-dotprod";
+#endif
+#ifdef HWCAP_ASIMDHP
+    if (hwcap & HWCAP_ASIMDHP) tag += "-fp16";
+#endif
+#if defined(HWCAP2_I8MM)
+    if (getauxval(AT_HWCAP2) & HWCAP2_I8MM) tag += "-i8mm";
+#endif
+    (void)hwcap;
+#endif
+#elif defined(__arm__) || defined(_M_ARM)
+    tag = "arm";
+#if defined(__linux__) && defined(HWCAP_NEON)
+    if (getauxval(AT_HWCAP) & HWCAP_NEON) tag += "-neon";
+#endif
+#else
+    tag = "unknown";
+#endif
+    return tag;
+}
+
+bool XnnpackWeightCache::Prepare(const MappedFile& model, const std::string& library_version)
+{
+    filename_.clear();
+    meta_.clear();
+    is_warm_ = false;
+    if (model.GetFilename().empty()) return false;
+
+    const std::string cpu_feature_tag = GetCpuFeatureTag();
+    const std::string filename = model.GetFilename() + "." + cpu_feature_tag + kCacheExtension;
+    const std::string filename_meta = filename + kMetaExtension;
+
+    char model_hash[32];
+    snprintf(model_hash, sizeof(model_hash), "%016llx", static_cast<unsigned long long>(model.GetHash()));
+    std::stringstream ss;
+    ss << "model_hash=" << model_hash << "\n";
+    ss << "model_size=" << model.GetSize() << "\n";
+    ss << "library=" << library_version << "\n";
+    ss << "cpu=" << cpu_feature_tag << "\n";
+    const std::string meta = ss.str();
+
+    if (ReadText(filename_meta) == meta && IsFileExist(filename)) {
+        is_warm_ = true;
+    } else {
+        /* Stale, unfinished or no cache. XNNPACK packs the weights again and writes a new one. The meta is written at Commit */
+        std::remove(filename_meta.c_str());
+        std::remove(filename.c_str());
+        if (!IsDirectoryWritable(filename)) {
+            PRINT_E("Cannot write %s. Weight cache is not used\n", filename.c_str());
+            return false;
+        }
+    }
+    PRINT("%s: %s\n", is_warm_ ? "Reuse" : "Build", filename.c_str());
+    filename_ = filename;
+    meta_ = meta;
+    return true;
+}
+
+bool XnnpackWeightCache::Commit()
+{
+    if (filename_.empty() || is_warm_ || meta_.empty()) return true;
+    const std::string meta = meta_;
+    meta_.clear();      /* commit only once */
+    if (!IsFileExist(filename_)) {
+        PRINT_E("%s was not written. Weights are packed at the next start again\n", filename_.c_str());
+        return false;
+    }
+    if (!WriteText(filename_ + kMetaExtension, meta)) {
+        PRINT_E("Cannot write %s%s\n", filename_.c_str(), kMetaExtension);
+        return false;
+    }
+    is_warm_ = true;
+    return true;
+}
@@ -0,0 +1,50 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef WEIGHT_CACHE_
+#define WEIGHT_CACHE_
+
+/* for general */
+#include <cstdint>
+#include <string>
+
+/* for My modules */
+#include "mapped_file.h"
+
+/* Persistent cache file of XNNPACK packed weights for a model */
+/*   - <model>.<cpu features>.xnnpack_cache next to the model. XNNPACK writes it at the first start and memory maps it at later starts */
+/*   - <cache>.meta records the model hash, the library version and the CPU features. The cache is deleted (rebuilt) when any of them changes */
+/*   - the meta is written by Commit, after XNNPACK has written the cache. A cache without the meta (e.g. the process stopped while writing it) is rebuilt */
+/*   - the cache is an optimization only. Inference works without it (e.g. when the model directory is read-only) */
+class XnnpackWeightCache {
+public:
+    XnnpackWeightCache();
+    ~XnnpackWeightCache();
+
+    /* call before creating the delegate. returns false when the cache cannot be used. library_version: anything which changes when the packing format may change */
+    bool Prepare(const MappedFile& model, const std::string& library_version);
+    /* call after the delegate has been applied (XNNPACK has written the cache by then) */
+    bool Commit();
+    const std::string& GetFilename() const { return filename_; }
+    bool IsWarm() const { return is_warm_; }        /* a valid cache existed at Prepare */
+
+    static std::string GetCpuFeatureTag();          /* e.g. "x86_64-avx2-fma", "aarch64-dotprod-fp16" */
+
+private:
+    std::string filename_;
+    std::string meta_;
+    bool is_warm_;
+};
+
+#endif
@@ -0,0 +1,301 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "common_helper.h"
+#include "common_helper_cv.h"
+#include "yuv_image.h"
+
+/*** Macro ***/
+#define TAG "YuvImage"
+#define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
+#define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
+
+static const std::string kYuvSourcePrefix = "yuv:";
+
+
+/*** Function ***/
+bool YuvImage::Read(cv::VideoCapture& cap, int32_t format_)
+{
+    cv::Mat frame;
+    if (!cap.read(frame) || frame.empty()) {
+        data = cv::Mat();
+        return false;
+    }
+    const int32_t w = static_cast<int32_t>(cap.get(cv::CAP_PROP_FRAME_WIDTH));
+    const int32_t h = static_cast<int32_t>(cap.get(cv::CAP_PROP_FRAME_HEIGHT));
+
+    /* Some backends return raw data as one row. Reshape it to the layout of each format */
+    if (format_ == kFormatYuyv) {
+        if (frame.type() == CV_8UC2) {
+            data = frame;
+        } else if (frame.type() == CV_8UC1 && frame.isContinuous() && static_cast<int32_t>(frame.total()) == w * h * 2) {
+            data = frame.reshape(2, h);
+        } else {
+            data = cv::Mat();
+        }
+    } else {
+        if (frame.type() == CV_8UC1 && frame.rows == h * 3 / 2) {
+            data = frame;
+        } else if (frame.type() == CV_8UC1 && frame.isContinuous() && static_cast<int32_t>(frame.total()) == w * h * 3 / 2) {
+            data = frame.reshape(1, h * 3 / 2);
+        } else {
+            data = cv::Mat();
+        }
+    }
+    if (data.empty()) {
+        PRINT_E("Unexpected frame (type = %d, %d x %d). The capture backend may not support raw YUV\n", frame.type(), frame.cols, frame.rows);
+        return false;
+    }
+    format = format_;
+    width = data.cols;
+    height = (format == kFormatYuyv) ? data.rows : data.rows * 2 / 3;
+    return true;
+}
+
+void YuvImage::ToBgr(cv::Mat& dst) const
+{
+#ifdef CV_COLOR_IS_RGB
+    static const int32_t kCodeList[] = { cv::COLOR_YUV2RGB_NV12, cv::COLOR_YUV2RGB_I420, cv::COLOR_YUV2RGB_YUYV };
+#else
+    static const int32_t kCodeList[] = { cv::COLOR_YUV2BGR_NV12, cv::COLOR_YUV2BGR_I420, cv::COLOR_YUV2BGR_YUYV };
+#endif
+    if (Empty()) {
+        dst = cv::Mat();
+        return;
+    }
+    cv::cvtColor(data, dst, kCodeList[format]);
+}
+
+
+bool CommonHelper::IsYuvSource(const std::string& input_name)
+{
+    return input_name.compare(0, kYuvSourcePrefix.size(), kYuvSourcePrefix) == 0;
+}
+
+bool CommonHelper::FindSourceYuv(const std::string& input_name, cv::VideoCapture& cap, int32_t& format, int32_t width, int32_t height)
+{
+    const std::string source = IsYuvSource(input_name) ? input_name.substr(kYuvSourcePrefix.size()) : input_name;
+    if (source == "jetson") {
+        /* the same as CreateGStreamerPipeline, but stop at NV12 instead of converting to BGR */
+        const std::string pipeline = "nvarguscamerasrc ! video/x-raw(memory:NVMM), width=(int)" + std::to_string(width) + ", height=(int)" + std::to_string(height) +
+            ", format=(string)NV12, framerate=(fraction)60/1 ! nvvidconv flip-method=2 ! video/x-raw, format=(string)NV12 ! appsink max-buffers=1 drop=True";
+        cap = cv::VideoCapture(pipeline, cv::CAP_GSTREAMER);
+        format = YuvImage::kFormatNv12;
+    } else if (source == "videotestsrc") {
+        const std::string pipeline = "videotestsrc is-live=true ! video/x-raw, width=(int)" + std::to_string(width) + ", height=(int)" + std::to_string(height) +
+            ", format=(string)NV12, framerate=(fraction)30/1 ! appsink max-buffers=1 drop=True";
+        cap = cv::VideoCapture(pipeline, cv::CAP_GSTREAMER);
+        format = YuvImage::kFormatNv12;
+    } else {
+        /* V4L2 (mmap streaming) without conversion to BGR */
+        int32_t cam_id = -1;
+        try {
+            cam_id = std::stoi(source);
+        }
+        catch (...) {}
+        if (cam_id < 0) {
+            printf("Invalid input source: %s\n", input_name.c_str());
+            return false;
+        }
+        cap = cv::VideoCapture(cam_id, cv::CAP_V4L2);
+        cap.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('Y', 'U', 'Y', 'V'));
+        cap.set(cv::CAP_PROP_FRAME_WIDTH, width);
+        cap.set(cv::CAP_PROP_FRAME_HEIGHT, height);
+        cap.set(cv::CAP_PROP_BUFFERSIZE, 1);
+        cap.set(cv::CAP_PROP_CONVERT_RGB, 0);
+        format = YuvImage::kFormatYuyv;
+    }
+    if (!cap.isOpened()) {
+        printf("Unable to open camera: %s\n", input_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+/* Access to each format. x, y are in the luma resolution */
+class YuvAccessorNv12 {
+public:
+    YuvAccessorNv12(const YuvImage& image) : data_(image.data.data), step_(image.data.step), uv_(image.data.data + image.data.step * image.height) {}
+    inline const uint8_t* LumaRow(int32_t y) const { return data_ + step_ * y; }
+    inline uint8_t Luma(const uint8_t* row, int32_t x) const { return row[x]; }
+    inline const uint8_t* ChromaRow(int32_t y) const { return uv_ + step_ * (y >> 1); }
+    inline void Chroma(const uint8_t* row, int32_t x, int32_t& u, int32_t& v) const { u = row[x & ~1]; v = row[(x & ~1) + 1]; }
+private:
+    const uint8_t* data_;
+    size_t step_;
+    const uint8_t* uv_;
+};
+
+class YuvAccessorI420 {
+public:
+    YuvAccessorI420(const YuvImage& image) : data_(image.data.data), step_(image.data.step), chroma_step_(image.data.step / 2)
+    {
+        u_ = data_ + step_ * image.height;
+        v_ = u_ + chroma_step_ * (image.height / 2);
+    }
+    inline const uint8_t* LumaRow(int32_t y) const { return data_ + step_ * y; }
+    inline uint8_t Luma(const uint8_t* row, int32_t x) const { return row[x]; }
+    inline const uint8_t* ChromaRow(int32_t y) const { return u_ + chroma_step_ * (y >> 1); }  /* V is at the same offset from v_ */
+    inline void Chroma(const uint8_t* row, int32_t x, int32_t& u, int32_t& v) const { u = row[x >> 1]; v = row[(x >> 1) + (v_ - u_)]; }
+private:
+    const uint8_t* data_;
+    size_t step_;
+    size_t chroma_step_;
+    const uint8_t* u_;
+    const uint8_t* v_;
+};
+
+class YuvAccessorYuyv {
+public:
+    YuvAccessorYuyv(const YuvImage& image) : data_(image.data.data), step_(image.data.step) {}
+    inline const uint8_t* LumaRow(int32_t y) const { return data_ + step_ * y; }
+    inline uint8_t Luma(const uint8_t* row, int32_t x) const { return row[x * 2]; }
+    inline const uint8_t* ChromaRow(int32_t y) const { return data_ + step_ * y; }
+    inline void Chroma(const uint8_t* row, int32_t x, int32_t& u, int32_t& v) const { u = row[(x >> 1) * 4 + 1]; v = row[(x >> 1) * 4 + 3]; }
+private:
+    const uint8_t* data_;
+    size_t step_;
+};
+
+static inline uint8_t Clip(int32_t value)
+{
+    return static_cast<uint8_t>((std::min)(255, (std::max)(0, value)));
+}
+
+/* Bilinear for luma, nearest for chroma. Fixed point BT.601 limited range */
+template <typename ACCESSOR>
+static void CropResizeCvtKernel(const YuvImage& org, const cv::Rect& src_rect, cv::Mat& dst, const cv::Rect& dst_rect, bool is_rgb)
+{
+    static constexpr int32_t kWeightShift = 8;
+    static constexpr int32_t kWeightOne = 1 << kWeightShift;
+    const ACCESSOR accessor(org);
+
+    /* Source position for each column */
+    std::vector<int32_t> x0_list(dst_rect.width), x1_list(dst_rect.width), wx_list(dst_rect.width);
+    const float scale_x = static_cast<float>(src_rect.width) / dst_rect.width;
+    for (int32_t x = 0; x < dst_rect.width; x++) {
+        const float fx = (std::min)(static_cast<float>(src_rect.width - 1), (std::max)(0.0f, (x + 0.5f) * scale_x - 0.5f));
+        const int32_t ix = static_cast<int32_t>(fx);
+        x0_list[x] = src_rect.x + ix;
+        x1_list[x] = src_rect.x + (std::min)(ix + 1, src_rect.width - 1);
+        wx_list[x] = static_cast<int32_t>((fx - ix) * kWeightOne);
+    }
+    const float scale_y = static_cast<float>(src_rect.height) / dst_rect.height;
+    const int32_t index_r = is_rgb ? 0 : 2;
+    const int32_t index_b = is_rgb ? 2 : 0;
+
+    cv::parallel_for_(cv::Range(0, dst_rect.height), [&](const cv::Range& range) {
+        for (int32_t y = range.start; y < range.end; y++) {
+            const float fy = (std::min)(static_cast<float>(src_rect.height - 1), (std::max)(0.0f, (y + 0.5f) * scale_y - 0.5f));
+            const int32_t iy = static_cast<int32_t>(fy);
+            const int32_t y0 = src_rect.y + iy;
+            const int32_t y1 = src_rect.y + (std::min)(iy + 1, src_rect.height - 1);
+            const int32_t wy = static_cast<int32_t>((fy - iy) * kWeightOne);
+            const uint8_t* row0 = accessor.LumaRow(y0);
+            const uint8_t* row1 = accessor.LumaRow(y1);
+            const uint8_t* row_chroma = accessor.ChromaRow(wy < kWeightOne / 2 ? y0 : y1);
+            uint8_t* p_dst = dst.ptr<uint8_t>(dst_rect.y + y) + dst_rect.x * 3;
+            for (int32_t x = 0; x < dst_rect.width; x++) {
+                const int32_t x0 = x0_list[x];
+                const int32_t x1 = x1_list[x];
+                const int32_t wx = wx_list[x];
+                const int32_t top = accessor.Luma(row0, x0) * (kWeightOne - wx) + accessor.Luma(row0, x1) * wx;
+                const int32_t bottom = accessor.Luma(row1, x0) * (kWeightOne - wx) + accessor.Luma(row1, x1) * wx;
+                const int32_t luma = (top * (kWeightOne - wy) + bottom * wy + (1 << (kWeightShift * 2 - 1))) >> (kWeightShift * 2);
+                int32_t u, v;
+                accessor.Chroma(row_chroma, wx < kWeightOne / 2 ? x0 : x1, u, v);
+                const int32_t c = (luma - 16) * 298;
+                const int32_t d = u - 128;
+                const int32_t e = v - 128;
+                p_dst[index_r] = Clip((c + 409 * e + 128) >> 8);
+                p_dst[1] = Clip((c - 100 * d - 208 * e + 128) >> 8);
+                p_dst[index_b] = Clip((c + 516 * d + 128) >> 8);
+                p_dst += 3;
+            }
+        }
+    });
+}
+
+void CommonHelper::CropResizeCvt(const YuvImage& org, cv::Mat& dst, int32_t& crop_x, int32_t& crop_y, int32_t& crop_w, int32_t& crop_h, bool is_rgb, int32_t crop_type)
+{
+    if (org.Empty() || dst.empty() || dst.type() != CV_8UC3) {
+        PRINT_E("Invalid image\n");
+        return;
+    }
+
+    /* The same geometry as CropResizeCvt for cv::Mat */
+    cv::Rect src_rect(crop_x, crop_y, crop_w, crop_h);
+    cv::Rect dst_rect(0, 0, dst.cols, dst.rows);
+    if (crop_type == kCropTypeCut) {
+        float aspect_ratio_src = static_cast<float>(src_rect.width) / src_rect.height;
+        float aspect_ratio_dst = static_cast<float>(dst.cols) / dst.rows;
+        cv::Rect target_rect(0, 0, src_rect.width, src_rect.height);
+        if (aspect_ratio_src > aspect_ratio_dst) {
+            target_rect.width = static_cast<int32_t>(src_rect.height * aspect_ratio_dst);
+            target_rect.x = (src_rect.width - target_rect.width) / 2;
+        } else {
+            target_rect.height = static_cast<int32_t>(src_rect.width / aspect_ratio_dst);
+            target_rect.y = (src_rect.height - target_rect.height) / 2;
+        }
+        crop_x += target_rect.x;
+        crop_y += target_rect.y;
+        crop_w = target_rect.width;
+        crop_h = target_rect.height;
+        src_rect = cv::Rect(crop_x, crop_y, crop_w, crop_h);
+    } else if (crop_type == kCropTypeExpand) {
+        float aspect_ratio_src = static_cast<float>(src_rect.width) / src_rect.height;
+        float aspect_ratio_dst = static_cast<float>(dst.cols) / dst.rows;
+        if (aspect_ratio_src > aspect_ratio_dst) {
+            dst_rect.height = static_cast<int32_t>(dst_rect.width / aspect_ratio_src);
+            dst_rect.y = (dst.rows - dst_rect.height) / 2;
+        } else {
+            dst_rect.width = static_cast<int32_t>(dst_rect.height * aspect_ratio_src);
+            dst_rect.x = (dst.cols - dst_rect.width) / 2;
+        }
+        crop_x -= dst_rect.x * crop_w / dst_rect.width;
+        crop_y -= dst_rect.y * crop_h / dst_rect.height;
+        crop_w = dst.cols * crop_w / dst_rect.width;
+        crop_h = dst.rows * crop_h / dst_rect.height;
+    }
+    src_rect &= cv::Rect(0, 0, org.width, org.height);
+    if (src_rect.area() <= 0 || dst_rect.area() <= 0) return;
+
+    switch (org.format) {
+    case YuvImage::kFormatNv12:
+        CropResizeCvtKernel<YuvAccessorNv12>(org, src_rect, dst, dst_rect, is_rgb);
+        break;
+    case YuvImage::kFormatI420:
+        CropResizeCvtKernel<YuvAccessorI420>(org, src_rect, dst, dst_rect, is_rgb);
+        break;
+    case YuvImage::kFormatYuyv:
+        CropResizeCvtKernel<YuvAccessorYuyv>(org, src_rect, dst, dst_rect, is_rgb);
+        break;
+    default:
+        PRINT_E("Unsupported format: %d\n", org.format);
+        break;
+    }
+}
@@ -0,0 +1,65 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef YUV_IMAGE_
+#define YUV_IMAGE_
+
+/* for general */
+#include <cstdint>
+#include <string>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "common_helper_cv.h"
+
+/* Raw frame from camera in its native format (no conversion to BGR at capture) */
+/*   - NV12 / I420: data is [height * 3 / 2, width], CV_8UC1 (Y plane followed by chroma) */
+/*   - YUYV: data is [height, width], CV_8UC2 */
+/*   - colors are BT.601 limited range, the same as cv::COLOR_YUV2BGR_XXX */
+class YuvImage {
+public:
+    enum {
+        kFormatNv12 = 0,
+        kFormatI420,
+        kFormatYuyv,
+    };
+
+public:
+    YuvImage() : format(kFormatNv12), width(0), height(0) {}
+
+    bool Empty() const { return data.empty(); }
+    bool Read(cv::VideoCapture& cap, int32_t format);   /* format is the one returned by FindSourceYuv */
+    void ToBgr(cv::Mat& dst) const;                     /* only when the image needs to be drawn */
+
+public:
+    int32_t format;
+    int32_t width;
+    int32_t height;
+    cv::Mat data;
+};
+
+namespace CommonHelper
+{
+/* Input names for YUV capture: "yuv:<camera id>" (V4L2, YUYV), "yuv:jetson" (CSI camera, NV12), "yuv:videotestsrc" (GStreamer test pattern, NV12) */
+bool IsYuvSource(const std::string& input_name);
+bool FindSourceYuv(const std::string& input_name, cv::VideoCapture& cap, int32_t& format, int32_t width = 640, int32_t height = 480);
+
+/* Crop, resize and color conversion from YUV to RGB (or BGR) in one pass. The same as CropResizeCvt for cv::Mat */
+/* dst is CV_8UC3 and already has the model input size. The area outside of the image (kCropTypeExpand) is not touched */
+void CropResizeCvt(const YuvImage& org, cv::Mat& dst, int32_t& crop_x, int32_t& crop_y, int32_t& crop_w, int32_t& crop_h, bool is_rgb = true, int32_t crop_type = kCropTypeStretch);
+}
+
+#endif
@@ -25,6 +25,7 @@ limitations under the License.
 #include <chrono>
 #include <fstream>
 #include <memory>
+#include <future>
 
 /* for OpenCV */
 #include <opencv2/opencv.hpp>
@@ -33,6 +34,7 @@ limitations under the License.
 /* for My modules */
 #include "common_helper.h"
 #include "common_helper_cv.h"
+#include "engine_initializer.h"
 #include "palm_detection_engine.h"
 #include "hand_landmark_engine.h"
 #include "classification_engine.h"
@@ -73,6 +75,8 @@ typedef struct {
     Rect rectFirst;
 } OBJECT_TRACKER;
 
+static constexpr bool kWarmUpAtInitialize = true;     /* run inference once at initialization so that the first frame costs the same as others */
+
 /*** Global variable ***/
 static std::unique_ptr<PalmDetectionEngine> s_palm_detection_engine;
 static std::unique_ptr<HandLandmarkEngine> s_hand_landmark_engine;
@@ -200,16 +204,39 @@ int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param
         return -1;
     }
 
-    s_palm_detection_engine.reset(new PalmDetectionEngine());
-    if (s_palm_detection_engine->Initialize(input_param.work_dir, input_param.num_threads) != PalmDetectionEngine::kRetOk) {
-        return -1;
-    }
-    s_hand_landmark_engine.reset(new HandLandmarkEngine());
-    if (s_hand_landmark_engine->Initialize(input_param.work_dir, input_param.num_threads) != HandLandmarkEngine::kRetOk) {
-        return -1;
-    }
-    s_classification_engine.reset(new ClassificationEngine());
-    if (s_classification_engine->Initialize(input_param.work_dir, input_param.num_threads) != HandLandmarkEngine::kRetOk) {
+    /* Initialize engines concurrently */
+    const cv::Mat mat_dummy = cv::Mat(480, 640, CV_8UC3, cv::Scalar(128, 128, 128));
+    auto future_palm_detection = CommonHelper::InitializeEngineAsync("PalmDetectionEngine", kWarmUpAtInitialize, [&]() {
+        s_palm_detection_engine.reset(new PalmDetectionEngine());
+        return s_palm_detection_engine->Initialize(input_param.work_dir, input_param.num_threads);
+    }, [&]() {
+        PalmDetectionEngine::Result palm_result;
+        return s_palm_detection_engine->Process(mat_dummy, palm_result);
+    });
+    auto future_hand_landmark = CommonHelper::InitializeEngineAsync("HandLandmarkEngine", kWarmUpAtInitialize, [&]() {
+        s_hand_landmark_engine.reset(new HandLandmarkEngine());
+        return s_hand_landmark_engine->Initialize(input_param.work_dir, input_param.num_threads);
+    }, [&]() {
+        HandLandmarkEngine::Result landmark_result;
+        return s_hand_landmark_engine->Process(mat_dummy, 220, 140, 200, 200, 0.0f, landmark_result);
+    });
+    auto future_classification = CommonHelper::InitializeEngineAsync("ClassificationEngine", kWarmUpAtInitialize, [&]() {
+        s_classification_engine.reset(new ClassificationEngine());
+        return s_classification_engine->Initialize(input_param.work_dir, input_param.num_threads);
+    }, [&]() {
+        ClassificationEngine::Result classification_result;
+        return s_classification_engine->Process(mat_dummy(cv::Rect(220, 140, 200, 200)), classification_result);
+    });
+    bool is_palm_detection_ok = future_palm_detection.get();
+    bool is_hand_landmark_ok = future_hand_landmark.get();
+    bool is_classification_ok = future_classification.get();
+    if (!is_palm_detection_ok || !is_hand_landmark_ok || !is_classification_ok) {
+        s_palm_detection_engine->Finalize();
+        s_palm_detection_engine.reset();
+        s_hand_landmark_engine->Finalize();
+        s_hand_landmark_engine.reset();
+        s_classification_engine->Finalize();
+        s_classification_engine.reset();
         return -1;
     }
 
@@ -133,25 +133,11 @@ int32_t DepthEngine::Finalize()
 }
 
 
-int32_t DepthEngine::Process(const cv::Mat& original_mat, Result& result)
+int32_t DepthEngine::Inference(const cv::Mat& img_src, cv::Mat& mat_depth, Result& result)
 {
-    if (!inference_helper_) {
-        PRINT_E("Inference helper is not created\n");
-        return kRetErr;
-    }
     /*** PreProcess ***/
     const auto& t_pre_process0 = std::chrono::steady_clock::now();
     InputTensorInfo& input_tensor_info = input_tensor_info_list_[0];
-    /* do resize and color conversion here because some inference engine doesn't support these operations */
-    int32_t crop_x = 0;
-    int32_t crop_y = 0;
-    int32_t crop_w = original_mat.cols;
-    int32_t crop_h = original_mat.rows;
-    cv::Mat img_src = cv::Mat::zeros(input_tensor_info.GetHeight(), input_tensor_info.GetWidth(), CV_8UC3);
-    //CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
-    //CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeCut);
-    CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeExpand);
-
     input_tensor_info.data = img_src.data;
     input_tensor_info.data_type = InputTensorInfo::kDataTypeImage;
     input_tensor_info.image_info.width = img_src.cols;
@@ -175,28 +161,71 @@ int32_t DepthEngine::Process(const cv::Mat& original_mat, Result& result)
     }
     const auto& t_inference1 = std::chrono::steady_clock::now();
 
-    /*** PostProcess ***/
-    const auto& t_post_process0 = std::chrono::steady_clock::now();
-    /* Retrieve the result */
+    /* Retrieve the result. copy because the tensor is overwritten by the next tile */
     int32_t output_height = output_tensor_info_list_[0].tensor_dims[1];
     int32_t output_width = output_tensor_info_list_[0].tensor_dims[2];
-    int32_t output_channel = output_tensor_info_list_[0].tensor_dims[3];
     float* values = output_tensor_info_list_[0].GetDataAsFloat();
     //printf("%f, %f, %f\n", values[0], values[100], values[400]);
-    cv::Mat mat_out = cv::Mat(output_height, output_width, CV_32FC1, values);  /* value has no specific range */
-    
+    mat_depth = cv::Mat(output_height, output_width, CV_32FC1, values).clone();  /* value has no specific range */
+
+    result.time_pre_process += static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
+    result.time_inference += static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
+    return kRetOk;
+}
+
+int32_t DepthEngine::Process(const cv::Mat& original_mat, Result& result)
+{
+    if (!inference_helper_) {
+        PRINT_E("Inference helper is not created\n");
+        return kRetErr;
+    }
+    const auto& t_process0 = std::chrono::steady_clock::now();
+    result.time_pre_process = 0;
+    result.time_inference = 0;
+
+    /* Relative depth in the model resolution, or in high resolution with tiles */
+    cv::Mat mat_depth;
+    const InputTensorInfo& input_tensor_info = input_tensor_info_list_[0];
+    if (max_tile_num_ > 0) {
+        tiler_.SetTileSize(input_tensor_info.GetWidth(), input_tensor_info.GetHeight());
+        DenseTiler::TileFunc func = [&](const cv::Mat& tile, cv::Mat& out) {
+            int32_t crop_x = 0;
+            int32_t crop_y = 0;
+            int32_t crop_w = tile.cols;
+            int32_t crop_h = tile.rows;
+            cv::Mat img_src = cv::Mat::zeros(tile.rows, tile.cols, CV_8UC3);
+            CommonHelper::CropResizeCvt(tile, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
+            return Inference(img_src, out, result);
+        };
+        if (tiler_.Process(original_mat, mat_depth, { func }) != DenseTiler::kRetOk) {
+            return kRetErr;
+        }
+    } else {
+        /* do resize and color conversion here because some inference engine doesn't support these operations */
+        int32_t crop_x = 0;
+        int32_t crop_y = 0;
+        int32_t crop_w = original_mat.cols;
+        int32_t crop_h = original_mat.rows;
+        cv::Mat img_src = cv::Mat::zeros(input_tensor_info.GetHeight(), input_tensor_info.GetWidth(), CV_8UC3);
+        //CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
+        //CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeCut);
+        CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeExpand);
+        if (Inference(img_src, mat_depth, result) != kRetOk) {
+            return kRetErr;
+        }
+    }
+
+    /*** PostProcess ***/
     /* (255 * (prediction - depth_min) / (depth_max - depth_min)) */
     double depth_min, depth_max;
-    cv::minMaxLoc(mat_out, &depth_min, &depth_max);
-    mat_out.convertTo(mat_out, CV_8UC1, 255. / (depth_max - depth_min), (-255. * depth_min) / (depth_max - depth_min));
-    const auto& t_post_process1 = std::chrono::steady_clock::now();
+    cv::minMaxLoc(mat_depth, &depth_min, &depth_max);
+    cv::Mat mat_out;
+    mat_depth.convertTo(mat_out, CV_8UC1, 255. / (depth_max - depth_min), (-255. * depth_min) / (depth_max - depth_min));
+    const auto& t_process1 = std::chrono::steady_clock::now();
 
     /* Return the results */
     result.mat_out = mat_out;
-    result.time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
-    result.time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
-    result.time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;;
+    result.time_post_process = static_cast<std::chrono::duration<double>>(t_process1 - t_process0).count() * 1000.0 - result.time_pre_process - result.time_inference;    /* including crop and blending of tiles */
 
     return kRetOk;
 }
-
@@ -28,6 +28,7 @@ limitations under the License.
 
 /* for My modules */
 #include "inference_helper.h"
+#include "dense_tiler.h"
 
 
 class DepthEngine {
@@ -47,14 +48,18 @@ public:
     } Result;
 
 public:
-    DepthEngine() {}
+    DepthEngine(int32_t max_tile_num = 0) : max_tile_num_(max_tile_num), tiler_(0, 0, 32, max_tile_num, DenseTiler::kNormalizeAffine) {}  /* max_tile_num > 0: output in high resolution with overlapping tiles */
     ~DepthEngine() {}
     int32_t Initialize(const std::string& work_dir, const int32_t num_threads);
     int32_t Finalize(void);
     int32_t Process(const cv::Mat& original_mat, Result& result);
 
+private:
+    int32_t Inference(const cv::Mat& img_src, cv::Mat& mat_depth, Result& result);
 
 private:
+    int32_t max_tile_num_;
+    DenseTiler tiler_;      /* relative depth has different scale and shift for each inference, so tiles are fitted to the whole image */
     std::unique_ptr<InferenceHelper> inference_helper_;
     std::vector<InputTensorInfo> input_tensor_info_list_;
     std::vector<OutputTensorInfo> output_tensor_info_list_;
@@ -81,6 +81,19 @@ static constexpr int32_t kRegMax = 7;
 
 
 /*** Function ***/
+static InferenceHelper* CreateInferenceHelper()
+{
+#ifdef MODEL_TYPE_TFLITE
+    //return InferenceHelper::Create(InferenceHelper::kTensorflowLite);
+    return InferenceHelper::Create(InferenceHelper::kTensorflowLiteXnnpack);
+    //return InferenceHelper::Create(InferenceHelper::kTensorflowLiteGpu);
+    //return InferenceHelper::Create(InferenceHelper::kTensorflowLiteEdgetpu);
+    //return InferenceHelper::Create(InferenceHelper::kTensorflowLiteNnapi);
+#else
+    return InferenceHelper::Create(InferenceHelper::kOpencv);
+#endif
+}
+
 int32_t DetectionEngine::Initialize(const std::string& work_dir, const int32_t num_threads)
 {
     /* Set model information */
@@ -110,15 +123,7 @@ int32_t DetectionEngine::Initialize(const std::string& work_dir, const int32_t n
     output_tensor_info_list_.push_back(OutputTensorInfo(OUTPUT_NAME_CLASS_2, TENSORTYPE));
 
     /* Create and Initialize Inference Helper */
-#ifdef MODEL_TYPE_TFLITE
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLite));
-    inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteXnnpack));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteGpu));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteEdgetpu));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteNnapi));
-#else
-    inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kOpencv));
-#endif
+    inference_helper_.reset(CreateInferenceHelper());
 
     if (!inference_helper_) {
         return kRetErr;
@@ -132,6 +137,25 @@ int32_t DetectionEngine::Initialize(const std::string& work_dir, const int32_t n
         return kRetErr;
     }
 
+    /* Create another Inference Helper with batch input (the first dimension is batch for both NCHW and NHWC) */
+    inference_helper_batch_.reset();
+    if (max_batch_size_ > 1) {
+        input_tensor_info_list_batch_ = input_tensor_info_list_;
+        input_tensor_info_list_batch_[0].tensor_dims[0] = max_batch_size_;
+        input_tensor_info_list_batch_[0].data_type = IS_NCHW ? InputTensorInfo::kDataTypeBlobNchw : InputTensorInfo::kDataTypeBlobNhwc;
+        output_tensor_info_list_batch_.clear();
+        for (const auto& output_tensor_info : output_tensor_info_list_) {
+            output_tensor_info_list_batch_.push_back(OutputTensorInfo(output_tensor_info.name, TENSORTYPE));
+        }
+        inference_helper_batch_.reset(CreateInferenceHelper());
+        if (!inference_helper_batch_
+            || inference_helper_batch_->SetNumThreads(num_threads) != InferenceHelper::kRetOk
+            || inference_helper_batch_->Initialize(model_filename, input_tensor_info_list_batch_, output_tensor_info_list_batch_) != InferenceHelper::kRetOk) {
+            PRINT_E("The model doesn't accept batch size %d. Images are processed one by one\n", max_batch_size_);
+            inference_helper_batch_.reset();
+        }
+    }
+
     /* read label */
     if (ReadLabel(labelFilename, label_list_) != kRetOk) {
         return kRetErr;
@@ -147,6 +171,10 @@ int32_t DetectionEngine::Finalize()
         return kRetErr;
     }
     inference_helper_->Finalize();
+    if (inference_helper_batch_) {
+        inference_helper_batch_->Finalize();
+        inference_helper_batch_.reset();
+    }
     return kRetOk;
 }
 
@@ -197,23 +225,119 @@ int32_t DetectionEngine::Process(const cv::Mat& original_mat, Result& result)
     /*** PostProcess ***/
     const auto& t_post_process0 = std::chrono::steady_clock::now();
 
+    DecodeOutput(output_tensor_info_list_, 0, 1, crop_x, crop_y, crop_w, crop_h, original_mat.size(), result);
+    const auto& t_post_process1 = std::chrono::steady_clock::now();
+
+    /* Return the results */
+    result.time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
+    result.time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
+    result.time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;;
+
+    return kRetOk;
+}
+
+int32_t DetectionEngine::ProcessBatch(const std::vector<const cv::Mat*>& original_mat_list, std::vector<Result*>& result_list)
+{
+    if (!inference_helper_) {
+        PRINT_E("Inference helper is not created\n");
+        return kRetErr;
+    }
+    const int32_t batch_size = static_cast<int32_t>(original_mat_list.size());
+    if (batch_size > max_batch_size_ || result_list.size() != original_mat_list.size()) {
+        PRINT_E("Invalid batch size (%d)\n", batch_size);
+        return kRetErr;
+    }
+    if (!inference_helper_batch_ || batch_size == 1) {
+        for (int32_t b = 0; b < batch_size; b++) {
+            if (Process(*original_mat_list[b], *result_list[b]) != kRetOk) {
+                return kRetErr;
+            }
+        }
+        return kRetOk;
+    }
+
+    /*** PreProcess ***/
+    /* Normalize each image into its slot of the batch blob. Unused slots are zero (the model has a fixed batch size) */
+    InputTensorInfo& input_tensor_info = input_tensor_info_list_batch_[0];
+    const int32_t input_width = input_tensor_info.GetWidth();
+    const int32_t input_height = input_tensor_info.GetHeight();
+    const int32_t input_size = input_width * input_height * 3;
+    if (blob_batch_.empty()) {
+        blob_batch_ = cv::Mat::zeros(1, max_batch_size_ * input_size, CV_32FC1);
+    }
+    const cv::Scalar mean(input_tensor_info.normalize.mean[0], input_tensor_info.normalize.mean[1], input_tensor_info.normalize.mean[2]);
+    const cv::Scalar norm(input_tensor_info.normalize.norm[0], input_tensor_info.normalize.norm[1], input_tensor_info.normalize.norm[2]);
+    std::vector<std::array<int32_t, 4>> crop_list(batch_size);
+    for (int32_t b = 0; b < batch_size; b++) {
+        const auto& t_pre_process0 = std::chrono::steady_clock::now();
+        const cv::Mat& original_mat = *original_mat_list[b];
+        auto& crop = crop_list[b];
+        crop = { 0, 0, original_mat.cols, original_mat.rows };
+        cv::Mat img_src = cv::Mat::zeros(input_height, input_width, CV_8UC3);
+        CommonHelper::CropResizeCvt(original_mat, img_src, crop[0], crop[1], crop[2], crop[3], IS_RGB, CommonHelper::kCropTypeCut);
+        cv::Mat img_normalized;
+        img_src.convertTo(img_normalized, CV_32FC3, 1.0 / 255);
+        cv::subtract(img_normalized, mean, img_normalized);
+        cv::divide(img_normalized, norm, img_normalized);
+        float* dst = blob_batch_.ptr<float>() + b * input_size;
+        if (IS_NCHW) {
+            std::vector<cv::Mat> plane_list;
+            for (int32_t c = 0; c < 3; c++) plane_list.push_back(cv::Mat(input_height, input_width, CV_32FC1, dst + c * input_width * input_height));
+            cv::split(img_normalized, plane_list);
+        } else {
+            memcpy(dst, img_normalized.data, input_size * sizeof(float));
+        }
+        const auto& t_pre_process1 = std::chrono::steady_clock::now();
+        result_list[b]->time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
+    }
+    memset(blob_batch_.ptr<float>() + batch_size * input_size, 0, (max_batch_size_ - batch_size) * input_size * sizeof(float));
+    input_tensor_info.data = blob_batch_.data;
+    if (inference_helper_batch_->PreProcess(input_tensor_info_list_batch_) != InferenceHelper::kRetOk) {
+        return kRetErr;
+    }
+
+    /*** Inference ***/
+    const auto& t_inference0 = std::chrono::steady_clock::now();
+    if (inference_helper_batch_->Process(output_tensor_info_list_batch_) != InferenceHelper::kRetOk) {
+        return kRetErr;
+    }
+    const auto& t_inference1 = std::chrono::steady_clock::now();
+
+    /*** PostProcess ***/
+    for (int32_t b = 0; b < batch_size; b++) {
+        const auto& t_post_process0 = std::chrono::steady_clock::now();
+        const auto& crop = crop_list[b];
+        DecodeOutput(output_tensor_info_list_batch_, b, max_batch_size_, crop[0], crop[1], crop[2], crop[3], original_mat_list[b]->size(), *result_list[b]);
+        const auto& t_post_process1 = std::chrono::steady_clock::now();
+        result_list[b]->time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
+        result_list[b]->time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;
+    }
+
+    return kRetOk;
+}
+
+void DetectionEngine::DecodeOutput(std::vector<OutputTensorInfo>& output_tensor_info_list, int32_t batch_index, int32_t batch_size, int32_t crop_x, int32_t crop_y, int32_t crop_w, int32_t crop_h, const cv::Size& image_size, Result& result)
+{
     /* Get boundig box */
     std::vector<BoundingBox> bbox_list;
     std::vector<int32_t> feature_num_list(kStriceNum);
     for (int32_t i = 0; i < kStriceNum; i++) {
-        feature_num_list[i] = output_tensor_info_list_[i * 2 + 1].GetElementNum() / kNumClass;    // feature num = (the output size of class) / 80
-        if (feature_num_list[i] <= 0) feature_num_list[i] = input_tensor_info.GetWidth() * input_tensor_info.GetHeight() / (kStrideList[i] * kStrideList[i]);   /* In case I cannot get GetElementNum (this happens with cv::dnn) */
+        feature_num_list[i] = output_tensor_info_list[i * 2 + 1].GetElementNum() / batch_size / kNumClass;    // feature num = (the output size of class) / 80
+        if (feature_num_list[i] <= 0) feature_num_list[i] = input_tensor_info_list_[0].GetWidth() * input_tensor_info_list_[0].GetHeight() / (kStrideList[i] * kStrideList[i]);   /* In case I cannot get GetElementNum (this happens with cv::dnn) */
     }
 
+    /* Results of the image are at batch_index in each output tensor */
     std::vector<std::vector<float>> reg_list(kStriceNum);
     std::vector<std::vector<float>> score_list(kStriceNum);
     for (int32_t i = 0; i < kStriceNum; i++) {
-        reg_list[i].assign(output_tensor_info_list_[2 * i].GetDataAsFloat(), output_tensor_info_list_[2 * i].GetDataAsFloat() + feature_num_list[i] * (4 * (kRegMax + 1)));
-        score_list[i].assign(output_tensor_info_list_[2 * i + 1].GetDataAsFloat(), output_tensor_info_list_[2 * i + 1].GetDataAsFloat() + feature_num_list[i] * kNumClass);
+        const float* reg = output_tensor_info_list[2 * i].GetDataAsFloat() + batch_index * feature_num_list[i] * (4 * (kRegMax + 1));
+        const float* score = output_tensor_info_list[2 * i + 1].GetDataAsFloat() + batch_index * feature_num_list[i] * kNumClass;
+        reg_list[i].assign(reg, reg + feature_num_list[i] * (4 * (kRegMax + 1)));
+        score_list[i].assign(score, score + feature_num_list[i] * kNumClass);
     }
     for (int32_t i = 0; i < kStriceNum; i++) {
-        int32_t grid_w = input_tensor_info.GetWidth() / kStrideList[i];
-        int32_t grid_h = input_tensor_info.GetHeight() / kStrideList[i];
+        int32_t grid_w = input_tensor_info_list_[0].GetWidth() / kStrideList[i];
+        int32_t grid_h = input_tensor_info_list_[0].GetHeight() / kStrideList[i];
         DecodeInfer(bbox_list, score_list[i], reg_list[i], threshold_confidence_
             , grid_w, grid_h, static_cast<float>(crop_w) / grid_w, static_cast<float>(crop_h) / grid_h);
     }
@@ -226,23 +350,15 @@ int32_t DetectionEngine::Process(const cv::Mat& original_mat, Result& result)
     for (auto& bbox : bbox_nms_list) {
         bbox.x = (std::max)(bbox.x, 0) + crop_x;
         bbox.y = (std::max)(bbox.y, 0) + crop_y;
-        bbox.w = (std::min)(bbox.w, original_mat.cols - bbox.x);
-        bbox.h = (std::min)(bbox.h, original_mat.rows - bbox.y);
+        bbox.w = (std::min)(bbox.w, image_size.width - bbox.x);
+        bbox.h = (std::min)(bbox.h, image_size.height - bbox.y);
     }
 
-    const auto& t_post_process1 = std::chrono::steady_clock::now();
-
-    /* Return the results */
     result.bbox_list = bbox_nms_list;
     result.crop.x = (std::max)(0, crop_x);
     result.crop.y = (std::max)(0, crop_y);
-    result.crop.w = (std::min)(crop_w, original_mat.cols - result.crop.x);
-    result.crop.h = (std::min)(crop_h, original_mat.rows - result.crop.y);
-    result.time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
-    result.time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
-    result.time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;;
-
-    return kRetOk;
+    result.crop.w = (std::min)(crop_w, image_size.width - result.crop.x);
+    result.crop.h = (std::min)(crop_h, image_size.height - result.crop.y);
 }
 
 /* Original code: https://github.com/RangiLyu/nanodet/blob/main/demo_ncnn/nanodet.cpp */
@@ -55,16 +55,21 @@ public:
     } Result;
 
 public:
-    DetectionEngine(float threshold_confidence = 0.4f, float threshold_nms_iou = 0.5f) {
+    DetectionEngine(float threshold_confidence = 0.4f, float threshold_nms_iou = 0.5f, int32_t max_batch_size = 1) {
         threshold_confidence_ = threshold_confidence;
         threshold_nms_iou_ = threshold_nms_iou;
+        max_batch_size_ = max_batch_size;
     }
     ~DetectionEngine() {}
     int32_t Initialize(const std::string& work_dir, const int32_t num_threads);
     int32_t Finalize(void);
     int32_t Process(const cv::Mat& original_mat, Result& result);
+    /* Run up to max_batch_size images with one inference. time_inference of each result is the time of the whole batch */
+    int32_t ProcessBatch(const std::vector<const cv::Mat*>& original_mat_list, std::vector<Result*>& result_list);
+    int32_t GetMaxBatchSize() const { return max_batch_size_; }
 
 private:
+    void DecodeOutput(std::vector<OutputTensorInfo>& output_tensor_info_list, int32_t batch_index, int32_t batch_size, int32_t crop_x, int32_t crop_y, int32_t crop_w, int32_t crop_h, const cv::Size& image_size, Result& result);
     int32_t DecodeInfer(std::vector<BoundingBox>& bbox_list, const std::vector<float>& score_list, const std::vector<float>& reg_list, double threshold, int32_t grid_w, int32_t grid_h, float scale_grid2org_w, float scale_grid2org_h);
 
     void DisPred2Bbox(BoundingBox& bbox, const std::vector<float>& reg_list, int32_t idx, int32_t grid_x, int32_t grid_y, float scale_grid2org_w, float scale_grid2org_h);
@@ -76,6 +81,13 @@ private:
     std::vector<OutputTensorInfo> output_tensor_info_list_;
     std::vector<std::string> label_list_;
 
+    /* for batch. the model must accept batch size = max_batch_size_ (otherwise images are processed one by one) */
+    int32_t max_batch_size_;
+    std::unique_ptr<InferenceHelper> inference_helper_batch_;
+    std::vector<InputTensorInfo> input_tensor_info_list_batch_;
+    std::vector<OutputTensorInfo> output_tensor_info_list_batch_;
+    cv::Mat blob_batch_;
+
     float threshold_confidence_;
     float threshold_nms_iou_;
 };
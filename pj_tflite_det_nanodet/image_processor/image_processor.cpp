@@ -33,6 +33,7 @@ limitations under the License.
 #include "common_helper.h"
 #include "common_helper_cv.h"
 #include "bounding_box.h"
+#include "batch_scheduler.h"
 #include "detection_engine.h"
 #include "image_processor.h"
 
@@ -41,14 +42,19 @@ limitations under the License.
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
+/* Cross-stream batch (used only when multiple streams call Process) */
+static constexpr int32_t kMaxBatchSize = 4;
+static constexpr double kMaxBatchWaitMsec = 5.0;
+
 /*** Global variable ***/
 std::unique_ptr<DetectionEngine> s_engine;
+std::unique_ptr<BatchScheduler<cv::Mat, DetectionEngine::Result>> s_batch_scheduler;
 
 /*** Function ***/
 static void DrawFps(cv::Mat& mat, double time_inference, cv::Point pos, double font_scale, int32_t thickness, cv::Scalar color_front, cv::Scalar color_back, bool is_text_on_rect = true)
 {
     char text[64];
-    static auto time_previous = std::chrono::steady_clock::now();
+    static thread_local auto time_previous = std::chrono::steady_clock::now();     /* for each stream */
     auto time_now = std::chrono::steady_clock::now();
     double fps = 1e9 / (time_now - time_previous).count();
     time_previous = time_now;
@@ -76,12 +82,20 @@ int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param
         return -1;
     }
 
-    s_engine.reset(new DetectionEngine());
+    const int32_t max_batch_size = (std::min)(kMaxBatchSize, (std::max)(1, input_param.num_streams));
+    s_engine.reset(new DetectionEngine(0.4f, 0.5f, max_batch_size));
     if (s_engine->Initialize(input_param.work_dir, input_param.num_threads) != DetectionEngine::kRetOk) {
         s_engine->Finalize();
         s_engine.reset();
         return -1;
     }
+
+    if (max_batch_size > 1) {
+        s_batch_scheduler.reset(new BatchScheduler<cv::Mat, DetectionEngine::Result>(
+            [](const std::vector<const cv::Mat*>& mat_list, std::vector<DetectionEngine::Result*>& result_list) {
+                return s_engine->ProcessBatch(mat_list, result_list);
+            }, max_batch_size, kMaxBatchWaitMsec));
+    }
     return 0;
 }
 
@@ -92,6 +106,7 @@ int32_t ImageProcessor::Finalize(void)
         return -1;
     }
 
+    s_batch_scheduler.reset();
     if (s_engine->Finalize() != DetectionEngine::kRetOk) {
         return -1;
     }
@@ -125,8 +140,16 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
     }
 
     DetectionEngine::Result det_result;
-    if (s_engine->Process(mat, det_result) != DetectionEngine::kRetOk) {
-        return -1;
+    BatchScheduler<cv::Mat, DetectionEngine::Result>::Stat batch_stat;
+    if (s_batch_scheduler) {
+        if (s_batch_scheduler->Process(mat, det_result, &batch_stat) != DetectionEngine::kRetOk) {
+            return -1;
+        }
+    } else {
+        if (s_engine->Process(mat, det_result) != DetectionEngine::kRetOk) {
+            return -1;
+        }
+        batch_stat.batch_size = 1;
     }
 
     /* Display target area  */
@@ -149,6 +172,8 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
     result.time_pre_process = det_result.time_pre_process;
     result.time_inference = det_result.time_inference;
     result.time_post_process = det_result.time_post_process;
+    result.time_batch_wait = batch_stat.time_wait;
+    result.batch_size = batch_stat.batch_size;
 
     return 0;
 }
@@ -34,12 +34,15 @@ namespace ImageProcessor
 typedef struct {
     char     work_dir[256];
     int32_t  num_threads;
+    int32_t  num_streams;   // number of threads calling Process concurrently. frames from them are batched if > 1
 } InputParam;
 
 typedef struct {
     double time_pre_process;   // [msec]
-    double time_inference;    // [msec]
+    double time_inference;    // [msec]  (time of the whole batch)
     double time_post_process;  // [msec]
+    double time_batch_wait;    // [msec]  waiting for frames from other streams
+    int32_t batch_size;
 } Result;
 
 int32_t Initialize(const InputParam& input_param);
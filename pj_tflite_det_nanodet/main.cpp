@@ -19,6 +19,9 @@ limitations under the License.
 #include <string>
 #include <algorithm>
 #include <chrono>
+#include <vector>
+#include <memory>
+#include <future>
 
 /* for OpenCV */
 #include <opencv2/opencv.hpp>
@@ -26,6 +29,7 @@ limitations under the License.
 /* for My modules */
 #include "image_processor.h"
 #include "common_helper_cv.h"
+#include "load_test_source.h"
 
 /*** Macro ***/
 #define WORK_DIR                      RESOURCE_DIR
@@ -44,19 +48,38 @@ int32_t main(int argc, char* argv[])
     double total_time_inference = 0;
     double total_time_post_process = 0;
 
-    /* Find source image */
-    std::string input_name = (argc > 1) ? argv[1] : DEFAULT_INPUT_IMAGE;
-    cv::VideoCapture cap;   /* if cap is not opened, src is still image */
-    if (!CommonHelper::FindSourceImage(input_name, cap)) {
-        return -1;
+    /* Find source image (multiple inputs = multiple streams. frames of all streams are processed concurrently and batched) */
+    /* load test sources ("synthetic?copies=8", "replay:xxx.mp4?copies=8") create one stream for each copy */
+    std::vector<std::string> argument_list;
+    for (int32_t i = 1; i < argc; i++) argument_list.push_back(argv[i]);
+    if (argument_list.empty()) argument_list.push_back(DEFAULT_INPUT_IMAGE);
+    std::vector<std::string> input_name_list;
+    std::vector<std::unique_ptr<cv::VideoCapture>> cap_list;   /* if cap is not opened, src is still image */
+    for (const auto& argument : argument_list) {
+        if (CommonHelper::IsLoadTestSource(argument)) {
+            auto source_list = CommonHelper::CreateLoadTestSource(argument);
+            if (source_list.empty()) return -1;
+            for (auto& source : source_list) {
+                input_name_list.push_back(argument);
+                cap_list.push_back(std::move(source));
+            }
+        } else {
+            input_name_list.push_back(argument);
+            cap_list.push_back(std::unique_ptr<cv::VideoCapture>(new cv::VideoCapture()));
+            if (!CommonHelper::FindSourceImage(argument, *cap_list.back())) {
+                return -1;
+            }
+        }
     }
+    const int32_t num_streams = static_cast<int32_t>(cap_list.size());
+    cv::VideoCapture& cap = *cap_list[0];
 
     /* Create video writer to save output video */
     cv::VideoWriter writer;
     // writer = cv::VideoWriter("out.mp4", cv::VideoWriter::fourcc('M', 'P', '4', 'V'), (std::max)(10.0, cap.get(cv::CAP_PROP_FPS)), cv::Size(static_cast<int32_t>(cap.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int32_t>(cap.get(cv::CAP_PROP_FRAME_HEIGHT))));
 
     /* Initialize image processor library */
-    ImageProcessor::InputParam input_param = { WORK_DIR, 4 };
+    ImageProcessor::InputParam input_param = { WORK_DIR, 4, num_streams };
     if (ImageProcessor::Initialize(input_param) != 0) {
         printf("Initialization Error\n");
         return -1;
@@ -68,24 +91,39 @@ int32_t main(int argc, char* argv[])
         const auto& time_all0 = std::chrono::steady_clock::now();
         /* Read image */
         const auto& time_cap0 = std::chrono::steady_clock::now();
-        cv::Mat image;
-        if (cap.isOpened()) {
-            cap.read(image);
-        } else {
-            image = cv::imread(input_name);
+        std::vector<cv::Mat> image_list(num_streams);
+        for (int32_t i = 0; i < num_streams; i++) {
+            if (cap_list[i]->isOpened()) {
+                cap_list[i]->read(image_list[i]);
+            } else {
+                image_list[i] = cv::imread(input_name_list[i]);
+            }
         }
-        if (image.empty()) break;
+        if (std::any_of(image_list.begin(), image_list.end(), [](const cv::Mat& image) { return image.empty(); })) break;
+        cv::Mat& image = image_list[0];
         const auto& time_cap1 = std::chrono::steady_clock::now();
 
-        /* Call image processor library */
+        /* Call image processor library (one thread per stream) */
         const auto& time_image_process0 = std::chrono::steady_clock::now();
-        ImageProcessor::Result result;
-        ImageProcessor::Process(image, result);
+        std::vector<ImageProcessor::Result> result_list(num_streams);
+        if (num_streams == 1) {
+            ImageProcessor::Process(image, result_list[0]);
+        } else {
+            std::vector<std::future<int32_t>> future_list;
+            for (int32_t i = 0; i < num_streams; i++) {
+                future_list.push_back(std::async(std::launch::async, [&image_list, &result_list, i]() { return ImageProcessor::Process(image_list[i], result_list[i]); }));
+            }
+            for (auto& future : future_list) future.get();
+        }
+        const ImageProcessor::Result& result = result_list[0];
         const auto& time_image_process1 = std::chrono::steady_clock::now();
 
         /* Display result */
         if (writer.isOpened()) writer.write(image);
         cv::imshow("test", image);
+        for (int32_t i = 1; i < num_streams; i++) {
+            cv::imshow("test" + std::to_string(i), image_list[i]);
+        }
 
         /* Input key command */
         if (cap.isOpened()) {
@@ -105,6 +143,13 @@ int32_t main(int argc, char* argv[])
         printf("    Pre processing:  %9.3lf [msec]\n", result.time_pre_process);
         printf("    Inference:       %9.3lf [msec]\n", result.time_inference);
         printf("    Post processing: %9.3lf [msec]\n", result.time_post_process);
+        if (num_streams > 1) {
+            for (int32_t i = 0; i < num_streams; i++) {
+                const auto& r = result_list[i];
+                printf("  Stream %d:          %9.3lf [msec] (batch wait = %.3lf [msec], batch size = %d)\n", i,
+                    r.time_batch_wait + r.time_pre_process + r.time_inference + r.time_post_process, r.time_batch_wait, r.batch_size);
+            }
+        }
         printf("=== Finished %d frame ===\n\n", frame_cnt);
 
         if (frame_cnt > 0) {    /* do not count the first process because it may include initialize process */
@@ -129,6 +174,10 @@ int32_t main(int argc, char* argv[])
         printf("    Inference:       %9.3lf [msec]\n", total_time_inference / frame_cnt);
         printf("    Post processing: %9.3lf [msec]\n", total_time_post_process / frame_cnt);
     }
+    for (int32_t i = 0; i < num_streams; i++) {
+        const LoadTestCapture* source = dynamic_cast<const LoadTestCapture*>(cap_list[i].get());
+        if (source) printf("Stream %d: %d frames processed, %d frames dropped\n", i, source->GetFrameNum(), source->GetDropNum());
+    }
 
     /* Fianlize image processor library */
     ImageProcessor::Finalize();
@@ -29,6 +29,7 @@ limitations under the License.
 /* for My modules */
 #include "inference_helper.h"
 #include "bounding_box.h"
+#include "resolution_selector.h"
 
 
 class DetectionEngine {
@@ -47,10 +48,12 @@ public:
             int32_t h;
             crop_() : x(0), y(0), w(0), h(0) {}
         } crop;
+        int32_t                  input_width;   /* input size used for this frame */
+        int32_t                  input_height;
         double                   time_pre_process;		// [msec]
         double                   time_inference;		// [msec]
         double                   time_post_process;	    // [msec]
-        Result_() : time_pre_process(0), time_inference(0), time_post_process(0)
+        Result_() : input_width(0), input_height(0), time_pre_process(0), time_inference(0), time_post_process(0)
         {}
     } Result;
 
@@ -59,20 +62,33 @@ public:
         threshold_box_confidence_ = threshold_box_confidence;
         threshold_class_confidence_ = threshold_class_confidence;
         threshold_nms_iou_ = threshold_nms_iou;
+        min_object_size_ = 0;
     }
     ~DetectionEngine() {}
     int32_t Initialize(const std::string& work_dir, const int32_t num_threads);
     int32_t Finalize(void);
     int32_t Process(const cv::Mat& original_mat, Result& result);
 
+    /* for adaptive resolution mode */
+    void SetLatencyBudget(double latency_budget);
+    void SetMinObjectSize(int32_t min_object_size);
+
+private:
+    typedef struct Interpreter_ {
+        std::unique_ptr<InferenceHelper> inference_helper;
+        std::vector<InputTensorInfo> input_tensor_info_list;
+        std::vector<OutputTensorInfo> output_tensor_info_list;
+    } Interpreter;
+
 private:
+    int32_t InitializeInterpreter(Interpreter& interpreter, const std::string& model_filename, int32_t width, int32_t height, const int32_t num_threads);
     int32_t ReadLabel(const std::string& filename, std::vector<std::string>& label_list);
     void GetBoundingBox(const float* data, float scale_x, float  scale_y, int32_t grid_w, int32_t grid_h, std::vector<BoundingBox>& bbox_list);
 
 private:
-    std::unique_ptr<InferenceHelper> inference_helper_;
-    std::vector<InputTensorInfo> input_tensor_info_list_;
-    std::vector<OutputTensorInfo> output_tensor_info_list_;
+    std::vector<Interpreter> interpreter_list_;     /* one interpreter for each input size (from the highest resolution) */
+    ResolutionSelector resolution_selector_;
+    int32_t min_object_size_;   /* the smallest tracked object in the previous frame [px]. 0 = unknown */
     std::vector<std::string> label_list_;
 
     float threshold_box_confidence_;
@@ -42,6 +42,9 @@ limitations under the License.
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
+/* Latency budget for detection in adaptive resolution mode. 0 = always use the highest resolution */
+static constexpr double kLatencyBudgetDetection = 0.0;     /* [msec] */
+
 /*** Global variable ***/
 std::unique_ptr<DetectionEngine> s_engine;
 Tracker s_tracker;
@@ -84,6 +87,7 @@ int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param
         s_engine.reset();
         return -1;
     }
+    s_engine->SetLatencyBudget(kLatencyBudgetDetection);
     return 0;
 }
 
@@ -143,6 +147,13 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
 
     /* Display tracking result  */
     s_tracker.Update(det_result.bbox_list);
+    int32_t min_object_size = 0;
+    for (auto& track : s_tracker.GetTrackList()) {
+        const auto& bbox = track.GetLatestData().bbox;
+        int32_t size = (std::min)(bbox.w, bbox.h);
+        if (size > 0 && (min_object_size == 0 || size < min_object_size)) min_object_size = size;
+    }
+    s_engine->SetMinObjectSize(min_object_size);    /* used to select input size for the next frame */
     int32_t num_track = 0;
     auto& track_list = s_tracker.GetTrackList();
     for (auto& track : track_list) {
@@ -161,9 +172,9 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
         }
         num_track++;
     }
-    CommonHelper::DrawText(mat, "DET: " + std::to_string(num_det) + ", TRACK: " + std::to_string(num_track), cv::Point(0, 20), 0.7, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(220, 220, 220));
+    CommonHelper::DrawText(mat, "DET: " + std::to_string(num_det) + ", TRACK: " + std::to_string(num_track) + ", INPUT: " + std::to_string(det_result.input_width) + "x" + std::to_string(det_result.input_height), cv::Point(0, 20), 0.7, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(220, 220, 220));
     DrawFps(mat, det_result.time_inference, cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
-    
+
     /* Return the results */
     int32_t bbox_num = 0;
     for (auto& track : track_list) {
@@ -0,0 +1,198 @@
+/* Copyright 2021 iwatake2222
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/*** Include ***/
+/* for general */
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+/* for OpenCV */
+#include <opencv2/opencv.hpp>
+
+/* for My modules */
+#include "detection_engine.h"
+#include "tracker.h"
+#include "accuracy_evaluator.h"
+
+/*** Macro ***/
+#define WORK_DIR                      RESOURCE_DIR
+
+static constexpr int32_t kNumThreads = 4;
+static constexpr double kLatencyBudgetList[] = { 20.0, 40.0 };      /* [msec] for adaptive resolution mode */
+static constexpr int32_t kDetectionIntervalList[] = { 1, 2, 3 };    /* run detection every N frames (tracker predicts the others) */
+
+/* low thresholds for mAP. tracking uses the same thresholds as the application */
+static constexpr float kThresholdBoxConfidenceForAp = 0.05f;
+static constexpr float kThresholdClassConfidenceForAp = 0.05f;
+static constexpr float kThresholdNmsIou = 0.5f;
+
+/*** Function ***/
+typedef struct Config_ {
+    std::string name;
+    int32_t     level;              /* -1 = adaptive */
+    double      latency_budget;
+    int32_t     detection_interval;
+} Config;
+
+static std::vector<Config> CreateConfigList(const DetectionEngine& engine, bool with_interval)
+{
+    std::vector<Config> config_list;
+    for (int32_t level = 0; level < engine.GetLevelNum(); level++) {
+        for (int32_t interval : kDetectionIntervalList) {
+            if (!with_interval && interval != 1) continue;
+            const auto& level_info = engine.GetLevel(level);
+            std::string name = "fixed_" + std::to_string(level_info.width) + "x" + std::to_string(level_info.height);
+            if (with_interval) name += "_every" + std::to_string(interval);
+            config_list.push_back({ name, level, 0, interval });
+        }
+    }
+    if (engine.GetLevelNum() > 1) {
+        for (double latency_budget : kLatencyBudgetList) {
+            config_list.push_back({ "adaptive_" + std::to_string(static_cast<int32_t>(latency_budget)) + "ms", -1, latency_budget, 1 });
+        }
+    }
+    return config_list;
+}
+
+static void ApplyConfig(DetectionEngine& engine, const Config& config)
+{
+    engine.SetFixedLevel(config.level);
+    engine.SetLatencyBudget(config.latency_budget);
+    engine.SetMinObjectSize(0);
+}
+
+static int32_t EvaluateDetection(const std::string& annotation_filename, const std::string& image_dir, EvaluationReport& report)
+{
+    DetectionEvaluator evaluator;
+    if (evaluator.LoadCocoAnnotation(annotation_filename) != 0) return -1;
+
+    DetectionEngine engine(kThresholdBoxConfidenceForAp, kThresholdClassConfidenceForAp, kThresholdNmsIou);
+    if (engine.Initialize(WORK_DIR, kNumThreads) != DetectionEngine::kRetOk) return -1;
+
+    for (const auto& config : CreateConfigList(engine, false)) {
+        ApplyConfig(engine, config);
+        evaluator.ClearResult();
+        std::vector<double> latency_list;
+        for (const auto& image_info : evaluator.GetImageList()) {
+            cv::Mat image = cv::imread(image_dir + "/" + image_info.file_name);
+            if (image.empty()) {
+                printf("Failed to read %s\n", image_info.file_name.c_str());
+                continue;
+            }
+            DetectionEngine::Result det_result;
+            if (engine.Process(image, det_result) != DetectionEngine::kRetOk) return -1;
+            latency_list.push_back(det_result.time_pre_process + det_result.time_inference + det_result.time_post_process);
+            evaluator.AddResult(image_info.id, det_result.bbox_list);
+        }
+        const auto& summary = evaluator.Evaluate();
+        printf("%s: AP = %.4f, AP50 = %.4f, AP75 = %.4f\n", config.name.c_str(), summary.ap, summary.ap50, summary.ap75);
+        report.Add(config.name, summary.ap, latency_list);
+    }
+
+    engine.Finalize();
+    return 0;
+}
+
+static int32_t EvaluateTracking(const std::string& sequence_dir, EvaluationReport& report_mota, EvaluationReport& report_idf1)
+{
+    TrackingEvaluator evaluator;
+    if (evaluator.LoadMotGroundTruth(sequence_dir + "/gt/gt.txt") != 0) return -1;
+    std::vector<cv::String> image_filename_list;
+    cv::glob(sequence_dir + "/img1/*.jpg", image_filename_list);
+    std::sort(image_filename_list.begin(), image_filename_list.end());
+    if (image_filename_list.empty()) {
+        printf("No image in %s/img1\n", sequence_dir.c_str());
+        return -1;
+    }
+
+    DetectionEngine engine;
+    if (engine.Initialize(WORK_DIR, kNumThreads) != DetectionEngine::kRetOk) return -1;
+
+    for (const auto& config : CreateConfigList(engine, true)) {
+        ApplyConfig(engine, config);
+        evaluator.ClearResult();
+        Tracker tracker(2 + config.detection_interval);    /* keep tracks alive during the frames without detection */
+        std::vector<double> latency_list;
+        for (size_t i = 0; i < image_filename_list.size(); i++) {
+            cv::Mat image = cv::imread(image_filename_list[i]);
+            if (image.empty()) break;
+
+            const auto& t0 = std::chrono::steady_clock::now();
+            std::vector<BoundingBox> person_list;
+            if (static_cast<int32_t>(i) % config.detection_interval == 0) {
+                DetectionEngine::Result det_result;
+                if (engine.Process(image, det_result) != DetectionEngine::kRetOk) return -1;
+                for (const auto& bbox : det_result.bbox_list) {
+                    if (bbox.label == "person") person_list.push_back(bbox);
+                }
+            }
+            tracker.Update(person_list);
+            int32_t min_object_size = 0;
+            for (auto& track : tracker.GetTrackList()) {
+                const auto& bbox = track.GetLatestData().bbox;
+                int32_t size = (std::min)(bbox.w, bbox.h);
+                if (size > 0 && (min_object_size == 0 || size < min_object_size)) min_object_size = size;
+            }
+            engine.SetMinObjectSize(min_object_size);
+            const auto& t1 = std::chrono::steady_clock::now();
+            latency_list.push_back(static_cast<std::chrono::duration<double>>(t1 - t0).count() * 1000.0);
+
+            std::vector<TrackingEvaluator::Object> object_list;
+            for (auto& track : tracker.GetTrackList()) {
+                if (track.GetDetectedCount() < 2) continue;
+                const auto& bbox = track.GetLatestData().bbox;
+                object_list.push_back({ track.GetId(), static_cast<float>(bbox.x), static_cast<float>(bbox.y), static_cast<float>(bbox.w), static_cast<float>(bbox.h) });
+            }
+            evaluator.AddResult(static_cast<int32_t>(i) + 1, object_list);
+        }
+        const auto& summary = evaluator.Evaluate();
+        printf("%s: MOTA = %.4f, IDF1 = %.4f, FP = %d, FN = %d, IDSW = %d\n", config.name.c_str(), summary.mota, summary.idf1, summary.num_fp, summary.num_fn, summary.num_switch);
+        report_mota.Add(config.name, summary.mota, latency_list);
+        report_idf1.Add(config.name, summary.idf1, latency_list);
+    }
+
+    engine.Finalize();
+    return 0;
+}
+
+int32_t main(int argc, char* argv[])
+{
+    const std::string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "det" && argc > 3) {
+        EvaluationReport report;
+        if (EvaluateDetection(argv[2], argv[3], report) != 0) return -1;
+        printf("=== Speed / accuracy trade-off ===\n");
+        report.Print("AP");
+        if (argc > 4) report.WriteCsv(argv[4], "AP");
+    } else if (mode == "mot" && argc > 2) {
+        EvaluationReport report_mota;
+        EvaluationReport report_idf1;
+        if (EvaluateTracking(argv[2], report_mota, report_idf1) != 0) return -1;
+        printf("=== Speed / accuracy trade-off ===\n");
+        report_mota.Print("MOTA");
+        report_idf1.Print("IDF1");
+        if (argc > 3) report_mota.WriteCsv(argv[3], "MOTA");
+    } else {
+        printf("Usage:\n");
+        printf("  %s det <instances_val2017.json> <image_dir> [out.csv]\n", argv[0]);
+        printf("  %s mot <sequence_dir (img1/, gt/gt.txt)> [out.csv]\n", argv[0]);
+        return -1;
+    }
+    return 0;
+}
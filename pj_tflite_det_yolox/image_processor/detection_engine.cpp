@@ -32,6 +32,8 @@ limitations under the License.
 #include "common_helper.h"
 #include "common_helper_cv.h"
 #include "inference_helper.h"
+#include "model_registry.h"
+#include "perf_counter.h"
 #include "detection_engine.h"
 
 /*** Macro ***/
@@ -44,23 +46,25 @@ limitations under the License.
 //#define MODEL_TYPE_ONNX
 
 #if defined(MODEL_TYPE_TFLITE)
-#define MODEL_NAME  "yolox_nano_480x640.tflite"
+#define MODEL_NAME_FORMAT  "yolox_nano_%dx%d.tflite"
 #define TENSORTYPE  TensorInfo::kTensorTypeFp32
 #define INPUT_NAME  "images"
-#define INPUT_DIMS  { 1, 480, 640, 3 }
 #define IS_NCHW     false
 #define IS_RGB      true
 #define OUTPUT_NAME "Identity"
 #elif defined(MODEL_TYPE_ONNX)
-#define MODEL_NAME  "yolox_nano_480x640.onnx"
+#define MODEL_NAME_FORMAT  "yolox_nano_%dx%d.onnx"
 #define TENSORTYPE  TensorInfo::kTensorTypeFp32
 #define INPUT_NAME  "images"
-#define INPUT_DIMS  { 1, 3, 480, 640 }
 #define IS_NCHW     true
 #define IS_RGB      true
 #define OUTPUT_NAME "output"
 #endif
 
+/* Input sizes (height, width) from the highest resolution. The first one is mandatory */
+/* The others are used for adaptive resolution mode only when the model file (e.g. yolox_nano_320x320.tflite) exists */
+static constexpr int32_t kInputSizeList[][2] = { { 480, 640 }, { 416, 416 }, { 320, 320 } };
+
 static constexpr int32_t kGridScaleList[] = { 8, 16, 32 };
 static constexpr int32_t kGridChannel = 1;
 static constexpr int32_t kNumberOfClass = 80;
@@ -68,18 +72,76 @@ static constexpr int32_t kElementNumOfAnchor = kNumberOfClass + 5;    // x, y, w
 
 #define LABEL_NAME   "label_coco_80.txt"
 
+/* Stages measured with hardware performance counters */
+static const int32_t s_perf_stage_crop_resize = PerfCounter::RegisterStage("yolox_crop_resize");
+static const int32_t s_perf_stage_inference = PerfCounter::RegisterStage("yolox_inference");
+static const int32_t s_perf_stage_decode = PerfCounter::RegisterStage("yolox_decode");
+static const int32_t s_perf_stage_nms = PerfCounter::RegisterStage("yolox_nms");
+
 
 /*** Function ***/
 int32_t DetectionEngine::Initialize(const std::string& work_dir, const int32_t num_threads)
 {
-    /* Set model information */
-    std::string model_filename = work_dir + "/model/" + MODEL_NAME;
     std::string labelFilename = work_dir + "/model/" + LABEL_NAME;
 
+    /* Prepare interpreter for each input size, and warm up it to measure processing time */
+    interpreter_list_.clear();
+    resolution_selector_ = ResolutionSelector();
+    for (const auto& input_size : kInputSizeList) {
+        char model_name[64];
+        snprintf(model_name, sizeof(model_name), MODEL_NAME_FORMAT, input_size[0], input_size[1]);
+        std::string model_filename = work_dir + "/model/" + model_name;
+        if (!interpreter_list_.empty() && !std::ifstream(model_filename)) continue;
+
+        Interpreter interpreter;
+        if (InitializeInterpreter(interpreter, model_filename, input_size[1], input_size[0], num_threads) != kRetOk) {
+            if (interpreter_list_.empty()) return kRetErr;
+            continue;
+        }
+
+        cv::Mat img_dummy = cv::Mat::zeros(input_size[0], input_size[1], CV_8UC3);
+        InputTensorInfo& input_tensor_info = interpreter.input_tensor_info_list[0];
+        input_tensor_info.data = img_dummy.data;
+        input_tensor_info.image_info.width = img_dummy.cols;
+        input_tensor_info.image_info.height = img_dummy.rows;
+        input_tensor_info.image_info.channel = img_dummy.channels();
+        input_tensor_info.image_info.crop_x = 0;
+        input_tensor_info.image_info.crop_y = 0;
+        input_tensor_info.image_info.crop_width = img_dummy.cols;
+        input_tensor_info.image_info.crop_height = img_dummy.rows;
+        input_tensor_info.image_info.is_bgr = false;
+        input_tensor_info.image_info.swap_color = false;
+        const auto& t0 = std::chrono::steady_clock::now();
+        if (interpreter.inference_helper->PreProcess(interpreter.input_tensor_info_list) != InferenceHelper::kRetOk
+            || interpreter.inference_helper->Process(interpreter.output_tensor_info_list) != InferenceHelper::kRetOk) {
+            return kRetErr;
+        }
+        const auto& t1 = std::chrono::steady_clock::now();
+        double time_warmup = static_cast<std::chrono::duration<double>>(t1 - t0).count() * 1000.0;
+        PRINT("Input size %d x %d: warm up = %.3lf [msec]\n", input_size[1], input_size[0], time_warmup);
+
+        resolution_selector_.AddLevel(input_size[1], input_size[0], time_warmup);
+        interpreter_list_.push_back(std::move(interpreter));
+    }
+
+    /* read label */
+    if (ReadLabel(labelFilename, label_list_) != kRetOk) {
+        return kRetErr;
+    }
+
+    return kRetOk;
+}
+
+int32_t DetectionEngine::InitializeInterpreter(Interpreter& interpreter, const std::string& model_filename, int32_t width, int32_t height, const int32_t num_threads)
+{
     /* Set input tensor info */
-    input_tensor_info_list_.clear();
+    interpreter.input_tensor_info_list.clear();
     InputTensorInfo input_tensor_info(INPUT_NAME, TENSORTYPE, IS_NCHW);
-    input_tensor_info.tensor_dims = INPUT_DIMS;
+    if (IS_NCHW) {
+        input_tensor_info.tensor_dims = { 1, 3, height, width };
+    } else {
+        input_tensor_info.tensor_dims = { 1, height, width, 3 };
+    }
     input_tensor_info.data_type = InputTensorInfo::kDataTypeImage;
     input_tensor_info.normalize.mean[0] = 0.485f;
     input_tensor_info.normalize.mean[1] = 0.456f;
@@ -87,37 +149,38 @@ int32_t DetectionEngine::Initialize(const std::string& work_dir, const int32_t n
     input_tensor_info.normalize.norm[0] = 0.229f;
     input_tensor_info.normalize.norm[1] = 0.224f;
     input_tensor_info.normalize.norm[2] = 0.225f;
-    input_tensor_info_list_.push_back(input_tensor_info);
+    interpreter.input_tensor_info_list.push_back(input_tensor_info);
 
     /* Set output tensor info */
-    output_tensor_info_list_.clear();
-    output_tensor_info_list_.push_back(OutputTensorInfo(OUTPUT_NAME, TENSORTYPE));
+    interpreter.output_tensor_info_list.clear();
+    interpreter.output_tensor_info_list.push_back(OutputTensorInfo(OUTPUT_NAME, TENSORTYPE));
+
+    /* Read identical models (e.g. copied model files) from one file, so that they share the page cache */
+    const std::string model_filename_resolved = ModelRegistry::Resolve(model_filename);
+    if (model_filename_resolved.empty()) {
+        return kRetErr;
+    }
 
     /* Create and Initialize Inference Helper */
 #if defined(MODEL_TYPE_TFLITE)
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLite));
-    inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteXnnpack));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteGpu));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteEdgetpu));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteNnapi));
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLite));
+    interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteXnnpack));
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteGpu));
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteEdgetpu));
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteNnapi));
 #elif defined(MODEL_TYPE_ONNX)
-    inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kOpencv));
+    interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kOpencv));
 #endif
 
-    if (!inference_helper_) {
-        return kRetErr;
-    }
-    if (inference_helper_->SetNumThreads(num_threads) != InferenceHelper::kRetOk) {
-        inference_helper_.reset();
+    if (!interpreter.inference_helper) {
         return kRetErr;
     }
-    if (inference_helper_->Initialize(model_filename, input_tensor_info_list_, output_tensor_info_list_) != InferenceHelper::kRetOk) {
-        inference_helper_.reset();
+    if (interpreter.inference_helper->SetNumThreads(num_threads) != InferenceHelper::kRetOk) {
+        interpreter.inference_helper.reset();
         return kRetErr;
     }
-
-    /* read label */
-    if (ReadLabel(labelFilename, label_list_) != kRetOk) {
+    if (interpreter.inference_helper->Initialize(model_filename_resolved, interpreter.input_tensor_info_list, interpreter.output_tensor_info_list) != InferenceHelper::kRetOk) {
+        interpreter.inference_helper.reset();
         return kRetErr;
     }
 
@@ -126,14 +189,41 @@ int32_t DetectionEngine::Initialize(const std::string& work_dir, const int32_t n
 
 int32_t DetectionEngine::Finalize()
 {
-    if (!inference_helper_) {
+    if (interpreter_list_.empty()) {
         PRINT_E("Inference helper is not created\n");
         return kRetErr;
     }
-    inference_helper_->Finalize();
+    for (auto& interpreter : interpreter_list_) {
+        interpreter.inference_helper->Finalize();
+    }
     return kRetOk;
 }
 
+void DetectionEngine::SetLatencyBudget(double latency_budget)
+{
+    resolution_selector_.SetLatencyBudget(latency_budget);
+}
+
+void DetectionEngine::SetMinObjectSize(int32_t min_object_size)
+{
+    min_object_size_ = min_object_size;
+}
+
+void DetectionEngine::SetFixedLevel(int32_t level)
+{
+    fixed_level_ = (level < static_cast<int32_t>(interpreter_list_.size())) ? level : -1;
+}
+
+int32_t DetectionEngine::GetLevelNum() const
+{
+    return resolution_selector_.GetLevelNum();
+}
+
+const ResolutionSelector::Level& DetectionEngine::GetLevel(int32_t level) const
+{
+    return resolution_selector_.GetLevel(level);
+}
+
 
 void DetectionEngine::GetBoundingBox(const float* data, float scale_x, float  scale_y, int32_t grid_w, int32_t grid_h, std::vector<BoundingBox>& bbox_list)
 {
@@ -170,24 +260,33 @@ void DetectionEngine::GetBoundingBox(const float* data, float scale_x, float  sc
 }
 
 
-int32_t DetectionEngine::Process(const cv::Mat& original_mat, Result& result)
+template <typename IMAGE>
+int32_t DetectionEngine::ProcessImage(const IMAGE& original, int32_t original_width, int32_t original_height, Result& result)
 {
-    if (!inference_helper_) {
+    if (interpreter_list_.empty()) {
         PRINT_E("Inference helper is not created\n");
         return kRetErr;
     }
+
+    /* Select input size for this frame (always the first one unless latency budget is set) */
+    const int32_t level = (fixed_level_ >= 0) ? fixed_level_ : resolution_selector_.Select(original_width, original_height, min_object_size_);
+    Interpreter& interpreter = interpreter_list_[level];
+
     /*** PreProcess ***/
     const auto& t_pre_process0 = std::chrono::steady_clock::now();
-    InputTensorInfo& input_tensor_info = input_tensor_info_list_[0];
+    InputTensorInfo& input_tensor_info = interpreter.input_tensor_info_list[0];
     /* do crop, resize and color conversion here because some inference engine doesn't support these operations */
     int32_t crop_x = 0;
     int32_t crop_y = 0;
-    int32_t crop_w = original_mat.cols;
-    int32_t crop_h = original_mat.rows;
+    int32_t crop_w = original_width;
+    int32_t crop_h = original_height;
     cv::Mat img_src = cv::Mat::zeros(input_tensor_info.GetHeight(), input_tensor_info.GetWidth(), CV_8UC3);
-    //CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
-    //CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeCut);
-    CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeExpand);
+    //CommonHelper::CropResizeCvt(original, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
+    //CommonHelper::CropResizeCvt(original, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeCut);
+    {
+        PerfCounter::Scope perf_scope(s_perf_stage_crop_resize);
+        CommonHelper::CropResizeCvt(original, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeExpand);
+    }
 
     input_tensor_info.data = img_src.data;
     input_tensor_info.data_type = InputTensorInfo::kDataTypeImage;
@@ -200,15 +299,18 @@ int32_t DetectionEngine::Process(const cv::Mat& original_mat, Result& result)
     input_tensor_info.image_info.crop_height = img_src.rows;
     input_tensor_info.image_info.is_bgr = false;
     input_tensor_info.image_info.swap_color = false;
-    if (inference_helper_->PreProcess(input_tensor_info_list_) != InferenceHelper::kRetOk) {
+    if (interpreter.inference_helper->PreProcess(interpreter.input_tensor_info_list) != InferenceHelper::kRetOk) {
         return kRetErr;
     }
     const auto& t_pre_process1 = std::chrono::steady_clock::now();
 
     /*** Inference ***/
     const auto& t_inference0 = std::chrono::steady_clock::now();
-    if (inference_helper_->Process(output_tensor_info_list_) != InferenceHelper::kRetOk) {
-        return kRetErr;
+    {
+        PerfCounter::Scope perf_scope(s_perf_stage_inference);
+        if (interpreter.inference_helper->Process(interpreter.output_tensor_info_list) != InferenceHelper::kRetOk) {
+            return kRetErr;
+        }
     }
     const auto& t_inference1 = std::chrono::steady_clock::now();
 
@@ -216,14 +318,17 @@ int32_t DetectionEngine::Process(const cv::Mat& original_mat, Result& result)
     const auto& t_post_process0 = std::chrono::steady_clock::now();
     /* Get boundig box */
     std::vector<BoundingBox> bbox_list;
-    float* output_data = output_tensor_info_list_[0].GetDataAsFloat();
-    for (const auto& grid_scale : kGridScaleList) {
-        int32_t grid_w = input_tensor_info.GetWidth() / grid_scale;
-        int32_t grid_h = input_tensor_info.GetHeight() / grid_scale;
-        float scale_x = static_cast<float>(grid_scale) * crop_w / input_tensor_info.GetWidth();      /* scale to original image */
-        float scale_y = static_cast<float>(grid_scale) * crop_h / input_tensor_info.GetHeight();
-        GetBoundingBox(output_data, scale_x, scale_y, grid_w, grid_h, bbox_list);
-        output_data += grid_w * grid_h * kGridChannel * kElementNumOfAnchor;
+    float* output_data = interpreter.output_tensor_info_list[0].GetDataAsFloat();
+    {
+        PerfCounter::Scope perf_scope(s_perf_stage_decode);
+        for (const auto& grid_scale : kGridScaleList) {
+            int32_t grid_w = input_tensor_info.GetWidth() / grid_scale;
+            int32_t grid_h = input_tensor_info.GetHeight() / grid_scale;
+            float scale_x = static_cast<float>(grid_scale) * crop_w / input_tensor_info.GetWidth();      /* scale to original image */
+            float scale_y = static_cast<float>(grid_scale) * crop_h / input_tensor_info.GetHeight();
+            GetBoundingBox(output_data, scale_x, scale_y, grid_w, grid_h, bbox_list);
+            output_data += grid_w * grid_h * kGridChannel * kElementNumOfAnchor;
+        }
     }
 
 
@@ -236,7 +341,10 @@ int32_t DetectionEngine::Process(const cv::Mat& original_mat, Result& result)
 
     /* NMS */
     std::vector<BoundingBox> bbox_nms_list;
-    BoundingBoxUtils::Nms(bbox_list, bbox_nms_list, threshold_nms_iou_);
+    {
+        PerfCounter::Scope perf_scope(s_perf_stage_nms);
+        BoundingBoxUtils::Nms(bbox_list, bbox_nms_list, threshold_nms_iou_);
+    }
 
     const auto& t_post_process1 = std::chrono::steady_clock::now();
 
@@ -244,15 +352,29 @@ int32_t DetectionEngine::Process(const cv::Mat& original_mat, Result& result)
     result.bbox_list = bbox_nms_list;
     result.crop.x = (std::max)(0, crop_x);
     result.crop.y = (std::max)(0, crop_y);
-    result.crop.w = (std::min)(crop_w, original_mat.cols - result.crop.x);
-    result.crop.h = (std::min)(crop_h, original_mat.rows - result.crop.y);
+    result.crop.w = (std::min)(crop_w, original_width - result.crop.x);
+    result.crop.h = (std::min)(crop_h, original_height - result.crop.y);
     result.time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
     result.time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
     result.time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;;
+    result.input_width = input_tensor_info.GetWidth();
+    result.input_height = input_tensor_info.GetHeight();
+
+    resolution_selector_.Feedback(level, result.time_pre_process + result.time_inference + result.time_post_process);
 
     return kRetOk;
 }
 
+int32_t DetectionEngine::Process(const cv::Mat& original_mat, Result& result)
+{
+    return ProcessImage(original_mat, original_mat.cols, original_mat.rows, result);
+}
+
+int32_t DetectionEngine::Process(const YuvImage& original_yuv, Result& result)
+{
+    return ProcessImage(original_yuv, original_yuv.width, original_yuv.height, result);
+}
+
 
 int32_t DetectionEngine::ReadLabel(const std::string& filename, std::vector<std::string>& label_list)
 {
@@ -25,6 +25,7 @@ limitations under the License.
 namespace cv {
     class Mat;
 };
+class YuvImage;
 
 #define NUM_MAX_RESULT 100
 
@@ -54,6 +55,7 @@ typedef struct {
 
 int32_t Initialize(const InputParam& input_param);
 int32_t Process(cv::Mat& mat, Result& result);
+int32_t Process(const YuvImage& yuv, cv::Mat& mat, Result& result);    /* detection from YUV. mat is converted to BGR only to draw the result */
 int32_t Finalize(void);
 int32_t Command(int32_t cmd);
 
@@ -26,6 +26,8 @@ limitations under the License.
 /* for My modules */
 #include "image_processor.h"
 #include "common_helper_cv.h"
+#include "yuv_image.h"
+#include "perf_counter.h"
 
 /*** Macro ***/
 #define WORK_DIR                      RESOURCE_DIR
@@ -47,7 +49,13 @@ int32_t main(int argc, char* argv[])
     /* Find source image */
     std::string input_name = (argc > 1) ? argv[1] : DEFAULT_INPUT_IMAGE;
     cv::VideoCapture cap;   /* if cap is not opened, src is still image */
-    if (!CommonHelper::FindSourceImage(input_name, cap)) {
+    const bool is_yuv = CommonHelper::IsYuvSource(input_name);     /* e.g. "yuv:0", "yuv:videotestsrc" */
+    int32_t yuv_format = 0;
+    if (is_yuv) {
+        if (!CommonHelper::FindSourceYuv(input_name, cap, yuv_format)) {
+            return -1;
+        }
+    } else if (!CommonHelper::FindSourceImage(input_name, cap)) {
         return -1;
     }
 
@@ -55,6 +63,9 @@ int32_t main(int argc, char* argv[])
     cv::VideoWriter writer;
     // writer = cv::VideoWriter("out.mp4", cv::VideoWriter::fourcc('M', 'P', '4', 'V'), (std::max)(10.0, cap.get(cv::CAP_PROP_FPS)), cv::Size(static_cast<int32_t>(cap.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int32_t>(cap.get(cv::CAP_PROP_FRAME_HEIGHT))));
 
+    /* Open performance counters before engines create worker threads, so that the workers are counted */
+    PerfCounter::Initialize();
+
     /* Initialize image processor library */
     ImageProcessor::InputParam input_param = { WORK_DIR, 4 };
     if (ImageProcessor::Initialize(input_param) != 0) {
@@ -69,18 +80,25 @@ int32_t main(int argc, char* argv[])
         /* Read image */
         const auto& time_cap0 = std::chrono::steady_clock::now();
         cv::Mat image;
-        if (cap.isOpened()) {
+        YuvImage yuv;
+        if (is_yuv) {
+            if (!yuv.Read(cap, yuv_format)) break;
+        } else if (cap.isOpened()) {
             cap.read(image);
         } else {
             image = cv::imread(input_name);
         }
-        if (image.empty()) break;
+        if (!is_yuv && image.empty()) break;
         const auto& time_cap1 = std::chrono::steady_clock::now();
 
         /* Call image processor library */
         const auto& time_image_process0 = std::chrono::steady_clock::now();
         ImageProcessor::Result result;
-        ImageProcessor::Process(image, result);
+        if (is_yuv) {
+            ImageProcessor::Process(yuv, image, result);
+        } else {
+            ImageProcessor::Process(image, result);
+        }
         const auto& time_image_process1 = std::chrono::steady_clock::now();
 
         /* Display result */
@@ -128,6 +146,7 @@ int32_t main(int argc, char* argv[])
         printf("    Pre processing:  %9.3lf [msec]\n", total_time_pre_process / frame_cnt);
         printf("    Inference:       %9.3lf [msec]\n", total_time_inference / frame_cnt);
         printf("    Post processing: %9.3lf [msec]\n", total_time_post_process / frame_cnt);
+        PerfCounter::Print();
     }
 
     /* Fianlize image processor library */
@@ -32,6 +32,9 @@ limitations under the License.
 #include "common_helper.h"
 #include "common_helper_cv.h"
 #include "inference_helper.h"
+#if defined(XNNPACK_WEIGHT_CACHE_ENABLED)
+#include "inference_helper_tensorflow_lite_xnnpack_cache.h"
+#endif
 #include "edge_engine.h"
 
 /*** Macro ***/
@@ -89,7 +92,11 @@ int32_t EdgeEngine::Initialize(const std::string& work_dir, const int32_t num_th
     /* Create and Initialize Inference Helper */
 #if defined(MODEL_TYPE_TFLITE)
     //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLite));
+#if defined(XNNPACK_WEIGHT_CACHE_ENABLED)
+    inference_helper_.reset(new InferenceHelperTensorflowLiteXnnpackCache());     /* keeps the packed weights in a file next to the model */
+#else
     inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteXnnpack));
+#endif
     //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteGpu));
     //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteEdgetpu));
     //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteNnapi));
@@ -124,23 +131,11 @@ int32_t EdgeEngine::Finalize()
 }
 
 
-int32_t EdgeEngine::Process(const cv::Mat& original_mat, Result& result)
+int32_t EdgeEngine::Inference(const cv::Mat& img_src, cv::Mat& mat_prob, Result& result)
 {
-    if (!inference_helper_) {
-        PRINT_E("Inference helper is not created\n");
-        return kRetErr;
-    }
     /*** PreProcess ***/
     const auto& t_pre_process0 = std::chrono::steady_clock::now();
     InputTensorInfo& input_tensor_info = input_tensor_info_list_[0];
-    /* do resize and color conversion here because some inference engine doesn't support these operations */
-    int32_t crop_x = 0;
-    int32_t crop_y = 0;
-    int32_t crop_w = original_mat.cols;
-    int32_t crop_h = original_mat.rows;
-    cv::Mat img_src = cv::Mat::zeros(input_tensor_info.GetHeight(), input_tensor_info.GetWidth(), CV_8UC3);
-    CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
-
     input_tensor_info.data = img_src.data;
     input_tensor_info.data_type = InputTensorInfo::kDataTypeImage;
     input_tensor_info.image_info.width = img_src.cols;
@@ -164,39 +159,77 @@ int32_t EdgeEngine::Process(const cv::Mat& original_mat, Result& result)
     }
     const auto& t_inference1 = std::chrono::steady_clock::now();
 
-    /*** PostProcess ***/
-    const auto& t_post_process0 = std::chrono::steady_clock::now();
-    /* Retrieve the result */
+    /* Retrieve the result. copy because the tensor is overwritten by the next tile */
+    /* https://github.com/xavysp/DexiNed/blob/5aead4b894ec060911ca4959531fd634f45ade73/DexiNed-TF2/run_model.py#L189 */
     const int32_t output_height = input_tensor_info.image_info.height;
     const int32_t output_width = input_tensor_info.image_info.width;
-    const size_t total_out_num = output_width * output_height;
-    float* values = output_tensor_info_list_[0].GetDataAsFloat();
-
-    /* https://github.com/xavysp/DexiNed/blob/5aead4b894ec060911ca4959531fd634f45ade73/DexiNed-TF2/run_model.py#L189 */
-    float min = 1.0f;
-    float max = 0.0f;
-    for (size_t i = 0; i < total_out_num; i++) {
-        values[i] = CommonHelper::Sigmoid(values[i]);
-        if (min > values[i]) min = values[i];
-        if (max < values[i]) max = values[i];
+    const float* values = output_tensor_info_list_[0].GetDataAsFloat();
+    mat_prob.create(output_height, output_width, CV_32FC1);
+    float* prob = mat_prob.ptr<float>(0);
+    for (int32_t i = 0; i < output_width * output_height; i++) {
+        prob[i] = CommonHelper::Sigmoid(values[i]);
     }
-    float range = max - min;
-    if (range <= 0) range = 0.000001f;
 
-    cv::Mat mat_out = cv::Mat(output_height, output_width, CV_8UC1, values);
-    for (size_t i = 0; i < total_out_num; i++) {
-        float val = (values[i] - min) * 255.0f / range;
-        mat_out.data[i] = static_cast<uint8_t>(val);
+    result.time_pre_process += static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
+    result.time_inference += static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
+    return kRetOk;
+}
+
+int32_t EdgeEngine::Process(const cv::Mat& original_mat, Result& result)
+{
+    if (!inference_helper_) {
+        PRINT_E("Inference helper is not created\n");
+        return kRetErr;
+    }
+    const auto& t_process0 = std::chrono::steady_clock::now();
+    result.time_pre_process = 0;
+    result.time_inference = 0;
+
+    /* Edge probability (0.0 - 1.0) in the model resolution, or in high resolution with tiles */
+    cv::Mat mat_prob;
+    const InputTensorInfo& input_tensor_info = input_tensor_info_list_[0];
+    if (max_tile_num_ > 0) {
+        /* Sigmoid output is absolute, so tiles are blended as they are and normalized together below */
+        tiler_.SetTileSize(input_tensor_info.GetWidth(), input_tensor_info.GetHeight());
+        DenseTiler::TileFunc func = [&](const cv::Mat& tile, cv::Mat& out) {
+            int32_t crop_x = 0;
+            int32_t crop_y = 0;
+            int32_t crop_w = tile.cols;
+            int32_t crop_h = tile.rows;
+            cv::Mat img_src = cv::Mat::zeros(tile.rows, tile.cols, CV_8UC3);
+            CommonHelper::CropResizeCvt(tile, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
+            return Inference(img_src, out, result);
+        };
+        if (tiler_.Process(original_mat, mat_prob, { func }) != DenseTiler::kRetOk) {
+            return kRetErr;
+        }
+    } else {
+        /* do resize and color conversion here because some inference engine doesn't support these operations */
+        int32_t crop_x = 0;
+        int32_t crop_y = 0;
+        int32_t crop_w = original_mat.cols;
+        int32_t crop_h = original_mat.rows;
+        cv::Mat img_src = cv::Mat::zeros(input_tensor_info.GetHeight(), input_tensor_info.GetWidth(), CV_8UC3);
+        CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
+        if (Inference(img_src, mat_prob, result) != kRetOk) {
+            return kRetErr;
+        }
     }
+
+    /*** PostProcess ***/
+    /* Normalize over the whole image (not each tile) */
+    double min, max;
+    cv::minMaxLoc(mat_prob, &min, &max);
+    double range = max - min;
+    if (range <= 0) range = 0.000001;
+    cv::Mat mat_out;
+    mat_prob.convertTo(mat_out, CV_8UC1, 255.0 / range, -255.0 * min / range);
     cv::bitwise_not(mat_out, mat_out);
-    const auto& t_post_process1 = std::chrono::steady_clock::now();
+    const auto& t_process1 = std::chrono::steady_clock::now();
 
     /* Return the results */
     result.mat_out = mat_out;
-    result.time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
-    result.time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
-    result.time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;;
+    result.time_post_process = static_cast<std::chrono::duration<double>>(t_process1 - t_process0).count() * 1000.0 - result.time_pre_process - result.time_inference;    /* including crop and blending of tiles */
 
     return kRetOk;
 }
-
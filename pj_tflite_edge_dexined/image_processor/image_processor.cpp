@@ -40,6 +40,9 @@ limitations under the License.
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
+/* > 0: output in high resolution with overlapping model-sized tiles (up to this number of tiles per frame). 0 = whole frame in one inference */
+static constexpr int32_t kMaxTileNum = 0;
+
 /*** Global variable ***/
 std::unique_ptr<EdgeEngine> s_engine;
 
@@ -62,7 +65,7 @@ int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param
         return -1;
     }
 
-    s_engine.reset(new EdgeEngine());
+    s_engine.reset(new EdgeEngine(kMaxTileNum));
     if (s_engine->Initialize(input_param.work_dir, input_param.num_threads) != EdgeEngine::kRetOk) {
         s_engine->Finalize();
         s_engine.reset();
@@ -38,6 +38,12 @@ public:
         kRetErr = -1,
     };
 
+    enum {
+        kModelFront = 0,    /* 128x128. for faces near the camera */
+        kModelBack,         /* 256x256. for small (far) faces */
+        kModelAuto,         /* select for each frame from the size of faces detected in the previous frame */
+    };
+
     typedef std::array<std::pair<int32_t, int32_t>, 6> KeyPoint;
 
     typedef struct Result_ {
@@ -50,32 +56,58 @@ public:
             int32_t h;
             crop_() : x(0), y(0), w(0), h(0) {}
         } crop;
+        crop_                    crop_roi;      /* area of the second pass (two scale mode). w = 0 if not used */
+        int32_t                  model;         /* model used for this frame (kModelFront or kModelBack) */
         double                   time_pre_process;      // [msec]
         double                   time_inference;        // [msec]
         double                   time_post_process;     // [msec]
-        Result_() : time_pre_process(0), time_inference(0), time_post_process(0)
+        Result_() : model(kModelFront), time_pre_process(0), time_inference(0), time_post_process(0)
         {}
     } Result;
 
 public:
-    FaceDetectionEngine(float threshold_confidence = 0.4f, float threshold_nms_iou = 0.5f) {
+    FaceDetectionEngine(float threshold_confidence = 0.4f, float threshold_nms_iou = 0.5f, int32_t model_select = kModelAuto, bool use_two_scale = false) {
         threshold_confidence_ = threshold_confidence;
         threshold_nms_iou_ = threshold_nms_iou;
+        model_select_ = model_select;
+        use_two_scale_ = use_two_scale;
+        model_current_ = kModelFront;
+        cnt_frame_no_face_ = 0;
     }
     ~FaceDetectionEngine() {}
     int32_t Initialize(const std::string& work_dir, const int32_t num_threads);
     int32_t Finalize(void);
     int32_t Process(const cv::Mat& original_mat, Result& result);
 
+    void SetModelSelect(int32_t model_select);
+    void SetTwoScale(bool use_two_scale);
+
     void  CreateAnchor(int32_t width, int32_t height, std::vector<std::pair<float, float>>& anchor_list);
     void  GetBoundingBox(const std::vector<float>& score_list, const std::vector<float>& regressor_list, const std::vector<std::pair<float, float>>& anchor_list, float threshold_score_logit, float scale_x, float scale_y, std::vector<BoundingBox>& bbox_list);
 
 private:
-    std::unique_ptr<InferenceHelper> inference_helper_;
-    std::vector<InputTensorInfo> input_tensor_info_list_;
-    std::vector<OutputTensorInfo> output_tensor_info_list_;
+    typedef struct Interpreter_ {
+        std::unique_ptr<InferenceHelper> inference_helper;
+        std::vector<InputTensorInfo> input_tensor_info_list;
+        std::vector<OutputTensorInfo> output_tensor_info_list;
+        std::vector<std::pair<float, float>> anchor_list;
+    } Interpreter;
+
+private:
+    int32_t InitializeInterpreter(Interpreter& interpreter, const std::string& model_filename, int32_t size, const std::vector<std::string>& output_name_list, const int32_t num_threads);
+    int32_t SelectModel(const cv::Mat& original_mat);
+    cv::Rect SelectRoi(const cv::Mat& original_mat);
+    int32_t ProcessInterpreter(Interpreter& interpreter, const cv::Mat& original_mat, int32_t& crop_x, int32_t& crop_y, int32_t& crop_w, int32_t& crop_h,
+        std::vector<BoundingBox>& bbox_list, std::vector<KeyPoint>& keypoint_list, double& time_pre_process, double& time_inference, double& time_post_process);
+
+private:
+    std::array<Interpreter, 2> interpreter_list_;   /* [kModelFront, kModelBack]. the back model is optional */
 
-    std::vector<std::pair<float, float>> anchor_list_;
+    int32_t model_select_;
+    bool    use_two_scale_;
+    int32_t model_current_;
+    int32_t cnt_frame_no_face_;
+    std::vector<BoundingBox> bbox_list_previous_;   /* faces detected in the previous frame */
 
     float threshold_confidence_;
     float threshold_nms_iou_;
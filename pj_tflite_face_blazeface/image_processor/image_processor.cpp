@@ -131,6 +131,9 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
 
     /* Display target area  */
     cv::rectangle(mat, cv::Rect(det_result.crop.x, det_result.crop.y, det_result.crop.w, det_result.crop.h), CommonHelper::CreateCvColor(0, 0, 0), 2);
+    if (det_result.crop_roi.w > 0) {
+        cv::rectangle(mat, cv::Rect(det_result.crop_roi.x, det_result.crop_roi.y, det_result.crop_roi.w, det_result.crop_roi.h), CommonHelper::CreateCvColor(120, 120, 120), 1);
+    }
 
     /* Display detection result and keypoint */
     for (const auto& bbox : det_result.bbox_list) {
@@ -145,6 +148,7 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
 
     /* Display tracking result  */
     CommonHelper::DrawText(mat, "DET: " + std::to_string(det_result.bbox_list.size()), cv::Point(0, 20), 0.7, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(220, 220, 220));
+    CommonHelper::DrawText(mat, det_result.model == FaceDetectionEngine::kModelBack ? "MODEL: back (256)" : "MODEL: front (128)", cv::Point(0, 45), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(220, 220, 220));
     
     
     /* Return the results */
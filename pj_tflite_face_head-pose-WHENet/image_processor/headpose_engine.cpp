@@ -185,11 +185,6 @@ int32_t HeadposeEngine::Process(const cv::Mat& original_mat, const std::vector<B
 
 
         /*** TODO: don't get nice raw output ***/
-        for (int32_t i = 0; i < roll_score_list.size(); i++) {
-            printf("%3d: %f\n", i, roll_score_list[i]);
-        }
-
-
         Softmax(yaw_score_list);
         Softmax(pitch_score_list);
         Softmax(roll_score_list);
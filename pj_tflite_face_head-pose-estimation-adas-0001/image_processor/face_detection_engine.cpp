@@ -24,6 +24,7 @@ limitations under the License.
 #include <algorithm>
 #include <chrono>
 #include <fstream>
+#include <limits>
 
 /* for OpenCV */
 #include <opencv2/opencv.hpp>
@@ -40,56 +41,50 @@ limitations under the License.
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
 /* Model parameters */
-#define MODEL_TYPE_128x128_CONCAT
-//#define MODEL_TYPE_128x128
-//#define MODEL_TYPE_256x256
-
-#if defined(MODEL_TYPE_128x128_CONCAT)
-#define MODEL_NAME  "face_detection_front.tflite"
-#define TENSORTYPE  TensorInfo::kTensorTypeFp32
-#define INPUT_NAME  "input"
-#define INPUT_DIMS  { 1, 128, 128, 3 }
-#define IS_NCHW     false
-#define IS_RGB      true
-#define OUTPUT_NAME_0 "classificators"
-#define OUTPUT_NAME_1 "regressors"
-#elif defined(MODEL_TYPE_128x128)
-#define MODEL_NAME  "face_detection_front_128x128_float32.tflite"
-#define TENSORTYPE  TensorInfo::kTensorTypeFp32
-#define INPUT_NAME  "input"
-#define INPUT_DIMS  { 1, 128, 128, 3 }
-#define IS_NCHW     false
-#define IS_RGB      true
-#define OUTPUT_NAME_0 "Identity"
-#define OUTPUT_NAME_1 "Identity_2"
-#define OUTPUT_NAME_2 "Identity_1"
-#define OUTPUT_NAME_3 "Identity_3"
-#elif defined(MODEL_TYPE_256x256)
-#define MODEL_NAME  "face_detection_back_256x256_float32.tflite"
+/* Both models are loaded, and the model is selected for each frame */
+#define MODEL_NAME_FRONT    "face_detection_front.tflite"
+#define INPUT_SIZE_FRONT    128
+#define OUTPUT_NAME_FRONT   { "classificators", "regressors" }
+#define MODEL_NAME_BACK     "face_detection_back_256x256_float32.tflite"
+#define INPUT_SIZE_BACK     256
+#define OUTPUT_NAME_BACK    { "Identity", "Identity_2", "Identity_1", "Identity_3" }
 #define TENSORTYPE  TensorInfo::kTensorTypeFp32
 #define INPUT_NAME  "input"
-#define INPUT_DIMS  { 1, 256, 256, 3 }
 #define IS_NCHW     false
 #define IS_RGB      true
-#define OUTPUT_NAME_0 "Identity"
-#define OUTPUT_NAME_1 "Identity_2"
-#define OUTPUT_NAME_2 "Identity_1"
-#define OUTPUT_NAME_3 "Identity_3"
-#endif
 static constexpr int32_t kElementNumOfAnchor = 16;    /* x, y, w, h, [x, y] */
 std::array<std::pair<int32_t, int32_t>, 2> kAnchorGridSize = { std::pair<int32_t, int32_t>(16, 16), std::pair < int32_t, int32_t>(8, 8) };
 std::array<int32_t, 2> kAnchorNum = { 2, 6 };
 
+/* Model selection */
+static constexpr float   kMinFaceSizeFront = 20.0f;         /* [px in the front model input] use the back model for faces smaller than this */
+static constexpr float   kMinFaceSizeFrontToReturn = 28.0f; /* [px in the front model input] go back to the front model (hysteresis) */
+static constexpr int32_t kIntervalSearchBack = 10;          /* [frame] run the back model once in this interval to find far faces while no face is detected */
+static constexpr float   kRoiScale = 2.0f;                  /* ROI of the second pass = area of the detected faces * this */
+
 /*** Function ***/
 int32_t FaceDetectionEngine::Initialize(const std::string& work_dir, const int32_t num_threads)
 {
-    /* Set model information */
-    std::string model_filename = work_dir + "/model/" + MODEL_NAME;
+    if (InitializeInterpreter(interpreter_list_[kModelFront], work_dir + "/model/" + MODEL_NAME_FRONT, INPUT_SIZE_FRONT, OUTPUT_NAME_FRONT, num_threads) != kRetOk) {
+        return kRetErr;
+    }
+    if (InitializeInterpreter(interpreter_list_[kModelBack], work_dir + "/model/" + MODEL_NAME_BACK, INPUT_SIZE_BACK, OUTPUT_NAME_BACK, num_threads) != kRetOk) {
+        PRINT("Back model is not available. Use the front model only\n");
+    }
+
+    model_current_ = kModelFront;
+    cnt_frame_no_face_ = 0;
+    bbox_list_previous_.clear();
 
+    return kRetOk;
+}
+
+int32_t FaceDetectionEngine::InitializeInterpreter(Interpreter& interpreter, const std::string& model_filename, int32_t size, const std::vector<std::string>& output_name_list, const int32_t num_threads)
+{
     /* Set input tensor info */
-    input_tensor_info_list_.clear();
+    interpreter.input_tensor_info_list.clear();
     InputTensorInfo input_tensor_info(INPUT_NAME, TENSORTYPE, IS_NCHW);
-    input_tensor_info.tensor_dims = INPUT_DIMS;
+    input_tensor_info.tensor_dims = { 1, size, size, 3 };
     input_tensor_info.data_type = InputTensorInfo::kDataTypeImage;
     input_tensor_info.normalize.mean[0] = 0.5f;     /* -1.0 - 1.0*/
     input_tensor_info.normalize.mean[1] = 0.5f;
@@ -97,69 +92,198 @@ int32_t FaceDetectionEngine::Initialize(const std::string& work_dir, const int32
     input_tensor_info.normalize.norm[0] = 0.5f;
     input_tensor_info.normalize.norm[1] = 0.5f;
     input_tensor_info.normalize.norm[2] = 0.5f;
-    input_tensor_info_list_.push_back(input_tensor_info);
+    interpreter.input_tensor_info_list.push_back(input_tensor_info);
 
     /* Set output tensor info */
-    output_tensor_info_list_.clear();
-    output_tensor_info_list_.push_back(OutputTensorInfo(OUTPUT_NAME_0, TENSORTYPE));
-    output_tensor_info_list_.push_back(OutputTensorInfo(OUTPUT_NAME_1, TENSORTYPE));
-#if defined(MODEL_TYPE_128x128) || defined(MODEL_TYPE_256x256)
-    output_tensor_info_list_.push_back(OutputTensorInfo(OUTPUT_NAME_2, TENSORTYPE));
-    output_tensor_info_list_.push_back(OutputTensorInfo(OUTPUT_NAME_3, TENSORTYPE));
-#endif
+    /* 2 outputs (score, regressor) or 4 outputs (score 16x16, regressor 16x16, score 8x8, regressor 8x8) */
+    interpreter.output_tensor_info_list.clear();
+    for (const auto& output_name : output_name_list) {
+        interpreter.output_tensor_info_list.push_back(OutputTensorInfo(output_name, TENSORTYPE));
+    }
 
     /* Create and Initialize Inference Helper */
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLite));
-    inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteXnnpack));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteGpu));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteEdgetpu));
-    // inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteNnapi));
-    
-
-    if (!inference_helper_) {
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLite));
+    interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteXnnpack));
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteGpu));
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteEdgetpu));
+    // interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteNnapi));
+
+    if (!interpreter.inference_helper) {
         return kRetErr;
     }
-    if (inference_helper_->SetNumThreads(num_threads) != InferenceHelper::kRetOk) {
-        inference_helper_.reset();
+    if (interpreter.inference_helper->SetNumThreads(num_threads) != InferenceHelper::kRetOk) {
+        interpreter.inference_helper.reset();
         return kRetErr;
     }
-    if (inference_helper_->Initialize(model_filename, input_tensor_info_list_, output_tensor_info_list_) != InferenceHelper::kRetOk) {
-        inference_helper_.reset();
+    if (interpreter.inference_helper->Initialize(model_filename, interpreter.input_tensor_info_list, interpreter.output_tensor_info_list) != InferenceHelper::kRetOk) {
+        interpreter.inference_helper.reset();
         return kRetErr;
     }
 
-    anchor_list_.clear();
-    CreateAnchor(input_tensor_info_list_[0].GetWidth(), input_tensor_info_list_[0].GetHeight(), anchor_list_);
+    interpreter.anchor_list.clear();
+    CreateAnchor(interpreter.input_tensor_info_list[0].GetWidth(), interpreter.input_tensor_info_list[0].GetHeight(), interpreter.anchor_list);
 
     return kRetOk;
 }
 
 int32_t FaceDetectionEngine::Finalize()
 {
-    if (!inference_helper_) {
+    if (!interpreter_list_[kModelFront].inference_helper) {
         PRINT_E("Inference helper is not created\n");
         return kRetErr;
     }
-    inference_helper_->Finalize();
+    for (auto& interpreter : interpreter_list_) {
+        if (interpreter.inference_helper) {
+            interpreter.inference_helper->Finalize();
+            interpreter.inference_helper.reset();
+        }
+    }
     return kRetOk;
 }
 
+void FaceDetectionEngine::SetModelSelect(int32_t model_select)
+{
+    model_select_ = model_select;
+}
+
+void FaceDetectionEngine::SetTwoScale(bool use_two_scale)
+{
+    use_two_scale_ = use_two_scale;
+}
+
+int32_t FaceDetectionEngine::SelectModel(const cv::Mat& original_mat)
+{
+    if (!interpreter_list_[kModelBack].inference_helper) return kModelFront;
+    if (model_select_ != kModelAuto) return model_select_;
+
+    if (bbox_list_previous_.empty()) {
+        /* Nothing near the camera. Look for far faces sometimes */
+        cnt_frame_no_face_++;
+        return (cnt_frame_no_face_ % kIntervalSearchBack == 0) ? kModelBack : kModelFront;
+    }
+    cnt_frame_no_face_ = 0;
+
+    /* The smallest face in the front model input (the whole frame is fit into the input) */
+    int32_t min_face_size = (std::numeric_limits<int32_t>::max)();
+    for (const auto& bbox : bbox_list_previous_) {
+        min_face_size = (std::min)(min_face_size, (std::max)(bbox.w, bbox.h));
+    }
+    const float min_face_size_in_front = static_cast<float>(min_face_size) * INPUT_SIZE_FRONT / (std::max)(original_mat.cols, original_mat.rows);
+
+    if (model_current_ == kModelFront && min_face_size_in_front < kMinFaceSizeFront) {
+        model_current_ = kModelBack;
+    } else if (model_current_ == kModelBack && min_face_size_in_front >= kMinFaceSizeFrontToReturn) {
+        model_current_ = kModelFront;
+    }
+    return model_current_;
+}
+
+cv::Rect FaceDetectionEngine::SelectRoi(const cv::Mat& original_mat)
+{
+    cv::Rect roi;
+    if (bbox_list_previous_.empty()) {
+        /* Center of the frame */
+        roi = cv::Rect(original_mat.cols / 4, original_mat.rows / 4, original_mat.cols / 2, original_mat.rows / 2);
+    } else {
+        /* Around the detected faces */
+        int32_t x0 = original_mat.cols, y0 = original_mat.rows, x1 = 0, y1 = 0;
+        for (const auto& bbox : bbox_list_previous_) {
+            x0 = (std::min)(x0, bbox.x);
+            y0 = (std::min)(y0, bbox.y);
+            x1 = (std::max)(x1, bbox.x + bbox.w);
+            y1 = (std::max)(y1, bbox.y + bbox.h);
+        }
+        const int32_t w = static_cast<int32_t>((x1 - x0) * kRoiScale);
+        const int32_t h = static_cast<int32_t>((y1 - y0) * kRoiScale);
+        roi = cv::Rect((x0 + x1) / 2 - w / 2, (y0 + y1) / 2 - h / 2, w, h);
+    }
+    roi &= cv::Rect(0, 0, original_mat.cols, original_mat.rows);
+
+    /* Meaningless if it's not smaller than the whole frame */
+    if (roi.width * 4 > original_mat.cols * 3 || roi.height * 4 > original_mat.rows * 3) return cv::Rect();
+    return roi;
+}
 
 int32_t FaceDetectionEngine::Process(const cv::Mat& original_mat, Result& result)
 {
-    if (!inference_helper_) {
+    if (!interpreter_list_[kModelFront].inference_helper) {
         PRINT_E("Inference helper is not created\n");
         return kRetErr;
     }
 
-    /*** PreProcess ***/
-    const auto& t_pre_process0 = std::chrono::steady_clock::now();
-    InputTensorInfo& input_tensor_info = input_tensor_info_list_[0];
-    /* do crop, resize and color conversion here because some inference engine doesn't support these operations */
+    /* Run the selected model on the whole frame, and optionally the front model on ROI */
+    const int32_t model = SelectModel(original_mat);
+    std::vector<BoundingBox> bbox_list;
+    std::vector<KeyPoint> keypoint_candidate_list;
     int32_t crop_x = 0;
     int32_t crop_y = 0;
     int32_t crop_w = original_mat.cols;
     int32_t crop_h = original_mat.rows;
+    if (ProcessInterpreter(interpreter_list_[model], original_mat, crop_x, crop_y, crop_w, crop_h, bbox_list, keypoint_candidate_list,
+        result.time_pre_process, result.time_inference, result.time_post_process) != kRetOk) {
+        return kRetErr;
+    }
+
+    cv::Rect roi;
+    if (use_two_scale_ && model == kModelFront) {
+        roi = SelectRoi(original_mat);
+        if (roi.area() > 0) {
+            int32_t roi_x = roi.x;
+            int32_t roi_y = roi.y;
+            int32_t roi_w = roi.width;
+            int32_t roi_h = roi.height;
+            if (ProcessInterpreter(interpreter_list_[kModelFront], original_mat, roi_x, roi_y, roi_w, roi_h, bbox_list, keypoint_candidate_list,
+                result.time_pre_process, result.time_inference, result.time_post_process) != kRetOk) {
+                return kRetErr;
+            }
+        }
+    }
+
+    /*** PostProcess ***/
+    const auto& t_post_process0 = std::chrono::steady_clock::now();
+    /* NMS (across the passes) */
+    std::vector<BoundingBox> bbox_nms_list;
+    BoundingBoxUtils::Nms(bbox_list, bbox_nms_list, threshold_nms_iou_, false);
+
+    std::vector<KeyPoint> keypoint_list;
+    for (auto& bbox : bbox_nms_list) {
+        /* Adjust bounding box */
+        int32_t candidate_index = bbox.class_id;
+        bbox.class_id = 0;
+        bbox.label = "FACE";
+        bbox.score = CommonHelper::Sigmoid(bbox.score);
+        BoundingBoxUtils::FixInScreen(bbox, original_mat.cols, original_mat.rows);
+        keypoint_list.push_back(keypoint_candidate_list[candidate_index]);
+    }
+    bbox_list_previous_ = bbox_nms_list;
+    const auto& t_post_process1 = std::chrono::steady_clock::now();
+
+    /* Return the results */
+    result.bbox_list = bbox_nms_list;
+    result.keypoint_list = keypoint_list;
+    result.crop.x = (std::max)(0, crop_x);
+    result.crop.y = (std::max)(0, crop_y);
+    result.crop.w = (std::min)(crop_w, original_mat.cols - result.crop.x);
+    result.crop.h = (std::min)(crop_h, original_mat.rows - result.crop.y);
+    result.crop_roi.x = roi.x;
+    result.crop_roi.y = roi.y;
+    result.crop_roi.w = roi.width;
+    result.crop_roi.h = roi.height;
+    result.model = model;
+    result.time_post_process += static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;
+
+    return kRetOk;
+}
+
+/* Run one model on the crop area, and add bounding boxes in the original image coordinate before NMS */
+/*   score is still logit, and class_id is the index of keypoint_list */
+int32_t FaceDetectionEngine::ProcessInterpreter(Interpreter& interpreter, const cv::Mat& original_mat, int32_t& crop_x, int32_t& crop_y, int32_t& crop_w, int32_t& crop_h,
+    std::vector<BoundingBox>& bbox_list, std::vector<KeyPoint>& keypoint_list, double& time_pre_process, double& time_inference, double& time_post_process)
+{
+    /*** PreProcess ***/
+    const auto& t_pre_process0 = std::chrono::steady_clock::now();
+    InputTensorInfo& input_tensor_info = interpreter.input_tensor_info_list[0];
+    /* do crop, resize and color conversion here because some inference engine doesn't support these operations */
     cv::Mat img_src = cv::Mat::zeros(input_tensor_info.GetHeight(), input_tensor_info.GetWidth(), CV_8UC3);
     //CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
     //CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeCut);
@@ -176,67 +300,47 @@ int32_t FaceDetectionEngine::Process(const cv::Mat& original_mat, Result& result
     input_tensor_info.image_info.crop_height = img_src.rows;
     input_tensor_info.image_info.is_bgr = false;
     input_tensor_info.image_info.swap_color = false;
-    if (inference_helper_->PreProcess(input_tensor_info_list_) != InferenceHelper::kRetOk) {
+    if (interpreter.inference_helper->PreProcess(interpreter.input_tensor_info_list) != InferenceHelper::kRetOk) {
         return kRetErr;
     }
     const auto& t_pre_process1 = std::chrono::steady_clock::now();
 
     /*** Inference ***/
     const auto& t_inference0 = std::chrono::steady_clock::now();
-    if (inference_helper_->Process(output_tensor_info_list_) != InferenceHelper::kRetOk) {
+    if (interpreter.inference_helper->Process(interpreter.output_tensor_info_list) != InferenceHelper::kRetOk) {
         return kRetErr;
     }
     const auto& t_inference1 = std::chrono::steady_clock::now();
 
     /*** PostProcess ***/
     const auto& t_post_process0 = std::chrono::steady_clock::now();
-    /* Get output data */
-#if defined(MODEL_TYPE_128x128_CONCAT)
+    /* Get output data (score and regressor are in pairs: [score, regressor, score, regressor, ...]) */
+    auto& output_tensor_info_list = interpreter.output_tensor_info_list;
     std::vector<float> score_list;
-    score_list.reserve(output_tensor_info_list_[0].GetElementNum());
-    score_list.insert(score_list.end(), output_tensor_info_list_[0].GetDataAsFloat(), output_tensor_info_list_[0].GetDataAsFloat() + output_tensor_info_list_[0].GetElementNum());
-
-    std::vector<float> regressor_list;
-    regressor_list.reserve(output_tensor_info_list_[1].GetElementNum());
-    regressor_list.insert(regressor_list.end(), output_tensor_info_list_[1].GetDataAsFloat(), output_tensor_info_list_[1].GetDataAsFloat() + output_tensor_info_list_[1].GetElementNum());
-#elif defined(MODEL_TYPE_128x128) || defined(MODEL_TYPE_256x256)
-    std::vector<float> score_list;
-    score_list.reserve(output_tensor_info_list_[0].GetElementNum() + output_tensor_info_list_[2].GetElementNum());
-    score_list.insert(score_list.end(), output_tensor_info_list_[0].GetDataAsFloat(), output_tensor_info_list_[0].GetDataAsFloat() + output_tensor_info_list_[0].GetElementNum());
-    score_list.insert(score_list.end(), output_tensor_info_list_[2].GetDataAsFloat(), output_tensor_info_list_[2].GetDataAsFloat() + output_tensor_info_list_[2].GetElementNum());
-
     std::vector<float> regressor_list;
-    regressor_list.reserve(output_tensor_info_list_[1].GetElementNum() + output_tensor_info_list_[3].GetElementNum());
-    regressor_list.insert(regressor_list.end(), output_tensor_info_list_[1].GetDataAsFloat(), output_tensor_info_list_[1].GetDataAsFloat() + output_tensor_info_list_[1].GetElementNum());
-    regressor_list.insert(regressor_list.end(), output_tensor_info_list_[3].GetDataAsFloat(), output_tensor_info_list_[3].GetDataAsFloat() + output_tensor_info_list_[3].GetElementNum());
-#endif
+    for (size_t i = 0; i + 1 < output_tensor_info_list.size(); i += 2) {
+        score_list.insert(score_list.end(), output_tensor_info_list[i].GetDataAsFloat(), output_tensor_info_list[i].GetDataAsFloat() + output_tensor_info_list[i].GetElementNum());
+        regressor_list.insert(regressor_list.end(), output_tensor_info_list[i + 1].GetDataAsFloat(), output_tensor_info_list[i + 1].GetDataAsFloat() + output_tensor_info_list[i + 1].GetElementNum());
+    }
 
     /* Get boundig box */
-    std::vector<BoundingBox> bbox_list;
+    std::vector<BoundingBox> bbox_candidate_list;
     float score_logit = CommonHelper::Logit(threshold_confidence_);
-    GetBoundingBox(score_list, regressor_list, anchor_list_, score_logit, static_cast<float>(crop_w) / input_tensor_info.GetWidth(), static_cast<float>(crop_h) / input_tensor_info.GetHeight(), bbox_list);
-
-    /* NMS */
-    std::vector<BoundingBox> bbox_nms_list;
-    BoundingBoxUtils::Nms(bbox_list, bbox_nms_list, threshold_nms_iou_, false);
+    GetBoundingBox(score_list, regressor_list, interpreter.anchor_list, score_logit, static_cast<float>(crop_w) / input_tensor_info.GetWidth(), static_cast<float>(crop_h) / input_tensor_info.GetHeight(), bbox_candidate_list);
 
-    std::vector<KeyPoint> keypoint_list;
-    for (auto& bbox : bbox_nms_list) {
-        /* Adjust bounding box */
+    for (auto& bbox : bbox_candidate_list) {
         int32_t anchor_index = bbox.class_id;
-        bbox.class_id = 0;
-        bbox.label = "FACE";
-        bbox.score = CommonHelper::Sigmoid(bbox.score);
+        bbox.class_id = static_cast<int32_t>(keypoint_list.size());
         bbox.x += crop_x;
         bbox.y += crop_y;
-        BoundingBoxUtils::FixInScreen(bbox, original_mat.cols, original_mat.rows);
+        bbox_list.push_back(bbox);
 
         /* Get keypoint */
         const float* regressor = &regressor_list[anchor_index * kElementNumOfAnchor];
         KeyPoint keypoint;
         for (int32_t key = 0; key < 6; key++) {
-            float x = regressor[4 + 2 * key + 0] + anchor_list_[anchor_index].first;
-            float y = regressor[4 + 2 * key + 1] + anchor_list_[anchor_index].second;
+            float x = regressor[4 + 2 * key + 0] + interpreter.anchor_list[anchor_index].first;
+            float y = regressor[4 + 2 * key + 1] + interpreter.anchor_list[anchor_index].second;
             keypoint[key].first = static_cast<int32_t>((x * crop_w) / input_tensor_info.GetWidth() + crop_x);  // resize to the original image size
             keypoint[key].second = static_cast<int32_t>((y * crop_h) / input_tensor_info.GetHeight() + crop_y);
         }
@@ -244,16 +348,9 @@ int32_t FaceDetectionEngine::Process(const cv::Mat& original_mat, Result& result
     }
     const auto& t_post_process1 = std::chrono::steady_clock::now();
 
-    /* Return the results */
-    result.bbox_list = bbox_nms_list;
-    result.keypoint_list = keypoint_list;
-    result.crop.x = (std::max)(0, crop_x);
-    result.crop.y = (std::max)(0, crop_y);
-    result.crop.w = (std::min)(crop_w, original_mat.cols - result.crop.x);
-    result.crop.h = (std::min)(crop_h, original_mat.rows - result.crop.y);
-    result.time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
-    result.time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
-    result.time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;;
+    time_pre_process += static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
+    time_inference += static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
+    time_post_process += static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;
 
     return kRetOk;
 }
@@ -35,6 +35,7 @@ limitations under the License.
 #include "bounding_box.h"
 #include "face_detection_engine.h"
 #include "headpose_engine.h"
+#include "head_pose_estimator.h"
 #include "image_processor.h"
 
 /*** Macro ***/
@@ -42,9 +43,19 @@ limitations under the License.
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
+/* Head pose estimation */
+/*   kHeadposeModeNetwork: head pose network for every face */
+/*   kHeadposeModeGeometric: fit the face detection keypoints to a 3D face model (no inference. the network is used only when the fit fails) */
+/*   kHeadposeModeHybrid: geometric, and the network only for the faces where the keypoints don't fit well (e.g. profile faces) */
+enum { kHeadposeModeNetwork = 0, kHeadposeModeGeometric, kHeadposeModeHybrid };
+static constexpr int32_t kHeadposeMode = kHeadposeModeHybrid;
+static constexpr float kGeometricErrorMax = 0.05f;      /* reprojection error / face size */
+static constexpr float kGeometricYawMax = 50.0f;        /* [deg]. ears are occluded beyond this */
+
 /*** Global variable ***/
 std::unique_ptr<FaceDetectionEngine> s_facedet_engine;
 std::unique_ptr<HeadposeEngine> s_headpose_engine;
+std::unique_ptr<HeadPoseEstimator> s_headpose_estimator;
 cv::Mat s_camera_matrix;
 
 /*** Function ***/
@@ -80,6 +91,8 @@ int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param
         return -1;
     }
 
+    s_headpose_estimator.reset(new HeadPoseEstimator(HeadPoseEstimator::kKeypointBlazeFace));
+
     s_camera_matrix.release();
 
     return 0;
@@ -227,6 +240,31 @@ static float CalcFocalLength(int32_t pixel_size, float fov)
     return (pixel_size / 2) / tanf(fov / 2);
 }
 
+/* Returns false when the network should estimate the pose of the face */
+static bool EstimateHeadposeGeometric(const cv::Size& image_size, const FaceDetectionEngine::KeyPoint& keypoint, HeadposeEngine::Result& result)
+{
+    const auto& t0 = std::chrono::steady_clock::now();
+    std::vector<cv::Point2f> keypoint_list;
+    for (const auto& p : keypoint) {
+        keypoint_list.push_back(cv::Point2f(static_cast<float>(p.first), static_cast<float>(p.second)));
+    }
+    HeadPoseEstimator::Result estimator_result;
+    if (s_headpose_estimator->Estimate(image_size, keypoint_list, estimator_result) != HeadPoseEstimator::kRetOk) {
+        return false;
+    }
+    if (kHeadposeMode == kHeadposeModeHybrid && (estimator_result.error > kGeometricErrorMax || std::abs(estimator_result.yaw) > kGeometricYawMax)) {
+        return false;
+    }
+    result.yaw = estimator_result.yaw;
+    result.pitch = estimator_result.pitch;
+    result.roll = estimator_result.roll;
+    const auto& t1 = std::chrono::steady_clock::now();
+    result.time_pre_process = 0;
+    result.time_inference = 0;
+    result.time_post_process = static_cast<std::chrono::duration<double>>(t1 - t0).count() * 1000.0;
+    return true;
+}
+
 int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
 {
     if (!s_facedet_engine || !s_headpose_engine) {
@@ -263,9 +301,23 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
     std::vector<BoundingBox> bbox_list = det_result.bbox_list;
 
     /* Estimate head pose */
-    std::vector<HeadposeEngine::Result> headpose_result_list;
-    if (s_headpose_engine->Process(mat, bbox_list, headpose_result_list) != HeadposeEngine::kRetOk) {
-        return -1;
+    std::vector<HeadposeEngine::Result> headpose_result_list(bbox_list.size());
+    std::vector<BoundingBox> bbox_network_list;
+    std::vector<size_t> index_network_list;
+    for (size_t i = 0; i < bbox_list.size(); i++) {
+        if (kHeadposeMode == kHeadposeModeNetwork || !EstimateHeadposeGeometric(mat.size(), det_result.keypoint_list[i], headpose_result_list[i])) {
+            bbox_network_list.push_back(bbox_list[i]);
+            index_network_list.push_back(i);
+        }
+    }
+    if (!bbox_network_list.empty()) {
+        std::vector<HeadposeEngine::Result> network_result_list;
+        if (s_headpose_engine->Process(mat, bbox_network_list, network_result_list) != HeadposeEngine::kRetOk) {
+            return -1;
+        }
+        for (size_t i = 0; i < (std::min)(index_network_list.size(), network_result_list.size()); i++) {
+            headpose_result_list[index_network_list[i]] = network_result_list[i];
+        }
     }
 
     /* Display head poses */
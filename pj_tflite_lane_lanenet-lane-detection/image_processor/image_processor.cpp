@@ -131,9 +131,9 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
 
     /* Draw line */
     //cv::Mat image_mask;
-    //cv::cvtColor(lane_result.image_binary_seg, image_mask, cv::COLOR_GRAY2BGR);
-    //cv::add(mat, image_mask, mat);
-    cv::add(mat, lane_result.image_instance_seg, mat);
+    //cv::cvtColor(lane_result.binary_seg.GetMap(), image_mask, cv::COLOR_GRAY2BGR);
+    //SegmentationMap(image_mask, lane_result.binary_seg.GetCrop()).AddTo(mat);
+    lane_result.instance_seg.AddTo(mat);
 
 
     /* Display det num  */
@@ -36,6 +36,7 @@ limitations under the License.
 #include "common_helper.h"
 #include "common_helper_cv.h"
 #include "inference_helper.h"
+#include "perf_counter.h"
 #include "lane_engine.h"
 
 /*** Macro ***/
@@ -43,6 +44,9 @@ limitations under the License.
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
+/* Stages measured with hardware performance counters */
+static const int32_t s_perf_stage_dbscan = PerfCounter::RegisterStage("lanenet_dbscan");
+
 /* Model parameters */
 #define USE_TFLITE
 #ifdef USE_TFLITE
@@ -220,23 +224,13 @@ int32_t LaneEngine::Process(const cv::Mat& original_mat, Result& result)
     visualize_instance_segmentation_result(cluster_ret, coords, instance_seg_result);
 
 
-    cv::resize(image_binary, image_binary, cv::Size(crop_w, crop_h));
-    result.image_binary_seg = cv::Mat(original_mat.size(), CV_8UC1);
-    cv::Rect crop = cv::Rect(crop_x < 0 ? 0 : crop_x, crop_y < 0 ? 0 : crop_y, crop_x < 0 ? original_mat.cols : crop_w, crop_h < 0 ? original_mat.rows : crop_h);
-    cv::Mat target = result.image_binary_seg(crop);
-    image_binary(cv::Rect(crop_x < 0 ? -crop_x : 0, crop_y < 0 ? -crop_y : 0, crop_x < 0 ? original_mat.cols : crop_w, crop_h < 0 ? original_mat.rows : crop_h)).copyTo(target);
-
-    cv::resize(instance_seg_result, instance_seg_result, cv::Size(crop_w, crop_h));
-    result.image_instance_seg = cv::Mat(original_mat.size(), CV_8UC3);
-    crop = cv::Rect(crop_x < 0 ? 0 : crop_x, crop_y < 0 ? 0 : crop_y, crop_x < 0 ? original_mat.cols : crop_w, crop_h < 0 ? original_mat.rows : crop_h);
-    target = result.image_instance_seg(crop);
-    instance_seg_result(cv::Rect(crop_x < 0 ? -crop_x : 0, crop_y < 0 ? -crop_y : 0, crop_x < 0 ? original_mat.cols : crop_w, crop_h < 0 ? original_mat.rows : crop_h)).copyTo(target);
-
-
     const auto& t_post_process1 = std::chrono::steady_clock::now();
 
 
     /* Return the results */
+    /* the results are kept in model resolution. they are resized onto the frame only when drawn */
+    result.binary_seg.Set(image_binary, cv::Rect(crop_x, crop_y, crop_w, crop_h));
+    result.instance_seg.Set(instance_seg_result, cv::Rect(crop_x, crop_y, crop_w, crop_h));
     result.crop.x = (std::max)(0, crop_x);
     result.crop.y = (std::max)(0, crop_y);
     result.crop.w = (std::min)(crop_w, original_mat.cols - result.crop.x);
@@ -388,6 +382,7 @@ static void cluster_pixem_embedding_features(std::vector<DBSCAMSample<float>>& e
     }
 
     // dbscan cluster
+    PerfCounter::Scope perf_scope(s_perf_stage_dbscan);
     auto dbscan = DBSCAN<DBSCAMSample<float>, float>();
     dbscan.Run(&embedding_samples, 4, 0.4, 500);            /* from config.ini */
     cluster_ret = dbscan.Clusters;
@@ -29,6 +29,7 @@ limitations under the License.
 /* for My modules */
 #include "inference_helper.h"
 #include "bounding_box.h"
+#include "segmentation_map.h"
 
 class LaneEngine {
 public:
@@ -40,8 +41,8 @@ public:
     typedef std::vector<std::pair<int32_t, int32_t>> Line;
 
     typedef struct Result_ {
-        cv::Mat image_binary_seg;
-        cv::Mat image_instance_seg;
+        SegmentationMap binary_seg;     // [kNumHeight, kNumWidth, 1]. value is 0 or 255 (uint8_t). in model resolution
+        SegmentationMap instance_seg;   // [kNumHeight, kNumWidth, 3]. color for each lane (uint8_t). in model resolution
         struct crop_ {
             int32_t x;
             int32_t y;
@@ -37,6 +37,7 @@ limitations under the License.
 /*** Macro ***/
 static constexpr float kResultMixRatio = 0.5f;
 static constexpr bool  kIsDrawAllResult = true;
+static constexpr int32_t kMaxTileNum = 0;        /* > 0: output in high resolution with overlapping model-sized tiles (up to this number of tiles per frame) */
 
 #define TAG "ImageProcessor"
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
@@ -66,7 +67,7 @@ int32_t ImageProcessor::Initialize(const InputParam& input_param)
         return -1;
     }
 
-    s_engine.reset(new SegmentationEngine());
+    s_engine.reset(new SegmentationEngine(kMaxTileNum));
     if (s_engine->Initialize(input_param.work_dir, input_param.num_threads) != SegmentationEngine::kRetOk) {
         s_engine->Finalize();
         s_engine.reset();
@@ -120,38 +121,42 @@ int32_t ImageProcessor::Process(cv::Mat& mat, Result& result)
         return -1;
     }
 
-    /* Draw segmentation image for all the classes weighted by score */
-    cv::Mat mat_all_class = cv::Mat::zeros(segmentation_result.mat_out_list[0].size(), CV_8UC3);
+    /* Draw segmentation image for all the classes weighted by score (score is calculated in model resolution only here) */
+    cv::Mat mat_all_class;
     if (kIsDrawAllResult) {
-        /* Pile all class */
+        const cv::Mat& logit_map = segmentation_result.logit_map.GetMap();
+        const int32_t channel = logit_map.channels();
+        std::vector<cv::Scalar> color_list;
+        for (int32_t c = 0; c < channel; c++) color_list.push_back(s_nice_color_generator.Get(c));
+        mat_all_class = cv::Mat::zeros(logit_map.size(), CV_8UC3);
 #pragma omp parallel for
-        for (int32_t i = 0; i < segmentation_result.mat_out_list.size(); i++) {
-            auto& mat_out = segmentation_result.mat_out_list[i];
-            cv::cvtColor(mat_out, mat_out, cv::COLOR_GRAY2BGR); /* 1channel -> 3 channel */
-            cv::multiply(mat_out, s_nice_color_generator.Get(i), mat_out);
-            mat_out.convertTo(mat_out, CV_8UC1);
-        }
-
-        // don't use parallel
-        for (int32_t i = 0; i < segmentation_result.mat_out_list.size(); i++) {
-            cv::add(mat_all_class, segmentation_result.mat_out_list[i], mat_all_class);
+        for (int32_t y = 0; y < logit_map.rows; y++) {
+            std::vector<float> score_list(channel, 0);
+            for (int32_t x = 0; x < logit_map.cols; x++) {
+                CommonHelper::SoftMaxFast(logit_map.ptr<float>(y) + x * channel, score_list.data(), channel);
+                cv::Scalar color(0, 0, 0);
+                for (int32_t c = 0; c < channel; c++) color += color_list[c] * score_list[c];
+                mat_all_class.at<cv::Vec3b>(y, x) = cv::Vec3b(cv::saturate_cast<uint8_t>(color[0]), cv::saturate_cast<uint8_t>(color[1]), cv::saturate_cast<uint8_t>(color[2]));
+            }
         }
     }
 
     /* Draw segmentation image for the class of the highest score */
-    cv::Mat& mat_max = segmentation_result.mat_out_max;
-    mat_max *= 255 / 19;    // to get nice color
+    cv::Mat mat_max = segmentation_result.class_map.GetMap() * (255 / 19);    // to get nice color
     cv::applyColorMap(mat_max, mat_max, cv::COLORMAP_JET);
 
     /* Create result image */
-    cv::resize(mat_max, mat_max, mat.size());
-    cv::Mat mat_masked;
-    cv::add(mat_max * kResultMixRatio, mat * (1.0f - kResultMixRatio), mat_masked);
-    cv::hconcat(mat, mat_masked, mat);
+    cv::Mat mat_masked = mat.clone();
+    SegmentationMap(mat_max, segmentation_result.class_map.GetCrop()).BlendTo(mat_masked, kResultMixRatio);
     if (kIsDrawAllResult) {
-        cv::resize(mat_all_class, mat_all_class, mat_max.size());
+        /* side by side view needs the results in the frame size */
+        SegmentationMap(mat_max, segmentation_result.class_map.GetCrop()).Materialize(mat.size(), mat_max);
+        SegmentationMap(mat_all_class, segmentation_result.logit_map.GetCrop()).Materialize(mat.size(), mat_all_class);
         cv::hconcat(mat_all_class, mat_max, mat_all_class);
+        cv::hconcat(mat, mat_masked, mat);
         cv::vconcat(mat, mat_all_class, mat);
+    } else {
+        cv::hconcat(mat, mat_masked, mat);
     }
     DrawFps(mat, segmentation_result.time_inference, cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
 
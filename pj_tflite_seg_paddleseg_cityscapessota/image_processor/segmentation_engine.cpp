@@ -32,6 +32,10 @@ limitations under the License.
 #include "common_helper.h"
 #include "common_helper_cv.h"
 #include "inference_helper.h"
+#if defined(XNNPACK_WEIGHT_CACHE_ENABLED)
+#include "inference_helper_tensorflow_lite_xnnpack_cache.h"
+#endif
+#include "perf_counter.h"
 #include "segmentation_engine.h"
 
 /*** Macro ***/
@@ -39,6 +43,11 @@ limitations under the License.
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
+/* Stages measured with hardware performance counters */
+static const int32_t s_perf_stage_crop_resize = PerfCounter::RegisterStage("paddleseg_crop_resize");
+static const int32_t s_perf_stage_inference = PerfCounter::RegisterStage("paddleseg_inference");
+static const int32_t s_perf_stage_argmax = PerfCounter::RegisterStage("paddleseg_argmax");
+
 /* Model parameters */
 #define MODEL_NAME  "paddleseg_cityscapessota_180x320.tflite"
 #define INPUT_DIMS  { 1, 180, 320, 3 }
@@ -76,7 +85,11 @@ int32_t SegmentationEngine::Initialize(const std::string& work_dir, const int32_
 
     /* Create and Initialize Inference Helper */
     //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLite));
+#if defined(XNNPACK_WEIGHT_CACHE_ENABLED)
+    inference_helper_.reset(new InferenceHelperTensorflowLiteXnnpackCache());     /* keeps the packed weights in a file next to the model */
+#else
     inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteXnnpack));
+#endif
     //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteGpu));
     //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteEdgetpu));
     //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteNnapi));
@@ -108,24 +121,11 @@ int32_t SegmentationEngine::Finalize()
 }
 
 
-int32_t SegmentationEngine::Process(const cv::Mat& original_mat, Result& result)
+int32_t SegmentationEngine::Inference(const cv::Mat& img_src, cv::Mat& logit_map, Result& result)
 {
-    if (!inference_helper_) {
-        PRINT_E("Inference helper is not created\n");
-        return kRetErr;
-    }
     /*** PreProcess ***/
     const auto& t_pre_process0 = std::chrono::steady_clock::now();
     InputTensorInfo& input_tensor_info = input_tensor_info_list_[0];
-    /* do resize and color conversion here because some inference engine doesn't support these operations */
-    float ratio = static_cast<float>(input_tensor_info.GetWidth()) / input_tensor_info.GetHeight();
-    int32_t crop_x = 0;
-    int32_t crop_y = 0;
-    int32_t crop_w = original_mat.cols;
-    int32_t crop_h = original_mat.rows;
-    cv::Mat img_src = cv::Mat::zeros(input_tensor_info.GetHeight(), input_tensor_info.GetWidth(), CV_8UC3);
-    CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
-
     input_tensor_info.data = img_src.data;
     input_tensor_info.data_type = InputTensorInfo::kDataTypeImage;
     input_tensor_info.image_info.width = img_src.cols;
@@ -144,68 +144,94 @@ int32_t SegmentationEngine::Process(const cv::Mat& original_mat, Result& result)
 
     /*** Inference ***/
     const auto& t_inference0 = std::chrono::steady_clock::now();
-    if (inference_helper_->Process(output_tensor_info_list_) != InferenceHelper::kRetOk) {
-        return kRetErr;
+    {
+        PerfCounter::Scope perf_scope(s_perf_stage_inference);
+        if (inference_helper_->Process(output_tensor_info_list_) != InferenceHelper::kRetOk) {
+            return kRetErr;
+        }
     }
     const auto& t_inference1 = std::chrono::steady_clock::now();
 
-    /*** PostProcess ***/
-    const auto& t_post_process0 = std::chrono::steady_clock::now();
     /* Retrieve the result */
     const int32_t output_height = input_tensor_info.image_info.height;
     const int32_t output_width = input_tensor_info.image_info.width;
-    const std::vector<float> value_list(output_tensor_info_list_[0].GetDataAsFloat(), output_tensor_info_list_[0].GetDataAsFloat() + output_height * output_width * OUTPUT_CHANNEL);
-    //printf("%f, %f, %f\n", value_list[0], value_list[100], value_list[400]);
+    /* Logits for all the classes (score is calculated only when needed) */
+    logit_map = cv::Mat(output_height, output_width, CV_32FC(OUTPUT_CHANNEL), output_tensor_info_list_[0].GetDataAsFloat()).clone();
+
+    result.time_pre_process += static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
+    result.time_inference += static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
+    return kRetOk;
+}
 
-    /* Scores for all the classes */
-    std::vector<cv::Mat> mat_separated_list(OUTPUT_CHANNEL);
-    for (int32_t c = 0; c < OUTPUT_CHANNEL; c++) {
-        mat_separated_list[c] = cv::Mat::zeros(output_height, output_width, CV_32FC1);
+int32_t SegmentationEngine::Process(const cv::Mat& original_mat, Result& result)
+{
+    if (!inference_helper_) {
+        PRINT_E("Inference helper is not created\n");
+        return kRetErr;
     }
- #pragma omp parallel for
-    for (int32_t y = 0; y < output_height; y++) {
-        for (int32_t x = 0; x < output_width; x++) {
-#if 1
-            /* Use Score [0.0, 1.0] */
-            size_t offset = (size_t)y * output_width * OUTPUT_CHANNEL + (size_t)x * OUTPUT_CHANNEL;
-            std::vector<float> score_list(OUTPUT_CHANNEL, 0);
-            CommonHelper::SoftMaxFast(value_list.data() + offset, score_list.data(), OUTPUT_CHANNEL);
-            for (int32_t c = 0; c < OUTPUT_CHANNEL; c++) {
-                mat_separated_list[c].at<float>(cv::Point(x, y)) = score_list[c];
-            }
-#else
-            /* Use Logit */
-            size_t offset = (size_t)y * output_width * OUTPUT_CHANNEL + (size_t)x * OUTPUT_CHANNEL;
-            for (int32_t c = 0; c < OUTPUT_CHANNEL; c++) {
-                float val = value_list[offset + c] / 20;    // experimentally determined
-                mat_separated_list[c].at<float>(cv::Point(x, y)) = (std::min)(1.0f, (std::max)(0.0f, val));
+    const auto& t_process0 = std::chrono::steady_clock::now();
+    result.time_pre_process = 0;
+    result.time_inference = 0;
+
+    /* Logits in the model resolution, or in high resolution with tiles */
+    cv::Mat logit_map;
+    int32_t crop_x = 0;
+    int32_t crop_y = 0;
+    int32_t crop_w = original_mat.cols;
+    int32_t crop_h = original_mat.rows;
+    const InputTensorInfo& input_tensor_info = input_tensor_info_list_[0];
+    if (max_tile_num_ > 0) {
+        tiler_.SetTileSize(input_tensor_info.GetWidth(), input_tensor_info.GetHeight());
+        DenseTiler::TileFunc func = [&](const cv::Mat& tile, cv::Mat& out) {
+            int32_t tile_crop_x = 0;
+            int32_t tile_crop_y = 0;
+            int32_t tile_crop_w = tile.cols;
+            int32_t tile_crop_h = tile.rows;
+            cv::Mat img_src = cv::Mat::zeros(tile.rows, tile.cols, CV_8UC3);
+            {
+                PerfCounter::Scope perf_scope(s_perf_stage_crop_resize);
+                CommonHelper::CropResizeCvt(tile, img_src, tile_crop_x, tile_crop_y, tile_crop_w, tile_crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
             }
-#endif
+            return Inference(img_src, out, result);
+        };
+        if (tiler_.Process(original_mat, logit_map, { func }) != DenseTiler::kRetOk) {
+            return kRetErr;
+        }
+    } else {
+        /* do resize and color conversion here because some inference engine doesn't support these operations */
+        cv::Mat img_src = cv::Mat::zeros(input_tensor_info.GetHeight(), input_tensor_info.GetWidth(), CV_8UC3);
+        {
+            PerfCounter::Scope perf_scope(s_perf_stage_crop_resize);
+            CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
+        }
+        if (Inference(img_src, logit_map, result) != kRetOk) {
+            return kRetErr;
         }
     }
 
+    /*** PostProcess ***/
     /* Argmax */
     /* ref: https://github.com/PaddlePaddle/PaddleSeg/blob/release/2.3/paddleseg/core/infer.py#L244 */
+    const int32_t output_height = logit_map.rows;
+    const int32_t output_width = logit_map.cols;
     cv::Mat mat_max = cv::Mat::zeros(output_height, output_width, CV_8UC1);
+    {
+        PerfCounter::Scope perf_scope(s_perf_stage_argmax);  /* OpenMP workers are counted when they are created after PerfCounter::Initialize */
 #pragma omp parallel for
-    for (int32_t y = 0; y < output_height; y++) {
-        for (int32_t x = 0; x < output_width; x++) {
-            const auto& current_iter = value_list.begin() + y * output_width * OUTPUT_CHANNEL + x * OUTPUT_CHANNEL;
-            const auto& max_iter = std::max_element(current_iter, current_iter + OUTPUT_CHANNEL);
-            float max_score = *max_iter;
-            auto max_c = std::distance(current_iter, max_iter);
-            mat_max.at<uint8_t>(cv::Point(x, y)) = static_cast<uint8_t>(max_c);
+        for (int32_t y = 0; y < output_height; y++) {
+            const float* logit = logit_map.ptr<float>(y);
+            for (int32_t x = 0; x < output_width; x++) {
+                const float* current = logit + x * OUTPUT_CHANNEL;
+                mat_max.at<uint8_t>(cv::Point(x, y)) = static_cast<uint8_t>(std::max_element(current, current + OUTPUT_CHANNEL) - current);
+            }
         }
     }
-    const auto& t_post_process1 = std::chrono::steady_clock::now();
+    const auto& t_process1 = std::chrono::steady_clock::now();
 
     /* Return the results */
-    result.mat_out_list = mat_separated_list;
-    result.mat_out_max = mat_max;
-    result.time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
-    result.time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
-    result.time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;;
+    result.logit_map.Set(logit_map, cv::Rect(crop_x, crop_y, crop_w, crop_h));
+    result.class_map.Set(mat_max, cv::Rect(crop_x, crop_y, crop_w, crop_h));
+    result.time_post_process = static_cast<std::chrono::duration<double>>(t_process1 - t_process0).count() * 1000.0 - result.time_pre_process - result.time_inference;    /* including crop and blending of tiles */
 
     return kRetOk;
 }
-
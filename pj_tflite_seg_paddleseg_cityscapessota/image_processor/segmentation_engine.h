@@ -28,6 +28,8 @@ limitations under the License.
 
 /* for My modules */
 #include "inference_helper.h"
+#include "segmentation_map.h"
+#include "dense_tiler.h"
 
 
 class SegmentationEngine {
@@ -38,8 +40,8 @@ public:
     };
 
     typedef struct Result_ {
-        std::vector<cv::Mat> mat_out_list;      // [height, width, 1]. value is 0 - 1.0 (float)
-        cv::Mat           mat_out_max;          // [height, width, 1]. value is 0 - 18  (uint8_t)
+        SegmentationMap   logit_map;            // [height, width, 19]. value is logit (float). in model resolution (or working resolution of tiles). apply softmax to get score
+        SegmentationMap   class_map;            // [height, width, 1]. value is 0 - 18  (uint8_t). in model resolution (or working resolution of tiles)
         double            time_pre_process;		// [msec]
         double            time_inference;		// [msec]
         double            time_post_process;	// [msec]
@@ -48,14 +50,18 @@ public:
     } Result;
 
 public:
-    SegmentationEngine() {}
+    SegmentationEngine(int32_t max_tile_num = 0) : max_tile_num_(max_tile_num), tiler_(0, 0, 32, max_tile_num) {}  /* max_tile_num > 0: output in high resolution with overlapping tiles */
     ~SegmentationEngine() {}
     int32_t Initialize(const std::string& work_dir, const int32_t num_threads);
     int32_t Finalize(void);
     int32_t Process(const cv::Mat& original_mat, Result& result);
 
+private:
+    int32_t Inference(const cv::Mat& img_src, cv::Mat& logit_map, Result& result);
 
 private:
+    int32_t max_tile_num_;
+    DenseTiler tiler_;      /* logits are blended, then argmax is taken on the blended logits */
     std::unique_ptr<InferenceHelper> inference_helper_;
     std::vector<InputTensorInfo> input_tensor_info_list_;
     std::vector<OutputTensorInfo> output_tensor_info_list_;
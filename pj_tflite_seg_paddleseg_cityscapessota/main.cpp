@@ -26,6 +26,7 @@ limitations under the License.
 /* for My modules */
 #include "common_helper_cv.h"
 #include "image_processor.h"
+#include "perf_counter.h"
 
 /*** Macro ***/
 static constexpr char kOutputVideoFilename[] = "";
@@ -55,6 +56,9 @@ int32_t main(int argc, char* argv[])
     /* Create video writer to save output video */
     cv::VideoWriter writer;
 
+    /* Open performance counters before engines create worker threads, so that the workers are counted */
+    PerfCounter::Initialize();
+
     /* Initialize image processor library */
     ImageProcessor::InputParam input_param = { WORK_DIR, 4 };
     if (ImageProcessor::Initialize(input_param) != 0) {
@@ -131,6 +135,7 @@ int32_t main(int argc, char* argv[])
         printf("    Pre processing:  %9.3lf [msec]\n", total_time_pre_process / frame_cnt);
         printf("    Inference:       %9.3lf [msec]\n", total_time_inference / frame_cnt);
         printf("    Post processing: %9.3lf [msec]\n", total_time_post_process / frame_cnt);
+        PerfCounter::Print();
     }
 
     /* Fianlize image processor library */
@@ -31,6 +31,8 @@ limitations under the License.
 /* for My modules */
 #include "common_helper.h"
 #include "common_helper_cv.h"
+#include "segmentation_map.h"
+#include "person_roi_tracker.h"
 #include "segmentation_engine.h"
 #include "image_processor.h"
 
@@ -39,8 +41,13 @@ limitations under the License.
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
+#define USE_PERSON_ROI      /* run matting on the person area of the previous frame (full frame when lost) */
+static constexpr double kAlphaThreshold = 0.5;
+static constexpr int32_t kOutputBufferNum = 1;      /* results are not kept across frames. 2 or more only for pipelining (each one is another interpreter) */
+
 /*** Global variable ***/
 static std::unique_ptr<SegmentationEngine> s_engine;
+static PersonRoiTracker s_roi_tracker;
 
 static cv::Scalar s_bg_color;
 static float  s_mask_area_border_x_ratio;
@@ -66,12 +73,15 @@ int32_t ImageProcessor::Initialize(const InputParam& input_param)
     }
 
     s_engine.reset(new SegmentationEngine());
-    if (s_engine->Initialize(input_param.work_dir, input_param.num_threads) != SegmentationEngine::kRetOk) {
+    if (s_engine->Initialize(input_param.work_dir, input_param.num_threads, kOutputBufferNum) != SegmentationEngine::kRetOk) {
         s_engine->Finalize();
         s_engine.reset();
         return -1;
     }
 
+    s_roi_tracker.SetAspectRatio(s_engine->GetInputAspectRatio());
+    s_roi_tracker.Reset();
+
     s_bg_color = cv::Vec<float, 3>(0.0f, 255.0f, 0.0f);
     s_mask_area_border_x_ratio = 1.0f;
 
@@ -128,9 +138,17 @@ int32_t ImageProcessor::Process(cv::Mat& mat, Result& result)
     //cv::resize(mat, mat, cv::Size(640, 640 * mat.rows / mat.cols));
 
     SegmentationEngine::Result segmentation_result;
+#ifdef USE_PERSON_ROI
+    const cv::Rect roi = s_roi_tracker.GetRoi(mat.size());
+    if (s_engine->Process(mat, segmentation_result, roi) != SegmentationEngine::kRetOk) {
+        return -1;
+    }
+    s_roi_tracker.UpdateByMask(SegmentationMap(segmentation_result.mat_pha, segmentation_result.crop), kAlphaThreshold, mat.size());
+#else
     if (s_engine->Process(mat, segmentation_result) != SegmentationEngine::kRetOk) {
         return -1;
     }
+#endif
 
     cv::Mat mat_fgr = segmentation_result.mat_fgr;
     cv::Mat mat_pha = segmentation_result.mat_pha;
@@ -145,13 +163,15 @@ int32_t ImageProcessor::Process(cv::Mat& mat, Result& result)
     /* binalization */
     //cv::threshold(mat_pha, mat_pha, 0.5, 1.0, cv::THRESH_BINARY);
 
+    /* Paste alpha of the crop into the full frame (0 = background outside of the crop) */
+    SegmentationMap(mat_pha, segmentation_result.crop).Materialize(mat.size(), mat_pha);
+
     /* Select masking area (just to show a nice demo) */
     UpdateMaskArea();
     cv::rectangle(mat_pha, cv::Rect(static_cast<int32_t>(s_mask_area_border_x_ratio * mat_pha.cols), 0, static_cast<int32_t>((1.0f - s_mask_area_border_x_ratio) * mat_pha.cols), mat_pha.rows), cv::Vec<float, 1>(1.0f), -1);
 
     /* Extact masked area */
     cv::Mat mat_composit;
-    cv::resize(mat_pha, mat_pha, mat.size());
     mat_pha = CommonHelper::CombineMat1to3(mat_pha, mat_pha, mat_pha);  /* 1 channel to 3 channel for masking */
     mat.convertTo(mat_composit, CV_32FC3);
     cv::multiply(mat_composit, mat_pha, mat_composit);
@@ -163,6 +183,9 @@ int32_t ImageProcessor::Process(cv::Mat& mat, Result& result)
     mat_pha.convertTo(mat_pha, CV_8UC3);
     mat_composit = mat_composit + mat_pha;
 
+#ifdef USE_PERSON_ROI
+    cv::rectangle(mat, roi, CommonHelper::CreateCvColor(255, 255, 0), 1);
+#endif
     cv::hconcat(mat, mat_composit, mat);
 #endif
     DrawFps(mat, segmentation_result.time_inference, cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
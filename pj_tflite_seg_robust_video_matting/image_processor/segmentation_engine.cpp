@@ -32,6 +32,10 @@ limitations under the License.
 #include "common_helper.h"
 #include "common_helper_cv.h"
 #include "inference_helper.h"
+#if defined(XNNPACK_WEIGHT_CACHE_ENABLED)
+#include "inference_helper_tensorflow_lite_xnnpack_cache.h"
+#endif
+#include "model_registry.h"
 #include "segmentation_engine.h"
 
 /*** Macro ***/
@@ -80,13 +84,32 @@ limitations under the License.
 
 
 /*** Function ***/
-int32_t SegmentationEngine::Initialize(const std::string& work_dir, const int32_t num_threads)
+int32_t SegmentationEngine::Initialize(const std::string& work_dir, const int32_t num_threads, const int32_t output_buffer_num)
 {
     /* Set model information */
     std::string model_filename = work_dir + "/model/" + MODEL_NAME;
 
+    /* Read identical models (e.g. copied model files) from one file, so that they share the page cache */
+    model_filename_ = ModelRegistry::Resolve(model_filename);
+    if (model_filename_.empty()) {
+        return kRetErr;
+    }
+
+    interpreter_ring_.Reset((std::max)(1, output_buffer_num));
+    for (int32_t i = 0; i < interpreter_ring_.GetNum(); i++) {
+        if (InitializeInterpreter(interpreter_ring_.Get(i), num_threads) != kRetOk) {
+            interpreter_ring_.Reset(0);
+            return kRetErr;
+        }
+    }
+
+    return kRetOk;
+}
+
+int32_t SegmentationEngine::InitializeInterpreter(Interpreter& interpreter, const int32_t num_threads)
+{
     /* Set input tensor info */
-    input_tensor_info_list_.clear();
+    interpreter.input_tensor_info_list.clear();
     InputTensorInfo input_tensor_info(INPUT_NAME, TENSORTYPE, IS_NCHW);
     input_tensor_info.tensor_dims = INPUT_DIMS;
     input_tensor_info.data_type = InputTensorInfo::kDataTypeImage;
@@ -112,34 +135,38 @@ int32_t SegmentationEngine::Initialize(const std::string& work_dir, const int32_
     input_tensor_info.normalize.norm[1] = 1.0f / 255.0f;
     input_tensor_info.normalize.norm[2] = 1.0f / 255.0f;
 #endif
-    input_tensor_info_list_.push_back(input_tensor_info);
+    interpreter.input_tensor_info_list.push_back(input_tensor_info);
 
     /* Set output tensor info */
-    output_tensor_info_list_.clear();
-    output_tensor_info_list_.push_back(OutputTensorInfo(OUTPUT_NAME_FGR, TENSORTYPE, IS_NCHW));
-    output_tensor_info_list_.push_back(OutputTensorInfo(OUTPUT_NAME_PHA, TENSORTYPE, IS_NCHW));
+    interpreter.output_tensor_info_list.clear();
+    interpreter.output_tensor_info_list.push_back(OutputTensorInfo(OUTPUT_NAME_FGR, TENSORTYPE, IS_NCHW));
+    interpreter.output_tensor_info_list.push_back(OutputTensorInfo(OUTPUT_NAME_PHA, TENSORTYPE, IS_NCHW));
 
     /* Create and Initialize Inference Helper */
 #ifdef USE_TFLITE
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLite));
-    inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteXnnpack));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteGpu));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteEdgetpu));
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteNnapi));
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLite));
+#if defined(XNNPACK_WEIGHT_CACHE_ENABLED)
+    interpreter.inference_helper.reset(new InferenceHelperTensorflowLiteXnnpackCache());     /* keeps the packed weights in a file next to the model */
+#else
+    interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteXnnpack));
+#endif
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteGpu));
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteEdgetpu));
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorflowLiteNnapi));
 #else
-    //inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kOpencv));  // not supporrted
-    inference_helper_.reset(InferenceHelper::Create(InferenceHelper::kTensorrt));
+    //interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kOpencv));  // not supporrted
+    interpreter.inference_helper.reset(InferenceHelper::Create(InferenceHelper::kTensorrt));
 #endif
 
-    if (!inference_helper_) {
+    if (!interpreter.inference_helper) {
         return kRetErr;
     }
-    if (inference_helper_->SetNumThreads(num_threads) != InferenceHelper::kRetOk) {
-        inference_helper_.reset();
+    if (interpreter.inference_helper->SetNumThreads(num_threads) != InferenceHelper::kRetOk) {
+        interpreter.inference_helper.reset();
         return kRetErr;
     }
-    if (inference_helper_->Initialize(model_filename, input_tensor_info_list_, output_tensor_info_list_) != InferenceHelper::kRetOk) {
-        inference_helper_.reset();
+    if (interpreter.inference_helper->Initialize(model_filename_, interpreter.input_tensor_info_list, interpreter.output_tensor_info_list) != InferenceHelper::kRetOk) {
+        interpreter.inference_helper.reset();
         return kRetErr;
     }
 
@@ -148,33 +175,63 @@ int32_t SegmentationEngine::Initialize(const std::string& work_dir, const int32_
 
 int32_t SegmentationEngine::Finalize()
 {
-
-    if (!inference_helper_) {
+    if (interpreter_ring_.GetNum() == 0) {
         PRINT_E("Inference helper is not created\n");
         return kRetErr;
     }
-    inference_helper_->Finalize();
+    if (interpreter_ring_.GetNumInUse() > 0) {
+        PRINT_E("Results are still referred to. They become invalid\n");
+    }
+    for (int32_t i = 0; i < interpreter_ring_.GetNum(); i++) {
+        Interpreter& interpreter = interpreter_ring_.Get(i);
+        if (interpreter.inference_helper) interpreter.inference_helper->Finalize();
+    }
+    interpreter_ring_.Reset(0);
     return kRetOk;
 }
 
 
-int32_t SegmentationEngine::Process(const cv::Mat& original_mat, Result& result)
+float SegmentationEngine::GetInputAspectRatio() const
+{
+    if (interpreter_ring_.GetNum() == 0) return 1.0f;
+    const InputTensorInfo& input_tensor_info = interpreter_ring_.Get(0).input_tensor_info_list[0];
+    return static_cast<float>(input_tensor_info.GetWidth()) / input_tensor_info.GetHeight();
+}
+
+int32_t SegmentationEngine::Process(const cv::Mat& original_mat, Result& result, const cv::Rect& roi)
 {
-    if (!inference_helper_) {
+    if (interpreter_ring_.GetNum() == 0) {
         PRINT_E("Inference helper is not created\n");
         return kRetErr;
     }
+    /* Use an interpreter whose outputs are not referred to by previous results */
+    const auto interpreter_ref = interpreter_ring_.Acquire();
+    if (!interpreter_ref) {
+        PRINT_E("All output buffers are in use. Release previous results\n");
+        return kRetErr;
+    }
+    Interpreter& interpreter = *interpreter_ref;
+
     /*** PreProcess ***/
     const auto& t_pre_process0 = std::chrono::steady_clock::now();
-    InputTensorInfo& input_tensor_info = input_tensor_info_list_[0];
+    InputTensorInfo& input_tensor_info = interpreter.input_tensor_info_list[0];
     /* do resize and color conversion here because some inference engine doesn't support these operations */
-    float ratio = static_cast<float>(input_tensor_info.GetWidth()) / input_tensor_info.GetHeight();
+    /* Full frame is stretched. ROI (person area) is padded to keep aspect ratio, so the crop may exceed the image */
     int32_t crop_x = 0;
     int32_t crop_y = 0;
     int32_t crop_w = original_mat.cols;
     int32_t crop_h = original_mat.rows;
+    int32_t crop_type = CommonHelper::kCropTypeStretch;
+    const cv::Rect roi_clipped = roi & cv::Rect(0, 0, original_mat.cols, original_mat.rows);
+    if (roi_clipped.area() > 0 && roi_clipped != cv::Rect(0, 0, original_mat.cols, original_mat.rows)) {
+        crop_x = roi_clipped.x;
+        crop_y = roi_clipped.y;
+        crop_w = roi_clipped.width;
+        crop_h = roi_clipped.height;
+        crop_type = CommonHelper::kCropTypeExpand;
+    }
     cv::Mat img_src = cv::Mat::zeros(input_tensor_info.GetHeight(), input_tensor_info.GetWidth(), CV_8UC3);
-    CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, CommonHelper::kCropTypeStretch);
+    CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, IS_RGB, crop_type);
 
     input_tensor_info.data = img_src.data;
     input_tensor_info.data_type = InputTensorInfo::kDataTypeImage;
@@ -187,14 +244,14 @@ int32_t SegmentationEngine::Process(const cv::Mat& original_mat, Result& result)
     input_tensor_info.image_info.crop_height = img_src.rows;
     input_tensor_info.image_info.is_bgr = false;
     input_tensor_info.image_info.swap_color = false;
-    if (inference_helper_->PreProcess(input_tensor_info_list_) != InferenceHelper::kRetOk) {
+    if (interpreter.inference_helper->PreProcess(interpreter.input_tensor_info_list) != InferenceHelper::kRetOk) {
         return kRetErr;
     }
     const auto& t_pre_process1 = std::chrono::steady_clock::now();
 
     /*** Inference ***/
     const auto& t_inference0 = std::chrono::steady_clock::now();
-    if (inference_helper_->Process(output_tensor_info_list_) != InferenceHelper::kRetOk) {
+    if (interpreter.inference_helper->Process(interpreter.output_tensor_info_list) != InferenceHelper::kRetOk) {
         return kRetErr;
     }
     const auto& t_inference1 = std::chrono::steady_clock::now();
@@ -204,17 +261,28 @@ int32_t SegmentationEngine::Process(const cv::Mat& original_mat, Result& result)
     /* Retrieve the result */
     const int32_t output_height = input_tensor_info.image_info.height;
     const int32_t output_width = input_tensor_info.image_info.width;
-    //std::vector<float> fgr_list(output_tensor_info_list_[0].GetDataAsFloat(), output_tensor_info_list_[0].GetDataAsFloat() + output_height * output_width * 3);
-    //std::vector<float> pha_list(output_tensor_info_list_[1].GetDataAsFloat(), output_tensor_info_list_[1].GetDataAsFloat() + output_height * output_width * 1);
+    //std::vector<float> fgr_list(interpreter.output_tensor_info_list[0].GetDataAsFloat(), interpreter.output_tensor_info_list[0].GetDataAsFloat() + output_height * output_width * 3);
+    //std::vector<float> pha_list(interpreter.output_tensor_info_list[1].GetDataAsFloat(), interpreter.output_tensor_info_list[1].GetDataAsFloat() + output_height * output_width * 1);
     //printf("FGR: [%f, %f], %f, %f, %f\n", *std::min_element(fgr_list.begin(), fgr_list.end()), *std::max_element(fgr_list.begin(), fgr_list.end()), fgr_list[0], fgr_list[100], fgr_list[400]);
     //printf("PHA: [%f, %f], %f, %f, %f\n", *std::min_element(pha_list.begin(), pha_list.end()), *std::max_element(pha_list.begin(), pha_list.end()), pha_list[0], pha_list[100], pha_list[400]);
-    cv::Mat mat_fgr = cv::Mat(output_height, output_width, CV_32FC3, output_tensor_info_list_[0].GetDataAsFloat()).clone();  // need to clone because the data itself is on tensor and will be deleted
-    cv::Mat mat_pha = cv::Mat(output_height, output_width, CV_32FC1, output_tensor_info_list_[1].GetDataAsFloat()).clone();
+    cv::Mat mat_fgr = cv::Mat(output_height, output_width, CV_32FC3, interpreter.output_tensor_info_list[0].GetDataAsFloat());
+    cv::Mat mat_pha = cv::Mat(output_height, output_width, CV_32FC1, interpreter.output_tensor_info_list[1].GetDataAsFloat());
+    const bool is_zero_copy = interpreter_ring_.GetNum() > 1;   /* the tensors are not overwritten while result.buffer holds this interpreter */
+    if (!is_zero_copy) {
+        mat_fgr = mat_fgr.clone();
+        mat_pha = mat_pha.clone();
+    }
     const auto& t_post_process1 = std::chrono::steady_clock::now();
 
     /* Return the results */
     result.mat_fgr = mat_fgr;
     result.mat_pha = mat_pha;
+    if (is_zero_copy) {
+        result.buffer = interpreter_ref;
+    } else {
+        result.buffer.reset();
+    }
+    result.crop = cv::Rect(crop_x, crop_y, crop_w, crop_h);
     result.time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
     result.time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
     result.time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;;
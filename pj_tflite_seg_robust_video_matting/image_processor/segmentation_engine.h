@@ -28,6 +28,7 @@ limitations under the License.
 
 /* for My modules */
 #include "inference_helper.h"
+#include "buffer_ring.h"
 
 
 class SegmentationEngine {
@@ -40,6 +41,8 @@ public:
     typedef struct Result_ {
         cv::Mat           mat_fgr;             // [height, width, 3], float (0.0 - 1.0)
         cv::Mat           mat_pha;             // [height, width, 1], float (0.0 - 1.0)
+        std::shared_ptr<const void> buffer;    // output_buffer_num > 1 only: mat_fgr / mat_pha refer to the output tensors. they are valid (not overwritten by the next Process) while this is held
+        cv::Rect          crop;                // area in the original image which mat_fgr / mat_pha correspond to (may exceed the image)
         double            time_pre_process;		// [msec]
         double            time_inference;		// [msec]
         double            time_post_process;	// [msec]
@@ -50,15 +53,29 @@ public:
 public:
     SegmentationEngine() {}
     ~SegmentationEngine() {}
-    int32_t Initialize(const std::string& work_dir, const int32_t num_threads);
+    /* output_buffer_num = 1: outputs are copied into the result */
+    /* output_buffer_num > 1: results refer to the output tensors without copy, for callers which keep results across frames (pipelining). */
+    /*   Each buffer is a whole interpreter. InferenceHelper loads the model again and XNNPACK packs its own weights, */
+    /*   so each one costs the packed weights and the tensor arena (hundreds of MB for resnet50 720x1280) */
+    int32_t Initialize(const std::string& work_dir, const int32_t num_threads, const int32_t output_buffer_num = 1);
     int32_t Finalize(void);
-    int32_t Process(const cv::Mat& original_mat, Result& result);
+    int32_t Process(const cv::Mat& original_mat, Result& result, const cv::Rect& roi = cv::Rect());   /* roi = crop area in original_mat. empty = full frame */
+    float GetInputAspectRatio() const;
 
 
 private:
-    std::unique_ptr<InferenceHelper> inference_helper_;
-    std::vector<InputTensorInfo> input_tensor_info_list_;
-    std::vector<OutputTensorInfo> output_tensor_info_list_;
+    typedef struct Interpreter_ {
+        std::unique_ptr<InferenceHelper> inference_helper;
+        std::vector<InputTensorInfo> input_tensor_info_list;
+        std::vector<OutputTensorInfo> output_tensor_info_list;
+    } Interpreter;
+
+private:
+    int32_t InitializeInterpreter(Interpreter& interpreter, const int32_t num_threads);
+
+private:
+    std::string model_filename_;                    /* resolved with ModelRegistry */
+    BufferRing<Interpreter> interpreter_ring_;      /* each interpreter has its own output tensors, so results of the previous frames stay valid (output_buffer_num > 1) */
 };
 
 #endif
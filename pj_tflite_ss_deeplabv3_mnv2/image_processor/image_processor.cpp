@@ -36,6 +36,8 @@ limitations under the License.
 #include "image_processor.h"
 
 /*** Macro ***/
+static constexpr int32_t kMaskAlpha = 128;     /* [0, 255] */
+
 #define TAG "ImageProcessor"
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
@@ -55,6 +57,22 @@ static void DrawFps(cv::Mat& mat, double time_inference, cv::Point pos, double f
     CommonHelper::DrawText(mat, text, cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
 }
 
+static const cv::Mat& GetPalette()
+{
+    static cv::Mat palette;
+    if (palette.empty()) {
+        std::vector<cv::Scalar> color_list;
+        for (int32_t i = 0; i < 256; i++) {
+            float color_ratio_b = (i % 2 + 1) / 2.0f;
+            float color_ratio_g = (i % 3 + 1) / 3.0f;
+            float color_ratio_r = (i % 4 + 1) / 4.0f;
+            color_list.push_back(cv::Scalar(static_cast<uint8_t>(255 * color_ratio_b), static_cast<uint8_t>(255 * color_ratio_g), static_cast<uint8_t>(255 * (1 - color_ratio_r))));
+        }
+        palette = SegmentationMap::CreatePalette(color_list, kMaskAlpha);
+    }
+    return palette;
+}
+
 int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param)
 {
     if (s_engine) {
@@ -114,9 +132,8 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
         return -1;
     }
 
-    /* Draw the result */
-    cv::resize(ss_result.image_mask, ss_result.image_mask, mat.size());
-    cv::add(mat, ss_result.image_mask, mat);
+    /* Draw the result (upscale, colorize and blend in one pass) */
+    ss_result.class_map.OverlayTo(mat, GetPalette(), cv::INTER_NEAREST);
 
     DrawFps(mat, ss_result.time_inference, cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
 
@@ -142,23 +142,14 @@ int32_t SemanticSegmentationEngine::Process(const cv::Mat& original_mat, Result&
     int32_t output_height = output_tensor_info_list_[0].tensor_dims[1];
     int32_t output_channel = 1;
     const int64_t* values = static_cast<int64_t*>(output_tensor_info_list_[0].data);
-    cv::Mat image_mask = cv::Mat::zeros(output_height, output_width, CV_8UC3);
-    for (int y = 0; y < output_height; y++) {
-        for (int x = 0; x < output_width; x++) {
-            int32_t max_channel = static_cast<int32_t>(values[y * output_width + x]);
-            float color_ratio_b = (max_channel % 2 + 1) / 2.0f;
-            float color_ratio_g = (max_channel % 3 + 1) / 3.0f;
-            float color_ratio_r = (max_channel % 4 + 1) / 4.0f;
-            image_mask.data[(y * output_width + x) * 3 + 0] = static_cast<uint8_t>(255 * color_ratio_b);
-            image_mask.data[(y * output_width + x) * 3 + 1] = static_cast<uint8_t>(255 * color_ratio_g);
-            image_mask.data[(y * output_width + x) * 3 + 2] = static_cast<uint8_t>(255 * (1 - color_ratio_r));
-
-        }
+    cv::Mat class_map = cv::Mat(output_height, output_width, CV_8UC1);
+    for (int32_t i = 0; i < output_height * output_width; i++) {
+        class_map.data[i] = static_cast<uint8_t>(values[i]);
     }
     const auto& t_post_process1 = std::chrono::steady_clock::now();
 
     /* Return the results */
-    result.image_mask = image_mask;
+    result.class_map.Set(class_map, cv::Rect(0, 0, original_mat.cols, original_mat.rows));
     result.time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
     result.time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
     result.time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;;
@@ -28,6 +28,7 @@ limitations under the License.
 
 /* for My modules */
 #include "inference_helper.h"
+#include "segmentation_map.h"
 
 
 class SemanticSegmentationEngine {
@@ -38,7 +39,7 @@ public:
     };
 
     typedef struct Result_ {
-        cv::Mat             image_mask;
+        SegmentationMap   class_map;            // [height, width, 1]. value is class id (uint8_t). in model resolution
         double            time_pre_process;		// [msec]
         double            time_inference;		// [msec]
         double            time_post_process;	// [msec]
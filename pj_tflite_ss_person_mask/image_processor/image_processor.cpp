@@ -32,6 +32,7 @@ limitations under the License.
 /* for My modules */
 #include "common_helper.h"
 #include "common_helper_cv.h"
+#include "person_roi_tracker.h"
 #include "semantic_segmentation_engine.h"
 #include "image_processor.h"
 
@@ -40,8 +41,12 @@ limitations under the License.
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
+#define USE_PERSON_ROI      /* run segmentation on the person area of the previous frame (full frame when lost) */
+static constexpr double kMaskThreshold = 128;
+
 /*** Global variable ***/
 std::unique_ptr<SemanticSegmentationEngine> s_engine;
+PersonRoiTracker s_roi_tracker;
 
 /*** Function ***/
 static void DrawFps(cv::Mat& mat, double time_inference, cv::Point pos, double font_scale, int32_t thickness, cv::Scalar color_front, cv::Scalar color_back, bool is_text_on_rect = true)
@@ -55,6 +60,18 @@ static void DrawFps(cv::Mat& mat, double time_inference, cv::Point pos, double f
     CommonHelper::DrawText(mat, text, cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
 }
 
+static const cv::Mat& GetPalette()
+{
+    static cv::Mat palette;
+    if (palette.empty()) {
+        palette = cv::Mat(1, 256, CV_8UC4);
+        for (int32_t i = 0; i < 256; i++) {
+            palette.at<cv::Vec4b>(i) = cv::Vec4b(0, 255, 0, i);     // optional: change mask color
+        }
+    }
+    return palette;
+}
+
 int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param)
 {
     if (s_engine) {
@@ -68,6 +85,8 @@ int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param
         s_engine.reset();
         return -1;
     }
+    s_roi_tracker.SetAspectRatio(s_engine->GetInputAspectRatio());
+    s_roi_tracker.Reset();
     return 0;
 }
 
@@ -110,16 +129,23 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
     }
 
     SemanticSegmentationEngine::Result ss_result;
+#ifdef USE_PERSON_ROI
+    const cv::Rect roi = s_roi_tracker.GetRoi(mat.size());
+    if (s_engine->Process(mat, ss_result, roi) != SemanticSegmentationEngine::kRetOk) {
+        return -1;
+    }
+    s_roi_tracker.UpdateByMask(ss_result.mask, kMaskThreshold, mat.size());
+#else
     if (s_engine->Process(mat, ss_result) != SemanticSegmentationEngine::kRetOk) {
         return -1;
     }
+#endif
 
-    /* Draw the result */
-    cv::cvtColor(ss_result.image_mask, ss_result.image_mask, cv::COLOR_GRAY2BGR);
-    cv::resize(ss_result.image_mask, ss_result.image_mask, mat.size());
-    cv::subtract(mat, ss_result.image_mask, mat);		// Fill out masked area
-    cv::multiply(ss_result.image_mask, cv::Scalar(0, 255, 0), ss_result.image_mask);	// optional: change mask color
-    cv::add(mat, ss_result.image_mask, mat);		// Fill out masked area
+    /* Draw the result (upscale and fill out masked area in one pass. mask value is used as alpha) */
+    ss_result.mask.OverlayTo(mat, GetPalette(), cv::INTER_LINEAR);
+#ifdef USE_PERSON_ROI
+    cv::rectangle(mat, roi, CommonHelper::CreateCvColor(255, 255, 0), 1);
+#endif
 
     DrawFps(mat, ss_result.time_inference, cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
 
@@ -30,6 +30,7 @@ limitations under the License.
 
 /* for My modules */
 #include "common_helper.h"
+#include "common_helper_cv.h"
 #include "inference_helper.h"
 #include "semantic_segmentation_engine.h"
 
@@ -97,7 +98,13 @@ int32_t SemanticSegmentationEngine::Finalize()
 }
 
 
-int32_t SemanticSegmentationEngine::Process(const cv::Mat& original_mat, Result& result)
+float SemanticSegmentationEngine::GetInputAspectRatio() const
+{
+    if (input_tensor_info_list_.empty()) return 1.0f;
+    return static_cast<float>(input_tensor_info_list_[0].GetWidth()) / input_tensor_info_list_[0].GetHeight();
+}
+
+int32_t SemanticSegmentationEngine::Process(const cv::Mat& original_mat, Result& result, const cv::Rect& roi)
 {
     if (!inference_helper_) {
         PRINT_E("Inference helper is not created\n");
@@ -107,11 +114,22 @@ int32_t SemanticSegmentationEngine::Process(const cv::Mat& original_mat, Result&
     const auto& t_pre_process0 = std::chrono::steady_clock::now();
     InputTensorInfo& input_tensor_info = input_tensor_info_list_[0];
     /* do resize and color conversion here because some inference engine doesn't support these operations */
-    cv::Mat img_src;
-    cv::resize(original_mat, img_src, cv::Size(input_tensor_info.GetWidth(), input_tensor_info.GetHeight()));
-#ifndef CV_COLOR_IS_RGB
-    cv::cvtColor(img_src, img_src, cv::COLOR_BGR2RGB);
-#endif
+    /* Full frame is stretched. ROI (person area) is padded to keep aspect ratio, so the crop may exceed the image */
+    int32_t crop_x = 0;
+    int32_t crop_y = 0;
+    int32_t crop_w = original_mat.cols;
+    int32_t crop_h = original_mat.rows;
+    int32_t crop_type = CommonHelper::kCropTypeStretch;
+    const cv::Rect roi_clipped = roi & cv::Rect(0, 0, original_mat.cols, original_mat.rows);
+    if (roi_clipped.area() > 0 && roi_clipped != cv::Rect(0, 0, original_mat.cols, original_mat.rows)) {
+        crop_x = roi_clipped.x;
+        crop_y = roi_clipped.y;
+        crop_w = roi_clipped.width;
+        crop_h = roi_clipped.height;
+        crop_type = CommonHelper::kCropTypeExpand;
+    }
+    cv::Mat img_src = cv::Mat::zeros(input_tensor_info.GetHeight(), input_tensor_info.GetWidth(), CV_8UC3);
+    CommonHelper::CropResizeCvt(original_mat, img_src, crop_x, crop_y, crop_w, crop_h, true, crop_type);
     input_tensor_info.data = img_src.data;
     input_tensor_info.data_type = InputTensorInfo::kDataTypeImage;
     input_tensor_info.image_info.width = img_src.cols;
@@ -147,7 +165,7 @@ int32_t SemanticSegmentationEngine::Process(const cv::Mat& original_mat, Result&
     const auto& t_post_process1 = std::chrono::steady_clock::now();
 
     /* Return the results */
-    result.image_mask = image_mask;
+    result.mask.Set(image_mask, cv::Rect(crop_x, crop_y, crop_w, crop_h));
     result.time_pre_process = static_cast<std::chrono::duration<double>>(t_pre_process1 - t_pre_process0).count() * 1000.0;
     result.time_inference = static_cast<std::chrono::duration<double>>(t_inference1 - t_inference0).count() * 1000.0;
     result.time_post_process = static_cast<std::chrono::duration<double>>(t_post_process1 - t_post_process0).count() * 1000.0;;
@@ -28,6 +28,7 @@ limitations under the License.
 
 /* for My modules */
 #include "inference_helper.h"
+#include "segmentation_map.h"
 
 
 class SemanticSegmentationEngine {
@@ -38,7 +39,7 @@ public:
     };
 
     typedef struct Result_ {
-        cv::Mat           image_mask;
+        SegmentationMap   mask;                 // [height, width, 1]. value is 0 - 255 (uint8_t). in model resolution
         double            time_pre_process;		// [msec]
         double            time_inference;		// [msec]
         double            time_post_process;	// [msec]
@@ -51,7 +52,8 @@ public:
     ~SemanticSegmentationEngine() {}
     int32_t Initialize(const std::string& work_dir, const int32_t num_threads);
     int32_t Finalize(void);
-    int32_t Process(const cv::Mat& original_mat, Result& result);
+    int32_t Process(const cv::Mat& original_mat, Result& result, const cv::Rect& roi = cv::Rect());   /* roi = crop area in original_mat. empty = full frame */
+    float GetInputAspectRatio() const;
 
 
 private:
@@ -129,16 +129,27 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
         return -1;
     }
 
+    /* Colorize in model resolution, then resize it onto the target area only */
+    const cv::Mat& score_map = ss_result.score_map.GetMap();
+    const int32_t channel = score_map.channels();
+    std::vector<cv::Scalar> color_list;
+    for (int32_t c = 0; c < channel; c++) color_list.push_back(GetColor(c));
+    cv::Mat image_color(score_map.size(), CV_8UC3);
 #pragma omp parallel for
-    for (int32_t i = 0; i < ss_result.image_list.size(); i++) {
-        cv::cvtColor(ss_result.image_list[i], ss_result.image_list[i], cv::COLOR_GRAY2BGR); /* 1channel -> 3 channel */
-        cv::resize(ss_result.image_list[i], ss_result.image_list[i], mat.size());
-        cv::multiply(ss_result.image_list[i], GetColor(i), ss_result.image_list[i]);
-        ss_result.image_list[i].convertTo(ss_result.image_list[i], CV_8UC3, 1, 0);
-    }
-    for (int32_t i = 0; i < ss_result.image_list.size(); i++) {
-        cv::add(mat, ss_result.image_list[i], mat);
+    for (int32_t y = 0; y < score_map.rows; y++) {
+        const float* score = score_map.ptr<float>(y);
+        cv::Vec3b* color = image_color.ptr<cv::Vec3b>(y);
+        for (int32_t x = 0; x < score_map.cols; x++) {
+            float b = 0, g = 0, r = 0;
+            for (int32_t c = 0; c < channel; c++) {
+                b += score[x * channel + c] * static_cast<float>(color_list[c][0]);
+                g += score[x * channel + c] * static_cast<float>(color_list[c][1]);
+                r += score[x * channel + c] * static_cast<float>(color_list[c][2]);
+            }
+            color[x] = cv::Vec3b(cv::saturate_cast<uint8_t>(b), cv::saturate_cast<uint8_t>(g), cv::saturate_cast<uint8_t>(r));
+        }
     }
+    SegmentationMap(image_color, ss_result.score_map.GetCrop()).AddTo(mat);
 
     DrawFps(mat, ss_result.time_inference, cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
 
@@ -177,21 +177,12 @@ int32_t SemanticSegmentationEngine::Process(const cv::Mat& original_mat, Result&
     int32_t output_channel = output_tensor_info_list_[0].tensor_dims[3];
     float* output_raw_data = static_cast<float*>(output_tensor_info_list_[0].data);
 
-    std::vector<cv::Mat> image_fp32_list;
-    for (int32_t i = 0; i < output_channel; i++) image_fp32_list.push_back(cv::Mat(output_height, output_width, CV_32FC1));
-
-#pragma omp parallel for num_threads(num_threads_)
-    for (int32_t y = 0; y < output_height; y++) {
-        for (int32_t x = 0; x < output_width; x++) {
-            for (int32_t c = 0; c < output_channel; c++) {
-                image_fp32_list[c].at<float>(cv::Point(x,y)) = output_raw_data[y * (output_width * output_channel) + x * output_channel + c];
-            }
-        }
-    }    
+    /* keep all the channels in one Mat (no split, no resize). copy because the output tensor is overwritten by the next inference */
+    cv::Mat score_map = cv::Mat(output_height, output_width, CV_32FC(output_channel), output_raw_data).clone();
     const auto& t_post_process1 = std::chrono::steady_clock::now();
 
     /* Return the results */
-    result.image_list = image_fp32_list;
+    result.score_map.Set(score_map, cv::Rect(crop_x, crop_y, crop_w, crop_h));
     result.crop.x = (std::max)(0, crop_x);
     result.crop.y = (std::max)(0, crop_y);
     result.crop.w = (std::min)(crop_w, original_mat.cols - result.crop.x);
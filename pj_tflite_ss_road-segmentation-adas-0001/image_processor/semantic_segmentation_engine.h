@@ -28,6 +28,7 @@ limitations under the License.
 
 /* for My modules */
 #include "inference_helper.h"
+#include "segmentation_map.h"
 
 
 class SemanticSegmentationEngine {
@@ -38,7 +39,7 @@ public:
     };
 
     typedef struct Result_ {
-        std::vector<cv::Mat> image_list;                // [height, width, 1]. value is 0 - 1.0 (FP32)
+        SegmentationMap   score_map;                    // [height, width, channel]. value is 0 - 1.0 (FP32). in model resolution
         struct crop_ {
             int32_t x;
             int32_t y;
@@ -41,6 +41,8 @@ limitations under the License.
 #define PRINT(...)   COMMON_HELPER_PRINT(TAG, __VA_ARGS__)
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
+#define USE_GUIDED_UPSAMPLING   /* output in the original resolution using edge-aware upsampling. comment out to output in the model resolution */
+
 /*** Global variable ***/
 std::unique_ptr<StylePredictionEngine> s_style_prediction_engine;
 std::unique_ptr<StyleTransferEngine> s_style_transfer_engine;
@@ -94,7 +96,11 @@ int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param
         return -1;
     }
 
-    s_style_transfer_engine.reset(new StyleTransferEngine());
+#ifdef USE_GUIDED_UPSAMPLING
+    s_style_transfer_engine.reset(new StyleTransferEngine(true));
+#else
+    s_style_transfer_engine.reset(new StyleTransferEngine(false));
+#endif
     if (s_style_transfer_engine->Initialize(input_param.work_dir, input_param.num_threads) != StyleTransferEngine::kRetOk) {
         s_style_transfer_engine->Finalize();
         s_style_transfer_engine.reset();
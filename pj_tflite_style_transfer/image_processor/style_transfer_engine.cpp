@@ -149,6 +149,11 @@ int32_t StyleTransferEngine::Process(const cv::Mat& original_mat, const float st
     cv::Mat out_mat_fp(cv::Size(output_tensor_info_list_[0].tensor_dims[1], output_tensor_info_list_[0].tensor_dims[2]), CV_32FC3, const_cast<float*>(output_tensor_info_list_[0].GetDataAsFloat()));
     cv::Mat out_mat;
     out_mat_fp.convertTo(out_mat, CV_8UC3, 255);
+    if (use_guided_upsampling_) {
+        cv::Mat out_mat_full;
+        guided_upsampler_.Process(original_mat, out_mat, out_mat_full);
+        out_mat = out_mat_full;
+    }
     const auto& t_post_process1 = std::chrono::steady_clock::now();
 
     /* Return the results */
@@ -28,6 +28,7 @@ limitations under the License.
 
 /* for My modules */
 #include "inference_helper.h"
+#include "guided_upsampler.h"
 
 
 class StyleTransferEngine {
@@ -38,7 +39,7 @@ public:
     };
 
     typedef struct Result_ {
-        cv::Mat           image;
+        cv::Mat           image;            /* the same size as the input image if guided upsampling is used. otherwise the model output size */
         double            time_pre_process;		// [msec]
         double            time_inference;		// [msec]
         double            time_post_process;	// [msec]
@@ -47,7 +48,7 @@ public:
     } Result;
 
 public:
-    StyleTransferEngine() {}
+    StyleTransferEngine(bool use_guided_upsampling = true) : use_guided_upsampling_(use_guided_upsampling) {}
     ~StyleTransferEngine() {}
     int32_t Initialize(const std::string& work_dir, const int32_t num_threads);
     int32_t Finalize(void);
@@ -58,6 +59,10 @@ private:
     std::unique_ptr<InferenceHelper> inference_helper_;
     std::vector<InputTensorInfo> input_tensor_info_list_;
     std::vector<OutputTensorInfo> output_tensor_info_list_;
+
+    /* run the network in low resolution and reconstruct the original resolution using the input image as guide */
+    bool use_guided_upsampling_;
+    GuidedUpsampler guided_upsampler_;
 };
 
 #endif
@@ -25,6 +25,7 @@ limitations under the License.
 #include <chrono>
 #include <fstream>
 #include <memory>
+#include <future>
 
 /* for OpenCV */
 #include <opencv2/opencv.hpp>
@@ -32,6 +33,7 @@ limitations under the License.
 /* for My modules */
 #include "common_helper.h"
 #include "common_helper_cv.h"
+#include "engine_initializer.h"
 #include "bounding_box.h"
 #include "detection_engine.h"
 #include "feature_engine.h"
@@ -45,6 +47,8 @@ limitations under the License.
 
 #define USE_DEEPSORT
 
+static constexpr bool kWarmUpAtInitialize = true;     /* run inference once at initialization so that the first frame costs the same as others */
+
 /*** Global variable ***/
 std::unique_ptr<DetectionEngine> s_det_engine;
 std::unique_ptr<FeatureEngine> s_feature_engine;
@@ -86,15 +90,27 @@ int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param
         return -1;
     }
 
-    s_det_engine.reset(new DetectionEngine(0.4f, 0.2f, 0.5f));
-    if (s_det_engine->Initialize(input_param.work_dir, input_param.num_threads) != DetectionEngine::kRetOk) {
+    /* Initialize engines concurrently */
+    const cv::Mat mat_dummy = cv::Mat(480, 640, CV_8UC3, cv::Scalar(128, 128, 128));
+    auto future_det = CommonHelper::InitializeEngineAsync("DetectionEngine", kWarmUpAtInitialize, [&]() {
+        s_det_engine.reset(new DetectionEngine(0.4f, 0.2f, 0.5f));
+        return s_det_engine->Initialize(input_param.work_dir, input_param.num_threads);
+    }, [&]() {
+        DetectionEngine::Result det_result;
+        return s_det_engine->Process(mat_dummy, det_result);
+    });
+    auto future_feature = CommonHelper::InitializeEngineAsync("FeatureEngine", kWarmUpAtInitialize, [&]() {
+        s_feature_engine.reset(new FeatureEngine());
+        return s_feature_engine->Initialize(input_param.work_dir, input_param.num_threads);
+    }, [&]() {
+        FeatureEngine::Result feature_result;
+        return s_feature_engine->Process(mat_dummy, BoundingBox(0, "", 1.0f, 0, 0, 128, 256), feature_result);
+    });
+    bool is_det_ok = future_det.get();
+    bool is_feature_ok = future_feature.get();
+    if (!is_det_ok || !is_feature_ok) {
         s_det_engine->Finalize();
         s_det_engine.reset();
-        return -1;
-    }
-
-    s_feature_engine.reset(new FeatureEngine());
-    if (s_feature_engine->Initialize(input_param.work_dir, input_param.num_threads) != FeatureEngine::kRetOk) {
         s_feature_engine->Finalize();
         s_feature_engine.reset();
         return -1;
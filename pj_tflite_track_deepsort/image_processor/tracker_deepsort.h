@@ -27,7 +27,8 @@ limitations under the License.
 
 /* for My modules */
 #include "bounding_box.h"
-#include "kalman_filter.h"
+#include "kalman_filter_batch.h"
+#include "spatial_hash.h"
 
 
 class TrackDeepSort {
@@ -42,11 +43,11 @@ public:
     } Data;
 
 public:
-    TrackDeepSort(const int32_t id, const BoundingBox& bbox_det, const std::vector<float>& feature);
+    TrackDeepSort(const int32_t id, const BoundingBox& bbox_det, const std::vector<float>& feature, const int32_t kf_index);
     ~TrackDeepSort();
 
-    BoundingBox Predict();
-    void Update(const BoundingBox& bbox_det);
+    BoundingBox Predict(const KalmanFilterBatch& kf_batch);
+    void Update(const BoundingBox& bbox_det, KalmanFilterBatch& kf_batch);
     void UpdateNoDetect();
 
     std::deque<Data>& GetDataHistory();
@@ -56,16 +57,11 @@ public:
     const int32_t GetId() const;
     const int32_t GetUndetectedCount() const;
     const int32_t GetDetectedCount() const;
-
-private:
-    KalmanFilter CreateKalmanFilter_UniformLinearMotion(const BoundingBox& bbox_start);
-    SimpleMatrix Bbox2KalmanObserved(const BoundingBox& bbox);
-    SimpleMatrix Bbox2KalmanStatus(const BoundingBox& bbox);
-    BoundingBox KalmanStatus2Bbox(const SimpleMatrix& X);
+    const int32_t GetKalmanFilterIndex() const;
 
 private:
     std::deque<Data> data_history_;
-    KalmanFilter kf_;
+    int32_t kf_index_;     /* index in KalmanFilterBatch of the tracker */
     int32_t id_;
     int32_t cnt_detected_;
     int32_t cnt_undetected_;
@@ -75,6 +71,7 @@ private:
 class TrackerDeepSort {
 private:
     static constexpr float kCostMax = 1.0F;
+    static constexpr int32_t kCellSizeStep = 16;
 
 public:
     TrackerDeepSort(int32_t threshold_frame_to_delete = 2);
@@ -87,12 +84,19 @@ public:
 
 private:
     float CalculateCost(TrackDeepSort& track, const BoundingBox& det_bbox, const std::vector<float>& det_feature);
+    void UpdateSpatialHash(const std::vector<BoundingBox>& det_list, int32_t det_size_mean);
 
 private:
     std::vector<TrackDeepSort> track_list_;
     int32_t track_sequence_num_;
 
     int32_t threshold_frame_to_delete_;
+
+    KalmanFilterBatch kf_batch_;    /* Kalman filters of all tracks */
+
+    /* to find nearby det for each track */
+    SpatialHash spatial_hash_;
+    int32_t cell_size_;
 };
 
 #endif
@@ -32,6 +32,8 @@ limitations under the License.
 #include "common_helper.h"
 #include "common_helper_cv.h"
 #include "inference_helper.h"
+#include "mapped_file.h"
+#include "result_store.h"
 #include "detection_engine.h"
 
 /*** Macro ***/
@@ -121,9 +123,22 @@ int32_t DetectionEngine::Initialize(const std::string& work_dir, const int32_t n
         return kRetErr;
     }
 
+    model_filename_ = model_filename;
     return kRetOk;
 }
 
+uint64_t DetectionEngine::CalculateConfigHash() const
+{
+    MappedFile model;
+    uint64_t hash = model.Open(model_filename_) ? model.GetHash() : ResultStore::CalculateHash(model_filename_);
+    for (const auto& label : label_list_) {
+        hash = ResultStore::CalculateHash(label + "\n", hash);
+    }
+    hash = ResultStore::CalculateHash(&threshold_box_confidence_, sizeof(threshold_box_confidence_), hash);
+    hash = ResultStore::CalculateHash(&threshold_class_confidence_, sizeof(threshold_class_confidence_), hash);
+    return hash;
+}
+
 int32_t DetectionEngine::Finalize()
 {
     if (!inference_helper_) {
@@ -236,12 +251,13 @@ int32_t DetectionEngine::Process(const cv::Mat& original_mat, Result& result)
 
     /* NMS */
     std::vector<BoundingBox> bbox_nms_list;
-    BoundingBoxUtils::Nms(bbox_list, bbox_nms_list, threshold_nms_iou_);
+    Nms(bbox_list, bbox_nms_list);
 
     const auto& t_post_process1 = std::chrono::steady_clock::now();
 
     /* Return the results */
     result.bbox_list = bbox_nms_list;
+    result.bbox_list_raw = std::move(bbox_list);
     result.crop.x = (std::max)(0, crop_x);
     result.crop.y = (std::max)(0, crop_y);
     result.crop.w = (std::min)(crop_w, original_mat.cols - result.crop.x);
@@ -254,6 +270,13 @@ int32_t DetectionEngine::Process(const cv::Mat& original_mat, Result& result)
 }
 
 
+void DetectionEngine::Nms(std::vector<BoundingBox>& bbox_list_raw, std::vector<BoundingBox>& bbox_list) const
+{
+    bbox_list.clear();
+    BoundingBoxUtils::Nms(bbox_list_raw, bbox_list, threshold_nms_iou_);
+}
+
+
 int32_t DetectionEngine::ReadLabel(const std::string& filename, std::vector<std::string>& label_list)
 {
     std::ifstream ifs(filename);
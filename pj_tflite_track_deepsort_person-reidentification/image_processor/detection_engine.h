@@ -40,6 +40,7 @@ public:
 
     typedef struct Result_ {
         std::vector<BoundingBox> bbox_list;
+        std::vector<BoundingBox> bbox_list_raw;     /* before NMS (sorted by score) */
         struct crop_ {
             int32_t x;
             int32_t y;
@@ -65,6 +66,12 @@ public:
     int32_t Finalize(void);
     int32_t Process(const cv::Mat& original_mat, Result& result);
 
+    /* For results read from the result store. NMS is the last step of Process, so it can be done again with another threshold */
+    void Nms(std::vector<BoundingBox>& bbox_list_raw, std::vector<BoundingBox>& bbox_list) const;
+    int32_t GetLabelNum() const { return static_cast<int32_t>(label_list_.size()); }
+    std::string GetLabel(int32_t class_id) const { return (class_id >= 0 && class_id < GetLabelNum()) ? label_list_[class_id] : ""; }
+    uint64_t CalculateConfigHash() const;   /* of what affects bbox_list_raw (model, labels and thresholds except NMS). reads the whole model */
+
 private:
     int32_t ReadLabel(const std::string& filename, std::vector<std::string>& label_list);
     void GetBoundingBox(const float* data, float scale_x, float  scale_y, int32_t grid_w, int32_t grid_h, std::vector<BoundingBox>& bbox_list);
@@ -73,6 +80,7 @@ private:
     std::unique_ptr<InferenceHelper> inference_helper_;
     std::vector<InputTensorInfo> input_tensor_info_list_;
     std::vector<OutputTensorInfo> output_tensor_info_list_;
+    std::string model_filename_;
     std::vector<std::string> label_list_;
 
     float threshold_box_confidence_;
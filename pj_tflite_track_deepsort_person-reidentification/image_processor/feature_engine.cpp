@@ -32,6 +32,8 @@ limitations under the License.
 #include "common_helper.h"
 #include "common_helper_cv.h"
 #include "inference_helper.h"
+#include "mapped_file.h"
+#include "result_store.h"
 #include "feature_engine.h"
 
 /*** Macro ***/
@@ -92,9 +94,16 @@ int32_t FeatureEngine::Initialize(const std::string& work_dir, const int32_t num
         return kRetErr;
     }
 
+    model_filename_ = model_filename;
     return kRetOk;
 }
 
+uint64_t FeatureEngine::CalculateConfigHash() const
+{
+    MappedFile model;
+    return model.Open(model_filename_) ? model.GetHash() : ResultStore::CalculateHash(model_filename_);
+}
+
 int32_t FeatureEngine::Finalize()
 {
     if (!inference_helper_) {
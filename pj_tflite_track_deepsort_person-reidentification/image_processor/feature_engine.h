@@ -53,12 +53,13 @@ public:
     int32_t Initialize(const std::string& work_dir, const int32_t num_threads);
     int32_t Finalize(void);
     int32_t Process(const cv::Mat& original_mat, const BoundingBox& bbox, Result& result);
-
+    uint64_t CalculateConfigHash() const;   /* of the model (for the result store). reads the whole model */
 
 private:
     std::unique_ptr<InferenceHelper> inference_helper_;
     std::vector<InputTensorInfo> input_tensor_info_list_;
     std::vector<OutputTensorInfo> output_tensor_info_list_;
+    std::string model_filename_;
 };
 
 #endif
@@ -25,6 +25,7 @@ limitations under the License.
 #include <chrono>
 #include <fstream>
 #include <memory>
+#include <future>
 
 /* for OpenCV */
 #include <opencv2/opencv.hpp>
@@ -32,10 +33,16 @@ limitations under the License.
 /* for My modules */
 #include "common_helper.h"
 #include "common_helper_cv.h"
+#include "engine_initializer.h"
 #include "bounding_box.h"
 #include "detection_engine.h"
 #include "feature_engine.h"
 #include "tracker_deepsort.h"
+#include "overlay_renderer.h"
+#include "qos_controller.h"
+#include "metrics.h"
+#include "alloc_profiler.h"
+#include "result_store.h"
 #include "image_processor.h"
 
 /*** Macro ***/
@@ -44,6 +51,43 @@ limitations under the License.
 #define PRINT_E(...) COMMON_HELPER_PRINT_E(TAG, __VA_ARGS__)
 
 #define USE_DEEPSORT
+#define USE_REID_GALLERY_FILE   /* share re-identification gallery b/w runs (and streams) */
+#define REID_GALLERY_FILENAME "reid_gallery.bin"
+#define USE_RESULT_STORE        /* store outputs of engines for each frame of a video file. re-runs skip inference (only NMS, tracker and drawing run) */
+
+/* QoS. Work is dropped in this order when a frame takes longer than kFrameDeadline */
+static constexpr double kFrameDeadline = 0.0;     /* [msec] (e.g. 33.3 for 30 fps camera). 0 = QoS off */
+enum {
+    kQosLevelFull = 0,
+    kQosLevelReduceFeature,         /* refresh feature of matched objects every few frames */
+    kQosLevelReduceFeatureMore,     /* refresh feature of matched objects rarely */
+    kQosLevelReduceDetection,       /* run detection every other frame (tracker predicts position in between) */
+    kQosLevelSkipFrame,             /* process every third frame (only drawing for the others) */
+    kQosLevelNum,
+};
+static constexpr int32_t kFeatureRefreshInterval[kQosLevelNum] = { 1, 3, 10, 10, 10 };
+static constexpr float kIouToSkipFeature = 0.7F;  /* det overlapping a tracked object more than this is regarded as matched */
+enum {
+    kStageDetection = 0,
+    kStageFeature,
+    kStageTracker,
+    kStageDraw,
+};
+
+/* Record in the result store: [crop x, y, w, h, bbox num] [StoredBbox x bbox num] [feature of each bbox] */
+/* bbox is before NMS. feature_length = 0 when the feature was not calculated (not a person, dropped by NMS or QoS) */
+typedef struct {
+    int32_t class_id;
+    float   score;
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+    int32_t feature_length;
+} StoredBbox;
+static constexpr int32_t kStoredHeaderNum = 5;
+
+static constexpr bool kWarmUpAtInitialize = true;     /* run inference once at initialization so that the first frame costs the same as others */
 
 /*** Global variable ***/
 std::unique_ptr<DetectionEngine> s_det_engine;
@@ -53,9 +97,124 @@ TrackerDeepSort s_tracker(200);
 #else
 TrackerDeepSort s_tracker(2);
 #endif
+std::string s_gallery_filename;
+OverlayRenderer s_renderer;
+QosController s_qos(kQosLevelNum, kFrameDeadline);
+int32_t s_frame_cnt = 0;
+ResultStore s_result_store;
+std::vector<uint8_t> s_result_buffer;
+
+/* Metrics (registered once, and updated lock-free for each frame) */
+static Metrics::Histogram& s_metrics_time_pre_process = Metrics::GetHistogram("stage_latency_msec", "stage", "pre_process", "Processing time of each stage per frame");
+static Metrics::Histogram& s_metrics_time_inference = Metrics::GetHistogram("stage_latency_msec", "stage", "inference");
+static Metrics::Histogram& s_metrics_time_post_process = Metrics::GetHistogram("stage_latency_msec", "stage", "post_process");
+static Metrics::Histogram& s_metrics_time_tracker = Metrics::GetHistogram("stage_latency_msec", "stage", "tracker");
+static Metrics::Histogram& s_metrics_time_draw = Metrics::GetHistogram("stage_latency_msec", "stage", "draw");
+static Metrics::Counter& s_metrics_frame_processed = Metrics::GetCounter("frames_total", "result", "processed", "Number of frames");
+static Metrics::Counter& s_metrics_frame_skipped = Metrics::GetCounter("frames_total", "result", "skipped");
+static Metrics::Counter& s_metrics_detection_skipped = Metrics::GetCounter("detection_skipped_total", "", "", "Number of frames where detection is skipped by QoS");
+static Metrics::Counter& s_metrics_feature_dropped = Metrics::GetCounter("feature_dropped_total", "", "", "Number of feature extractions dropped by QoS");
+static Metrics::Counter& s_metrics_inference_det = Metrics::GetCounter("inference_total", "engine", "detection", "Number of inference calls");
+static Metrics::Counter& s_metrics_inference_feature = Metrics::GetCounter("inference_total", "engine", "feature");
+static Metrics::Gauge& s_metrics_qos_level = Metrics::GetGauge("qos_level", "", "", "Current QoS level (0 = full)");
+static Metrics::Gauge& s_metrics_track_num = Metrics::GetGauge("track_num", "", "", "Number of objects being displayed as tracked");
+static Metrics::Counter& s_metrics_result_store_hit = Metrics::GetCounter("result_store_total", "result", "hit", "Number of frames looked up in the result store");
+static Metrics::Counter& s_metrics_result_store_miss = Metrics::GetCounter("result_store_total", "result", "miss");
+
+/* Heap allocation is counted for each stage (only when built with COMMON_HELPER_WITH_ALLOC_PROFILER=on) */
+static const int32_t s_alloc_stage_detection = AllocProfiler::RegisterStage("detection");
+static const int32_t s_alloc_stage_feature = AllocProfiler::RegisterStage("feature");
+static const int32_t s_alloc_stage_tracker = AllocProfiler::RegisterStage("tracker");
+static const int32_t s_alloc_stage_draw = AllocProfiler::RegisterStage("draw");
 
 /*** Function ***/
-static void DrawFps(cv::Mat& mat, double time_inference_det, double time_inference_feature, int32_t num_feature, cv::Point pos, double font_scale, int32_t thickness, cv::Scalar color_front, cv::Scalar color_back, bool is_text_on_rect = true)
+static double GetTimeMsec(const std::chrono::steady_clock::time_point& t0, const std::chrono::steady_clock::time_point& t1)
+{
+    return static_cast<std::chrono::duration<double>>(t1 - t0).count() * 1000.0;
+}
+
+static bool IsMatchedToConfirmedTrack(const BoundingBox& bbox, std::vector<TrackDeepSort>& track_list, int32_t& id)
+{
+    for (auto& track : track_list) {
+        if (track.GetDetectedCount() < 2) continue;
+        const auto& track_bbox = track.GetLatestData().bbox;
+        if (track_bbox.score == 0) continue;    /* not detected at the previous frame */
+        if (BoundingBoxUtils::CalculateIoU(track_bbox, bbox) > kIouToSkipFeature) {
+            id = track.GetId();
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool LoadResult(int64_t frame_index, DetectionEngine::Result& det_result, std::vector<std::vector<float>>& feature_raw_list)
+{
+    const uint8_t* data;
+    uint32_t size;
+    if (!s_result_store.Find(frame_index, data, size)) return false;
+
+    int32_t header[kStoredHeaderNum];
+    if (size < sizeof(header)) return false;
+    std::memcpy(header, data, sizeof(header));
+    const int32_t num = header[4];
+    size_t offset = sizeof(header);
+    if (num < 0 || offset + sizeof(StoredBbox) * num > size) return false;
+    std::vector<StoredBbox> stored_bbox_list(num);
+    std::memcpy(stored_bbox_list.data(), data + offset, sizeof(StoredBbox) * num);
+    offset += sizeof(StoredBbox) * num;
+
+    det_result.crop.x = header[0];
+    det_result.crop.y = header[1];
+    det_result.crop.w = header[2];
+    det_result.crop.h = header[3];
+    det_result.bbox_list_raw.clear();
+    feature_raw_list.assign(num, std::vector<float>());
+    for (int32_t i = 0; i < num; i++) {
+        const StoredBbox& stored_bbox = stored_bbox_list[i];
+        if (stored_bbox.class_id < 0 || stored_bbox.class_id >= s_det_engine->GetLabelNum()) return false;
+        const size_t feature_size = sizeof(float) * (std::max)(0, stored_bbox.feature_length);
+        if (offset + feature_size > size) return false;
+        feature_raw_list[i].resize(feature_size / sizeof(float));
+        if (feature_size > 0) std::memcpy(feature_raw_list[i].data(), data + offset, feature_size);
+        offset += feature_size;
+        det_result.bbox_list_raw.push_back(BoundingBox(stored_bbox.class_id, s_det_engine->GetLabel(stored_bbox.class_id), stored_bbox.score, stored_bbox.x, stored_bbox.y, stored_bbox.w, stored_bbox.h));
+    }
+    return true;
+}
+
+static void SaveResult(int64_t frame_index, const DetectionEngine::Result& det_result, const std::vector<std::vector<float>>& feature_raw_list)
+{
+    const int32_t num = static_cast<int32_t>(det_result.bbox_list_raw.size());
+    const int32_t header[kStoredHeaderNum] = { det_result.crop.x, det_result.crop.y, det_result.crop.w, det_result.crop.h, num };
+    s_result_buffer.resize(sizeof(header) + sizeof(StoredBbox) * num);
+    std::memcpy(s_result_buffer.data(), header, sizeof(header));
+    for (int32_t i = 0; i < num; i++) {
+        const BoundingBox& bbox = det_result.bbox_list_raw[i];
+        const StoredBbox stored_bbox = { bbox.class_id, bbox.score, bbox.x, bbox.y, bbox.w, bbox.h, static_cast<int32_t>(feature_raw_list[i].size()) };
+        std::memcpy(s_result_buffer.data() + sizeof(header) + sizeof(StoredBbox) * i, &stored_bbox, sizeof(stored_bbox));
+    }
+    for (const auto& feature : feature_raw_list) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(feature.data());
+        s_result_buffer.insert(s_result_buffer.end(), p, p + sizeof(float) * feature.size());
+    }
+    if (s_result_store.Append(frame_index, s_result_buffer.data(), static_cast<uint32_t>(s_result_buffer.size())) != ResultStore::kRetOk) {
+        PRINT_E("Failed to store the result of frame %lld\n", static_cast<long long>(frame_index));
+    }
+}
+
+static std::vector<float>* FindFeatureRaw(const BoundingBox& bbox, const std::vector<BoundingBox>& bbox_list_raw, std::vector<std::vector<float>>& feature_raw_list)
+{
+    /* bbox after NMS is a copy of one in the raw list */
+    for (size_t i = 0; i < bbox_list_raw.size() && i < feature_raw_list.size(); i++) {
+        const BoundingBox& bbox_raw = bbox_list_raw[i];
+        if (bbox_raw.class_id == bbox.class_id && bbox_raw.score == bbox.score && bbox_raw.x == bbox.x && bbox_raw.y == bbox.y && bbox_raw.w == bbox.w && bbox_raw.h == bbox.h) {
+            return &feature_raw_list[i];
+        }
+    }
+    return nullptr;
+}
+
+static void DrawFps(OverlayRenderer& renderer, double time_inference_det, double time_inference_feature, int32_t num_feature, cv::Point pos, double font_scale, int32_t thickness, cv::Scalar color_front, cv::Scalar color_back, bool is_text_on_rect = true)
 {
     char text[128];
     static auto time_previous = std::chrono::steady_clock::now();
@@ -63,7 +222,7 @@ static void DrawFps(cv::Mat& mat, double time_inference_det, double time_inferen
     double fps = 1e9 / (time_now - time_previous).count();
     time_previous = time_now;
     snprintf(text, sizeof(text), "FPS: %4.1f, Inference: DET: %4.1f[ms], FEATURE:%3d x %4.1f[ms]", fps, time_inference_det, num_feature, time_inference_feature / num_feature);
-    CommonHelper::DrawText(mat, text, cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
+    renderer.AddText(text, pos, font_scale, thickness, color_front, color_back, is_text_on_rect, false);
 }
 
 static cv::Scalar GetColorForId(int32_t id)
@@ -86,20 +245,54 @@ int32_t ImageProcessor::Initialize(const ImageProcessor::InputParam& input_param
         return -1;
     }
 
-    s_det_engine.reset(new DetectionEngine(0.4f, 0.2f, 0.5f));
-    if (s_det_engine->Initialize(input_param.work_dir, input_param.num_threads) != DetectionEngine::kRetOk) {
+    /* Initialize engines concurrently */
+    const cv::Mat mat_dummy = cv::Mat(480, 640, CV_8UC3, cv::Scalar(128, 128, 128));
+    auto future_det = CommonHelper::InitializeEngineAsync("DetectionEngine", kWarmUpAtInitialize, [&]() {
+        s_det_engine.reset(new DetectionEngine(0.4f, 0.2f, 0.5f));
+        return s_det_engine->Initialize(input_param.work_dir, input_param.num_threads);
+    }, [&]() {
+        DetectionEngine::Result det_result;
+        return s_det_engine->Process(mat_dummy, det_result);
+    });
+    auto future_feature = CommonHelper::InitializeEngineAsync("FeatureEngine", kWarmUpAtInitialize, [&]() {
+        s_feature_engine.reset(new FeatureEngine());
+        return s_feature_engine->Initialize(input_param.work_dir, input_param.num_threads);
+    }, [&]() {
+        FeatureEngine::Result feature_result;
+        return s_feature_engine->Process(mat_dummy, BoundingBox(0, "", 1.0f, 0, 0, 128, 256), feature_result);
+    });
+    bool is_det_ok = future_det.get();
+    bool is_feature_ok = future_feature.get();
+    if (!is_det_ok || !is_feature_ok) {
         s_det_engine->Finalize();
         s_det_engine.reset();
-        return -1;
-    }
-
-    s_feature_engine.reset(new FeatureEngine());
-    if (s_feature_engine->Initialize(input_param.work_dir, input_param.num_threads) != FeatureEngine::kRetOk) {
         s_feature_engine->Finalize();
         s_feature_engine.reset();
         return -1;
     }
-    
+
+#ifdef USE_REID_GALLERY_FILE
+    s_gallery_filename = std::string(input_param.work_dir) + "/" + REID_GALLERY_FILENAME;
+    if (s_tracker.LoadGallery(s_gallery_filename) != 0) {
+        PRINT("Start with empty gallery\n");
+    }
+#endif
+
+#ifdef USE_RESULT_STORE
+    /* <work_dir>/<video name>.<hash of video path>.results. Stored results are discarded when a model, the labels or a detection threshold changes */
+    const std::string source_name = input_param.source_name;
+    if (!source_name.empty()) {
+        const uint64_t config_hash_det = s_det_engine->CalculateConfigHash();
+        const uint64_t key = ResultStore::CalculateHash(&config_hash_det, sizeof(config_hash_det), s_feature_engine->CalculateConfigHash());
+        char source_hash[32];
+        snprintf(source_hash, sizeof(source_hash), "%016llx", static_cast<unsigned long long>(ResultStore::CalculateHash(source_name)));
+        const std::string filename = std::string(input_param.work_dir) + "/" + source_name.substr(source_name.find_last_of("/\\") + 1) + "." + source_hash + ".results";
+        if (s_result_store.Open(filename, key) == ResultStore::kRetOk) {
+            PRINT("Resume from frame %lld (inference is skipped until then)\n", static_cast<long long>(s_result_store.GetResumeIndex()));
+        }
+    }
+#endif
+
     return 0;
 }
 
@@ -118,6 +311,13 @@ int32_t ImageProcessor::Finalize(void)
         return -1;
     }
 
+#ifdef USE_REID_GALLERY_FILE
+    if (s_tracker.SaveGallery(s_gallery_filename) != 0) {
+        PRINT_E("Failed to save gallery\n");
+    }
+#endif
+    s_result_store.Close();
+
     return 0;
 }
 
@@ -131,39 +331,92 @@ int32_t ImageProcessor::Command(int32_t cmd)
 
     switch (cmd) {
     case 0:
+        s_renderer.SetMode(OverlayRenderer::kModeDisplay);
+        break;
+    case 1:
+        s_renderer.SetMode(OverlayRenderer::kModeNone);    /* skip drawing when nobody watches */
+        break;
     default:
         PRINT_E("command(%d) is not supported\n", cmd);
         return -1;
     }
+    return 0;
 }
 
 
-int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
+int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result, int64_t frame_index)
 {
     if (!s_det_engine || !s_feature_engine) {
         PRINT_E("Not initialized\n");
         return -1;
     }
 
-    /* Detection */
+    /* Decide what to drop at this frame */
+    s_frame_cnt++;
+    const int32_t qos_level = s_qos.GetLevel();
+    const bool is_frame_skipped = (qos_level >= kQosLevelSkipFrame) && (s_frame_cnt % 3 != 0);
+    const bool is_detection_skipped = is_frame_skipped || ((qos_level == kQosLevelReduceDetection) && (s_frame_cnt % 2 != 0));
+
+    /* Detection (read from the result store when this frame was processed at the previous run) */
+    AllocProfiler::Scope alloc_scope(s_alloc_stage_detection);
+    const auto& t_det0 = std::chrono::steady_clock::now();
     DetectionEngine::Result det_result;
-    if (s_det_engine->Process(mat, det_result) != DetectionEngine::kRetOk) {
-        return -1;
+    std::vector<std::vector<float>> feature_raw_list;   /* for each bbox in bbox_list_raw. empty = not calculated */
+    const bool is_result_stored = !is_detection_skipped && frame_index >= 0 && s_result_store.IsOpened();
+    bool is_result_reused = false;
+    bool is_result_updated = false;
+    if (!is_detection_skipped) {
+        if (is_result_stored && LoadResult(frame_index, det_result, feature_raw_list)) {
+            std::vector<BoundingBox> bbox_list_sorted = det_result.bbox_list_raw;   /* NMS sorts the list. keep the order of feature_raw_list */
+            s_det_engine->Nms(bbox_list_sorted, det_result.bbox_list);
+            is_result_reused = true;
+            s_metrics_result_store_hit.Add();
+        } else {
+            if (s_det_engine->Process(mat, det_result) != DetectionEngine::kRetOk) {
+                return -1;
+            }
+            s_metrics_inference_det.Add();
+            feature_raw_list.resize(det_result.bbox_list_raw.size());
+            is_result_updated = true;
+            if (is_result_stored) s_metrics_result_store_miss.Add();
+        }
     }
+    const auto& t_det1 = std::chrono::steady_clock::now();
 
     /* Extract feature for the detected objects */
+    AllocProfiler::SetStage(s_alloc_stage_feature);
     std::vector<std::vector<float>> feature_list;
     double time_pre_process_feature = 0;   // [msec]
     double time_inference_feature = 0;    // [msec]
     double time_post_process_feature = 0;  // [msec]
+    int32_t num_dropped_feature = 0;
     for (const auto& bbox : det_result.bbox_list) {
 #ifdef USE_DEEPSORT
         if (bbox.class_id == 0) {   /* Calculate face feature for person only */
+            /* Use the stored feature */
+            std::vector<float>* feature_raw = FindFeatureRaw(bbox, det_result.bbox_list_raw, feature_raw_list);
+            if (feature_raw && !feature_raw->empty()) {
+                feature_list.push_back(*feature_raw);
+                continue;
+            }
+            /* Re-use the feature of the tracked object if it's obviously the same object (refresh sometimes) */
+            int32_t id = 0;
+            if (kFeatureRefreshInterval[qos_level] > 1 && IsMatchedToConfirmedTrack(bbox, s_tracker.GetTrackList(), id)
+                && (s_frame_cnt + id) % kFeatureRefreshInterval[qos_level] != 0) {
+                feature_list.push_back(std::vector<float>());
+                num_dropped_feature++;
+                continue;
+            }
             FeatureEngine::Result feature_result;
             if (s_feature_engine->Process(mat, bbox, feature_result) != DetectionEngine::kRetOk) {
                 return -1;
             }
             feature_list.push_back(feature_result.feature);
+            if (feature_raw) {
+                *feature_raw = feature_result.feature;
+                is_result_updated = true;
+            }
+            s_metrics_inference_feature.Add();
             time_pre_process_feature += feature_result.time_pre_process;
             time_inference_feature += feature_result.time_inference;
             time_post_process_feature += feature_result.time_post_process;
@@ -174,45 +427,87 @@ int32_t ImageProcessor::Process(cv::Mat& mat, ImageProcessor::Result& result)
         feature_list.push_back(std::vector<float>());   /* the length of feature is 0. so it's not used in tracker (DeepSORT) */
 #endif
     }
+    if (is_result_stored && is_result_updated) SaveResult(frame_index, det_result, feature_raw_list);
+    const auto& t_feature1 = std::chrono::steady_clock::now();
+
+    /* Update tracker (the tracker predicts position when detection is skipped) */
+    AllocProfiler::SetStage(s_alloc_stage_tracker);
+    if (!is_frame_skipped) {
+        s_tracker.Update(det_result.bbox_list, feature_list);
+    }
+    const auto& t_tracker1 = std::chrono::steady_clock::now();
 
     /* Display target area  */
-    cv::rectangle(mat, cv::Rect(det_result.crop.x, det_result.crop.y, det_result.crop.w, det_result.crop.h), CommonHelper::CreateCvColor(0, 0, 0), 2);
+    AllocProfiler::SetStage(s_alloc_stage_draw);
+    if (!is_detection_skipped) {
+        s_renderer.AddRect(cv::Rect(det_result.crop.x, det_result.crop.y, det_result.crop.w, det_result.crop.h), CommonHelper::CreateCvColor(0, 0, 0), 2);
+    }
 
     /* Display detection result (black rectangle) */
     int32_t num_det = 0;
     for (const auto& bbox : det_result.bbox_list) {
-        cv::rectangle(mat, cv::Rect(bbox.x, bbox.y, bbox.w, bbox.h), CommonHelper::CreateCvColor(0, 0, 0), 1);
+        s_renderer.AddRect(cv::Rect(bbox.x, bbox.y, bbox.w, bbox.h), CommonHelper::CreateCvColor(0, 0, 0), 1);
         num_det++;
     }
 
     /* Display tracking result  */
-    s_tracker.Update(det_result.bbox_list, feature_list);
     int32_t num_track = 0;
     auto& track_list = s_tracker.GetTrackList();
     for (auto& track : track_list) {
         if (track.GetDetectedCount() < 2) continue; /* To decrease FP */
         const auto& bbox = track.GetLatestData().bbox;
-        if (bbox.score == 0) continue;  /* the oboject is in tracker, but not detected at the current frame */
+        if (bbox.score == 0 && (!is_detection_skipped || track.GetUndetectedCount() > 1)) continue;  /* the oboject is in tracker, but not detected at the current frame (show predicted position if detection is skipped) */
+        num_track++;
+        if (!s_renderer.IsEnabled()) continue;
         cv::Scalar color = GetColorForId(track.GetId());
-        cv::rectangle(mat, cv::Rect(bbox.x, bbox.y, bbox.w, bbox.h), color, 2);
-        CommonHelper::DrawText(mat, std::to_string(track.GetId()) + ": " + bbox.label, cv::Point(bbox.x, bbox.y - 13), 0.35, 1, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(220, 220, 220));
+        s_renderer.AddRect(cv::Rect(bbox.x, bbox.y, bbox.w, bbox.h), color, 2);
+        s_renderer.AddText(std::to_string(track.GetId()) + ": " + bbox.label, cv::Point(bbox.x, bbox.y - 13), 0.35, 1, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(220, 220, 220));
 
         auto& track_history = track.GetDataHistory();
-        for (size_t i = 1; i < track_history.size(); i++) {
-            cv::Point p0(track_history[i].bbox.x + track_history[i].bbox.w / 2, track_history[i].bbox.y + track_history[i].bbox.h);
-            cv::Point p1(track_history[i - 1].bbox.x + track_history[i - 1].bbox.w / 2, track_history[i - 1].bbox.y + track_history[i - 1].bbox.h);
-            cv::line(mat, p0, p1, color);
+        std::vector<cv::Point> trajectory;
+        trajectory.reserve(track_history.size());
+        for (const auto& data : track_history) {
+            trajectory.push_back(cv::Point(data.bbox.x + data.bbox.w / 2, data.bbox.y + data.bbox.h));
         }
-        num_track++;
+        s_renderer.AddPolyline(trajectory, color);
+    }
+    s_renderer.AddText("DET: " + std::to_string(num_det) + ", TRACK: " + std::to_string(num_track), cv::Point(0, 20), 0.7, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(220, 220, 220), true, false);
+    if (qos_level > kQosLevelFull) {
+        s_renderer.AddText("QoS LEVEL: " + std::to_string(qos_level), cv::Point(0, 45), 0.7, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(220, 220, 220), true, true);
     }
-    CommonHelper::DrawText(mat, "DET: " + std::to_string(num_det) + ", TRACK: " + std::to_string(num_track), cv::Point(0, 20), 0.7, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(220, 220, 220));
 
-    DrawFps(mat, det_result.time_inference, time_inference_feature, static_cast<int32_t>(feature_list.size()), cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
+    DrawFps(s_renderer, det_result.time_inference, time_inference_feature, static_cast<int32_t>(feature_list.size()), cv::Point(0, 0), 0.5, 2, CommonHelper::CreateCvColor(0, 0, 0), CommonHelper::CreateCvColor(180, 180, 180), true);
+    s_renderer.Render(mat);
+    const auto& t_draw1 = std::chrono::steady_clock::now();
+
+    /* Feedback processing time to QoS controller (skipped stages are counted as 0 to estimate average time per frame) */
+    s_qos.Feedback(kStageDetection, GetTimeMsec(t_det0, t_det1));
+    s_qos.Feedback(kStageFeature, GetTimeMsec(t_det1, t_feature1));
+    s_qos.Feedback(kStageTracker, GetTimeMsec(t_feature1, t_tracker1));
+    s_qos.Feedback(kStageDraw, GetTimeMsec(t_tracker1, t_draw1));
+    s_qos.Update();
+
+    /* Update metrics */
+    s_metrics_time_pre_process.Observe(det_result.time_pre_process + time_pre_process_feature);
+    s_metrics_time_inference.Observe(det_result.time_inference + time_inference_feature);
+    s_metrics_time_post_process.Observe(det_result.time_post_process + time_post_process_feature);
+    s_metrics_time_tracker.Observe(GetTimeMsec(t_feature1, t_tracker1));
+    s_metrics_time_draw.Observe(GetTimeMsec(t_tracker1, t_draw1));
+    (is_frame_skipped ? s_metrics_frame_skipped : s_metrics_frame_processed).Add();
+    if (is_detection_skipped) s_metrics_detection_skipped.Add();
+    s_metrics_feature_dropped.Add(num_dropped_feature);
+    s_metrics_qos_level.Set(qos_level);
+    s_metrics_track_num.Set(num_track);
 
     /* Return the results */
     result.time_pre_process = det_result.time_pre_process + time_pre_process_feature;
     result.time_inference = det_result.time_inference + time_inference_feature;
     result.time_post_process = det_result.time_post_process + time_post_process_feature;
+    result.qos_level = qos_level;
+    result.num_dropped_feature = num_dropped_feature;
+    result.is_detection_skipped = is_detection_skipped;
+    result.is_frame_skipped = is_frame_skipped;
+    result.is_result_reused = is_result_reused;
 
     return 0;
 }
@@ -34,16 +34,22 @@ namespace ImageProcessor
 typedef struct {
     char     work_dir[256];
     int32_t  num_threads;
+    char     source_name[256];      // video file. outputs of engines are stored for each frame to resume (empty = not stored)
 } InputParam;
 
 typedef struct {
     double time_pre_process;   // [msec]
     double time_inference;    // [msec]
     double time_post_process;  // [msec]
+    int32_t qos_level;              // 0 = full processing
+    int32_t num_dropped_feature;    // feature extraction skipped at this frame
+    bool    is_detection_skipped;
+    bool    is_frame_skipped;       // only drawing is done at this frame
+    bool    is_result_reused;       // detection and feature are read from the result store
 } Result;
 
 int32_t Initialize(const InputParam& input_param);
-int32_t Process(cv::Mat& mat, Result& result);
+int32_t Process(cv::Mat& mat, Result& result, int64_t frame_index = -1);    // frame_index: position in source_name
 int32_t Finalize(void);
 int32_t Command(int32_t cmd);
 
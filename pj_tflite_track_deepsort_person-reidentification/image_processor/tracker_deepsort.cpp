@@ -22,15 +22,17 @@ limitations under the License.
 #include <array>
 #include <memory>
 #include <numeric>
+#include <algorithm>
 
 /* for My modules */
 #include "common_helper.h"
 #include "bounding_box.h"
 #include "tracker_deepsort.h"
-#include "hungarian_algorithm.h"
+#include "spatial_hash.h"
+#include "sparse_assignment.h"
 
 
-TrackDeepSort::TrackDeepSort(const int32_t id, const BoundingBox& bbox_det, const std::vector<float>& feature)
+TrackDeepSort::TrackDeepSort(const int32_t id, const BoundingBox& bbox_det, const std::vector<float>& feature, const int32_t kf_index)
 {
     Data data;
     data.bbox = bbox_det;
@@ -38,7 +40,7 @@ TrackDeepSort::TrackDeepSort(const int32_t id, const BoundingBox& bbox_det, cons
     data.feature = feature;
     data_history_.push_back(data);
 
-    kf_ = CreateKalmanFilter_UniformLinearMotion(bbox_det);
+    kf_index_ = kf_index;
 
     cnt_detected_ = 1;
     cnt_undetected_ = 0;
@@ -49,12 +51,11 @@ TrackDeepSort::~TrackDeepSort()
 {
 }
 
-BoundingBox TrackDeepSort::Predict()
+BoundingBox TrackDeepSort::Predict(const KalmanFilterBatch& kf_batch)
 {
-    kf_.Predict();
-
+    /* kf_batch.Predict must be called before */
     BoundingBox bbox = GetLatestBoundingBox();
-    BoundingBox bbox_pred = KalmanStatus2Bbox(kf_.X);   // w, y, w, h only
+    BoundingBox bbox_pred = kf_batch.GetBoundingBox(kf_index_);   // w, y, w, h only
     bbox.w = bbox_pred.w;
     bbox.h = bbox_pred.h;
     bbox.x = bbox_pred.x;
@@ -72,9 +73,9 @@ BoundingBox TrackDeepSort::Predict()
     return bbox;
 }
 
-void TrackDeepSort::Update(const BoundingBox& bbox_det)
+void TrackDeepSort::Update(const BoundingBox& bbox_det, KalmanFilterBatch& kf_batch)
 {
-    kf_.Update(Bbox2KalmanObserved(bbox_det));
+    kf_batch.Update(kf_index_, bbox_det);
 
     Data data;
     data.bbox = bbox_det;
@@ -82,7 +83,7 @@ void TrackDeepSort::Update(const BoundingBox& bbox_det)
 
     BoundingBox& bbox = data_history_.back().bbox;
     BoundingBox& bbox_raw = data_history_.back().bbox_raw;
-    BoundingBox bbox_est = KalmanStatus2Bbox(kf_.X);   // w, y, w, h only
+    BoundingBox bbox_est = kf_batch.GetBoundingBox(kf_index_);   // w, y, w, h only
     bbox_raw = bbox_det;
     bbox = bbox_det;
     bbox.w = bbox_est.w;
@@ -129,113 +130,21 @@ const int32_t TrackDeepSort::GetDetectedCount() const
     return cnt_detected_;
 }
 
-
-static constexpr int32_t kNumObserve = 4;   /* (cx, cy, area, aspect) */
-static constexpr int32_t kNumStatus = 7;    /* (cx, cy, area, aspect, vx, vy, vz)   (v = speed)*/
-KalmanFilter TrackDeepSort::CreateKalmanFilter_UniformLinearMotion(const BoundingBox& bbox_start)
-{
-    /*** X(t) = F * X(t-1) + w(t) ***/
-    /* Matrix to calculate X(t) from X(t-1). assume uniform motion: x(t) = x(t-1) + vt, v(t) = v(t-1) */
-    const SimpleMatrix F(kNumStatus, kNumStatus, {
-        1, 0, 0, 0, 1, 0, 0,
-        0, 1, 0, 0, 0, 1, 0,
-        0, 0, 1, 0, 0, 0, 1,
-        0, 0, 0, 1, 0, 0, 0,
-        0, 0, 0, 0, 1, 0, 0,
-        0, 0, 0, 0, 0, 1, 0,
-        0, 0, 0, 0, 0, 0, 1,
-        });
-
-
-    /* w(t), = noise, follows Q */
-    const SimpleMatrix Q(kNumStatus, kNumStatus, {
-        1, 0, 0, 0,    0,    0,     0,
-        0, 1, 0, 0,    0,    0,     0,
-        0, 0, 1, 0,    0,    0,     0,
-        0, 0, 0, 1,    0,    0,     0,
-        0, 0, 0, 0, 0.01,    0,     0,
-        0, 0, 0, 0,    0, 0.01,     0,
-        0, 0, 0, 0,    0,    0, 0.001,
-        });
-
-    /*** Z(t) = H * X(t) + v(t) ***/
-    /* Matrix to calculate Z(observed value) from X(internal status) */
-    const SimpleMatrix H(kNumObserve, kNumStatus, {
-        1, 0, 0, 0, 0, 0, 0,
-        0, 1, 0, 0, 0, 0, 0,
-        0, 0, 1, 0, 0, 0, 0,
-        0, 0, 0, 1, 0, 0, 0,
-        });
-
-    /* v(t), = noise, follows R */
-    const SimpleMatrix R(kNumObserve, kNumObserve, {
-        1, 0,  0,  0,
-        0, 1,  0,  0,
-        0, 0, 10,  0,
-        0, 0,  0, 10,
-        });
-
-    /* First internal status */
-    SimpleMatrix P0 = SimpleMatrix::IdentityMatrix(kNumStatus);
-    P0 = P0 * 10;   /* Set big noise at first to make K=1 and trust observed value rather than estimated value */
-
-    const SimpleMatrix X0 = Bbox2KalmanStatus(bbox_start);
-
-    KalmanFilter kf;
-    kf.Initialize(
-        F,
-        Q,
-        H,
-        R,
-        X0,
-        P0
-    );
-
-    return kf;
-}
-
-SimpleMatrix TrackDeepSort::Bbox2KalmanStatus(const BoundingBox& bbox)
-{
-    SimpleMatrix X(kNumStatus, 1, {
-        static_cast<double>(bbox.x + bbox.w / 2),
-        static_cast<double>(bbox.y + bbox.h / 2),
-        static_cast<double>(bbox.w * bbox.h),
-        static_cast<double>(bbox.w) / bbox.h,
-        0,
-        0,
-        0
-        });
-    return X;
-}
-
-SimpleMatrix TrackDeepSort::Bbox2KalmanObserved(const BoundingBox& bbox)
-{
-    SimpleMatrix Z(kNumObserve, 1, {
-        static_cast<double>(bbox.x + bbox.w / 2),
-        static_cast<double>(bbox.y + bbox.h / 2),
-        static_cast<double>(bbox.w * bbox.h),
-        static_cast<double>(bbox.w) / bbox.h,
-        });
-    return Z;
-}
-
-BoundingBox TrackDeepSort::KalmanStatus2Bbox(const SimpleMatrix& X)
+const int32_t TrackDeepSort::GetKalmanFilterIndex() const
 {
-    BoundingBox bbox;
-    bbox.w = static_cast<int32_t>(std::sqrt(X(2, 0) * X(3, 0)));
-    bbox.h = static_cast<int32_t>(X(2, 0) / bbox.w);
-    bbox.x = static_cast<int32_t>(X(0, 0) - bbox.w / 2);
-    bbox.y = static_cast<int32_t>(X(1, 0) - bbox.h / 2);
-    return bbox;
+    return kf_index_;
 }
 
 
-
 constexpr float TrackerDeepSort::kCostMax;  // for link error in Android Studio (clang)
+constexpr int32_t TrackerDeepSort::kCellSizeStep;
+constexpr float TrackerDeepSort::kThresholdReidentify;
 TrackerDeepSort::TrackerDeepSort(int32_t threshold_frame_to_delete)
 {
     track_sequence_num_ = 0;
+    frame_cnt_ = 0;
     threshold_frame_to_delete_ = threshold_frame_to_delete;
+    cell_size_ = 0;
 }
 
 TrackerDeepSort::~TrackerDeepSort()
@@ -245,7 +154,10 @@ TrackerDeepSort::~TrackerDeepSort()
 void TrackerDeepSort::Reset()
 {
     track_list_.clear();
+    kf_batch_.Clear();
     track_sequence_num_ = 0;
+    frame_cnt_ = 0;
+    gallery_.Reset();
 }
 
 
@@ -254,23 +166,31 @@ std::vector<TrackDeepSort>& TrackerDeepSort::GetTrackList()
     return track_list_;
 }
 
+int32_t TrackerDeepSort::LoadGallery(const std::string& filename)
+{
+    if (gallery_.Load(filename) != ReidGallery::kRetOk) {
+        return -1;
+    }
+    /* do not re-use ids in the gallery for new objects */
+    track_sequence_num_ = (std::max)(track_sequence_num_, gallery_.GetMaxId() + 1);
+    return 0;
+}
+
+int32_t TrackerDeepSort::SaveGallery(const std::string& filename)
+{
+    if (gallery_.Save(filename) != ReidGallery::kRetOk) {
+        return -1;
+    }
+    return 0;
+}
+
 static float CosineSimilarity(const std::vector<float>& feature0, const std::vector<float>& feature1)
 {
     if (feature0.size() == 0 || feature1.size() == 0 || feature0.size() != feature1.size()) {
         return 999; /* invalid */
     }
-    float norm_0 = 0;
-    float norm_1 = 0;
-    float dot = 0;
-    for (size_t i = 0; i < feature0.size(); i++) {
-        norm_0 += feature0[i] * feature0[i];
-        norm_1 += feature1[i] * feature1[i];
-        dot += feature0[i] * feature1[i];
-    }
-    
-    if (norm_0 == 0 || norm_1 == 0) return 999; /* invalid */
-
-    return (std::max)(0.0f, dot / (std::sqrt(norm_0) * std::sqrt(norm_1)));
+    /* features are already L2-normalised in TrackerDeepSort::Update, so just take dot product */
+    return (std::max)(0.0f, ReidGallery::Dot(feature0.data(), feature1.data(), static_cast<int32_t>(feature0.size())));
 }
 
 //static float EuclidDistance(const std::array<float, 512>& feature0, const std::array<float, 512>& feature1)
@@ -330,7 +250,7 @@ float TrackerDeepSort::CalculateCost(TrackDeepSort& track, const BoundingBox& de
             break;
         }
         similarity_history.push_back(val);
-        //if (similarity_history.size() > 10) break;  /* use the feature up to past 50 (5 * 10) frame */
+        if (similarity_history.size() >= 10) break;  /* use the feature up to past 50 (5 * 10) frame */
     }
     if (similarity_history.size() > 0) {
         similarity_feature = std::accumulate(similarity_history.begin(), similarity_history.end(), 0.0f) / similarity_history.size();   /* take average similarity */
@@ -352,37 +272,71 @@ float TrackerDeepSort::CalculateCost(TrackDeepSort& track, const BoundingBox& de
 }
 
 
-void TrackerDeepSort::Update(const std::vector<BoundingBox>& det_list, const std::vector<std::vector<float>>& feature_list)
+void TrackerDeepSort::UpdateSpatialHash(const std::vector<BoundingBox>& det_list, int32_t det_size_mean)
+{
+    /* cell size follows the object size (quantized not to re-create the buckets every frame) */
+    int32_t cell_size = (std::max)(kCellSizeStep, (det_size_mean + kCellSizeStep - 1) / kCellSizeStep * kCellSizeStep);
+    if (cell_size != cell_size_) {
+        cell_size_ = cell_size;
+        spatial_hash_.SetCellSize(cell_size_);
+    } else {
+        spatial_hash_.Clear();
+    }
+    for (size_t i_det = 0; i_det < det_list.size(); i_det++) {
+        spatial_hash_.Insert(static_cast<int32_t>(i_det), det_list[i_det].x, det_list[i_det].y);
+    }
+}
+
+void TrackerDeepSort::Update(const std::vector<BoundingBox>& det_list, const std::vector<std::vector<float>>& feature_list_org)
 {
+    frame_cnt_++;
+
+    /* Normalize features once here, so that similarity is calculated just by dot product */
+    std::vector<std::vector<float>> feature_list = feature_list_org;
+    for (auto& feature : feature_list) {
+        ReidGallery::Normalize(feature);
+    }
+
     /*** Predict the position at the current frame using the previous status for all tracked bbox ***/
+    kf_batch_.Predict();
     for (auto& track : track_list_) {
-        track.Predict();
+        track.Predict(kf_batch_);
     }
 
     /*** Association ***/
-    /* Calculate IoU b/w predicted position and detected position */
-    size_t size_cost_matrix = (std::max)(track_list_.size(), det_list.size());  /* workaround: my hungarian algorithm sometimes outputs wrong result when the input matrix is not squared */
-    std::vector<std::vector<float>> cost_matrix(size_cost_matrix, std::vector<float>(size_cost_matrix, kCostMax));
-    for (size_t i_track = 0; i_track < track_list_.size(); i_track++) {
-        for (size_t i_det = 0; i_det < det_list.size(); i_det++) {
-            cost_matrix[i_track][i_det] = CalculateCost(track_list_[i_track], det_list[i_det], feature_list[i_det]);
+    /* Calculate cost only for nearby pairs (CalculateCost rejects far pairs anyway) */
+    std::vector<SparseAssignment::Edge> edge_list;
+    int32_t max_det_size = 0;
+    int32_t sum_det_size = 0;
+    for (const auto& det : det_list) {
+        max_det_size = (std::max)(max_det_size, det.w + det.h);
+        sum_det_size += (det.w + det.h) / 2;
+    }
+    if (track_list_.size() > 0 && det_list.size() > 0) {
+        UpdateSpatialHash(det_list, sum_det_size / static_cast<int32_t>(det_list.size()));
+        std::vector<int32_t> det_index_list;
+        for (size_t i_track = 0; i_track < track_list_.size(); i_track++) {
+            /* the same threshold as CalculateCost with the biggest det */
+            const auto& track_bbox = track_list_[i_track].GetLatestBoundingBox();
+            const int32_t range = (track_bbox.w + track_bbox.h + max_det_size) / 2 + 1;
+            spatial_hash_.Query(track_bbox.x - range, track_bbox.y - range, track_bbox.x + range, track_bbox.y + range, det_index_list);
+            for (int32_t i_det : det_index_list) {
+                float cost = CalculateCost(track_list_[i_track], det_list[i_det], feature_list[i_det]);
+                if (cost < kCostMax) {
+                    edge_list.push_back({ static_cast<int32_t>(i_track), i_det, cost });
+                }
+            }
         }
     }
 
     /* Assign track and det */
-    std::vector<int32_t> det_index_for_track(size_cost_matrix, -1);
-    std::vector<int32_t> track_index_for_det(size_cost_matrix, -1);
-    if (track_list_.size() > 0 && det_list.size() > 0) {
-        HungarianAlgorithm<float> solver(cost_matrix);
-        solver.Solve(det_index_for_track, track_index_for_det);
-    }
+    std::vector<int32_t> det_index_for_track;
+    std::vector<int32_t> track_index_for_det;
+    SparseAssignment::Solve(static_cast<int32_t>(track_list_.size()), static_cast<int32_t>(det_list.size()), edge_list, kCostMax, det_index_for_track, track_index_for_det);
 
 #if 0
-    for (size_t i_track = 0; i_track < track_list_.size(); i_track++) {
-        for (size_t i_det = 0; i_det < det_list.size(); i_det++) {
-            printf("%.3f  ", cost_matrix[i_track][i_det]);
-        }
-        printf("\n");
+    for (const auto& edge : edge_list) {
+        printf("%3d - %3d: %.3f\n", edge.row, edge.col, edge.cost);
     }
 
     printf("track:  det\n");
@@ -396,12 +350,15 @@ void TrackerDeepSort::Update(const std::vector<BoundingBox>& det_list, const std
 #endif
 
     /*** Update track ***/
-    std::vector<bool> is_det_assigned_list(size_cost_matrix, false);
+    std::vector<bool> is_det_assigned_list(det_list.size(), false);
     for (size_t i_track = 0; i_track < track_list_.size(); i_track++) {
         int32_t assigned_det_index = det_index_for_track[i_track];
-        if (assigned_det_index >= 0 && assigned_det_index < static_cast<int32_t>(det_list.size()) && cost_matrix[i_track][assigned_det_index] < kCostMax) {
-            track_list_[i_track].Update(det_list[assigned_det_index]);
-            track_list_[i_track].GetLatestData().feature = feature_list[assigned_det_index];
+        if (assigned_det_index >= 0) {
+            track_list_[i_track].Update(det_list[assigned_det_index], kf_batch_);
+            if (!feature_list[assigned_det_index].empty()) {
+                track_list_[i_track].GetLatestData().feature = feature_list[assigned_det_index];    /* otherwise, keep the previous feature (feature extraction was skipped) */
+            }
+            gallery_.Update(track_list_[i_track].GetId(), feature_list[assigned_det_index], frame_cnt_);
             is_det_assigned_list[assigned_det_index] = true;
         } else{
             track_list_[i_track].UpdateNoDetect();
@@ -411,6 +368,8 @@ void TrackerDeepSort::Update(const std::vector<BoundingBox>& det_list, const std
     /*** Delete tracks ***/
     for (auto it = track_list_.begin(); it != track_list_.end();) {
         if (it->GetUndetectedCount() >= threshold_frame_to_delete_) {
+            gallery_.SetActive(it->GetId(), false);     /* keep the feature in gallery as a lost object */
+            kf_batch_.Remove(it->GetKalmanFilterIndex());
             it = track_list_.erase(it);
         } else {
             it++;
@@ -420,8 +379,15 @@ void TrackerDeepSort::Update(const std::vector<BoundingBox>& det_list, const std
     /*** Add new tracks ***/
     for (size_t i = 0; i < det_list.size(); i++) {
         if (is_det_assigned_list[i] == false) {
-            track_list_.push_back(TrackDeepSort(track_sequence_num_, det_list[i], feature_list[i]));
-            track_sequence_num_++;
+            /* Re-identify a lost object using gallery. Otherwise, assign a new id */
+            int32_t id = -1;
+            float similarity = 0;
+            if (!gallery_.Search(feature_list[i], id, similarity) || similarity < kThresholdReidentify) {
+                id = track_sequence_num_;
+                track_sequence_num_++;
+            }
+            track_list_.push_back(TrackDeepSort(id, det_list[i], feature_list[i], kf_batch_.Add(det_list[i])));
+            gallery_.Update(id, feature_list[i], frame_cnt_);
         }
     }
 }
@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 #include <algorithm>
 #include <chrono>
+#include <memory>
 
 /* for OpenCV */
 #include <opencv2/opencv.hpp>
@@ -26,12 +27,21 @@ limitations under the License.
 /* for My modules */
 #include "image_processor.h"
 #include "common_helper_cv.h"
+#include "metrics.h"
+#include "load_test_source.h"
+#include "alloc_profiler.h"
 
 /*** Macro ***/
 #define WORK_DIR                      RESOURCE_DIR
 #define DEFAULT_INPUT_IMAGE           RESOURCE_DIR"/kite.jpg"
 #define LOOP_NUM_FOR_TIME_MEASUREMENT 10
 
+/* Metrics export. empty / 0 = disabled */
+#define METRICS_PROMETHEUS_FILE       ""      /* e.g. "/var/lib/node_exporter/textfile/reid.prom" */
+#define METRICS_JSON_FILE             ""      /* e.g. "metrics.jsonl" */
+#define METRICS_HTTP_PORT             0       /* e.g. 9100 (http://127.0.0.1:9100/metrics) */
+#define METRICS_EXPORT_INTERVAL_MSEC  1000
+
 /*** Function ***/
 int32_t main(int argc, char* argv[])
 {
@@ -44,30 +54,59 @@ int32_t main(int argc, char* argv[])
     double total_time_inference = 0;
     double total_time_post_process = 0;
 
-    /* Find source image */
+    /* Start metrics exporter */
+    Metrics::Histogram& metrics_time_all = Metrics::GetHistogram("frame_latency_msec", "stage", "total", "Processing time per frame in the main loop");
+    Metrics::Histogram& metrics_time_cap = Metrics::GetHistogram("frame_latency_msec", "stage", "capture");
+    Metrics::Histogram& metrics_time_render = Metrics::GetHistogram("frame_latency_msec", "stage", "render");
+    Metrics::Gauge& metrics_source_drop = Metrics::GetGauge("source_dropped_frames", "", "", "Frames dropped by the load test source because processing was slower than real time");
+    MetricsExporter metrics_exporter;
+    if (std::string(METRICS_PROMETHEUS_FILE) != "") metrics_exporter.AddSink(std::unique_ptr<MetricsSink>(new MetricsSinkPrometheusFile(METRICS_PROMETHEUS_FILE)));
+    if (std::string(METRICS_JSON_FILE) != "") metrics_exporter.AddSink(std::unique_ptr<MetricsSink>(new MetricsSinkJsonLines(METRICS_JSON_FILE)));
+    if (METRICS_HTTP_PORT > 0) metrics_exporter.AddSink(std::unique_ptr<MetricsSink>(new MetricsSinkHttp(METRICS_HTTP_PORT)));
+    metrics_exporter.Start(METRICS_EXPORT_INTERVAL_MSEC);
+
+    /* Find source image (or load test source. e.g. "synthetic?objects=30", "replay:xxx.mp4?speed=2") */
     std::string input_name = (argc > 1) ? argv[1] : DEFAULT_INPUT_IMAGE;
-    cv::VideoCapture cap;   /* if cap is not opened, src is still image */
-    if (!CommonHelper::FindSourceImage(input_name, cap)) {
-        return -1;
+    std::unique_ptr<cv::VideoCapture> cap_source;   /* if cap is not opened, src is still image */
+    if (CommonHelper::IsLoadTestSource(input_name)) {
+        auto source_list = CommonHelper::CreateLoadTestSource(input_name);  /* only the first copy is used (single stream) */
+        if (source_list.empty()) return -1;
+        cap_source = std::move(source_list[0]);
+    } else {
+        cap_source.reset(new cv::VideoCapture());
+        if (!CommonHelper::FindSourceImage(input_name, *cap_source)) {
+            return -1;
+        }
     }
+    cv::VideoCapture& cap = *cap_source;
+    const LoadTestCapture* load_test_source = dynamic_cast<const LoadTestCapture*>(cap_source.get());
 
     /* Create video writer to save output video */
     cv::VideoWriter writer;
     //writer = cv::VideoWriter("out.mp4", cv::VideoWriter::fourcc('M', 'P', '4', 'V'), (std::max)(10.0, cap.get(cv::CAP_PROP_FPS)), cv::Size(static_cast<int32_t>(cap.get(cv::CAP_PROP_FRAME_WIDTH)), static_cast<int32_t>(cap.get(cv::CAP_PROP_FRAME_HEIGHT))));
 
     /* Initialize image processor library */
-    ImageProcessor::InputParam input_param = { WORK_DIR, 4 };
+    ImageProcessor::InputParam input_param = { WORK_DIR, 4, "" };
+    if (cap.isOpened() && cap.get(cv::CAP_PROP_FRAME_COUNT) > 0 && !load_test_source) {
+        snprintf(input_param.source_name, sizeof(input_param.source_name), "%s", input_name.c_str());   /* video file: resumable */
+    }
     if (ImageProcessor::Initialize(input_param) != 0) {
         printf("Initialization Error\n");
         return -1;
     }
 
     /*** Process for each frame ***/
+    const int32_t alloc_stage_capture = AllocProfiler::RegisterStage("capture");
+    const int32_t alloc_stage_render = AllocProfiler::RegisterStage("render");
+    AllocProfiler::Snapshot alloc_snapshot_start;
+    AllocProfiler::Snapshot alloc_snapshot_end;
     int32_t frame_cnt = 0;
     for (frame_cnt = 0; cap.isOpened() || frame_cnt < LOOP_NUM_FOR_TIME_MEASUREMENT; frame_cnt++) {
+        if (frame_cnt == 1) AllocProfiler::GetSnapshot(alloc_snapshot_start);   /* do not count the first frame as well as processing time */
         const auto& time_all0 = std::chrono::steady_clock::now();
         /* Read image */
         const auto& time_cap0 = std::chrono::steady_clock::now();
+        AllocProfiler::SetStage(alloc_stage_capture);
         cv::Mat image;
         if (cap.isOpened()) {
             cap.read(image);
@@ -80,12 +119,16 @@ int32_t main(int argc, char* argv[])
         /* Call image processor library */
         const auto& time_image_process0 = std::chrono::steady_clock::now();
         ImageProcessor::Result result;
-        ImageProcessor::Process(image, result);
+        ImageProcessor::Process(image, result, cap.isOpened() ? static_cast<int64_t>(cap.get(cv::CAP_PROP_POS_FRAMES)) - 1 : -1);
         const auto& time_image_process1 = std::chrono::steady_clock::now();
 
         /* Display result */
+        const auto& time_render0 = std::chrono::steady_clock::now();
+        AllocProfiler::SetStage(alloc_stage_render);
         if (writer.isOpened()) writer.write(image);
         cv::imshow("test", image);
+        AllocProfiler::SetStage(0);
+        const auto& time_render1 = std::chrono::steady_clock::now();
 
         /* Input key command */
         if (cap.isOpened()) {
@@ -105,8 +148,15 @@ int32_t main(int argc, char* argv[])
         printf("    Pre processing:  %9.3lf [msec]\n", result.time_pre_process);
         printf("    Inference:       %9.3lf [msec]\n", result.time_inference);
         printf("    Post processing: %9.3lf [msec]\n", result.time_post_process);
+        printf("  QoS level:         %9d (dropped feature = %d%s%s)\n", result.qos_level, result.num_dropped_feature, result.is_detection_skipped ? ", detection skipped" : "", result.is_frame_skipped ? ", frame skipped" : "");
+        if (result.is_result_reused) printf("  Result store:      detection and feature are reused\n");
         printf("=== Finished %d frame ===\n\n", frame_cnt);
 
+        metrics_time_all.Observe(time_all);
+        metrics_time_cap.Observe(time_cap);
+        metrics_time_render.Observe(static_cast<std::chrono::duration<double>>(time_render1 - time_render0).count() * 1000.0);
+        if (load_test_source) metrics_source_drop.Set(load_test_source->GetDropNum());
+
         if (frame_cnt > 0) {    /* do not count the first process because it may include initialize process */
             total_time_all += time_all;
             total_time_cap += time_cap;
@@ -118,6 +168,9 @@ int32_t main(int argc, char* argv[])
     }
     
     /*** Finalize ***/
+    AllocProfiler::SetStage(0);
+    AllocProfiler::GetSnapshot(alloc_snapshot_end);
+
     /* Print average processing time */
     if (frame_cnt > 1) {
         frame_cnt--;    /* because the first process was not counted */
@@ -128,10 +181,14 @@ int32_t main(int argc, char* argv[])
         printf("    Pre processing:  %9.3lf [msec]\n", total_time_pre_process / frame_cnt);
         printf("    Inference:       %9.3lf [msec]\n", total_time_inference / frame_cnt);
         printf("    Post processing: %9.3lf [msec]\n", total_time_post_process / frame_cnt);
+        AllocProfiler::PrintPerFrame(alloc_snapshot_start, alloc_snapshot_end, frame_cnt);
     }
+    if (load_test_source) printf("Source: %d frames processed, %d frames dropped\n", load_test_source->GetFrameNum(), load_test_source->GetDropNum());
 
     /* Fianlize image processor library */
     ImageProcessor::Finalize();
+    metrics_exporter.Stop();
+    metrics_exporter.Flush();
     if (writer.isOpened()) writer.release();
     cv::waitKey(-1);
 